@@ -92,18 +92,29 @@
 #if defined(__ICCARM__) || defined(__CC_ARM) || defined(__GNUC__)
     #include <stdint.h>
     extern uint32_t SystemCoreClock;
+    void hr_timer_init(void);
+    uint32_t hr_timer_now(void);
 #endif
 
 #define configUSE_PREEMPTION                     1
-#define configSUPPORT_STATIC_ALLOCATION          0
+/* All tasks and queues are created statically. Build with STATIC_ALLOCATION_ONLY set to 1 to leave out the FreeRTOS heap
+completely, any call that needs it will then fail to link. */
+#ifndef STATIC_ALLOCATION_ONLY
+#define STATIC_ALLOCATION_ONLY                   0
+#endif
+#define configSUPPORT_STATIC_ALLOCATION          1
+#if STATIC_ALLOCATION_ONLY
+#define configSUPPORT_DYNAMIC_ALLOCATION         0
+#else
 #define configSUPPORT_DYNAMIC_ALLOCATION         1
+#endif
 #define configUSE_IDLE_HOOK                      0
 #define configUSE_TICK_HOOK                      0
 #define configCPU_CLOCK_HZ                       ( SystemCoreClock )
 #define configTICK_RATE_HZ                       ((TickType_t)1000)
 #define configMAX_PRIORITIES                     ( 7 )
 #define configMINIMAL_STACK_SIZE                 ((uint16_t)128)
-#define configTOTAL_HEAP_SIZE                    ((size_t)70360)
+#define configTOTAL_HEAP_SIZE                    ((size_t)4096)
 #define configMAX_TASK_NAME_LEN                  ( 16 )
 #define configUSE_16_BIT_TICKS                   0
 #define configUSE_MUTEXES                        1
@@ -168,7 +179,11 @@ standard names. */
 /* USER CODE BEGIN Defines */   	      
 /* Section where parameter definitions can be added (for instance, to override default ones in FreeRTOS.h) */
 #define configUSE_TRACE_FACILITY                   1
-//#define configGENERATE_RUN_TIME_STATS              1
+#define configGENERATE_RUN_TIME_STATS              1
+
+/* Run time statistics are counted in microseconds with TIM5, see hrTimer.h. */
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()   hr_timer_init()
+#define portGET_RUN_TIME_COUNTER_VALUE()           hr_timer_now()
 
 
 /* USER CODE END Defines */ 
@@ -0,0 +1,105 @@
+#ifndef ACQUISITION_H
+#define ACQUISITION_H
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// UMSATS 2018-2020
+//
+// Repository:
+//  UMSATS/Avionics-2019
+//
+// File Description:
+//  Header file for the sensor acquisition schedule. The accelerometer, gyroscope and BMP388 each have their own rate
+//  (acc_rate, gyro_rate and bmp_rate in the configuration) and a periodic timer wheel timer that notifies the sensor
+//  task when a reading is due.
+//  All the timers are phase locked to one start time. The accelerometer and gyroscope are both read by the IMU task,
+//  so they never use SPI3 at the same time, and when both are due at once they are read together into one reading.
+//  The BMP388 is offset by half of the fastest IMU period so its task does not wake at the same time as the IMU task.
+//  Readings from both tasks go to one queue as sensorReading_t, in the order they were taken.
+//
+// History
+// 2026-10-19
+// - Created.
+// - Added acquisition_missed().
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include <stdint.h>
+#include "cmsis_os.h"
+#include "bmi08x_defs.h"
+#include "bmp3_defs.h"
+#include "configuration.h"
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// DEFINITIONS AND MACROS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+//Sensor bits, used for the task notifications and in sensorReading_t.
+#define ACQ_ACC				0x01
+#define ACQ_GYRO			0x02
+#define ACQ_BMP				0x04
+
+#define ACQ_MAX_IMU_RATE	2000		//Hz, for the accelerometer and the gyroscope.
+#define ACQ_MAX_BMP_RATE	200			//Hz, the fastest BMP388 output data rate.
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// STRUCTS AND STRUCT TYPEDEFS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+typedef struct{
+
+	uint8_t sensors;						//ACQ_ACC, ACQ_GYRO and ACQ_BMP bits of the readings held.
+	uint32_t time_ticks;					//Time of the reading in ticks.
+	uint32_t time_us;						//hr_timer_now() time of the reading, for the log.
+	struct bmi08x_sensor_data acc;
+	struct bmi08x_sensor_data gyro;
+	struct bmp3_data bmp;
+
+}sensorReading_t;
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// FUNCTION PROTOTYPES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Works out the periods and phases from the rates in the configuration. Rates out of range are limited to
+//	1 Hz - ACQ_MAX_IMU_RATE or ACQ_MAX_BMP_RATE. Call after the configuration is read and before the sensor tasks run.
+//	timer_wheel_init() must have been called.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void acquisition_init(configData_t * configParams);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Starts the timers for the given sensors. Each one sets its bit in the notification value of the calling task when
+//	it is due. The first reading is at the next point of the shared schedule.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void acquisition_start(uint8_t sensors);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Blocks the calling task until at least one of its sensors is due.
+//
+// Returns:
+//  The ACQ_ bits of the sensors to read.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint8_t acquisition_wait(void);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  The period of a sensor in microseconds, after limiting.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint32_t acquisition_period(uint8_t sensor);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  The period in microseconds for a rate in Hz, limited to 1 Hz - max_rate the same way as acquisition_init().
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint32_t acquisition_rate_period(uint16_t rate,uint16_t max_rate);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  The number of readings of a sensor missed since acquisition_init(), because the sensor was due again before its
+//	task had woken up for the last time. A higher priority task holding the CPU for longer than a period does this.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint32_t acquisition_missed(uint8_t sensor);
+
+#endif // ACQUISITION_H
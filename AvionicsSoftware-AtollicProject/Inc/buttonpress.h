@@ -12,6 +12,8 @@
 // History
 // 2019-03-13 by Benjamin Zacharias
 // - Created.
+// 2026-10-19
+// - vTask_timerbp replaced by timerbp_start(), which runs from the timer wheel.
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -59,6 +61,12 @@
 //  Enter description of return values (if any).
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 void Timerbp_GPIO_Init(void);
-void vTask_timerbp(void *param);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Starts polling the button. When it is pressed the output is toggled after TIME_INTERVAL1 and again TIME_INTERVAL2
+//  after that. Call Timerbp_GPIO_Init() and timer_wheel_init() first.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void timerbp_start(void);
 
 #endif // BP_H
@@ -12,6 +12,8 @@
 // History
 // 2019-01-13 by Cole Wiebe
 // - Created.
+// 2026-10-19
+// - buzz() no longer blocks. Tones are queued and played from the TIM2 interrupt.
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -23,8 +25,8 @@
 // CONSTANTS
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 #define FREQ 4000 //in hertz
-#define COUNTER (84000000 * ((1/FREQ)/2)) //84000000 = clock frequency in hz
-#define SECOND 4
+#define BUZZER_QUEUE_LENGTH		32		//Tones that can be waiting to play.
+#define BUZZER_IRQ_PRIORITY		6		//Does not use any FreeRTOS calls.
 //#define PIN1 GPIO_PIN_4
 //#define PIN2 GPIO_PIN_5
 
@@ -44,12 +46,38 @@
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 // Description:
 //  makes a buzzer buzz for a given amount of milliseconds
+//	Returns right away, the tone plays after any that are already queued. Safe to call before the scheduler is started.
 //
 // Returns:
-//  int seconds
+//  void
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 void buzz(int milliseconds);
 
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Queues a tone followed by a silence. A frequency of 0 is a silence of on_ms+off_ms.
+//	Longer patterns are built by calling this once per beep.
+//
+// Returns:
+//  1 if the tone was queued, 0 if the queue is full.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint8_t buzz_tone(uint16_t frequency,uint16_t on_ms,uint16_t off_ms);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Checks if anything is playing or queued.
+//
+// Returns:
+//  1 while the buzzer is busy, 0 otherwise.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint8_t buzzer_busy(void);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Called from TIM2_IRQHandler. Toggles the buzzer pin and moves on to the next tone when one is done.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void buzzer_irq(void);
+
 void Error_Handler(void);
 
 #endif // BUZZER_H
@@ -0,0 +1,91 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// UMSATS 2018-2020
+//
+// Repository:
+//  UMSATS/Avionics-2019
+//
+// File Description:
+//  Header file for the flight state checkpoints used to carry on after a reset in flight.
+//  A checkpoint holds everything the flight state machine needs (state, flags, altitude filter and counters) plus the
+//  log position and the time since launch, packed into CHECKPOINT_WORDS 32 bit words with a CRC.
+//  This module has no HAL or FreeRTOS dependencies so it can be built on a host (see Tools/flightReplay.c).
+//  Storing the words is left to restart.c.
+//
+// History
+// 2026-10-19
+// - Created.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include <stdint.h>
+#include "flightState.h"
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// DEFINITIONS AND MACROS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#define CHECKPOINT_PERIOD		100			//Time between checkpoints in flight in ms.
+#define CHECKPOINT_WORDS		10			//Packed size, including the CRC.
+#define CHECKPOINT_MAGIC		0xC4E0
+#define CHECKPOINT_NO_CONFIG	0xFFFF		//config_slot when there is no saved configuration.
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// STRUCTS AND STRUCT TYPEDEFS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+typedef struct{
+
+	uint8_t state;
+	uint8_t flags;
+
+	//Copied from flightState_t.
+	float altitude;
+	float alt_filtered;
+	float alt_prev;
+	uint8_t alt_count;
+	uint8_t alt_main_count;
+	uint16_t apogee_holdout_count;
+
+	uint32_t flash_address;				//Next page the log would have been written to.
+	uint32_t flight_time;				//ms since launch detection.
+	uint16_t config_slot;				//Journal slot of the newest configuration record, see config_journal_slot().
+	uint32_t sequence;					//Set by restart_save().
+
+}checkpoint_t;
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// FUNCTION PROTOTYPES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Copies the state, flags, filter and counters of the flight state machine into a checkpoint.
+//	The log position, flight time and configuration slot are left for the caller to fill in.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void checkpoint_save(checkpoint_t * checkpoint,const flightState_t * fs);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Puts the flight state machine back the way it was when the checkpoint was taken, including the state and flags
+//	it points at. The state machine must have been set up with flight_state_init() first.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void checkpoint_restore(const checkpoint_t * checkpoint,flightState_t * fs);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Packs a checkpoint into words, with the magic number in the first word and a CRC-32 of the others in the last.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void checkpoint_pack(const checkpoint_t * checkpoint,uint32_t words[CHECKPOINT_WORDS]);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Unpacks words written by checkpoint_pack().
+//
+// Returns:
+//  1 if the magic number and CRC are good, 0 otherwise (the checkpoint is then left unchanged).
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint8_t checkpoint_unpack(const uint32_t words[CHECKPOINT_WORDS],checkpoint_t * checkpoint);
+
+#endif // CHECKPOINT_H
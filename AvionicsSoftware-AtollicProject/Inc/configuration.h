@@ -12,6 +12,13 @@
 // History
 // 2019-05-27 by Joseph Howarth
 // - Created.
+// 2026-10-19
+// - The configuration is saved to a journal instead of erasing and rewriting one sector.
+// - Added read_config_at() and config_journal_slot() for warm restarts.
+// - data_rate replaced by separate accelerometer, gyroscope and BMP388 sample rates.
+// - Added the logging rate of each flight phase.
+// - Added the event capture windows and shock level, in what was padding after the id.
+// - Removed the flash pointer, the journal goes through the flash service.
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -20,6 +27,8 @@
 #include "bmi08x_defs.h"
 #include "bmp3_defs.h"
 #include "flash.h"
+#include "flightState.h"		//For the states and flag macros.
+#include "logRate.h"			//For the logging phases.
 
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -29,11 +38,20 @@
 //Defaults for the configuration options.
 #define ID						0x5A
 
-#define DATA_RATE 				50
+#define ACC_RATE				100				//Sample rates in Hz, see acquisition.h for the limits.
+#define GYRO_RATE				100
+#define BMP_RATE				20
+#define LOG_RATE_PAD			100				//Logging rates in Hz for each flight phase, 0 logs every reading.
+#define LOG_RATE_ASCENT			1000			//These only limit the sample rates above.
+#define LOG_RATE_DROGUE			200
+#define LOG_RATE_MAIN			10
+#define CAPTURE_PRE_TIME		20				//Event capture windows before and after a trigger, in 10 ms.
+#define CAPTURE_POST_TIME		50
+#define CAPTURE_SHOCK_G			10				//g, acceleration that triggers a capture window. 0 for none.
 #define INITIAL_WAIT_TIME 		10000			//in milliseconds
 #define FLAGS 					0x00			//default not in flight, not recording.
-#define DATA_START_ADDRESS		0x00001000		//Start writing to second page of memory.
-#define DATA_END_ADDRESS		0x00001000		//Assume no saved data.
+#define DATA_START_ADDRESS		FLASH_START_ADDRESS		//Start writing after the configuration journal.
+#define DATA_END_ADDRESS		FLASH_START_ADDRESS		//Assume no saved data.
 
 #define ACC_BANDWIDTH			BMI08X_ACCEL_BW_NORMAL
 #define ACC_ODR					BMI08X_ACCEL_ODR_100_HZ
@@ -54,22 +72,6 @@
 #define GND_PRES				101325
 
 
-#define STATE_XTRACT					0x01
-#define STATE_LAUNCHPAD					0x02
-#define STATE_LAUNCHPAD_ARMED			0x03
-#define STATE_IN_FLIGHT_PRE_APOGEE		0x04
-#define STATE_IN_FLIGHT_POST_APOGEE		0x05
-#define STATE_IN_FLIGHT_POST_MAIN		0x06
-#define STATE_LANDED					0x07
-
-//Macros to get flags.
-#define IS_IN_FLIGHT(x)		((x>>0)&0x01)
-#define	IS_RECORDING(x)		((x>>1)&0x01)
-#define IS_PRE_DROGUE(x)	((x>>2)&0x01)
-#define IS_POST_DROGUE(x)	((x>>3)&0x01)
-#define IS_POST_MAIN(x)		((x>>4)&0x01)
-
-
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 // ENUMS AND ENUM TYPEDEFS
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -83,8 +85,13 @@ typedef enum{
 typedef struct {
 
 	uint8_t 	 id;
+	uint8_t		 capture_pre;	//10 ms, see eventCapture.h.
+	uint8_t		 capture_post;	//10 ms
+	uint8_t		 capture_shock;	//g
 	uint32_t	 initial_time_to_wait;
-	uint8_t 	 data_rate;
+	uint16_t	 acc_rate;		//Hz
+	uint16_t	 gyro_rate;		//Hz
+	uint16_t	 bmp_rate;		//Hz
 	uint8_t 	 flags;
 	uint32_t	 start_data_address;
 	uint32_t	 end_data_address;
@@ -104,11 +111,12 @@ typedef struct {
 	uint8_t 	 pres_os;
 	uint8_t  	 iir_coef;
 
+	uint16_t	 log_rate[LOG_PHASES];	//Hz, indexed by LOG_PHASE_.
+
 	float	 	 ref_alt;
 	float 	 	 ref_pres;
 
 
-	FlashStruct_t * flash;
 	uint8_t state;
 
 
@@ -120,6 +128,9 @@ typedef union{
 	uint8_t  bytes[sizeof(configDataStruct_t)] ;
 	configDataStruct_t values;
 } configData_t;
+
+//Number of bytes saved to flash. The state is not saved (it is padded to 4 bytes).
+#define CONFIG_SAVED_SIZE		(sizeof(configData_t)-4)
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 // TYPEDEFS
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -145,6 +156,8 @@ configStatus_t init_config(configData_t* configuration);
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 // Description:
 //  Reads the configuration values from flash memory..
+//	Scans the whole journal and loads the newest record with a good CRC. Must be called before write_config().
+//	If there is no good record the saved values are set to 0xFF, like erased memory.
 //
 // Returns:
 //  Returns a configStatus_t with OK or ERROR.
@@ -155,11 +168,48 @@ configStatus_t read_config(configData_t* configuration);
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 // Description:
 //  Writes the configuration values to flash memory..
+//	Appends a record to the journal, this is a single page program. Only erases if config_service() has not
+//	erased the next sector by the time the current one is full.
 //
 // Returns:
 //  Returns a configStatus_t with OK or ERROR.
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 configStatus_t write_config(configData_t* configuration);
 
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Background compaction of the journal. Starts erasing the sector after the one being written, if it holds old
+//	records, and returns without waiting. Call regularly while nothing else is using the flash.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void config_service(configData_t* configuration);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Erases the whole journal. The next write_config() starts again at the first sector.
+//
+// Returns:
+//  Returns a configStatus_t with OK or ERROR.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+configStatus_t erase_config(configData_t* configuration);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Reads the configuration record in one journal slot instead of scanning the journal, for a quick restart.
+//	Fails if the slot after it is not blank, as the record may not be the newest.
+//
+// Returns:
+//  Returns a configStatus_t with OK or ERROR. Call read_config() on ERROR.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+configStatus_t read_config_at(configData_t* configuration,uint16_t slot);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Journal slot of the newest configuration record, to be passed to read_config_at() after a reset.
+//
+// Returns:
+//  The slot number, or 0xFFFF if nothing has been read or written.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint16_t config_journal_slot(void);
+
 
 #endif // CONFIGURATION_H
@@ -0,0 +1,95 @@
+#ifndef CRC_H
+#define CRC_H
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// UMSATS 2018-2020
+//
+// Repository:
+//  UMSATS/Avionics-2019
+//
+// File Description:
+//  Header file for the CRC-32 functions. The CRC is CRC-32/MPEG-2 (polynomial 0x04C11DB7, initial value 0xFFFFFFFF,
+//  not reflected, no final XOR), the same one the STM32 CRC unit computes.
+//  On the flight computer crc32() uses the CRC unit, a word at a time in a critical section, about 1 us for 64 bytes.
+//  Host builds, which do not define USE_HAL_DRIVER, use the table in software and need no HAL or FreeRTOS.
+//  crc16() is CRC-16/CCITT-FALSE (polynomial 0x1021, initial value 0xFFFF), for short radio frames.
+//
+// History
+// 2026-10-19
+// - Created.
+// - crc32() uses the STM32 CRC unit. Added crc32_software() and crc32_hardware().
+// - Added crc16().
+// - crc32_hardware() uses a critical section instead of turning interrupts off.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include <stdint.h>
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// DEFINITIONS AND MACROS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#define CRC32_INIT		0xFFFFFFFF
+#define CRC16_INIT		0xFFFF
+
+#ifdef USE_HAL_DRIVER
+#define CRC_HARDWARE	1
+#else
+#define CRC_HARDWARE	0
+#endif
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// FUNCTION PROTOTYPES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Continues a CRC over more data. Start with CRC32_INIT. Always done in software, the CRC unit can only start from
+//	CRC32_INIT.
+//
+// Returns:
+//  The updated CRC.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint32_t crc32_update(uint32_t crc,const uint8_t * data,uint32_t length);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Computes the CRC of a buffer, with the CRC unit when there is one.
+//
+// Returns:
+//  The CRC.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint32_t crc32(const uint8_t * data,uint32_t length);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Computes the CRC of a buffer with the table, to compare against the CRC unit.
+//
+// Returns:
+//  The CRC.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint32_t crc32_software(const uint8_t * data,uint32_t length);
+
+#if CRC_HARDWARE
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Computes the CRC of a buffer with the CRC unit. Whole words go through the unit and the last 1 to 3 bytes through
+//	the table. The unit is used in a critical section, so any task can call it, but not an
+//	interrupt.
+//
+// Returns:
+//  The CRC.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint32_t crc32_hardware(const uint8_t * data,uint32_t length);
+#endif
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Computes the CRC-16 of a buffer, a bit at a time. Only meant for a few dozen bytes.
+//
+// Returns:
+//  The CRC.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint16_t crc16(const uint8_t * data,uint32_t length);
+
+#endif // CRC_H
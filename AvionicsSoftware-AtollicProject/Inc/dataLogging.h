@@ -12,6 +12,12 @@
 // History
 // 2019-04-09 by Joseph Howarth
 // - Created.
+// 2026-10-19
+// - Added the checkpoint to carry on from after a reset in flight.
+// - Removed the timer task handle, the backup timers run from the timer wheel.
+// - One queue of sensorReading_t readings instead of separate IMU and pressure queues.
+// - Includes the flight phase logging rates.
+// - Removed the flash pointer, pages are written through the flash service.
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -20,53 +26,29 @@
 
 #include <string.h> 				// For memcpy
 #include "cmsis_os.h"				//For delay and queues
-#include "flash.h"					//For flash memory functions
+#include "flashService.h"			//For flash memory functions
 #include "pressure_sensor_bmp3.h"	//For bmp reading struct
-#include "sensorAG.h"				//For imu_reading struct
+#include "sensorAG.h"
+#include "acquisition.h"			//For the sensor reading struct
 #include "altimeter.h"
 #include "buzzer.h"
 #include "recovery.h"
+#include "logPacket.h"			//For the packet format and page buffers.
+#include "logRate.h"			//For the flight phase logging rates.
+#include "eventCapture.h"		//For the full rate windows around flight events.
+#include "flightState.h"		//For launch, apogee, main and landing detection.
+#include "checkpoint.h"			//For carrying on after a reset in flight.
 #include <math.h>
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 // DEFINITIONS AND MACROS
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
-#define DATA_BUFFER_SIZE	FLASH_PAGE_SIZE			//Matches flash memory page size.
-#define ACC_TYPE 			0x800000
-#define GYRO_TYPE			0x400000
-#define PRES_TYPE			0x200000
-#define	TEMP_TYPE			0x100000
-
-#define DROGUE_DETECT		0x080000
-#define DROGUE_DEPLOY		0x040000
-
-#define MAIN_DETECT			0x020000
-#define MAIN_DEPLOY			0x010000
-
-#define LAUNCH_DETECT		0x008000
-#define LAND_DETECT			0x004000
-
-#define POWER_FAIL			0x002000
-#define	OVERCURRENT_EVENT	0x001000
-
-#define	ACC_LENGTH	6		//Length of a accelerometer measurement in bytes.
-#define	GYRO_LENGTH	6		//Length of a gyroscope measurement in bytes.
-#define	PRES_LENGTH	3		//Length of a pressure measurement in bytes.
-#define	TEMP_LENGTH	3		//Length of a temperature measurement in bytes.
-#define ALT_LENGTH  4
-#define HEADER_SIZE 3
 
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 // ENUMS AND ENUM TYPEDEFS
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 
-typedef enum{
-
-	BUFFER_A = 0,
-	BUFFER_B = 1
-
-} BufferSelection_t;
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 // STRUCTS AND STRUCT TYPEDEFS
@@ -74,24 +56,17 @@ typedef enum{
 
 typedef struct{
 
-	FlashStruct_t * flash_ptr;
 	UART_HandleTypeDef * uart;
 	configData_t *flightCompConfig;
 
 	//Queues
-	QueueHandle_t IMU_data_queue;	//For holding accelerometer and gyroscope readings.
-	QueueHandle_t PRES_data_queue;	//For holding pressure and temp. readings.
-
-	TaskHandle_t *timerTask_h;
-
-}LoggingStruct_t;
+	QueueHandle_t sensor_queue;		//For holding accelerometer, gyroscope and pressure readings, at their own rates.
 
 
-typedef struct{
+	checkpoint_t * resume;			//Checkpoint to carry on from after a reset in flight, NULL to start on the pad.
 
-			uint8_t  data[HEADER_SIZE+ACC_LENGTH+GYRO_LENGTH+PRES_LENGTH+TEMP_LENGTH+ALT_LENGTH];
+}LoggingStruct_t;
 
-}Measurement_t;
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 // TYPEDEFS
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -109,7 +84,7 @@ typedef struct{
 //  This task logs data measurements to the flash memory.
 //
 //	Should be passed a populated LoggingStruct as the parameter.
-//	The flash should be initialized before this task is started.
+//	The flash service should be initialized before this task is started.
 //
 // Returns:
 //
@@ -0,0 +1,141 @@
+#ifndef EVENT_CAPTURE_H
+#define EVENT_CAPTURE_H
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// UMSATS 2018-2020
+//
+// Repository:
+//  UMSATS/Avionics-2019
+//
+// File Description:
+//  Header file for the event capture windows. The log is normally averaged down to the rate of the flight phase (see
+//  logRate.h), which is too slow to see ignition, burnout, separation or a deployment charge. Every reading is also
+//  kept in a short RAM history at the sensor rates. When launch is detected, a parachute is deployed or the
+//  acceleration goes over the shock level, the readings from the window before the trigger are written from the
+//  history, followed by every reading until the window after the trigger ends.
+//  The window is a tagged segment in the log: an EXT_KIND_CAPTURE record, the readings at full rate, then an
+//  EXT_KIND_CAPTURE_END record. The normal stream stops during the segment and carries on after it. A trigger during
+//  a window extends it.
+//  This module has no HAL or FreeRTOS dependencies.
+//
+// History
+// 2026-10-19
+// - Created.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include <stdint.h>
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// DEFINITIONS AND MACROS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#define CAPTURE_HISTORY_LENGTH		256			//Readings kept in RAM, 128 ms with both IMU sensors at 2 kHz.
+#define CAPTURE_WINDOW_UNIT			10			//ms, unit of the window lengths in the configuration.
+
+//Trigger bits, in the capture record.
+#define CAPTURE_LAUNCH				0x01
+#define CAPTURE_DROGUE				0x02
+#define CAPTURE_MAIN				0x04
+#define CAPTURE_SHOCK				0x08
+
+#define CAPTURE_LENGTH				7			//Payload of the capture record.
+#define CAPTURE_END_LENGTH			2			//Payload of the capture end record.
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// STRUCTS AND STRUCT TYPEDEFS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//One reading as it goes into a measurement.
+typedef struct{
+
+	uint32_t time_us;			//hr_timer_now() time of the reading.
+	uint32_t types;				//ACC_TYPE, GYRO_TYPE, PRES_TYPE and TEMP_TYPE bits of the readings held.
+	int16_t acc[3];
+	int16_t gyro[3];
+	uint32_t pressure;
+	int32_t temperature;
+
+}captureReading_t;
+
+typedef struct{
+
+	captureReading_t history[CAPTURE_HISTORY_LENGTH];
+	uint16_t head;				//Where the next reading goes.
+	uint16_t count;				//Readings in the history.
+
+	uint32_t pre_us;			//Window before and after a trigger.
+	uint32_t post_us;
+	uint32_t shock_level;		//Square of the raw acceleration magnitude that triggers a window, 0 for none.
+
+	uint8_t active;				//1 while a window is being written.
+	uint32_t end_us;			//End of the window being written.
+	uint16_t readings;			//Readings written in the window so far.
+
+}eventCapture_t;
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// FUNCTION PROTOTYPES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Sets up a capture with an empty history. The windows are in CAPTURE_WINDOW_UNIT ms (capture_pre and capture_post in
+//	the configuration). With both windows 0 nothing is ever captured.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void capture_init(eventCapture_t * capture,uint8_t pre,uint8_t post,uint32_t shock_level);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Works out the shock level for capture_init() from a level in g and the accelerometer range setting
+//	(BMI088_ACCEL_RANGE_). A level at or over the range is limited to full scale on one axis.
+//
+// Returns:
+//  The square of the raw acceleration magnitude, or 0 if shock_g is 0.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint32_t capture_shock_level(uint8_t shock_g,uint8_t acc_range);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Adds a reading to the history, dropping the oldest one when it is full.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void capture_add(eventCapture_t * capture,const captureReading_t * reading);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Checks a reading and the flight events that came with it for anything that triggers a window.
+//
+// Returns:
+//  The CAPTURE_ trigger bits, 0 for none or when capturing is off.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint8_t capture_triggers(const eventCapture_t * capture,const captureReading_t * reading,uint32_t events);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Starts a window at the newest reading in the history, or extends the one being written. When a new window starts,
+//	the capture record is built in payload (CAPTURE_LENGTH bytes) and the readings from before the trigger should be
+//	written, oldest first, with capture_history(capture,count-1) down to capture_history(capture,0), the trigger reading.
+//
+// Returns:
+//  The number of readings to write from the history, including the trigger reading, or 0 if a window was extended.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint16_t capture_start(eventCapture_t * capture,uint8_t triggers,uint8_t * payload);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Gets a reading from the history, 0 being the newest.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+const captureReading_t * capture_history(const eventCapture_t * capture,uint16_t age);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Checks if the window being written has ended by the time of a new reading. When it has, the capture end record is
+//	built in payload (CAPTURE_END_LENGTH bytes) and should be written before the reading. Otherwise the reading is part
+//	of the window and is counted.
+//
+// Returns:
+//  1 if the window ended, 0 otherwise.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint8_t capture_update(eventCapture_t * capture,uint32_t time_us,uint8_t * payload);
+
+#endif // EVENT_CAPTURE_H
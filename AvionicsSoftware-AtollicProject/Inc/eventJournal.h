@@ -0,0 +1,113 @@
+#ifndef EVENT_JOURNAL_H
+#define EVENT_JOURNAL_H
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// UMSATS 2018-2020
+//
+// Repository:
+//  UMSATS/Avionics-2019
+//
+// File Description:
+//  Header file for the flight event journal. The event bits in the log only reach flash when their page fills, so a
+//  power loss right after a deployment can lose the record of it. Each new flight event is also written straight away
+//  to its own small record in the FLASH_EVENT_SECTORS parameter sectors after the configuration journal, before any
+//  more log data. A record holds the time, the events, the state and a snapshot of the altitude estimate.
+//
+//  The records fill the sectors in turn, like the configuration journal, and the sector after the current one is
+//  erased in the background on the launch pad. Writing a record is one page program in the highest flash service
+//  class, so the time from the event to the record being in flash is at most the end of a page program in progress
+//  plus the record's own program, about 6 ms. An erase in progress is suspended for it.
+//
+// History
+// 2026-10-19
+// - Created.
+// - Flash access goes through the flash service.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include <stdint.h>
+#include "flash.h"
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// DEFINITIONS AND MACROS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#define EVENT_JOURNAL_ADDRESS		(FLASH_PARAM_SECTOR_SIZE*FLASH_CONFIG_SECTORS)
+#define EVENT_RECORD_SIZE			32
+#define EVENT_SLOTS_PER_SECTOR		(FLASH_PARAM_SECTOR_SIZE/EVENT_RECORD_SIZE)
+#define EVENT_JOURNAL_SLOTS			(EVENT_SLOTS_PER_SECTOR*FLASH_EVENT_SECTORS)
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// ENUMS AND ENUM TYPEDEFS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+typedef enum{
+	EVENT_JOURNAL_OK,
+	EVENT_JOURNAL_ERROR
+} eventJournalStatus_t;
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// STRUCTS AND STRUCT TYPEDEFS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+typedef struct{
+
+	uint32_t sequence;				//Counts up with every record, set by event_journal_write().
+	uint32_t time_us;				//hr_timer_now() time of the reading the events came with.
+	uint32_t flight_time;			//ms since launch, 0 before launch.
+	uint8_t events;					//Event bits of a measurement header (DROGUE_DETECT etc.), shifted down by EXT_KIND_SHIFT.
+	uint8_t state;					//Flight state after the events.
+	float altitude;					//m, latest unfiltered altitude.
+	float alt_filtered;				//m
+	uint32_t log_address;			//Flash address the log had reached, to find the same time in the log.
+
+}eventRecord_t;
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// FUNCTION PROTOTYPES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Finds where the next record goes. Only the first record of each sector and a binary search of the current sector
+//	are read, so this is quick enough for a restart in flight. Call once the flash service is initialized.
+//
+// Returns:
+//  EVENT_JOURNAL_OK, or EVENT_JOURNAL_ERROR if the flash could not be read.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+eventJournalStatus_t event_journal_init(void);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Writes a record and waits for it to be programmed. Sets the sequence number of the record.
+//
+// Returns:
+//  EVENT_JOURNAL_OK, or EVENT_JOURNAL_ERROR if the record could not be written.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+eventJournalStatus_t event_journal_write(eventRecord_t * record);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Background erase of the sector after the current one, the same as config_service(). Returns without waiting.
+//	Call regularly while nothing else is using the flash.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void event_journal_service(void);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Erases the whole journal.
+//
+// Returns:
+//  EVENT_JOURNAL_OK, or EVENT_JOURNAL_ERROR if a sector could not be erased.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+eventJournalStatus_t event_journal_erase(void);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Reads a record. Index 0 is the first slot of the oldest sector, so going up to EVENT_JOURNAL_SLOTS-1 gives the
+//	records oldest first.
+//
+// Returns:
+//  EVENT_JOURNAL_OK if the slot holds a good record, EVENT_JOURNAL_ERROR if it is blank or bad.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+eventJournalStatus_t event_journal_read(uint16_t index,eventRecord_t * record);
+
+#endif // EVENT_JOURNAL_H
@@ -12,6 +12,15 @@
 // History
 // 2019-03-28 by Joseph Howarth
 // - Created.
+// 2026-10-19
+// - The first FLASH_CONFIG_SECTORS parameter sectors are kept for the configuration journal.
+// - Added scan_flash_from().
+// - The FLASH_EVENT_SECTORS parameter sectors after the configuration journal are kept for the event journal.
+// - Added suspend_erase() and resume_erase(). FLASH_SECTOR_SIZE is 64 KB, the size erase_sector() erases.
+// - Added read_stream(), a Fast Read of any length into double buffers by DMA.
+// - Added clear_status_reg(), to clear the program and erase error bits.
+// - suspend_erase() gives up after FLASH_SUSPEND_TIMEOUT_US and checks the erase suspend bit. Added get_status_reg2().
+// - read_stream() blocks until each DMA buffer is done, and gives up after FLASH_DMA_TIMEOUT_MS.
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -32,10 +41,15 @@
 #define 	WE_COMMAND				0x06		//Write Enable
 #define		PP_COMMAND				0x02		//Page Program Command (write)
 #define		READ_COMMAND			0x03
+#define		FAST_READ_COMMAND		0x0B		//Followed by the address and one dummy byte.
 #define 	ERASE_SEC_COMMAND		0xD8
 #define 	ERASE_PARAM_SEC_COMMAND 0x20
 #define		GET_STATUS_REG_COMMAND	0x05
 #define		BULK_ERASE_COMMAND		0x60		//Command to erase the whole device.
+#define		ERASE_SUSPEND_COMMAND	0x75
+#define		ERASE_RESUME_COMMAND	0x7A
+#define		CLEAR_STATUS_COMMAND	0x30		//Clears the error bits.
+#define		GET_STATUS_REG2_COMMAND	0x07		//Status register 2, which has the erase suspend bit.
 
 //Constants
 #define		MANUFACTURER_ID			0x01
@@ -48,23 +62,36 @@
 
 #define 	FLASH_PAGE_SIZE			256
 #define 	FLASH_PARAM_SECTOR_SIZE (FLASH_PAGE_SIZE*16)
-#define		FLASH_SECTOR_SIZE		(FLASH_PAGE_SIZE*64)
-#define 	FLASH_START_ADDRESS		(0x00000000+FLASH_PARAM_SECTOR_SIZE)
-#define		FLASH_SIZE_BYTES		(8000000-FLASH_PARAM_SECTOR_SIZE)
+#define		FLASH_SECTOR_SIZE		(FLASH_PAGE_SIZE*256)
+#define		FLASH_CONFIG_SECTORS	4			//Parameter sectors at the start of memory used for the configuration journal.
+#define		FLASH_EVENT_SECTORS		2			//Parameter sectors after the configuration journal used for the flight event journal.
+#define 	FLASH_START_ADDRESS		(0x00000000+(FLASH_PARAM_SECTOR_SIZE*(FLASH_CONFIG_SECTORS+FLASH_EVENT_SECTORS)))
+#define		FLASH_SIZE_BYTES		(8000000-FLASH_START_ADDRESS)
 #define 	FLASH_PARAM_END_ADDRESS (0x0001FFFF)
 #define 	FLASH_END_ADDRESS		(0x7FFFFF)
 
+//Timing
+#define		FLASH_SUSPEND_TIME_US	45			//Longest time from the suspend command until reads and programs can start.
+#define		FLASH_SUSPEND_TIMEOUT_US	200		//Longest wait for the device to stop after the suspend command.
+#define		FLASH_RESUME_RUN_US		100			//Time an erase must run after a resume before it is suspended again.
+
+#define		FLASH_DMA_TIMEOUT_MS	20			//Longest wait for one read_stream() buffer, the 1280 byte download buffers take about 1 ms.
+
+#define		FLASH_DMA_IRQ_PRIORITY	6			//Below configMAX_SYSCALL_INTERRUPT_PRIORITY, notifies the waiting task.
+
 //Status Reg. Bits
 #define 	P_ERR_BIT				0x06		//Programming Error Bit.
 #define		E_ERR_BIT				0x05		//Erase Error Bit.
 #define		WEL_BIT					0x01		//Write Enable Latch Bit.
 #define		WIP_BIT					0x00		//Write In Progress Bit.
+#define		ES_BIT					0x01		//Erase Suspend Bit, in status register 2.
 
 //Macros
 #define		WAS_PROGRAMING_ERROR(x)	((x >> P_ERR_BIT) & 0x01)
 #define		WAS_ERASE_ERROR(x)		((x >> E_ERR_BIT) & 0x01)
 #define		IS_WRITE_ENABLE(x)		((x >> WEL_BIT) & 0x01)
 #define		IS_DEVICE_BUSY(x)		((x >> WIP_BIT) & 0x01)
+#define		IS_ERASE_SUSPENDED(x)	((x >> ES_BIT) & 0x01)
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 // ENUMS AND ENUM TYPEDEFS
@@ -82,6 +109,18 @@ typedef struct {
 
 
 } FlashStruct_t;
+
+//Called with each buffer read by read_stream(). Returns 1 to carry on, 0 to stop the stream.
+typedef uint8_t (*FlashStreamCallback_t)(void * context,uint32_t address,uint8_t * data,uint16_t length);
+
+typedef struct{
+
+	uint8_t * buffers[2];				//Filled in turn, the DMA fills one while the callback has the other.
+	uint16_t buffer_size;
+	FlashStreamCallback_t callback;
+	void * context;
+
+} FlashStream_t;
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 // TYPEDEFS
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -180,6 +219,36 @@ FlashStatus_t 	erase_param_sector(FlashStruct_t * flash,uint32_t address);
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 FlashStatus_t 	erase_device(FlashStruct_t * flash);
 
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  This suspends a sector or parameter sector erase and waits for the device to stop, at most FLASH_SUSPEND_TIME_US
+//	by the data sheet. The wait ends after FLASH_SUSPEND_TIMEOUT_US, and the erase only counts as suspended if the
+//	erase suspend bit is set once the device has stopped.
+//	While the erase is suspended pages outside the sector being erased can be read and programmed. Another erase can
+//	not be started until the erase is resumed.
+//
+// Returns:
+//  Returns FLASH_OK if the erase was suspended, FLASH_ERROR if it had finished or failed (read the status register to
+//	tell which), FLASH_BUSY if the device did not stop in time.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+FlashStatus_t 	suspend_erase(FlashStruct_t * flash);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  This resumes a suspended erase. The device is busy again until the erase finishes.
+//
+// Returns:
+//  Returns FLASH_BUSY if a program is still in progress, FLASH_OK otherwise.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+FlashStatus_t 	resume_erase(FlashStruct_t * flash);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  This clears the program and erase error bits of the status register. After an error the device stays busy and
+//	ignores commands until they are cleared.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void			clear_status_reg(FlashStruct_t * flash);
+
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 // Description:
 //  This returns the status register of teh flash.
@@ -190,6 +259,15 @@ FlashStatus_t 	erase_device(FlashStruct_t * flash);
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 uint8_t get_status_reg(FlashStruct_t * flash);
 
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  This returns status register 2 of the flash, which has the erase suspend bit.
+//
+// Returns:
+//  The status register 2 value (8 bits).
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint8_t get_status_reg2(FlashStruct_t * flash);
+
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 // Description:
 //  This returns the address of the first empty page in memory.
@@ -200,4 +278,38 @@ uint8_t get_status_reg(FlashStruct_t * flash);
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 uint32_t scan_flash(FlashStruct_t * flash);
 
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Same as scan_flash(), but starts at address instead of FLASH_START_ADDRESS.
+//	Used after a reset in flight, when the checkpoint gives an address close to the end of the data.
+//
+// Returns:
+//  The address  (32 bits).
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint32_t scan_flash_from(FlashStruct_t * flash,uint32_t address);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Reads length bytes from address with a single Fast Read command. The data is clocked in by DMA, a buffer at a time,
+//	and each full buffer is passed to the stream callback while the DMA fills the other one. The CS stays low until the
+//	end, so there is no command overhead between buffers. The callback can stop the stream early, the buffer being
+//	filled then is not passed on.
+//	The task blocks until each buffer is done, so the callback should take about as long as a buffer takes to read.
+//	A buffer that takes longer than FLASH_DMA_TIMEOUT_MS is aborted and the CS is raised.
+//
+//	If the device is busy the function exits early and returns FLASH_BUSY.
+//
+// Returns:
+//  FLASH_OK, FLASH_BUSY, or FLASH_ERROR if the DMA could not be started, failed or timed out. read is set to the bytes
+//	passed to the callback.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+FlashStatus_t	read_stream(FlashStruct_t * flash,uint32_t address,uint32_t length,FlashStream_t * stream,uint32_t * read);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Called from DMA2_Stream0_IRQHandler and DMA2_Stream3_IRQHandler, the SPI1 receive and transmit DMA streams.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void flash_dma_rx_irq(void);
+void flash_dma_tx_irq(void);
+
 #endif // TEMPLATE_H
@@ -0,0 +1,223 @@
+#ifndef FLASH_SERVICE_H
+#define FLASH_SERVICE_H
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// UMSATS 2018-2020
+//
+// Repository:
+//  UMSATS/Avionics-2019
+//
+// File Description:
+//  Header file for the flash service task. The service task owns the flash memory, the driver in flash.c is only
+//  called from here. Other modules send it reads, programs and erases. Each request has a class, and each class has
+//  its own queue. The queues are served in class order, so an event record never waits behind log pages, erases or
+//  a download, only behind the request already running.
+//  Programs to consecutive addresses in the same page are merged into one program, and an erase of a sector that is
+//  already queued is done once for both. The time each request waits in its queue is kept for each class.
+//  Before the scheduler starts the requests are run straight away by the caller.
+//
+//  An erase does not hold up the other classes. While it runs, a request that can go ahead suspends it, is done, and
+//  the erase is resumed once nothing else is waiting. Requests for the sector being erased, scans and other erases
+//  wait for it to finish. A resumed erase always runs for FLASH_RESUME_RUN_US before it is suspended again, so it
+//  still finishes when requests keep coming. A suspend only counts once the device shows the erase suspend bit, and if
+//  the device does not stop within FLASH_SUSPEND_TIMEOUT_US, suspending is turned off until the next reset. The
+//  longest time from queuing to finishing of the requests served during an erase is kept for each class, which is the
+//  write latency the logging task sees while the journals are erased.
+//
+//  A stream reads a long range with one Fast Read, through the caller's double buffers, for downloads. The callback
+//  runs in the service task. After each buffer the stream gives way to any waiting request of a higher class, and is
+//  started again from where it stopped once they are done.
+//
+//  The service runs above the sensor tasks, so it never holds the CPU while the flash is busy. The end of a program is
+//  polled every FLASH_POLL_US from a timer wheel timer and the end of an erase every tick, and the task blocks in
+//  between, so the sensor tasks only wait for the SPI transfers themselves.
+//
+//  The service keeps a map of the erase sectors from FLASH_START_ADDRESS that may hold data, so erasing and downloading
+//  can skip the ones that are already blank. A bit is cleared before the first program into its sector and set again
+//  when the sector is erased. The map is kept in the sector at FLASH_MAP_ADDRESS as a list of one page records, the
+//  last complete one being current. Programs clear bits of the current record in place. An erase only sets the bit in
+//  RAM, and flash_map_commit() writes the map as a new record, so until then the sector still counts as used after a
+//  reset. The record is marked complete after its bits are written, and without a complete record every sector counts
+//  as used, so a reset at any point can only make the map say a blank sector is used.
+//
+// History
+// 2026-10-19
+// - Created.
+// - Erases are suspended for the other requests.
+// - Added flash_stream().
+// - Added flash_verify(). Program and erase errors are counted for each class.
+// - Added the map of used sectors.
+// - Added FLASH_POLL_US. The service blocks between status polls instead of spinning.
+// - Suspending is turned off if the device does not stop for it.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include <stdint.h>
+#include "cmsis_os.h"
+#include "flash.h"
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// DEFINITIONS AND MACROS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//Request classes, highest priority first.
+#define FLASH_CLASS_EVENT			0			//Event journal records.
+#define FLASH_CLASS_CONFIG			1			//Configuration journal, which also holds the flight state.
+#define FLASH_CLASS_DATA			2			//Log pages.
+#define FLASH_CLASS_ERASE			3			//Erases that nothing is waiting on.
+#define FLASH_CLASS_READ			4			//Scans and downloads.
+#define FLASH_CLASSES				5
+
+#define FLASH_QUEUE_LENGTH			4			//Requests waiting in each class.
+#define FLASH_MERGE_MAX				4			//Requests done as one.
+#define FLASH_SERVICE_STACK_SIZE	384			//In words. A stream serves the other requests from inside its callback.
+#define FLASH_SERVICE_PRIORITY		3			//Above the logging task, so a request starts as soon as the flash is free.
+#define FLASH_POLL_US				100			//us between status polls while a program runs, about 20 for a page.
+#define FLASH_ERASE_SUSPEND_ENABLED	1			//0 to make every request wait for an erase to finish, to compare the latency.
+
+//Used sector map. The second to last sector is past the end of the log (FLASH_SIZE_BYTES) and before the log index.
+#define FLASH_MAP_ADDRESS			(FLASH_END_ADDRESS+1-2*FLASH_SECTOR_SIZE)
+#define FLASH_MAP_PARAM_SECTORS		((FLASH_PARAM_END_ADDRESS+1-FLASH_START_ADDRESS)/FLASH_PARAM_SECTOR_SIZE)
+#define FLASH_MAP_SECTORS			(FLASH_MAP_PARAM_SECTORS+(FLASH_END_ADDRESS-FLASH_PARAM_END_ADDRESS)/FLASH_SECTOR_SIZE)
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// STRUCTS AND STRUCT TYPEDEFS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+typedef struct{
+
+	uint32_t count;				//Requests served.
+	uint32_t merged;			//Requests done as part of another one.
+	uint64_t wait_total;		//us from being queued to starting.
+	uint32_t wait_max;			//us
+	uint32_t busy_max;			//us from starting to finishing.
+	uint32_t erase_latency_max;	//us from being queued to finishing, for requests served while an erase was running.
+	uint32_t suspends;			//Times an erase of this class was suspended.
+	uint32_t errors;			//Requests that failed, including verifies that did not match.
+
+}flashClassStats_t;
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// FUNCTION PROTOTYPES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Creates the queues and sets the flash the service owns. Call once the flash is initialized, before any other
+//	flash_ function.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void flash_service_init(FlashStruct_t * flash);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  The service task. Takes no parameters.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void vTask_flash_service(void * pvParameters);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Reads from the flash and waits for the data.
+//
+// Returns:
+//  FLASH_OK, or FLASH_ERROR if the request could not be queued.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+FlashStatus_t flash_read(uint8_t flash_class,uint32_t address,uint8_t * data,uint16_t length);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Programs up to a page and waits for the program to finish. The data must not cross a page boundary.
+//
+// Returns:
+//  FLASH_OK, or FLASH_ERROR.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+FlashStatus_t flash_program(uint8_t flash_class,uint32_t address,const uint8_t * data,uint16_t length);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Erases the sector holding address, a 4 KB parameter sector up to FLASH_PARAM_END_ADDRESS and a 64 KB sector after
+//	it. With pending set to NULL it waits for the erase to finish. Otherwise it returns once the erase is queued, sets
+//	*pending to 1, and the service clears it when the erase is done.
+//
+// Returns:
+//  FLASH_OK, or FLASH_ERROR. For a background erase, FLASH_BUSY if the queue is full.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+FlashStatus_t flash_erase(uint8_t flash_class,uint32_t address,volatile uint8_t * pending);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Reads back up to a page and compares it with data. With pending set to NULL it waits for the result. Otherwise it
+//	returns once the verify is queued, sets *pending to 1, and the service sets *result and then clears *pending when
+//	the verify is done. data must stay the same until then.
+//
+// Returns:
+//  FLASH_OK, or FLASH_ERROR if the flash does not hold data. For a background verify, FLASH_BUSY if the queue is full.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+FlashStatus_t flash_verify(uint8_t flash_class,uint32_t address,const uint8_t * data,uint16_t length,volatile uint8_t * pending,FlashStatus_t * result);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Reads length bytes from address through the double buffers of stream and waits until it is done, see read_stream().
+//	The callback is run by the service task, and the stream can be stopped by returning 0 from it. Waits for any erase
+//	to finish first.
+//
+// Returns:
+//  FLASH_OK, or FLASH_ERROR.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+FlashStatus_t flash_stream(uint8_t flash_class,uint32_t address,uint32_t length,FlashStream_t * stream);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Finds the end of the log data at or after address, the same as scan_flash_from().
+//
+// Returns:
+//  The address of the first empty page.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint32_t flash_scan(uint32_t address);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Checks the map for the erase sector holding address.
+//
+// Returns:
+//  1 if the sector may hold data, 0 if it is blank or is not in the map (before FLASH_START_ADDRESS, or the map sector).
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint8_t flash_map_used(uint32_t address);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Finds the first run of used sectors from address on, before end. *range_end is set to the end of the run, at most end.
+//
+// Returns:
+//  The start of the run, address if its sector is used, or end if there is none.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint32_t flash_map_next(uint32_t address,uint32_t end,uint32_t * range_end);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  The number of sectors in the map that may hold data, out of FLASH_MAP_SECTORS.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint16_t flash_map_count(void);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Writes the map as a new record, so the sectors erased since the last one are blank after a reset too. Call after
+//	erasing sectors. When the map sector is full it is erased first. Waits for any erase to finish.
+//
+// Returns:
+//  FLASH_OK, or FLASH_ERROR.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+FlashStatus_t flash_map_commit(void);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Copies the queue statistics of a class.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void flash_service_stats(uint8_t flash_class,flashClassStats_t * stats);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Clears the queue statistics of every class.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void flash_service_reset_stats(void);
+
+#endif // FLASH_SERVICE_H
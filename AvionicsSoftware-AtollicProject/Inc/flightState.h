@@ -0,0 +1,132 @@
+#ifndef FLIGHT_STATE_H
+#define FLIGHT_STATE_H
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// UMSATS 2018-2020
+//
+// Repository:
+//  UMSATS/Avionics-2019
+//
+// File Description:
+//  Header file for the flight state machine (launch, apogee, main and landing detection).
+//  This module only makes decisions. Firing the e-matches, writing the configuration and logging are left to the caller,
+//  so the same code can be run on a host against recorded data (see Tools/flightReplay.c).
+//
+// History
+// 2026-10-19
+// - Created. Detection logic moved out of loggingTask.
+// - flight_state_deployed() only moves the state forward.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include <stdint.h>
+#include "logPacket.h"		//For the event bits.
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// DEFINITIONS AND MACROS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+#define STATE_XTRACT					0x01
+#define STATE_LAUNCHPAD					0x02
+#define STATE_LAUNCHPAD_ARMED			0x03
+#define STATE_IN_FLIGHT_PRE_APOGEE		0x04
+#define STATE_IN_FLIGHT_POST_APOGEE		0x05
+#define STATE_IN_FLIGHT_POST_MAIN		0x06
+#define STATE_LANDED					0x07
+
+//Macros to get flags.
+#define IS_IN_FLIGHT(x)		((x>>0)&0x01)
+#define	IS_RECORDING(x)		((x>>1)&0x01)
+#define IS_PRE_DROGUE(x)	((x>>2)&0x01)
+#define IS_POST_DROGUE(x)	((x>>3)&0x01)
+#define IS_POST_MAIN(x)		((x>>4)&0x01)
+
+//Flag bits set by the state machine.
+#define FLAG_IN_FLIGHT		0x01
+#define FLAG_RECORDING		0x02
+#define FLAG_PRE_DROGUE		0x04
+#define FLAG_POST_DROGUE	0x08
+#define FLAG_POST_MAIN		0x10
+
+//Detection thresholds.
+#define LAUNCH_ACC_THRESHOLD		10892		//Raw accelerometer x reading (~4g at 12g range).
+#define APOGEE_HOLDOUT_SAMPLES		(20*15)		//Samples after launch before apogee detection is allowed.
+#define APOGEE_MIN_ALTITUDE			9000.0		//2438m -> 8,000 ft
+#define MAIN_ALTITUDE				375.0		//375m ==  1230 ft
+#define MAIN_ALTITUDE_SAMPLES		5			//Consecutive samples below MAIN_ALTITUDE before main deploys.
+#define LANDED_ALTITUDE_WINDOW		1.0			//Altitude must stay within +/- this many meters.
+#define LANDED_ALTITUDE_SAMPLES		200			//Number of samples the altitude must stay in the window.
+#define LANDED_GYRO_THRESHOLD		63075		//Sum of squared gyro readings (~4.4 deg/sec).
+#define ALTITUDE_FILTER_GAIN		0.2
+
+//Backup timer, started at launch detection.
+#define BACKUP_DROGUE_TIME			30000		//ms after launch.
+#define BACKUP_BEEP_TIME			250			//ms, the timer beeps twice after the drogue.
+#define BACKUP_MAIN_TIME			155000		//ms after the drogue beeps.
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// STRUCTS AND STRUCT TYPEDEFS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+typedef struct{
+
+	uint8_t * state;					//Points at the state in the flight computer configuration.
+	uint8_t * flags;					//Points at the flags in the flight computer configuration.
+
+	float altitude;						//Most recent unfiltered altitude.
+	float alt_filtered;
+	float alt_prev;
+	uint8_t alt_count;
+	uint8_t alt_main_count;
+	uint16_t apogee_holdout_count;
+
+}flightState_t;
+
+typedef struct{
+
+	int16_t acc[3];
+	int16_t gyro[3];
+	float altitude;
+
+}flightSample_t;
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// FUNCTION PROTOTYPES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Approximates the altitude in meters from a pressure in 0.01 Pa and a temperature in 0.01 deg C.
+//	ref_pres is the ground pressure in Pa and ref_alt the ground altitude in meters.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+float pressure_altitude(float pressure,float temperature,float ref_pres,float ref_alt);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Resets the detection counters and points the state machine at the configuration state and flags.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void flight_state_init(flightState_t * fs,uint8_t * state,uint8_t * flags);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Runs the launch, landing, main and apogee checks on a new sample, in that order.
+//	Launch and landing change the state immediately. Main and apogee only report the detection, the caller must
+//	fire the e-match and call flight_state_deployed() once the deployment is confirmed.
+//
+// Returns:
+//  The event bits detected with this sample (LAUNCH_DETECT, LAND_DETECT, MAIN_DETECT, DROGUE_DETECT), or 0.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint32_t flight_state_update(flightState_t * fs,const flightSample_t * sample);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Moves to the next state after a deployment has been confirmed. event is either MAIN_DETECT or DROGUE_DETECT.
+//	The state never goes back, so a drogue confirmed after the main only sets the flag.
+//
+// Returns:
+//  The matching deploy event bit (MAIN_DEPLOY or DROGUE_DEPLOY).
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint32_t flight_state_deployed(flightState_t * fs,uint32_t event);
+
+#endif // FLIGHT_STATE_H
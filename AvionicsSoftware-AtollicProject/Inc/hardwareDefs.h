@@ -12,6 +12,8 @@
 // History
 // 2019-03-27 by Joseph Howarth
 // - Created.
+// 2026-10-19
+// - Added the radio UART pins.
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -49,6 +51,13 @@
 #define UART_RX_PIN				GPIO_PIN_12
 #define UART_RX_PORT			GPIOA
 
+//UART 1 to the radio modem, on the JTAG pins, which are free when debugging over SWD.
+#define RADIO_UART_TX_PIN		GPIO_PIN_15
+#define RADIO_UART_TX_PORT		GPIOA
+
+#define RADIO_UART_RX_PIN		GPIO_PIN_3
+#define RADIO_UART_RX_PORT		GPIOB
+
 //Flash Memory on SPI1
 
 #define FLASH_SPI_PORT			GPIOA
@@ -0,0 +1,47 @@
+#ifndef HR_TIMER_H
+#define HR_TIMER_H
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// UMSATS 2018-2020
+//
+// Repository:
+//  UMSATS/Avionics-2019
+//
+// File Description:
+//  Header file for the high resolution timer. TIM5 is used as a free running 32 bit counter at 1 MHz, it wraps around
+//  about every 71 minutes. FreeRTOS uses it for the run time statistics.
+//
+// History
+// 2026-10-19
+// - Created.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include <stdint.h>
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// DEFINITIONS AND MACROS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#define HR_TIMER_FREQ	1000000		//In hertz.
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// FUNCTION PROTOTYPES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Starts TIM5 counting up from 0. Does nothing if it is already running.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void hr_timer_init(void);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Reads the timer.
+//
+// Returns:
+//  The time since hr_timer_init() in microseconds. Use unsigned subtraction for intervals so the wrap around does not matter.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint32_t hr_timer_now(void);
+
+#endif // HR_TIMER_H
@@ -0,0 +1,66 @@
+#ifndef LIVE_STREAM_H
+#define LIVE_STREAM_H
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// UMSATS 2018-2020
+//
+// Repository:
+//  UMSATS/Avionics-2019
+//
+// File Description:
+//  Header file for the live sensor stream. When the flight computer is set not to record, the logging task sends every
+//  reading at the full sensor rate over the xtract UART in the records of streamFrame.h, for checkout on the bench and
+//  the pad with Tools/streamView.c. The records wait in a queue that DMA sends from, so the logging task never waits
+//  for the UART. A record that does not fit in the queue is dropped and counted, and a stats record with the counts is
+//  sent every LIVE_STREAM_STATS_PERIOD ms.
+//  The UART must be USART6 (DMA2 stream 6 channel 5). DMA2_Stream6_IRQHandler must call live_stream_dma_irq() and
+//  USART6_IRQHandler live_stream_uart_irq() (stm32f4xx_it.c).
+//
+// History
+// 2026-10-19
+// - Created.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include <stdint.h>
+#include "stm32f4xx_hal.h"
+#include "eventCapture.h"
+#include "streamFrame.h"
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// DEFINITIONS AND MACROS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//A reading of both IMU sensors is 24 bytes on the wire and a BMP388 reading 20. At the fastest sensor rates
+//(ACQ_MAX_IMU_RATE and ACQ_MAX_BMP_RATE) that is about 52000 bytes/s, 56% of the link. At 115200 baud the default
+//rates fit, but not more than about 450 IMU readings a second.
+#define LIVE_STREAM_BAUD_RATE		921600
+#define LIVE_STREAM_STATS_PERIOD	1000		//ms between stats records.
+#define LIVE_STREAM_IRQ_PRIORITY	6			//Held off by critical sections, does not use any FreeRTOS calls.
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// FUNCTION PROTOTYPES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Sets the UART to LIVE_STREAM_BAUD_RATE, sets up its DMA and clears the queue. Called by the logging task before the
+//	first reading. Nothing else may use the UART after this.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void live_stream_start(UART_HandleTypeDef * huart);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Queues a reading, and a stats record when one is due. events are the event bits of the reading, as in the log.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void live_stream_reading(const captureReading_t * reading,uint32_t events);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Called from the interrupt handlers of the DMA stream and the UART.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void live_stream_dma_irq(void);
+void live_stream_uart_irq(void);
+
+#endif // LIVE_STREAM_H
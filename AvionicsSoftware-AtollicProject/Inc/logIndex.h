@@ -0,0 +1,115 @@
+#ifndef LOG_INDEX_H
+#define LOG_INDEX_H
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// UMSATS 2018-2020
+//
+// Repository:
+//  UMSATS/Avionics-2019
+//
+// File Description:
+//  Header file for the log index, which moves log pages that could not be programmed to spare pages. The last sector of
+//  the flash, above the end of the log, holds a table of remapped log addresses followed by the spare pages. Entry n
+//  of the table is the log address whose data is in spare page n, so the table only grows and nothing is erased in
+//  flight. When a log page fails its verify the same data is written to the next spare page and the entry is added.
+//  Reading the log back, a remapped page is read from its spare page instead, the last entry for an address winning.
+//
+//  The entry is programmed before the spare page, so a reset between the two leaves an entry pointing at a blank
+//  spare page and never a used spare page without an entry.
+//
+// History
+// 2026-10-19
+// - Created.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include <stdint.h>
+#include "flash.h"
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// DEFINITIONS AND MACROS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#define LOG_INDEX_ADDRESS			(FLASH_END_ADDRESS+1-FLASH_SECTOR_SIZE)		//Last sector, past FLASH_SIZE_BYTES.
+#define LOG_INDEX_ENTRY_SIZE		4
+#define LOG_INDEX_PAGES				4											//Pages of the table.
+#define LOG_SPARE_ADDRESS			(LOG_INDEX_ADDRESS+(LOG_INDEX_PAGES*FLASH_PAGE_SIZE))
+#define LOG_SPARE_PAGES				((FLASH_SECTOR_SIZE/FLASH_PAGE_SIZE)-LOG_INDEX_PAGES)
+
+#define LOG_VERIFY_ENABLED			1			//0 to write log pages without reading them back.
+#define LOG_VERIFY_RETRIES			1			//Programs of the same page before it is remapped.
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// ENUMS AND ENUM TYPEDEFS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+typedef enum{
+	LOG_INDEX_OK,
+	LOG_INDEX_ERROR
+} logIndexStatus_t;
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// FUNCTION PROTOTYPES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Reads the table into RAM. Call once the flash service is initialized, and again after the flash is erased.
+//
+// Returns:
+//  LOG_INDEX_OK, or LOG_INDEX_ERROR if the flash could not be read.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+logIndexStatus_t log_index_init(void);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Writes a page of log data to the next spare page and adds it to the table. A spare page that fails its verify is
+//	left and the next one is tried.
+//
+// Returns:
+//  The address of the spare page, or 0 if there are no spare pages left.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint32_t log_index_remap(uint32_t address,const uint8_t * page);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Finds where the data of a log page is.
+//
+// Returns:
+//  The spare page holding it if the page was remapped, otherwise the page address.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint32_t log_index_lookup(uint32_t address);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Finds the first remapped log page at or after address.
+//
+// Returns:
+//  Its address, or 0xFFFFFFFF if there is none.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint32_t log_index_next(uint32_t address);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Erases the table and the spare pages.
+//
+// Returns:
+//  LOG_INDEX_OK, or LOG_INDEX_ERROR if the sector could not be erased.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+logIndexStatus_t log_index_erase(void);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  The number of entries in the table, the same as the spare pages used.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint16_t log_index_count(void);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Entry n of the table.
+//
+// Returns:
+//  The log address whose data is in spare page n, which is at LOG_SPARE_ADDRESS+n*FLASH_PAGE_SIZE.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint32_t log_index_entry(uint16_t n);
+
+#endif // LOG_INDEX_H
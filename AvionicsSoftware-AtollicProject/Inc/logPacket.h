@@ -0,0 +1,311 @@
+#ifndef LOG_PACKET_H
+#define LOG_PACKET_H
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// UMSATS 2018-2020
+//
+// Repository:
+//  UMSATS/Avionics-2019
+//
+// File Description:
+//  Header file for the flight log packet encoder and page writer.
+//  This module has no HAL or FreeRTOS dependencies so the exact same encoding can be run on a host
+//  (see Tools/flightReplay.c).
+//
+// History
+// 2026-10-19
+// - Created. Packet encoding and page buffering moved out of dataLogging.c.
+// - Added log_packet_begin() and the single sensor functions for mixed rate measurements.
+// - The time field holds a microsecond delta with a scale, and sync records hold the full time.
+// - Added the event capture records.
+// - Every page ends with a CRC-32 of the data before it.
+// - Every page starts with a header holding its sequence number and where the first packet in it starts, so a reader
+//   can start at any page.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include <stdint.h>
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// DEFINITIONS AND MACROS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#define LOG_PAGE_SIZE		256						//Matches flash memory page size.
+#define LOG_PAGE_HEADER_SIZE	4					//Format, sequence number and first packet offset at the start of every page.
+#define LOG_PAGE_CRC_SIZE	4						//CRC-32 at the end of every page, see crc.h.
+#define LOG_PAGE_DATA_SIZE	(LOG_PAGE_SIZE-LOG_PAGE_HEADER_SIZE-LOG_PAGE_CRC_SIZE)	//Packet bytes in a page.
+#define LOG_PAGE_CRC_OFFSET	(LOG_PAGE_SIZE-LOG_PAGE_CRC_SIZE)
+
+#define LOG_PAGE_FORMAT		0x01					//First byte of every page.
+#define LOG_PAGE_NO_PACKET	0xFF					//First packet offset of a page that no packet starts in.
+#define LOG_PAD_PAGES		25						//Number of pages kept in RAM while on the launch pad.
+
+#define ACC_TYPE 			0x800000
+#define GYRO_TYPE			0x400000
+#define PRES_TYPE			0x200000
+#define	TEMP_TYPE			0x100000
+
+#define DROGUE_DETECT		0x080000
+#define DROGUE_DEPLOY		0x040000
+
+#define MAIN_DETECT			0x020000
+#define MAIN_DEPLOY			0x010000
+
+#define LAUNCH_DETECT		0x008000
+#define LAND_DETECT			0x004000
+
+#define POWER_FAIL			0x002000
+#define	OVERCURRENT_EVENT	0x001000
+
+#define TYPE_MASK			0xF00000
+#define EVENT_MASK			0x0FF000
+#define DELTA_T_MASK		0x000FFF
+
+#define	ACC_LENGTH	6		//Length of a accelerometer measurement in bytes.
+#define	GYRO_LENGTH	6		//Length of a gyroscope measurement in bytes.
+#define	PRES_LENGTH	3		//Length of a pressure measurement in bytes.
+#define	TEMP_LENGTH	3		//Length of a temperature measurement in bytes.
+#define ALT_LENGTH  4
+#define HEADER_SIZE 3
+
+#define MEASUREMENT_MAX_SIZE	(HEADER_SIZE+ACC_LENGTH+GYRO_LENGTH+PRES_LENGTH+TEMP_LENGTH+ALT_LENGTH)
+
+//Extended records have no type bits set. The event bits hold the record kind and the time bits the payload length.
+#define EXT_KIND_MASK		0x0FF000
+#define EXT_KIND_SHIFT		12
+#define EXT_LENGTH_MASK		0x000FFF
+#define EXT_MAX_PAYLOAD		240
+
+#define EXT_KIND_PROFILE	0x01		//Profiling zone statistics, see profiler.h.
+#define EXT_KIND_TASKS		0x02		//CPU share and stack high water mark of each task, see taskMonitor.h.
+#define EXT_KIND_RESTART	0x03		//Logging carried on from a checkpoint after a reset in flight, see restart.h.
+#define EXT_KIND_PYRO		0x04		//Result of an e-match pulse, see recovery.h.
+#define EXT_KIND_SYNC		0x05		//Full 32 bit microsecond time of the next measurement.
+#define EXT_KIND_CAPTURE	0x06		//Start of an event capture window at full rate, see eventCapture.h.
+#define EXT_KIND_CAPTURE_END	0x07	//End of an event capture window.
+
+//The 12 time bits of a measurement are a 2 bit scale and a 10 bit count. The count is in units of 1, 8, 64 or 512 us,
+//so 2 kHz readings are exact and gaps up to about half a second still fit.
+#define TIME_SCALE_SHIFT	10
+#define TIME_COUNT_MASK		0x3FF
+#define TIME_SCALE_BITS		3			//Each scale is 8 times the one before.
+#define TIME_MAX_SCALE		3
+#define TIME_MAX_DELTA		((uint32_t)TIME_COUNT_MASK << (TIME_MAX_SCALE*TIME_SCALE_BITS))	//us
+
+#define SYNC_PERIOD			1000000		//us between sync records, so a reader can pick up the time again after bad data.
+#define SYNC_LENGTH			4
+#define SYNC_RECORD_SIZE	(HEADER_SIZE+SYNC_LENGTH)
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// ENUMS AND ENUM TYPEDEFS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+typedef enum{
+
+	BUFFER_A = 0,
+	BUFFER_B = 1
+
+} BufferSelection_t;
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// STRUCTS AND STRUCT TYPEDEFS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+typedef struct{
+
+			uint8_t  data[MEASUREMENT_MAX_SIZE];
+
+}Measurement_t;
+
+//Called with every full page. The page is only valid for the duration of the call.
+typedef void (*logPageHandler_t)(void * context, uint8_t * page);
+
+typedef struct{
+
+	uint8_t buffers[2][LOG_PAGE_SIZE];			//Pages being filled while the previous one is written to flash.
+	BufferSelection_t buffer_selection;
+	uint16_t buffer_index;						//The current index in the packet bytes of the selected page.
+	uint16_t page_sequence;						//Sequence number of the selected page.
+	uint8_t first_packet;						//Offset of the first packet in the selected page, LOG_PAGE_NO_PACKET until one starts.
+
+	uint8_t pad_buffer[LOG_PAGE_SIZE*LOG_PAD_PAGES];	//Holds the most recent packets while on the launch pad.
+	uint16_t pad_tail;							//Start of the oldest complete packet in the pad buffer.
+	uint16_t pad_used;							//Number of bytes in the pad buffer.
+
+	logPageHandler_t page_handler;
+	void * page_handler_context;
+
+}LogWriter_t;
+
+//Time of the measurements written so far, as a reader works it out from the deltas.
+typedef struct{
+
+	uint32_t time;						//us, time of the last measurement. Rounding in the deltas is carried into the next one.
+	uint32_t sync_time;					//us, time of the last sync record.
+	uint8_t synced;						//0 until the first sync record.
+
+}LogClock_t;
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// FUNCTION PROTOTYPES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Clears a measurement. An empty measurement has a length of 0.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void log_packet_clear(Measurement_t * measurement);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Starts a new measurement with no readings. delta_t is the time field from log_clock_stamp().
+//	Readings are then added in the order they are stored: accelerometer, gyroscope, pressure. Any of them can be left out,
+//	so each sensor can be logged at its own rate.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void log_packet_begin(Measurement_t * measurement,uint16_t delta_t);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Adds an accelerometer reading. Must come before any other reading.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void log_packet_add_acc(Measurement_t * measurement,const int16_t acc[3]);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Adds a gyroscope reading, after the accelerometer if there is one.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void log_packet_add_gyro(Measurement_t * measurement,const int16_t gyro[3]);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Starts a new measurement with an accelerometer and gyroscope reading. delta_t is the time field from log_clock_stamp().
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void log_packet_set_imu(Measurement_t * measurement,uint16_t delta_t,const int16_t acc[3],const int16_t gyro[3]);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Adds a pressure, temperature and altitude reading, after any IMU readings in the measurement.
+//	Pressure and temperature are stored as 24 bit values, the altitude as the raw bits of a float.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void log_packet_set_pres(Measurement_t * measurement,uint32_t pressure,uint32_t temperature,uint32_t altitude_bits);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  ORs event bits (DROGUE_DETECT, LAUNCH_DETECT etc.) into the header of a measurement.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void log_packet_add_event(Measurement_t * measurement,uint32_t events);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Reads the 24 bit header from the first HEADER_SIZE bytes of a packet.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint32_t log_packet_header(const uint8_t * packet);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Finds the total length of a packet from the type bits of its header.
+//
+// Returns:
+//  The packet length including the header, or 0 if the header is not valid.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint8_t log_packet_length(uint32_t header);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Builds an extended record (header with no type bits, then the payload) in dest.
+//	dest must hold HEADER_SIZE+length bytes. Extended records do not advance the time.
+//
+// Returns:
+//  The record length, or 0 if the kind is 0 or the payload is longer than EXT_MAX_PAYLOAD.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint8_t log_packet_ext(uint8_t * dest,uint8_t kind,const uint8_t * payload,uint8_t length);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Sets up a clock with no time. The first measurement stamped gets a sync record.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void log_clock_init(LogClock_t * clock);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Works out the time field of the next measurement, taken at time_us (hr_timer_now() time). A sync record is needed
+//	first when the clock has not been synced, every SYNC_PERIOD, and when the gap is too long (or negative) for a delta.
+//	It is built in sync_record, which must hold SYNC_RECORD_SIZE bytes, and the time field is then 0.
+//
+// Returns:
+//  The length of the sync record to write before the measurement, or 0 if there is none.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint8_t log_clock_stamp(LogClock_t * clock,uint32_t time_us,uint16_t * delta_t,uint8_t * sync_record);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Reads the time since the previous measurement from a measurement header.
+//
+// Returns:
+//  The delta in microseconds.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint32_t log_packet_delta_us(uint32_t header);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Reads the time from a sync record, including its header.
+//
+// Returns:
+//  The time of the next measurement in microseconds.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint32_t log_packet_sync_time(const uint8_t * record);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Sets up a page writer with empty buffers. The handler is called each time a page is filled. sequence is the sequence
+//	number of the first page, the number of pages already in the log when carrying on after a reset.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void log_writer_init(LogWriter_t * writer,logPageHandler_t handler,void * context,uint16_t sequence);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Appends a packet to the page stream. data must be one whole packet, so the page header can say where packets start.
+//	Packets are split across pages when they do not fit. The header and the CRC are added to each page as it fills,
+//	before it goes to the handler.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void log_writer_append(LogWriter_t * writer,const uint8_t * data,uint16_t length);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Adds a packet to the launch pad buffer. When the buffer is full the oldest packets are dropped.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void log_writer_append_pad(LogWriter_t * writer,const uint8_t * data,uint16_t length);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Moves everything in the launch pad buffer into the page stream, oldest packet first.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void log_writer_flush_pad(LogWriter_t * writer);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Checks the CRC at the end of a page, which covers the header and the packet bytes.
+//
+// Returns:
+//  1 if it matches the data, 0 if not.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint8_t log_page_check(const uint8_t * page);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Reads the sequence number from the header of a page. Pages are numbered from 0 at FLASH_START_ADDRESS, so a page
+//	that is not where its number says is left over from an earlier log or was moved.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint16_t log_page_sequence(const uint8_t * page);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Reads where the first packet starting in a page is, from the header. A reader that starts at this page, or that
+//	skipped a bad page before it, starts here. The bytes before it are the end of a packet from the page before.
+//
+// Returns:
+//  The offset in the packet bytes of the page (from LOG_PAGE_HEADER_SIZE), or LOG_PAGE_NO_PACKET.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint8_t log_page_first_packet(const uint8_t * page);
+
+#endif // LOG_PACKET_H
@@ -0,0 +1,130 @@
+#ifndef LOG_RATE_H
+#define LOG_RATE_H
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// UMSATS 2018-2020
+//
+// Repository:
+//  UMSATS/Avionics-2019
+//
+// File Description:
+//  Header file for the flight phase logging rates. Each phase of the flight (on the pad, ascent, drogue descent and
+//  main descent) has its own rate for the log, set in the configuration. The sensors are still read at their own rates
+//  and the flight state machine sees every reading. Only what goes to flash is reduced, by averaging blocks of readings
+//  rather than dropping them, so the log keeps the noise filtering of the full rate.
+//  This module has no HAL or FreeRTOS dependencies.
+//
+// History
+// 2026-10-19
+// - Created.
+// - The flash use includes the page CRC.
+// - The flash use includes the page header.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include <stdint.h>
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// DEFINITIONS AND MACROS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#define LOG_PHASE_PAD			0			//Armed on the launch pad, and any state that is not in flight.
+#define LOG_PHASE_ASCENT		1			//Boost and coast, up to apogee.
+#define LOG_PHASE_DROGUE		2			//After apogee, under the drogue.
+#define LOG_PHASE_MAIN			3			//After the main is deployed.
+#define LOG_PHASES				4
+
+#define LOG_RATE_MAX			2000		//Hz. A rate of 0 logs every reading.
+
+//Phase lengths used for the capacity projection, in seconds.
+#define PROJECTION_ASCENT_TIME	30			//Same as the backup drogue timer.
+#define PROJECTION_DROGUE_TIME	155			//Same as the backup main timer.
+#define PROJECTION_MAIN_TIME	600
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// STRUCTS AND STRUCT TYPEDEFS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//Running sum of a block of readings.
+typedef struct{
+
+	int64_t sum[3];
+	uint16_t count;
+	uint16_t factor;			//Readings in each block.
+
+}logMean_t;
+
+typedef struct{
+
+	uint32_t period[3];			//us between readings of the accelerometer, gyroscope and BMP388.
+	logMean_t acc;
+	logMean_t gyro;
+	logMean_t bmp;				//Pressure and temperature.
+	uint8_t phase;
+
+}logRate_t;
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// FUNCTION PROTOTYPES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Finds the logging phase of a flight state (STATE_ in flightState.h).
+//
+// Returns:
+//  One of the LOG_PHASE_ values.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint8_t log_rate_phase(uint8_t state);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Finds how many readings go in each logged average.
+//
+// Returns:
+//  The sample rate over the log rate, rounded, and at least 1.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint16_t log_rate_factor(uint32_t sample_period_us,uint16_t log_rate);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Sets up the averages with nothing in them. The periods are the time between readings of the accelerometer, gyroscope
+//	and BMP388 in microseconds. log_rate_set() must be called before adding readings.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void log_rate_init(logRate_t * lr,const uint32_t period_us[3]);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Sets the phase and its log rate. A block that is part way through is finished at the new size.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void log_rate_set(logRate_t * lr,uint8_t phase,uint16_t log_rate);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Adds an accelerometer or gyroscope reading. With force set, a block that is not full is logged anyway, so
+//	a measurement can be written with the flight events.
+//
+// Returns:
+//  1 with the average of the block in out when it is time to log it, 0 otherwise.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint8_t log_rate_add_acc(logRate_t * lr,const int16_t in[3],int16_t out[3],uint8_t force);
+uint8_t log_rate_add_gyro(logRate_t * lr,const int16_t in[3],int16_t out[3],uint8_t force);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Same as log_rate_add_acc() for a pressure and temperature reading.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint8_t log_rate_add_bmp(logRate_t * lr,uint32_t pressure,int32_t temperature,uint32_t * pressure_out,int32_t * temperature_out,uint8_t force);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Estimates the flash used per second of a phase, from the packet sizes in logPacket.h. Accelerometer and gyroscope
+//	readings at the same rate share a packet, the BMP388 readings are out of phase so they have their own. Includes the
+//	header and CRC of each page.
+//
+// Returns:
+//  Bytes per second.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint32_t log_rate_bytes_per_second(const uint32_t period_us[3],uint16_t log_rate);
+
+#endif // LOG_RATE_H
@@ -13,6 +13,8 @@
 // History
 // 2019-03-04 Eric Kapilik
 // - Created.
+// 2026-10-19
+// - The task sends sensorReading_t readings.
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -57,7 +59,7 @@ typedef struct {
 typedef struct{
 
 	UART_HandleTypeDef * huart;
-	QueueHandle_t	bmp388_queue;
+	QueueHandle_t	bmp388_queue;	//Gets sensorReading_t readings.
 	configData_t *flightCompConfig;
 
 } PressureTaskParams;
@@ -0,0 +1,130 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// UMSATS 2018-2020
+//
+// Repository:
+//  UMSATS/Avionics-2019
+//
+// File Description:
+//  Header file for the hot path profiler. Zones are timed with the DWT cycle counter and the results kept in a static
+//  table, one entry per zone. Build with PROFILING_ENABLED set to 1 to use it, otherwise the zones compile to nothing.
+//
+// History
+// 2026-10-19
+// - Created.
+// - Added the event journal zone.
+// - Added the summary log zone.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include <stdint.h>
+#include "stm32f4xx_hal.h"		//For the DWT registers.
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// DEFINITIONS AND MACROS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#ifndef PROFILING_ENABLED
+#define PROFILING_ENABLED		0
+#endif
+
+#define PROFILING_LOG_PERIOD	10000	//Time between profile records in the flight log in ms. 0 to not log them.
+
+#define PROFILE_HIST_BINS		20
+#define PROFILE_HIST_SHIFT		6		//Bin 0 holds everything under 2^(SHIFT+1) cycles, each bin after that doubles.
+
+//Size of the extended log record built by profile_log_payload().
+#define PROFILE_RECORD_ZONE_SIZE	17
+#define PROFILE_RECORD_SIZE			(PROFILE_RECORD_ZONE_SIZE*PROFILE_ZONE_COUNT)
+
+#if PROFILING_ENABLED
+
+//Both must be used in the same block. Zones can nest but not overlap.
+#define PROFILE_BEGIN(zone)		uint32_t profile_start_##zone = DWT->CYCCNT
+#define PROFILE_END(zone)		profile_record(zone,DWT->CYCCNT - profile_start_##zone)
+
+#else
+
+#define PROFILE_BEGIN(zone)
+#define PROFILE_END(zone)
+
+#endif
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// ENUMS AND ENUM TYPEDEFS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+typedef enum{
+
+	PROFILE_PACKET_ENCODE = 0,	//Building a log packet from the IMU and BMP readings.
+	PROFILE_ALTITUDE,			//altitude_approx()
+	PROFILE_PROGRAM_PAGE,		//program_page(), including the status register read.
+	PROFILE_IMU_READ,			//Accelerometer and gyroscope SPI reads in vTask_sensorAG.
+	PROFILE_BMP_READ,			//Pressure and temperature SPI read in vTask_pressure_sensor_bmp3.
+	PROFILE_FLIGHT_STATE,		//Launch, apogee, main and landing checks.
+	PROFILE_EVENT_JOURNAL,		//Writing an event journal record, from the event to the record being in flash.
+	PROFILE_SUMMARY_LOG,		//summary_log_service(), programming a double word of the internal flash.
+
+	PROFILE_ZONE_COUNT
+
+} profileZone_t;
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// STRUCTS AND STRUCT TYPEDEFS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+typedef struct{
+
+	uint32_t count;
+	uint32_t min;							//In cycles.
+	uint32_t max;
+	uint64_t total;							//Used for the mean.
+	uint32_t histogram[PROFILE_HIST_BINS];
+
+}profileStats_t;
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// FUNCTION PROTOTYPES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Turns on the DWT cycle counter and clears the statistics. Call once after HAL_Init().
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void profile_init(void);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Adds one measurement to a zone. Safe to call from any task, and before the scheduler is started.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void profile_record(profileZone_t zone,uint32_t cycles);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Clears the statistics for all zones.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void profile_reset(void);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Copies the statistics of a zone into stats, so they can be printed without holding off the zones.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void profile_get(profileZone_t zone,profileStats_t * stats);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Short name of a zone for printing.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+const char * profile_zone_name(profileZone_t zone);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Fills payload with the count, min, max and mean of every zone, for an EXT_KIND_PROFILE log record.
+//	Each zone is the zone number followed by the four values as big endian 32 bit integers.
+//
+// Returns:
+//  The payload length, PROFILE_RECORD_SIZE.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint8_t profile_log_payload(uint8_t * payload);
+
+#endif // PROFILER_H
@@ -11,6 +11,9 @@
 // History
 // 2019-05-29 by Joseph Howarth
 // - Created.
+// 2026-10-19
+// - activate_mosfet() returns right away. The pulse is timed by TIM9 (drogue) or TIM11 (main) and the results are
+//   reported as events, see pyro_get_event().
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 #ifndef RECOVERY_H
 #define RECOVERY_H
@@ -23,7 +26,16 @@
 // DEFINITIONS AND MACROS
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 
-#define EMATCH_ON_TIME		50
+#define EMATCH_ON_TIME		50								//ms
+#define EMATCH_ON_TIME_US	((uint32_t)EMATCH_ON_TIME*1000)		//Pulse width in us, at most 65536.
+
+#define PYRO_EVENT_QUEUE_LENGTH		8
+
+//Payload of the EXT_KIND_PYRO log record.
+#define PYRO_RECORD_SIZE			7
+//Above configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY so kernel critical sections do not hold off the end of the pulse.
+//The handler must not call FreeRTOS.
+#define PYRO_IRQ_PRIORITY			1
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 // ENUMS AND ENUM TYPEDEFS
@@ -46,9 +58,26 @@ typedef enum{
 	NO_OVERCURRENT,
 	OVERCURRENT
 }overcurrentStatus_t;
+
+typedef enum{
+
+	PYRO_OK,
+	PYRO_BUSY,			//The channel is already firing.
+	PYRO_ERROR
+}pyroStatus_t;
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 // STRUCTS AND STRUCT TYPEDEFS
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
+//The result of one pulse.
+typedef struct{
+
+	recoverySelect_t channel;
+	continuityStatus_t continuity;		//Read after the pulse. OPEN_CIRCUIT if the e-match fired.
+	overcurrentStatus_t overcurrent;	//Read at the end of the pulse.
+	uint32_t pulse_width;				//Measured in us.
+	uint32_t time;						//hr_timer_now() at the end of the pulse.
+
+}pyroEvent_t;
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 // TYPEDEFS
@@ -83,14 +112,48 @@ void enable_mosfet(recoverySelect_t recov_event);
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 // Description:
-//  Activates the mosfet driver for the specified recovery event.
-//	The driver will be activated for the number of ms specified by the constant EMATCH_ON_TIME.
-//  The driver will be disabled after and must be re-enabled be fore every call of this function.
+//  Activates the mosfet driver for the specified recovery event and returns right away.
+//	The driver is activated for EMATCH_ON_TIME_US, timed by the channel's timer, and then disabled. It must be
+//	re-enabled before every call of this function. When the pulse ends a pyroEvent_t is queued, see pyro_get_event().
+//
+// Returns:
+//	PYRO_OK if the pulse was started, PYRO_BUSY if the channel is still firing, PYRO_ERROR for a bad channel.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+pyroStatus_t activate_mosfet(recoverySelect_t recov_event);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Takes the oldest pulse result off the event queue. Does not block.
+//
+// Returns:
+//	1 if there was an event, 0 otherwise.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint8_t pyro_get_event(pyroEvent_t * event);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Checks if a pulse is in progress on the specified recovery circuit.
 //
 // Returns:
+//	1 while firing, 0 otherwise.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint8_t pyro_busy(recoverySelect_t recov_event);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Ends the pulse and queues the result. Called from the TIM9 (drogue) and TIM11 (main) interrupts.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void pyro_irq(recoverySelect_t recov_event);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Fills payload with the channel, continuity and overcurrent (1 byte each) and the measured pulse width in us
+//	(big endian), for an EXT_KIND_PYRO log record.
 //
+// Returns:
+//  The payload length, PYRO_RECORD_SIZE.
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
-void activate_mosfet(recoverySelect_t recov_event);
+uint8_t pyro_log_payload(uint8_t * payload,const pyroEvent_t * event);
 
 
 
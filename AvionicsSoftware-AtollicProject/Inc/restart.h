@@ -0,0 +1,80 @@
+#ifndef RESTART_H
+#define RESTART_H
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// UMSATS 2018-2020
+//
+// Repository:
+//  UMSATS/Avionics-2019
+//
+// File Description:
+//  Header file for warm restarts. Checkpoints are kept in the RTC backup registers, which keep their contents through
+//  a reset, a brownout or a watchdog, and are written in a few microseconds so they can be saved often without touching
+//  the flash. There are two copies written in turn, so a reset in the middle of a save leaves the other one.
+//
+// History
+// 2026-10-19
+// - Created.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include <stdint.h>
+#include "checkpoint.h"
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// DEFINITIONS AND MACROS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#define RESTART_TEST_RESET_TIME		0		//For testing, reset the board this many ms after launch. 0 to turn off.
+
+//Payload of the EXT_KIND_RESTART log record.
+#define RESTART_RECORD_SIZE			9
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// FUNCTION PROTOTYPES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Turns on access to the backup registers and starts timing the recovery. Call right after SystemClock_Config().
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void restart_init(void);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Loads the newest good checkpoint from the backup registers.
+//
+// Returns:
+//  1 if a checkpoint was found, 0 otherwise.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint8_t restart_load(checkpoint_t * checkpoint);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Gives the checkpoint the next sequence number and writes it over the older of the two copies.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void restart_save(checkpoint_t * checkpoint);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Erases both copies so the next boot is a cold start. Call when arming on the pad and after landing.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void restart_clear(void);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Time since restart_init() in microseconds. Reset and clock start up before restart_init() are not included.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint32_t restart_boot_time(void);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Fills payload with the recovery time in microseconds and the flight time of the checkpoint in ms (both big endian)
+//	and the state the flight carried on in, for an EXT_KIND_RESTART log record.
+//
+// Returns:
+//  The payload length, RESTART_RECORD_SIZE.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint8_t restart_log_payload(uint8_t * payload,uint32_t recovery_time,const checkpoint_t * checkpoint);
+
+#endif // RESTART_H
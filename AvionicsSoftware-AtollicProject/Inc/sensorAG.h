@@ -12,6 +12,8 @@
 // History
 // 2019-03-29 by Benjamin Zacharias
 // - Created.
+// 2026-10-19
+// - Readings are sent as sensorReading_t, imu_data_struct removed.
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -36,19 +38,11 @@
 // STRUCTS AND STRUCT TYPEDEFS
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 
-//Groups both sensor readings and a time stamp.
-typedef struct {
-
-	struct bmi08x_sensor_data	data_acc;
-	struct bmi08x_sensor_data	data_gyro;
-	uint32_t time_ticks;	//time of sensor reading in ticks.
-}imu_data_struct;
-
 //Parameters for vTask_sensorAG.
 typedef struct{
 
 	UART_HandleTypeDef * huart;
-	QueueHandle_t imu_queue;
+	QueueHandle_t imu_queue;		//Gets sensorReading_t readings.
 	configData_t *flightCompConfig;
 
 } ImuTaskStruct;
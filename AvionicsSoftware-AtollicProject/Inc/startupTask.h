@@ -12,6 +12,9 @@
 // History
 // 2019-04-19 by Joseph Howarth
 // - Created.
+// 2026-10-19
+// - Removed the timer task handle.
+// - Removed the flash pointer, the flash is erased through the flash service.
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -20,7 +23,7 @@
 
 #include "cmsis_os.h"
 #include "configuration.h"
-#include "flash.h"
+#include "flashService.h"
 #include "stm32f4xx_hal_uart_io.h"
 #include "hardwareDefs.h"
 
@@ -42,9 +45,7 @@ typedef struct{
 	  TaskHandle_t bmpTask_h ;
 	  TaskHandle_t imuTask_h ;
 	  TaskHandle_t xtractTask_h;
-	  TaskHandle_t timerTask_h;
 
-	  FlashStruct_t * flash_ptr;
 	  UART_HandleTypeDef * huart_ptr;
 	  configData_t * flightCompConfig;
 
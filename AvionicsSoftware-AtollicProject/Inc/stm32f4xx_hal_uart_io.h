@@ -12,6 +12,8 @@
 // History
 // 2019-02-13 Eric Kapilik
 // - Created.
+// 2026-10-19
+// - Added MX_HAL_UART1_Init() for the radio.
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -81,6 +83,22 @@ void MX_HAL_UART2_Init(UART_HandleTypeDef* uart);
 void MX_HAL_UART6_Init(UART_HandleTypeDef* uart);
 
 
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//	For UART port 1 only, this should only be run ONCE. (i.e. only one program should call it, once.)
+//  Enable UART clock, initialize GPIO pins, and create UART structure required for communication.
+//	Uses the radio pins in hardwareDefs.h.
+//
+// Parameters:
+//  UART_HandleTypeDef Pointer (needed by communication functions)
+//  uint32_t baud_rate - the baud rate of the radio modem
+//
+// Returns:
+//  VOID
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void MX_HAL_UART1_Init(UART_HandleTypeDef* uart, uint32_t baud_rate);
+
+
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 // Description:
 //  Transmit message to UART port. Does not add new line to message.
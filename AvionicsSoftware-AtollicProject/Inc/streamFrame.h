@@ -0,0 +1,189 @@
+#ifndef STREAM_FRAME_H
+#define STREAM_FRAME_H
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// UMSATS 2018-2020
+//
+// Repository:
+//  UMSATS/Avionics-2019
+//
+// File Description:
+//  Header file for the live sensor stream records: the encoding, the queue they wait in for the UART and the decoder.
+//  Nothing here uses the HAL or FreeRTOS, so the ground tools build the same code (see Tools/streamView.c). The UART
+//  side is in liveStream.c.
+//
+//  Each record is COBS encoded and followed by a 0x00, so a receiver that loses or damages a byte finds the start of
+//  the next record at the next 0x00. Record layout before encoding, multi byte values big endian:
+//   kind, sequence number (2), time in us (4), body, CRC-16 of everything before it.
+//  A reading body is a byte of STREAM_HAS_ flags followed by the parts it flags, in the order of the flags: the
+//  accelerometer (3 x 2), the gyroscope (3 x 2), the pressure and temperature (4 + 4, raw BMP388 values in 0.01 Pa and
+//  0.01 deg C) and the event bits (1, shifted down by EXT_KIND_SHIFT). A stats body is the number of records queued and
+//  the number dropped because the queue was full, since the stream started (4 + 4).
+//  Every record takes a sequence number, including the ones dropped, so a gap in the sequence numbers is the records
+//  dropped by the flight computer plus the ones lost on the link.
+//
+// History
+// 2026-10-19
+// - Created.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include <stdint.h>
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// DEFINITIONS AND MACROS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#define STREAM_DELIMITER		0x00
+
+#define STREAM_KIND_READING		0x01
+#define STREAM_KIND_STATS		0x02
+
+#define STREAM_HAS_ACC			0x01
+#define STREAM_HAS_GYRO			0x02
+#define STREAM_HAS_PRES			0x04		//Pressure and temperature.
+#define STREAM_HAS_EVENTS		0x08
+
+#define STREAM_HEADER_SIZE		7			//Kind, sequence number and time.
+#define STREAM_CRC_SIZE			2
+#define STREAM_MAX_BODY			22			//Flags, accelerometer, gyroscope, pressure, temperature and events.
+#define STREAM_MAX_RECORD		(STREAM_HEADER_SIZE+STREAM_MAX_BODY+STREAM_CRC_SIZE)
+#define STREAM_MAX_FRAME		(STREAM_MAX_RECORD+2)	//One COBS code byte for every 254 bytes, and the delimiter.
+
+#define STREAM_QUEUE_SIZE		2048		//Bytes of frames waiting for the UART, about 80 readings.
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// STRUCTS AND STRUCT TYPEDEFS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+typedef struct{
+
+	uint8_t kind;				//STREAM_KIND_
+	uint16_t sequence;
+	uint32_t time_us;
+
+	//Reading.
+	uint8_t contents;			//STREAM_HAS_
+	int16_t acc[3];
+	int16_t gyro[3];
+	uint32_t pressure;			//0.01 Pa
+	int32_t temperature;		//0.01 deg C
+	uint8_t events;
+
+	//Stats.
+	uint32_t queued;			//Records queued before this one.
+	uint32_t dropped;			//Records dropped because the queue was full.
+
+}streamRecord_t;
+
+//Frames waiting for the UART. Only the writer moves head, after the bytes are in, and only the UART moves tail, so an
+//interrupt can take bytes out while a frame is put in.
+typedef struct{
+
+	volatile uint8_t buffer[STREAM_QUEUE_SIZE];
+	volatile uint16_t head;
+	volatile uint16_t tail;
+	uint16_t sequence;
+
+	uint32_t queued;
+	uint32_t dropped;
+	uint32_t bytes;
+
+}streamQueue_t;
+
+typedef struct{
+
+	streamRecord_t record;		//Last good record.
+
+	uint8_t buffer[STREAM_MAX_FRAME];
+	uint8_t length;
+	uint8_t overflow;			//Set when a frame is too long, until the next delimiter.
+	uint8_t synced;				//Set after the first delimiter.
+	uint8_t started;			//Set after the first good record.
+	uint16_t sequence;
+
+	uint32_t records;
+	uint32_t lost;				//Records missing from the sequence numbers.
+	uint32_t bad;				//Frames with a bad COBS encoding, CRC or length.
+	uint32_t skipped;			//Bytes before the first delimiter.
+
+}streamDecoder_t;
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// FUNCTION PROTOTYPES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  COBS encodes length bytes of src into dest, which must hold length + length/254 + 1 bytes. The result has no 0x00
+//	and no delimiter.
+//
+// Returns:
+//  The encoded length.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint16_t cobs_encode(const uint8_t * src,uint16_t length,uint8_t * dest);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Decodes length bytes of COBS, without the delimiter, from src into dest, which must hold length bytes.
+//
+// Returns:
+//  The decoded length, 0 if the input is not valid COBS.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint16_t cobs_decode(const uint8_t * src,uint16_t length,uint8_t * dest);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Encodes a record, adds the CRC, COBS encodes it and adds the delimiter. frame must hold STREAM_MAX_FRAME bytes.
+//
+// Returns:
+//  The frame length.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint8_t stream_frame_build(const streamRecord_t * record,uint8_t * frame);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Clears the queue and puts a delimiter in it, so the first frame is decoded whatever the receiver saw before.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void stream_queue_init(streamQueue_t * queue);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Gives the record the next sequence number, and for a stats record the counts of the queue, then queues its frame.
+//	Readings leave room in the queue for a stats record.
+//
+// Returns:
+//  1 if queued, 0 if dropped because the queue is full.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint8_t stream_queue_put(streamQueue_t * queue,streamRecord_t * record);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Points data at the oldest bytes in the queue, as many as are in one piece.
+//
+// Returns:
+//  The number of bytes, 0 if the queue is empty.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint16_t stream_queue_chunk(const streamQueue_t * queue,const uint8_t ** data);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Removes bytes that have been sent from the queue.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void stream_queue_release(streamQueue_t * queue,uint16_t length);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Clears the decoder. Bytes are skipped until the first delimiter.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void stream_decoder_init(streamDecoder_t * dec);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Adds a received byte.
+//
+// Returns:
+//  1 when the byte ends a good record, which is then in dec->record, otherwise 0.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint8_t stream_decode(streamDecoder_t * dec,uint8_t byte);
+
+#endif // STREAM_FRAME_H
@@ -0,0 +1,147 @@
+#ifndef SUMMARY_LOG_H
+#define SUMMARY_LOG_H
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// UMSATS 2018-2020
+//
+// Repository:
+//  UMSATS/Avionics-2019
+//
+// File Description:
+//  Header file for the summary log. Everything else is kept on the external flash, so if that chip or SPI1 fails
+//  nothing comes back. The summary log is a small, slow log of the flight in the last 128 KB sector of the STM32's own
+//  flash (sector 7, left out of the FLASH region in STM32F401RE_FLASH.ld): the flight events, the altitude estimate at
+//  10 Hz in flight and a set of health counters every second, with a record at boot.
+//
+//  Records are SUMMARY_RECORD_SIZE bytes, in order from the start of the sector, each with a CRC-16 in its last two
+//  bytes. They wait in a queue in RAM and summary_log_service() programs one double word (two words, as the board runs
+//  at 3.3 V without the external programming voltage the 64 bit mode needs) each time it is called, so the CPU is only
+//  held up for the two word programs, about 32 us. A record cut short by a reset fails its CRC and the log carries on
+//  after it. The sector is only erased on the ground, because the CPU stalls for the whole erase, about 1 s.
+//
+// History
+// 2026-10-19
+// - Created.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include <stdint.h>
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// DEFINITIONS AND MACROS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#define SUMMARY_LOG_ADDRESS			0x08060000	//Must match the SUMMARY region in STM32F401RE_FLASH.ld.
+#define SUMMARY_LOG_SIZE			0x20000
+#define SUMMARY_RECORD_SIZE			16
+#define SUMMARY_RECORDS				(SUMMARY_LOG_SIZE/SUMMARY_RECORD_SIZE)
+#define SUMMARY_QUEUE_RECORDS		16			//Records waiting to be programmed.
+
+#define SUMMARY_STATE_PERIOD		100			//ms between state records in flight.
+#define SUMMARY_HEALTH_PERIOD		1000		//ms between health records in flight.
+#define SUMMARY_PAD_PERIOD			10000		//ms between state and health records before launch, so hours on the pad fit.
+
+#define SUMMARY_KIND_BOOT			0x01
+#define SUMMARY_KIND_STATE			0x02
+#define SUMMARY_KIND_EVENT			0x03
+#define SUMMARY_KIND_HEALTH			0x04
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// ENUMS AND ENUM TYPEDEFS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+typedef enum{
+	SUMMARY_LOG_OK,
+	SUMMARY_LOG_ERROR
+} summaryLogStatus_t;
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// STRUCTS AND STRUCT TYPEDEFS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+typedef struct{
+
+	uint8_t kind;					//SUMMARY_KIND_
+	uint8_t state;					//Flight state.
+	uint32_t time_ms;				//ms since boot.
+
+	//Boot.
+	uint8_t reset_flags;			//RCC_CSR bits 24 to 31, set by summary_log_boot().
+	uint8_t warm;					//1 when carrying on from a checkpoint in flight.
+
+	//State.
+	float altitude;					//m, latest unfiltered altitude.
+	float alt_filtered;				//m
+
+	//Event.
+	uint8_t events;					//Event bits of a measurement header, shifted down by EXT_KIND_SHIFT.
+
+	//Boot and event.
+	uint32_t log_address;			//Flash address the log had reached.
+
+	//Health, counts since the last health record.
+	uint16_t flash_errors;			//Flash service requests that failed, all classes, since boot.
+	uint16_t acc_readings;			//Accelerometer readings received.
+	uint16_t bmp_readings;			//BMP388 readings received.
+	uint8_t remapped;				//Log pages moved to spare pages.
+	uint8_t dropped;				//Summary records dropped since boot, set by summary_log_put().
+
+}summaryRecord_t;
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// FUNCTION PROTOTYPES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Finds where the next record goes with a binary search for the first blank record. Call once at boot.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void summary_log_init(void);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Queues a boot record with the reset flags, then clears them.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void summary_log_boot(uint8_t state,uint8_t warm,uint32_t log_address);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Queues a record, setting its time and the dropped count of a health record. Only one task may call this and
+//	summary_log_service().
+//
+// Returns:
+//  SUMMARY_LOG_OK, or SUMMARY_LOG_ERROR if the record was dropped because the queue or the log is full.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+summaryLogStatus_t summary_log_put(summaryRecord_t * record);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Programs the next double word of the oldest queued record, if there is one. Call often, the queue holds about
+//	1.5 s of records in flight and each record takes two calls.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void summary_log_service(void);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Erases the sector if it is not blank. Records still queued are kept. The CPU stalls until the erase is done, so
+//	only call this on the ground.
+//
+// Returns:
+//  SUMMARY_LOG_OK, or SUMMARY_LOG_ERROR if the sector could not be erased.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+summaryLogStatus_t summary_log_erase(void);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Returns the number of records written, including any cut short.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint16_t summary_log_count(void);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Reads a record, oldest first.
+//
+// Returns:
+//  SUMMARY_LOG_OK if the record is good, SUMMARY_LOG_ERROR if it is blank or its CRC is bad.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+summaryLogStatus_t summary_log_read(uint16_t index,summaryRecord_t * record);
+
+#endif // SUMMARY_LOG_H
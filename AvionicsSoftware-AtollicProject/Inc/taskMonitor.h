@@ -0,0 +1,82 @@
+#ifndef TASK_MONITOR_H
+#define TASK_MONITOR_H
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// UMSATS 2018-2020
+//
+// Repository:
+//  UMSATS/Avionics-2019
+//
+// File Description:
+//  Header file for the task monitor. The monitor task samples the FreeRTOS run time statistics and stack high water
+//  marks of every task, so the stack sizes in main.c can be set from real flights.
+//
+// History
+// 2026-10-19
+// - Created.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include <stdint.h>
+#include "cmsis_os.h"
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// DEFINITIONS AND MACROS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#define TASK_MONITOR_PERIOD			1000	//Time between samples in ms. The CPU share is over this period.
+#define TASK_MONITOR_LOG_PERIOD		5000	//Time between task records in the flight log in ms. 0 to not log them.
+#define TASK_MONITOR_MAX_TASKS		12
+#define TASK_MONITOR_STACK_SIZE		256		//In words.
+#define TASK_MONITOR_PRIORITY		3		//Above the sensor tasks so the samples are evenly spaced.
+
+//Size of the extended log record built by task_monitor_log_payload().
+#define TASK_RECORD_NAME_LENGTH		8
+#define TASK_RECORD_TASK_SIZE		(5+TASK_RECORD_NAME_LENGTH)
+#define TASK_RECORD_MAX_SIZE		(TASK_RECORD_TASK_SIZE*TASK_MONITOR_MAX_TASKS)
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// STRUCTS AND STRUCT TYPEDEFS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+typedef struct{
+
+	char name[configMAX_TASK_NAME_LEN];
+	uint8_t number;			//FreeRTOS task number, in the order the tasks were created.
+	eTaskState state;
+	uint8_t priority;
+	uint16_t cpu_permille;	//Share of the CPU over the last period, in tenths of a percent.
+	uint16_t stack_free;	//Least amount of stack that has been free, in words.
+
+}taskMonitorEntry_t;
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// FUNCTION PROTOTYPES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Samples every TASK_MONITOR_PERIOD ms. Takes no parameters.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void vTask_monitor(void * pvParameters);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Copies the latest sample, up to max_entries tasks.
+//
+// Returns:
+//  The number of tasks copied. 0 until the first period has passed.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint8_t task_monitor_get(taskMonitorEntry_t * entries,uint8_t max_entries);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Fills payload with the latest sample, for an EXT_KIND_TASKS log record. For each task: the task number, the CPU share
+//	in tenths of a percent and the free stack in words (both 16 bit big endian), then the first TASK_RECORD_NAME_LENGTH
+//	characters of the name padded with zeros. payload must hold TASK_RECORD_MAX_SIZE bytes.
+//
+// Returns:
+//  The payload length, 0 if there is no sample yet.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint8_t task_monitor_log_payload(uint8_t * payload);
+
+#endif // TASK_MONITOR_H
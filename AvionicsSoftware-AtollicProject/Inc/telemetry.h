@@ -0,0 +1,92 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// UMSATS 2018-2020
+//
+// Repository:
+//  UMSATS/Avionics-2019
+//
+// File Description:
+//  Header file for the telemetry task, which sends the flight state, events, estimated altitude and speed and the health
+//  of the flight computer to a radio modem in the frames of telemetryFrame.h. The logging task publishes a sample with
+//  every pressure reading, and the task builds a frame every TELEMETRY_FRAME_PERIOD ms from what the budget of the link
+//  allows. The UART can be any one that is set up, the budget follows its baud rate. Frames are sent a byte per
+//  interrupt, and the interrupt handler of the UART must call telemetry_irq() (USART1_IRQHandler in stm32f4xx_it.c).
+//
+// History
+// 2026-10-19
+// - Created.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include <stdint.h>
+#include "cmsis_os.h"
+#include "stm32f4xx_hal.h"
+#include "configuration.h"
+#include "telemetryFrame.h"
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// DEFINITIONS AND MACROS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#define TELEMETRY_BAUD_RATE			9600
+#define TELEMETRY_BUDGET_PERCENT	80			//Share of the link the frames may use.
+#define TELEMETRY_FRAME_PERIOD		100			//ms between frames.
+#define TELEMETRY_VELOCITY_GAIN		0.2			//Low pass filter on the speed from the change in filtered altitude.
+#define TELEMETRY_STACK_SIZE		256			//In words.
+#define TELEMETRY_PRIORITY			1			//Below the sensor and logging tasks.
+#define TELEMETRY_IRQ_PRIORITY		7			//Does not use any FreeRTOS calls.
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// STRUCTS AND STRUCT TYPEDEFS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+typedef struct{
+
+	UART_HandleTypeDef * huart;
+	configData_t * flightCompConfig;
+
+}TelemetryParams_t;
+
+typedef struct{
+
+	uint32_t time_us;			//Time of the pressure reading.
+	uint32_t events;			//Event bits of this reading. Every bit seen is sent from then on.
+	float altitude;				//m
+	float alt_filtered;			//m
+	int16_t acc[3];
+	uint32_t flight_time;		//ms since launch, 0 before.
+	uint32_t log_address;
+
+}telemetrySample_t;
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// FUNCTION PROTOTYPES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Builds and sends a frame every TELEMETRY_FRAME_PERIOD ms. Takes a TelemetryParams_t.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void vTask_telemetry(void * pvParameters);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Hands the latest estimates to the telemetry task. Called by the logging task with every pressure reading. Works out the
+//	vertical speed, so it must be called for every one.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void telemetry_publish(const telemetrySample_t * sample);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Copies the frames and bytes sent so far.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void telemetry_stats(uint32_t * frames,uint32_t * bytes);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Sends the next byte of the frame. Called from the interrupt handler of the telemetry UART.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void telemetry_irq(void);
+
+#endif // TELEMETRY_H
@@ -0,0 +1,183 @@
+#ifndef TELEMETRY_FRAME_H
+#define TELEMETRY_FRAME_H
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// UMSATS 2018-2020
+//
+// Repository:
+//  UMSATS/Avionics-2019
+//
+// File Description:
+//  Header file for the radio telemetry frames: the field table, the scheduler that decides which fields go in each frame
+//  and the decoder. Nothing here uses the HAL or FreeRTOS, so the ground tools build the same code (see
+//  Tools/telemetryLink.c). The telemetry task is in telemetry.c.
+//
+//  Frame layout, multi byte values big endian:
+//   0xA5, payload length, sequence number, time in ms (low 16 bits), payload, CRC-16 of everything after the 0xA5.
+//  The payload is a list of fields. Each starts with a byte holding the field number in the low 6 bits and the coding in
+//  the top 2: the full value (1, 2 or 4 bytes as in the field table), or the change from the value last sent in 1 or
+//  2 bytes. A field is sent in full at least every TLM_KEY_INTERVAL sends, and a receiver that misses a frame ignores
+//  changes until it has the full value again.
+//
+// History
+// 2026-10-19
+// - Created.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include <stdint.h>
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// DEFINITIONS AND MACROS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#define TLM_SYNC				0xA5
+#define TLM_HEADER_SIZE			5			//Sync, payload length, sequence number and time.
+#define TLM_CRC_SIZE			2
+#define TLM_OVERHEAD			(TLM_HEADER_SIZE+TLM_CRC_SIZE)
+#define TLM_MAX_PAYLOAD			64
+#define TLM_MAX_FRAME			(TLM_OVERHEAD+TLM_MAX_PAYLOAD)
+
+#define TLM_ID_MASK				0x3F
+#define TLM_CODING_SHIFT		6
+#define TLM_CODING_FULL			0
+#define TLM_CODING_DELTA8		1
+#define TLM_CODING_DELTA16		2
+
+#define TLM_KEY_INTERVAL		8			//Most sends of a field as a change before it is sent in full again.
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// ENUMS AND ENUM TYPEDEFS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+typedef enum{
+
+	TLM_STATE,				//Flight state, STATE_LAUNCHPAD etc.
+	TLM_FLAGS,				//Configuration flags, FLAG_IN_FLIGHT etc.
+	TLM_EVENTS,				//Every event bit seen this flight, shifted down by EXT_KIND_SHIFT.
+	TLM_CONTINUITY,			//Bit 0 set if the drogue e-match is closed, bit 1 the main.
+	TLM_ALTITUDE,			//Filtered altitude in dm.
+	TLM_VELOCITY,			//Vertical speed from the filtered altitude in dm/s.
+	TLM_ACC_X,				//Raw accelerometer readings.
+	TLM_ACC_Y,
+	TLM_ACC_Z,
+	TLM_ALT_RAW,			//Unfiltered altitude in dm.
+	TLM_FLIGHT_TIME,		//ms since launch.
+	TLM_LOG_ADDRESS,		//Flash address the log has reached.
+	TLM_CPU_LOAD,			//Share of the CPU used by the tasks, in tenths of a percent.
+	TLM_STACK_MIN,			//Least free stack of any task, in words.
+	TLM_FLASH_ERRORS,		//Flash requests that failed.
+	TLM_FIELDS
+
+}tlmField_t;
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// STRUCTS AND STRUCT TYPEDEFS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+typedef struct{
+
+	const char * name;
+	uint8_t width;				//Bytes of the full value, 1, 2 or 4.
+	uint8_t is_signed;
+	uint8_t priority;			//0 goes first.
+	uint8_t on_change;			//Sent in the next frame when it changes, as well as every period.
+	uint16_t period;			//ms between sends.
+
+}tlmFieldInfo_t;
+
+typedef struct{
+
+	int32_t value;				//Latest value.
+	int32_t sent;				//Value the receiver has.
+	uint32_t sent_time;			//ms
+	uint8_t valid;				//Set once there is a value.
+	uint8_t changed;
+	uint8_t since_key;			//Sends since it was last sent in full.
+
+}tlmFieldState_t;
+
+typedef struct{
+
+	tlmFieldState_t fields[TLM_FIELDS];
+	uint32_t bytes_per_second;	//Budget of the link.
+	uint32_t credit;			//Bytes that may be sent now, in thousandths of a byte.
+	uint32_t last_time;			//ms of the last frame built.
+	uint8_t sequence;
+
+	uint32_t frames;
+	uint32_t bytes;
+
+}tlmScheduler_t;
+
+typedef struct{
+
+	int32_t values[TLM_FIELDS];
+	uint8_t valid[TLM_FIELDS];	//Cleared after a lost frame until the full value comes.
+	uint32_t updated;			//Bit n set if field n was in the last frame.
+	uint16_t time;				//Time of the last frame.
+	uint8_t sequence;
+
+	uint8_t buffer[TLM_MAX_FRAME];
+	uint8_t length;
+	uint8_t started;			//Set after the first good frame.
+
+	uint32_t frames;
+	uint32_t lost;				//Frames missing from the sequence numbers.
+	uint32_t bad;				//Frames with a bad CRC or field.
+	uint32_t skipped;			//Bytes dropped looking for the start of a frame.
+
+}tlmDecoder_t;
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// CONSTANTS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+extern const tlmFieldInfo_t tlm_fields[TLM_FIELDS];
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// FUNCTION PROTOTYPES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  The bytes per second frames may use on a UART link, 10 bits a byte.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint32_t tlm_budget(uint32_t baud_rate,uint8_t percent);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Clears the fields. Every field is due as soon as it has a value.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void tlm_init(tlmScheduler_t * sched,uint32_t bytes_per_second,uint32_t now);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Sets the latest value of a field.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void tlm_set(tlmScheduler_t * sched,uint8_t field,int32_t value);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Builds the next frame from the fields that are due, highest priority first and then the longest overdue, as many as
+//	the budget built up since the last frame allows. Fields that do not fit stay due for the next frame. frame must
+//	hold TLM_MAX_FRAME bytes.
+//
+// Returns:
+//  The frame length, 0 if nothing is sent this time.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint8_t tlm_build(tlmScheduler_t * sched,uint32_t now,uint8_t * frame);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Clears the decoder.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void tlm_decoder_init(tlmDecoder_t * dec);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Adds a received byte. Bytes that do not make a frame with a good CRC are dropped a byte at a time until one does.
+//
+// Returns:
+//  1 when the byte ends a good frame and the values are updated, otherwise 0.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint8_t tlm_decode(tlmDecoder_t * dec,uint8_t byte);
+
+#endif // TELEMETRY_FRAME_H
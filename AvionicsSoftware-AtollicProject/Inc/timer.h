@@ -12,6 +12,10 @@
 // History
 // 2019-03-13 by Benjamin Zacharias
 // - Created.
+// 2026-10-19
+// - Added timer_set_elapsed() so the backup timer can carry on after a reset in flight.
+// - vTask_timer and timer_set_elapsed() replaced by backup_timer_init() and backup_timer_start(), run from the timer wheel.
+// - backup_timer_init() no longer takes the configuration, the timers do not set the state.
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -39,8 +43,8 @@
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 // CONSTANTS
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
-#define TIME_INTERVAL1 30000 // drogue 30 seconds.
-#define TIME_INTERVAL2 155000	//150 seconds
+#define TIME_INTERVAL1 BACKUP_DROGUE_TIME // drogue 30 seconds.
+#define TIME_INTERVAL2 BACKUP_MAIN_TIME	//150 seconds
 #define TIME_INTERVAL3 3000 //3s
 #define TIME_INTERVAL4 200	//200ms
 //input for timer: default user button
@@ -64,6 +68,20 @@
 //  Enter description of return values (if any).
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 void Timer_GPIO_Init(void);
-void vTask_timer(void *param);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Sets up the backup deployment timers. They only fire the e-matches, the pyro events then reach the logging task,
+//	which moves the flight state.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void backup_timer_init(void);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Starts the backup deployment timers, given how long ago the launch was in ms (0 at launch detection).
+//	Steps that are already past are skipped and the others happen at the same time after launch as they would have.
+//	Returns right away, the e-matches are fired from the timer wheel interrupt.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void backup_timer_start(uint32_t elapsed_ms);
 
 #endif // TIMER_H
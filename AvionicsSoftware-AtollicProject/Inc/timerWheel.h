@@ -0,0 +1,112 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// UMSATS 2018-2020
+//
+// Repository:
+//  UMSATS/Avionics-2019
+//
+// File Description:
+//  Header file for the timer wheel. One shot and periodic callbacks are run at a given microsecond from the TIM5
+//  capture/compare 1 interrupt, so timed jobs (backup deployment, button timers...) do not each need a task and a stack.
+//
+//  The timers are kept in a hierarchical wheel of TIMER_WHEEL_LEVELS levels of 64 slots. Level n holds the timers that
+//  differ from the current time first in bits 6n to 6n+5 of their expiry time, so starting and cancelling a timer is
+//  a couple of pointer writes, and finding the next one is a bit scan per level. When the time reaches a slot above
+//  level 0, its timers are moved down a level. The compare register is set to the next slot, so the interrupt only
+//  runs when something is due.
+//
+//  Callbacks run in the interrupt at TIMER_WHEEL_IRQ_PRIORITY. They must be short and may only use the FromISR
+//  FreeRTOS calls. The timer structs are owned by the caller and must stay valid while the timer is running.
+//
+// History
+// 2026-10-19
+// - Created.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include <stdint.h>
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// DEFINITIONS AND MACROS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#define TIMER_WHEEL_LEVELS			6			//6 bits per level covers the 32 bit time.
+#define TIMER_WHEEL_SLOTS			64
+#define TIMER_WHEEL_MAX_DELAY		0x7FFFFFFF	//us, about 35 minutes. Times are compared with signed differences.
+#define TIMER_WHEEL_IRQ_PRIORITY	5			//Lowest number that can still use the FromISR FreeRTOS calls.
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// TYPEDEFS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+typedef void (*wheelCallback_t)(void * arg);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// STRUCTS AND STRUCT TYPEDEFS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+typedef struct wheelTimer_s{
+
+	struct wheelTimer_s * next;
+	struct wheelTimer_s * prev;
+	uint32_t expiry;				//hr_timer_now() time to run at.
+	uint32_t period;				//us, 0 for a one shot timer.
+	wheelCallback_t callback;
+	void * arg;
+	uint8_t level;
+	uint8_t slot;
+	uint8_t active;
+
+}wheelTimer_t;
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// FUNCTION PROTOTYPES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Empties the wheel and turns on the TIM5 compare interrupt. Starts the high resolution timer if it is not running.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void timer_wheel_init(void);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Sets up a timer with the function to call and its argument. The timer is not started.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void wheel_timer_setup(wheelTimer_t * timer,wheelCallback_t callback,void * arg);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Starts (or restarts) a timer delay_us from now. With a period, it then runs every period_us after that, without
+//	drifting. A delay of 0 runs it as soon as possible. Can be called from a task, an interrupt or a callback.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void wheel_timer_start(wheelTimer_t * timer,uint32_t delay_us,uint32_t period_us);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Same as wheel_timer_start() but at an hr_timer_now() time. A time that is already past runs as soon as possible.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void wheel_timer_start_at(wheelTimer_t * timer,uint32_t time_us,uint32_t period_us);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Stops a timer. Does nothing if it is not running.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void wheel_timer_cancel(wheelTimer_t * timer);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Checks if a timer is running.
+//
+// Returns:
+//  1 if it is waiting to run, 0 otherwise.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint8_t wheel_timer_active(const wheelTimer_t * timer);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Runs the timers that are due. Called from the TIM5 interrupt.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void timer_wheel_irq(void);
+
+#endif // TIMER_WHEEL_H
@@ -12,6 +12,18 @@
 // History
 // 2019-02-15 by Eric Kapilik
 // - Created.
+// 2026-10-19
+// - Added the prof and profreset commands.
+// - Added the tasks and top commands.
+// - Added fire_ematch() for the e-match menu.
+// - Added log_capacity_report() for the config menu.
+// - Added event_journal_report() for the memory menu.
+// - Removed the flash pointer. Added flash_service_report() for the flash command.
+// - Added log_index_report() for the memory menu.
+// - Added verify_flight() and crc_benchmark() for the verify and crcbench commands.
+// - Added telemetry_report() for the radio command.
+// - Added read_sparse() for the reads command.
+// - Added summary_log_report() for the summary command.
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -26,6 +38,11 @@
 // DEFINITIONS AND MACROS
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 
+//Header of each range sent by the reads command: the marker, then the start address and the length (4 + 4, big endian).
+//A range with a length of 0 ends the download.
+#define XTRACT_RANGE_MARKER		"RNG:"
+#define XTRACT_RANGE_HEADER_SIZE	12
+
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 // ENUMS AND ENUM TYPEDEFS
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -46,7 +63,6 @@ typedef enum{
 typedef struct{
 
 	UART_HandleTypeDef *huart;
-	FlashStruct_t *flash;
 	configData_t *flightCompConfig;
 	TaskHandle_t startupTaskHandle;
 }	xtractParams;
@@ -109,6 +125,17 @@ void help(UART_HandleTypeDef * uart); //display help menu
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 void read(xtractParams * params);
 
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Downloads only the parts of the log in sectors the flash service map has as used, each run of used sectors up to
+//	its last page with data. Each part is sent after a range header (XTRACT_RANGE_MARKER), and Tools/sparseDump.c
+//	puts the image back together with the blank parts in between.
+//
+// Returns:
+//  VOID
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void read_sparse(xtractParams * params);
+
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 // Description:
 //  starts a timer that prints when it is done
@@ -138,4 +165,120 @@ void memory_menu(char* command, xtractParams * params);
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 void configure(char* command,xtractParams * params);
 
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  prints the profiling zone statistics (count, min, mean, max and histogram of the run times).
+//
+// Returns:
+//  VOID
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void profile_report(UART_HandleTypeDef * uart);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  prints the CPU share and free stack of every task from the task monitor.
+//
+// Returns:
+//  VOID
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void task_report(UART_HandleTypeDef * uart);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  plays a one second beep while a 1 ms task loop runs, and prints the longest gap between loops.
+//	Shows that the buzzer does not hold up the tasks.
+//
+// Returns:
+//  VOID
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void buzzer_test(UART_HandleTypeDef * uart);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Fires the e-match and prints the measured pulse width, continuity and overcurrent once the pulse is done.
+//	The driver must be armed first.
+//
+// Returns:
+//  VOID
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void fire_ematch(UART_HandleTypeDef * uart,recoverySelect_t event);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Prints the logging rate and flash use of each flight phase, how many minutes of each phase fit in the free flash,
+//	and how much of it a typical flight would use. Uses the rates in the configuration, not the ones running now.
+//
+// Returns:
+//  VOID
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void log_capacity_report(UART_HandleTypeDef * uart,configData_t * config);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Prints every record in the flight event journal, oldest first, without reading the log.
+//
+// Returns:
+//  VOID
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void event_journal_report(UART_HandleTypeDef * uart);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Prints the number of requests in each flash service class, how many were merged into another request, the mean
+//	and longest time spent in the queue, the longest time the flash was busy with one request, the longest time from
+//	queuing to finishing while an erase was running, how many times erases of the class were suspended and how many
+//	requests failed.
+//
+// Returns:
+//  VOID
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void flash_service_report(UART_HandleTypeDef * uart);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Prints every log page that was moved to a spare page, and how many spare pages are left.
+//
+// Returns:
+//  VOID
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void log_index_report(UART_HandleTypeDef * uart);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Streams the whole log on the flight computer and checks the CRC at the end of every page, without sending the data.
+//	Prints the number of pages checked and with a bad CRC, and how long it took.
+//
+// Returns:
+//  VOID
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void verify_flight(UART_HandleTypeDef * uart);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Times the CRC of the same data with the software table and the CRC unit, and prints each in MB/s.
+//
+// Returns:
+//  VOID
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void crc_benchmark(UART_HandleTypeDef * uart);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Prints the telemetry frames and bytes sent since power on, the mean bytes per second and the budget of the link.
+//
+// Returns:
+//  VOID
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void telemetry_report(UART_HandleTypeDef * uart);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Prints every record of the summary log in the internal flash, oldest first, and how many records are bad and how
+//	many are left. It does not use the external flash, so it works when that does not.
+//
+// Returns:
+//  VOID
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+void summary_log_report(UART_HandleTypeDef * uart);
+
 #endif // XTRACT_H
@@ -87,9 +87,9 @@ task.h is included from an application file. */
 
 #undef MPU_WRAPPERS_INCLUDED_FROM_API_FILE
 
-#if( configSUPPORT_DYNAMIC_ALLOCATION == 0 )
-	#error This file must not be used if configSUPPORT_DYNAMIC_ALLOCATION is 0
-#endif
+/* Compiled out instead of an error so the static allocation only build does not
+need a different file list. */
+#if( configSUPPORT_DYNAMIC_ALLOCATION == 1 )
 
 /* Block sizes must not get too small. */
 #define heapMINIMUM_BLOCK_SIZE	( ( size_t ) ( xHeapStructSize << 1 ) )
@@ -476,3 +476,4 @@ uint8_t *puc;
 	}
 }
 
+#endif /* configSUPPORT_DYNAMIC_ALLOCATION == 1 */
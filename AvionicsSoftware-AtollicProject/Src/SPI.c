@@ -7,6 +7,9 @@
 // History
 // 2019-02-06 by Joseph Howarth
 // - Created.
+// 2026-10-19
+// - SPI3 (BMI088) runs at 5.25 MHz instead of 164 kHz.
+// - SPI1 (flash) runs at 10.5 MHz instead of 328 kHz.
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -50,7 +53,7 @@ void spi1_init(SPI_HandleTypeDef *hspi){
 	  hspi->Init.CLKPolarity = SPI_POLARITY_LOW;
 	  hspi->Init.CLKPhase = SPI_PHASE_1EDGE;
 	  hspi->Init.NSS = SPI_NSS_SOFT;
-	  hspi->Init.BaudRatePrescaler = SPI_BAUDRATEPRESCALER_256;
+	  hspi->Init.BaudRatePrescaler = SPI_BAUDRATEPRESCALER_8;		//10.5 MHz, so a Fast Read stream runs at about 1.3 MB/s. The flash takes up to 40 MHz.
 	  hspi->Init.FirstBit = SPI_FIRSTBIT_MSB;
 	  hspi->Init.TIMode = SPI_TIMODE_DISABLE;
 	  hspi->Init.CRCCalculation = SPI_CRCCALCULATION_DISABLE;
@@ -158,7 +161,7 @@ void spi3_init(SPI_HandleTypeDef *hspi){
 	  hspi->Init.CLKPolarity = SPI_POLARITY_LOW;
 	  hspi->Init.CLKPhase = SPI_PHASE_1EDGE;
 	  hspi->Init.NSS = SPI_NSS_SOFT;
-	  hspi->Init.BaudRatePrescaler = SPI_BAUDRATEPRESCALER_256;
+	  hspi->Init.BaudRatePrescaler = SPI_BAUDRATEPRESCALER_8;		//5.25 MHz, the BMI088 takes up to 10 MHz. Fast enough to read it at 2 kHz.
 	  hspi->Init.FirstBit = SPI_FIRSTBIT_MSB;
 	  hspi->Init.TIMode = SPI_TIMODE_DISABLE;
 	  hspi->Init.CRCCalculation = SPI_CRCCALCULATION_DISABLE;
@@ -0,0 +1,170 @@
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// UMSATS 2018-2020
+//
+// Repository:
+//  UMSATS/Avionics-2019
+//
+// File Description:
+//  Source file for the sensor acquisition schedule.
+//
+// History
+// 2026-10-19
+// - Created.
+// - Counts the readings missed because the task had not taken the last notification yet.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include "acquisition.h"
+#include "timerWheel.h"
+#include "hrTimer.h"
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// DEFINITIONS AND MACROS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#define ACQ_CHANNELS	3
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// STRUCTS AND STRUCT TYPEDEFS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+typedef struct{
+
+	uint8_t sensor;
+	uint32_t period;		//us
+	uint32_t phase;			//us after the schedule start.
+	TaskHandle_t task;		//Notified when the sensor is due.
+	uint32_t missed;		//Times the sensor was due again before the task took its bit.
+	wheelTimer_t timer;
+
+}acqChannel_t;
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// CONSTANTS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+static acqChannel_t channels[ACQ_CHANNELS] = {
+
+	{ .sensor = ACQ_ACC },
+	{ .sensor = ACQ_GYRO },
+	{ .sensor = ACQ_BMP }
+};
+
+static uint32_t schedule_start;		//hr_timer_now() time every timer is phased from.
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// FUNCTIONS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+uint32_t acquisition_rate_period(uint16_t rate,uint16_t max_rate){
+
+	if(rate == 0){
+		rate = 1;
+	}
+	if(rate > max_rate){
+		rate = max_rate;
+	}
+
+	return HR_TIMER_FREQ/rate;
+}
+
+//Runs in the timer wheel interrupt.
+static void sensor_due(void * arg){
+
+	acqChannel_t * channel = (acqChannel_t *)arg;
+	BaseType_t woken = pdFALSE;
+	uint32_t pending = 0;
+
+	//A bit still set from the last time merges with this one, so that reading is lost.
+	xTaskNotifyAndQueryFromISR(channel->task,channel->sensor,eSetBits,&pending,&woken);
+	if(pending & channel->sensor){
+		channel->missed++;
+	}
+	portYIELD_FROM_ISR(woken);
+}
+
+void acquisition_init(configData_t * configParams){
+
+	uint8_t i;
+
+	channels[0].period = acquisition_rate_period(configParams->values.acc_rate,ACQ_MAX_IMU_RATE);
+	channels[1].period = acquisition_rate_period(configParams->values.gyro_rate,ACQ_MAX_IMU_RATE);
+	channels[2].period = acquisition_rate_period(configParams->values.bmp_rate,ACQ_MAX_BMP_RATE);
+
+	//The IMU readings line up at the start, the BMP388 sits half way between the fastest of them.
+	channels[0].phase = 0;
+	channels[1].phase = 0;
+	channels[2].phase = ((channels[0].period < channels[1].period) ? channels[0].period : channels[1].period)/2;
+
+	for(i=0;i<ACQ_CHANNELS;i++){
+
+		channels[i].task = NULL;
+		channels[i].missed = 0;
+		wheel_timer_setup(&channels[i].timer,sensor_due,&channels[i]);
+	}
+
+	schedule_start = hr_timer_now();
+}
+
+void acquisition_start(uint8_t sensors){
+
+	TaskHandle_t task = xTaskGetCurrentTaskHandle();
+	uint32_t now = hr_timer_now();
+	uint8_t i;
+
+	for(i=0;i<ACQ_CHANNELS;i++){
+
+		acqChannel_t * channel = &channels[i];
+
+		if(!(sensors & channel->sensor)){
+			continue;
+		}
+
+		//Next point of this sensor's schedule, so the phases hold whenever each task starts.
+		uint32_t first = schedule_start + channel->phase;
+		uint32_t since = now - first;
+
+		if((int32_t)since >= 0){
+			first += (since/channel->period + 1)*channel->period;
+		}
+
+		channel->task = task;
+		wheel_timer_start_at(&channel->timer,first,channel->period);
+	}
+}
+
+uint8_t acquisition_wait(void){
+
+	uint32_t due = 0;
+
+	while(due == 0){
+		xTaskNotifyWait(0,0xFFFFFFFF,&due,portMAX_DELAY);
+	}
+
+	return due & (ACQ_ACC | ACQ_GYRO | ACQ_BMP);
+}
+
+uint32_t acquisition_period(uint8_t sensor){
+
+	uint8_t i;
+
+	for(i=0;i<ACQ_CHANNELS;i++){
+		if(channels[i].sensor == sensor){
+			return channels[i].period;
+		}
+	}
+
+	return 0;
+}
+
+uint32_t acquisition_missed(uint8_t sensor){
+
+	uint8_t i;
+
+	for(i=0;i<ACQ_CHANNELS;i++){
+		if(channels[i].sensor == sensor){
+			return channels[i].missed;
+		}
+	}
+
+	return 0;
+}
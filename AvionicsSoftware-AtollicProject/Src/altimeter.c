@@ -10,12 +10,15 @@
 // History
 // 2019-04-01 by Eric Kapilik
 // - Created.
+// 2026-10-19
+// - Added a profiling zone.
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 // INCLUDES
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 #include "altimeter.h"
+#include "profiler.h"
 #include <math.h>
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -52,10 +55,10 @@ alt_value altitude_approx(float pressure, float temperature,configData_t * confi
 //	double temp_term = temperature / lapse_rate_static;
 //	double press_term = (pressure / reference_pressure) * const_exp_term - 1;
 //	return (temp_term * press_term) + reference_altitude;
-	float p_term = pow((config->values.ref_pres/(pressure/100)),(1/5.257F))-1;
-	float t_term = (temperature/100)+273.15F;
 	alt_value result;
-	result.float_val =(p_term*t_term)/0.0065F+config->values.ref_alt;
+	PROFILE_BEGIN(PROFILE_ALTITUDE);
+	result.float_val = pressure_altitude(pressure,temperature,config->values.ref_pres,config->values.ref_alt);
+	PROFILE_END(PROFILE_ALTITUDE);
 	return result;
 
 }
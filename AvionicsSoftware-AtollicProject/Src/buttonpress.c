@@ -10,6 +10,8 @@
 // History
 // 2019-03-13 by Benjamin Zacharias
 // - Created.
+// 2026-10-19
+// - The button is polled and the output toggled from the timer wheel instead of a task.
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -20,12 +22,16 @@
 #include <string.h>
 
 #include "buttonpress.h"
-#include "cmsis_os.h"
+#include "timerWheel.h"
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 // DEFINITIONS AND MACROS
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
-static UART_HandleTypeDef* uart;
+#define BUTTON_POLL_PERIOD	10000		//us
+
+static wheelTimer_t poll_timer;
+static wheelTimer_t toggle_timer;
+static uint8_t toggles_left;
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 // ENUMS AND ENUM TYPEDEFS
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -82,21 +88,32 @@ void Timerbp_GPIO_Init(void)
   HAL_GPIO_Init(INPUT_PORT, &GPIO_InitStruct);
 }
 
-void vTask_timerbp(void *param){
-	uart = (UART_HandleTypeDef*) param;
-	taskENABLE_INTERRUPTS();
-
-	/* As per most FreeRTOS tasks, this task is implemented in an infinite loop. */
-	while(1){
-		if(!HAL_GPIO_ReadPin(INPUT_PORT, INPUT_PIN)){
-				//TODO check how long outputs should be on for
-				//TODO check in init that outputs are off before connecting to e-matches
-				vTaskDelay(pdMS_TO_TICKS(TIME_INTERVAL1)); //wait for the first time interval
-				HAL_GPIO_TogglePin(OUTPUT1_PORT,OUTPUT1_PIN); //toggle Output 1
-				vTaskDelay(pdMS_TO_TICKS(TIME_INTERVAL2)); //wait for the second time interval
-				HAL_GPIO_TogglePin(OUTPUT1_PORT,OUTPUT1_PIN); //toggle Output 1
-		}
+static void toggle_output(void * arg){
+
+	HAL_GPIO_TogglePin(OUTPUT1_PORT,OUTPUT1_PIN); //toggle Output 1
+
+	if(--toggles_left > 0){
+		wheel_timer_start(&toggle_timer,(uint32_t)TIME_INTERVAL2*1000,0); //wait for the second time interval
 	}
 }
 
+static void poll_button(void * arg){
+
+	//A press while the output sequence is running is ignored.
+	if(!HAL_GPIO_ReadPin(INPUT_PORT, INPUT_PIN) && !wheel_timer_active(&toggle_timer)){
+
+		//TODO check how long outputs should be on for
+		//TODO check in init that outputs are off before connecting to e-matches
+		toggles_left = 2;
+		wheel_timer_start(&toggle_timer,(uint32_t)TIME_INTERVAL1*1000,0); //wait for the first time interval
+	}
+}
+
+void timerbp_start(void){
+
+	wheel_timer_setup(&toggle_timer,toggle_output,NULL);
+	wheel_timer_setup(&poll_timer,poll_button,NULL);
+	wheel_timer_start(&poll_timer,BUTTON_POLL_PERIOD,BUTTON_POLL_PERIOD);
+}
+
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
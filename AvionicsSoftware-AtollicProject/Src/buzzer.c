@@ -10,6 +10,9 @@
 // History
 // 2019-01-13 by Cole Wiebe
 // - Created.
+// 2026-10-19
+// - Tones are queued and the pin is toggled from the TIM2 update interrupt instead of busy waiting on TIM2.
+//   The buzzer pin (PB2) has no timer channel, so the square wave can not be made by the timer alone.
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 // INCLUDES
@@ -17,62 +20,147 @@
 #include "buzzer.h"
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
-// FUNCTION PROTOTYPES
-//-------------------------------------------------------------------------------------------------------------------------------------------------------------
-//-------------------------------------------------------------------------------------------------------------------------------------------------------------
-// Description:
-//  Initializes the pins being used by the buzzer and the timer
-//
-// Returns:
-//  void
+// STRUCTS AND STRUCT TYPEDEFS
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
+typedef struct{
 
+	uint16_t frequency;		//In hertz, 0 for silence.
+	uint16_t on_ms;
+	uint16_t off_ms;
+
+}buzzerTone_t;
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
-// Description:
-//  makes a buzzer buzz for a given amount of seconds
-//
-// Returns:
-//  int seconds
+// CONSTANTS
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
+static buzzerTone_t queue[BUZZER_QUEUE_LENGTH];
+static volatile uint8_t queue_head;		//Next free entry, only changed by callers.
+static volatile uint8_t queue_tail;		//Tone playing now, only changed by the interrupt.
+static volatile uint8_t playing;
 
+static uint32_t timer_clock;			//TIM2 input clock in hertz.
+static uint32_t half_periods;			//Pin toggles left in the tone.
+static uint32_t silence_ms;				//ms of silence left after the tone.
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 // FUNCTIONS
-//int main2(void)
-//{
-//	/* Initialize all configured peripherals & timer */
-//	Initialization();
-//	return(1);
-//}
-//-------------------------------------------------------------------------------------------------------------------------------------------------------------
-/**
-  * @brief System Clock Configuration
-  * @retval None
-  */
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//Sets up the tone at the tail of the queue, or stops the timer if the queue is empty. Runs with the timer interrupt held off.
+static void start_tone(void){
+
+	const buzzerTone_t * tone;
+
+	HAL_GPIO_WritePin(BUZZER_PORT,BUZZER_PIN,GPIO_PIN_RESET);
+
+	if(queue_tail == queue_head){
+
+		TIM2->CR1 &= ~TIM_CR1_CEN;
+		playing = 0;
+		return;
+	}
+
+	tone = &queue[queue_tail];
+
+	if(tone->frequency == 0){
+
+		half_periods = 0;
+		silence_ms = tone->on_ms + tone->off_ms;
+		TIM2->ARR = (timer_clock/1000) - 1;
+	}
+	else{
+
+		half_periods = ((uint32_t)tone->on_ms*tone->frequency*2)/1000;
+		silence_ms = tone->off_ms;
+		TIM2->ARR = (timer_clock/(2*(uint32_t)tone->frequency)) - 1;
+	}
+
+	TIM2->CNT = 0;
+	TIM2->CR1 |= TIM_CR1_CEN;
+	playing = 1;
+}
+
+void buzzer_irq(void){
+
+	if((TIM2->SR & TIM_SR_UIF) == 0){
+		return;
+	}
+	TIM2->SR = ~TIM_SR_UIF;
+
+	if(half_periods > 0){
+
+		HAL_GPIO_TogglePin(BUZZER_PORT,BUZZER_PIN);
+		half_periods--;
+
+		if(half_periods > 0){
+			return;
+		}
+
+		HAL_GPIO_WritePin(BUZZER_PORT,BUZZER_PIN,GPIO_PIN_RESET);
+
+		if(silence_ms > 0){
+
+			//Tone done, the silence is counted in ms so the interrupt rate drops.
+			TIM2->ARR = (timer_clock/1000) - 1;
+			TIM2->CNT = 0;
+			return;
+		}
+	}
+	else if(silence_ms > 0){
+
+		silence_ms--;
+		if(silence_ms > 0){
+			return;
+		}
+	}
+
+	queue_tail = (queue_tail + 1) % BUZZER_QUEUE_LENGTH;
+	start_tone();
+}
+
+uint8_t buzz_tone(uint16_t frequency,uint16_t on_ms,uint16_t off_ms){
+
+	uint8_t next;
+	uint32_t primask;
+
+	if(on_ms == 0 && off_ms == 0){
+		return 1;
+	}
+
+	//Several tasks can queue tones, and this is used before the scheduler starts.
+	primask = __get_PRIMASK();
+	__disable_irq();
+
+	next = (queue_head + 1) % BUZZER_QUEUE_LENGTH;
+	if(next == queue_tail){
+
+		__set_PRIMASK(primask);
+		return 0;
+	}
+
+	queue[queue_head].frequency = frequency;
+	queue[queue_head].on_ms = on_ms;
+	queue[queue_head].off_ms = off_ms;
+	queue_head = next;
+
+	if(!playing){
+		start_tone();
+	}
+
+	__set_PRIMASK(primask);
+	return 1;
+}
+
 void buzz(int milliseconds)
 {
-	int count = milliseconds * SECOND;
-	  while (count != 0)
-	  {
-		  HAL_GPIO_WritePin (BUZZER_PORT, BUZZER_PIN, GPIO_PIN_SET); //sets first pin as high
-		  //HAL_GPIO_WritePin (GPIOA, PIN2, GPIO_PIN_RESET); // sets second pin as low
-		    //count to 10,502.56 for proper delay of 0.125 ms
-		    TIM2->CNT = 0; //Sets timer count to 0
-		    TIM2->CR1 |= 1; //Enables Timer
-		    while((TIM2->SR & 1) != 1){} //Waits for timer to reach specified value
-		    TIM2->CR1 &= ~1; //Disables Timer
-		    TIM2->SR &= ~1; //Resets UIF pin
-		  	HAL_GPIO_WritePin (BUZZER_PORT, BUZZER_PIN, GPIO_PIN_RESET); // sets first pin as low
-		  	//HAL_GPIO_WritePin (GPIOA, PIN2, GPIO_PIN_SET); //sets second pin as high
-		  	TIM2->CNT = 0;
-		  	TIM2->CR1 |= 1;
-		  	while((TIM2->SR & 1) != 1){}
-		  	TIM2->CR1 &= ~1;
-		  	TIM2->SR &= ~1;
-		  	count -= 1;
-	  }
+	if(milliseconds > 0){
+		buzz_tone(FREQ,(milliseconds > 0xFFFF) ? 0xFFFF : milliseconds,0);
+	}
+}
+
+uint8_t buzzer_busy(void){
+
+	return playing;
 }
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -85,12 +173,33 @@ void buzzerInit(void)
   	 GPIO_InitTypeDef GPIOInit;
      GPIOInit.Pin       = BUZZER_PIN;
      GPIOInit.Mode      = GPIO_MODE_OUTPUT_PP;
+     GPIOInit.Pull      = GPIO_NOPULL;
+     GPIOInit.Speed     = GPIO_SPEED_FREQ_LOW;
 
      HAL_GPIO_Init(BUZZER_PORT,&GPIOInit);
-     
+     HAL_GPIO_WritePin(BUZZER_PORT,BUZZER_PIN,GPIO_PIN_RESET);
+
 	/* Enables clock for timer */
 	__HAL_RCC_TIM2_CLK_ENABLE();
 
-	/* set value to count to */
-	TIM2->ARR = 10500;
+	//The APB1 timers run at twice the bus clock when the bus is divided down.
+	timer_clock = HAL_RCC_GetPCLK1Freq();
+	if((RCC->CFGR & RCC_CFGR_PPRE1) != RCC_HCLK_DIV1){
+		timer_clock *= 2;
+	}
+
+	TIM2->CR1 = TIM_CR1_URS;		//Only overflows set the update flag, not the UG bit.
+	TIM2->PSC = 0;
+	TIM2->ARR = (timer_clock/1000) - 1;
+	TIM2->EGR = TIM_EGR_UG;
+	TIM2->SR = 0;
+	TIM2->DIER = TIM_DIER_UIE;
+
+	queue_head = 0;
+	queue_tail = 0;
+	playing = 0;
+
+	HAL_NVIC_SetPriority(TIM2_IRQn,BUZZER_IRQ_PRIORITY,0);
+	HAL_NVIC_EnableIRQ(TIM2_IRQn);
 }
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
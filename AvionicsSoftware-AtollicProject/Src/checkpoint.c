@@ -0,0 +1,121 @@
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// UMSATS 2018-2020
+//
+// Repository:
+//  UMSATS/Avionics-2019
+//
+// File Description:
+//  Source file for the flight state checkpoints.
+//
+// History
+// 2026-10-19
+// - Created.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include "checkpoint.h"
+#include "crc.h"
+#include <string.h>
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// FUNCTIONS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+static uint32_t float_bits(float value){
+
+	uint32_t bits;
+
+	memcpy(&bits,&value,sizeof(bits));
+	return bits;
+}
+
+static float bits_float(uint32_t bits){
+
+	float value;
+
+	memcpy(&value,&bits,sizeof(value));
+	return value;
+}
+
+//CRC of the words as big endian bytes, so it is the same on any host.
+static uint32_t words_crc(const uint32_t * words,uint8_t count){
+
+	uint32_t crc = CRC32_INIT;
+	uint8_t bytes[4];
+	uint8_t i;
+
+	for(i=0;i<count;i++){
+
+		bytes[0] = (words[i] >> 24) & 0xFF;
+		bytes[1] = (words[i] >> 16) & 0xFF;
+		bytes[2] = (words[i] >> 8) & 0xFF;
+		bytes[3] = words[i] & 0xFF;
+		crc = crc32_update(crc,bytes,4);
+	}
+
+	return crc;
+}
+
+void checkpoint_save(checkpoint_t * checkpoint,const flightState_t * fs){
+
+	checkpoint->state = *fs->state;
+	checkpoint->flags = *fs->flags;
+
+	checkpoint->altitude = fs->altitude;
+	checkpoint->alt_filtered = fs->alt_filtered;
+	checkpoint->alt_prev = fs->alt_prev;
+	checkpoint->alt_count = fs->alt_count;
+	checkpoint->alt_main_count = fs->alt_main_count;
+	checkpoint->apogee_holdout_count = fs->apogee_holdout_count;
+}
+
+void checkpoint_restore(const checkpoint_t * checkpoint,flightState_t * fs){
+
+	*fs->state = checkpoint->state;
+	*fs->flags = checkpoint->flags;
+
+	fs->altitude = checkpoint->altitude;
+	fs->alt_filtered = checkpoint->alt_filtered;
+	fs->alt_prev = checkpoint->alt_prev;
+	fs->alt_count = checkpoint->alt_count;
+	fs->alt_main_count = checkpoint->alt_main_count;
+	fs->apogee_holdout_count = checkpoint->apogee_holdout_count;
+}
+
+void checkpoint_pack(const checkpoint_t * checkpoint,uint32_t words[CHECKPOINT_WORDS]){
+
+	words[0] = ((uint32_t)CHECKPOINT_MAGIC << 16) | ((uint32_t)checkpoint->state << 8) | checkpoint->flags;
+	words[1] = ((uint32_t)checkpoint->alt_count << 24) | ((uint32_t)checkpoint->alt_main_count << 16) | checkpoint->apogee_holdout_count;
+	words[2] = float_bits(checkpoint->altitude);
+	words[3] = float_bits(checkpoint->alt_filtered);
+	words[4] = float_bits(checkpoint->alt_prev);
+	words[5] = checkpoint->flash_address;
+	words[6] = checkpoint->flight_time;
+	words[7] = checkpoint->config_slot;
+	words[8] = checkpoint->sequence;
+	words[9] = words_crc(words,CHECKPOINT_WORDS-1);
+}
+
+uint8_t checkpoint_unpack(const uint32_t words[CHECKPOINT_WORDS],checkpoint_t * checkpoint){
+
+	if((words[0] >> 16) != CHECKPOINT_MAGIC || words[9] != words_crc(words,CHECKPOINT_WORDS-1)){
+		return 0;
+	}
+
+	checkpoint->state = (words[0] >> 8) & 0xFF;
+	checkpoint->flags = words[0] & 0xFF;
+	checkpoint->alt_count = (words[1] >> 24) & 0xFF;
+	checkpoint->alt_main_count = (words[1] >> 16) & 0xFF;
+	checkpoint->apogee_holdout_count = words[1] & 0xFFFF;
+	checkpoint->altitude = bits_float(words[2]);
+	checkpoint->alt_filtered = bits_float(words[3]);
+	checkpoint->alt_prev = bits_float(words[4]);
+	checkpoint->flash_address = words[5];
+	checkpoint->flight_time = words[6];
+	checkpoint->config_slot = words[7] & 0xFFFF;
+	checkpoint->sequence = words[8];
+
+	return 1;
+}
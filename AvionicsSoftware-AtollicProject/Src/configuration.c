@@ -10,6 +10,14 @@
 // History
 // 2019-05-26 by Joseph Howarth
 // - Created.
+// 2026-10-19
+// - The configuration is saved as sequence numbered, CRC checked records appended to a journal in the first
+//   FLASH_CONFIG_SECTORS parameter sectors. The sector after the current one is erased in the background.
+// - Added read_config_at() and config_journal_slot().
+// - Defaults for the separate sample rates.
+// - Defaults for the flight phase logging rates.
+// - Defaults for the event capture windows.
+// - Flash access goes through the flash service.
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 #ifndef CONFIG_H
 #define CONFIG_H
@@ -19,10 +27,34 @@
 
 
 #include "configuration.h"
+#include "flashService.h"
+#include "crc.h"
+#include "cmsis_os.h"
+#include <string.h>
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 // DEFINITIONS AND MACROS
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#define JOURNAL_ADDRESS				0x00000000
+#define JOURNAL_SECTORS				FLASH_CONFIG_SECTORS
+#define JOURNAL_SLOT_SIZE			64			//Each record takes one slot, 4 slots per page.
+#define JOURNAL_SLOTS_PER_SECTOR	(FLASH_PARAM_SECTOR_SIZE/JOURNAL_SLOT_SIZE)
+#define JOURNAL_SLOTS_PER_PAGE		(FLASH_PAGE_SIZE/JOURNAL_SLOT_SIZE)
+
+//Record layout: magic (2 bytes), sequence number (4), length (1), reserved (1), configuration, CRC-32 of everything before it (4).
+#define RECORD_MAGIC				0xC0F6
+#define RECORD_HEADER_SIZE			8
+#define RECORD_CRC_SIZE				4
+#define RECORD_SIZE					(RECORD_HEADER_SIZE+CONFIG_SAVED_SIZE+RECORD_CRC_SIZE)
+
+#define SECTOR_ADDRESS(sector)		(JOURNAL_ADDRESS+((uint32_t)(sector)*FLASH_PARAM_SECTOR_SIZE))
+#define SLOT_ADDRESS(sector,slot)	(SECTOR_ADDRESS(sector)+((uint32_t)(slot)*JOURNAL_SLOT_SIZE))
+#define NEXT_SECTOR(sector)			(((sector)+1)%JOURNAL_SECTORS)
+#define JOURNAL_SLOT(sector,slot)	((uint16_t)((sector)*JOURNAL_SLOTS_PER_SECTOR+(slot)))
+#define NO_SLOT						0xFFFF
+
+//Fails to compile if a record does not fit in a slot.
+typedef char record_fits_in_slot[(RECORD_SIZE <= JOURNAL_SLOT_SIZE) ? 1 : -1];
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 // ENUMS AND ENUM TYPEDEFS
@@ -32,6 +64,19 @@
 // STRUCTS AND STRUCT TYPEDEFS
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 
+//Where the next record goes.
+typedef struct{
+
+	uint32_t sequence;							//Sequence number of the newest record.
+	uint8_t sector;								//Sector being written.
+	uint16_t next_slot;							//Next free slot in that sector.
+	uint8_t blank[JOURNAL_SECTORS];				//1 if the sector is known to be erased.
+	uint8_t erasing;							//1 while config_service() is erasing the next sector.
+	volatile uint8_t erase_pending;				//Cleared by the flash service when that erase is done.
+	uint16_t newest;							//Slot of the newest record, counted from the start of the journal.
+
+}configJournal_t;
+
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 // TYPEDEFS
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -41,11 +86,33 @@
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 // Description:
-//  Enter description for static function here.
+//  Waits for a background erase, so it cannot run after records are written to its sector. Gives up the CPU if the
+//	scheduler is running.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+static void finish_erase(void);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Erases a journal sector and waits for it to finish.
+//
+// Returns:
+//  FLASH_OK if the sector was erased.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+static FlashStatus_t erase_journal_sector(uint8_t sector);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Checks the magic number, length and CRC of a record.
 //
 // Returns:
-//  Enter description of return values (if any).
+//  1 if the record is good, 0 otherwise.
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
+static uint8_t record_valid(const uint8_t * record);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// CONSTANTS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+static configJournal_t journal = { .newest = NO_SLOT };
 
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -56,7 +123,16 @@ configStatus_t init_config(configData_t* configuration){
 	configuration->values.id = ID;
 
 	configuration->values.initial_time_to_wait = INITIAL_WAIT_TIME;
-	configuration->values.data_rate = DATA_RATE;
+	configuration->values.acc_rate = ACC_RATE;
+	configuration->values.gyro_rate = GYRO_RATE;
+	configuration->values.bmp_rate = BMP_RATE;
+	configuration->values.log_rate[LOG_PHASE_PAD] = LOG_RATE_PAD;
+	configuration->values.log_rate[LOG_PHASE_ASCENT] = LOG_RATE_ASCENT;
+	configuration->values.log_rate[LOG_PHASE_DROGUE] = LOG_RATE_DROGUE;
+	configuration->values.log_rate[LOG_PHASE_MAIN] = LOG_RATE_MAIN;
+	configuration->values.capture_pre = CAPTURE_PRE_TIME;
+	configuration->values.capture_post = CAPTURE_POST_TIME;
+	configuration->values.capture_shock = CAPTURE_SHOCK_G;
 	configuration->values.flags = FLAGS;
 	configuration->values.start_data_address = DATA_START_ADDRESS;
 	configuration->values.end_data_address = DATA_END_ADDRESS;
@@ -87,38 +163,270 @@ configStatus_t init_config(configData_t* configuration){
 
 }
 
+static void finish_erase(void){
+
+	while(journal.erase_pending){
+
+		if(xTaskGetSchedulerState() == taskSCHEDULER_RUNNING){
+			vTaskDelay(1);
+		}
+	}
+
+	if(journal.erasing){
+		journal.erasing = 0;
+		journal.blank[NEXT_SECTOR(journal.sector)] = 1;
+	}
+}
+
+static FlashStatus_t erase_journal_sector(uint8_t sector){
+
+	FlashStatus_t result = flash_erase(FLASH_CLASS_CONFIG,SECTOR_ADDRESS(sector),NULL);
+
+	if(result == FLASH_OK){
+		journal.blank[sector] = 1;
+	}
+
+	return result;
+}
+
+static uint8_t record_valid(const uint8_t * record){
+
+	uint32_t crc;
+	uint32_t stored_crc;
+
+	if(((record[0] << 8) | record[1]) != RECORD_MAGIC || record[6] != CONFIG_SAVED_SIZE){
+		return 0;
+	}
+
+	crc = crc32(record,RECORD_HEADER_SIZE+CONFIG_SAVED_SIZE);
+	stored_crc = ((uint32_t)record[RECORD_HEADER_SIZE+CONFIG_SAVED_SIZE] << 24) | ((uint32_t)record[RECORD_HEADER_SIZE+CONFIG_SAVED_SIZE+1] << 16)
+				| ((uint32_t)record[RECORD_HEADER_SIZE+CONFIG_SAVED_SIZE+2] << 8) | record[RECORD_HEADER_SIZE+CONFIG_SAVED_SIZE+3];
+
+	return crc == stored_crc;
+}
+
 configStatus_t read_config(configData_t* configuration){
 
 	configStatus_t stat = CONFIG_ERROR;
 
-	FlashStatus_t result = read_page(configuration->values.flash,0x00000000,configuration->bytes,sizeof(configData_t)-(sizeof(FlashStruct_t*)+4)); //The state variable is padded to 4 bytes!
+	uint8_t page[FLASH_PAGE_SIZE];
+	int16_t last_used[JOURNAL_SECTORS];		//Last slot that is not blank in each sector, -1 if none.
+	uint32_t newest_sequence = 0;
+	uint8_t newest_sector = 0;
+	uint16_t newest_slot = NO_SLOT;
+	uint8_t found = 0;
+	uint8_t sector;
+	uint16_t slot;
 
-	if(result == FLASH_OK){
+	for(sector=0;sector<JOURNAL_SECTORS;sector++){
+
+		last_used[sector] = -1;
+
+		for(slot=0;slot<JOURNAL_SLOTS_PER_SECTOR;slot++){
+
+			uint8_t * record = &page[(slot % JOURNAL_SLOTS_PER_PAGE)*JOURNAL_SLOT_SIZE];
+			uint16_t i;
+
+			if(slot % JOURNAL_SLOTS_PER_PAGE == 0){
+
+				if(flash_read(FLASH_CLASS_CONFIG,SLOT_ADDRESS(sector,slot),page,FLASH_PAGE_SIZE) != FLASH_OK){
+					return CONFIG_ERROR;
+				}
+			}
+
+			for(i=0;i<JOURNAL_SLOT_SIZE;i++){
+
+				if(record[i] != 0xFF){
+					last_used[sector] = slot;
+					break;
+				}
+			}
+
+			if(last_used[sector] == slot && record_valid(record)){
+
+				uint32_t sequence = ((uint32_t)record[2] << 24) | ((uint32_t)record[3] << 16) | ((uint32_t)record[4] << 8) | record[5];
+
+				if(!found || sequence > newest_sequence){
+
+					found = 1;
+					newest_sequence = sequence;
+					newest_sector = sector;
+					newest_slot = JOURNAL_SLOT(sector,slot);
+					memcpy(configuration->bytes,&record[RECORD_HEADER_SIZE],CONFIG_SAVED_SIZE);
+				}
+			}
+		}
+
+		journal.blank[sector] = (last_used[sector] < 0);
+	}
+
+	//Carry on after the last slot used in the sector with the newest record, a torn write after it is skipped.
+	journal.sequence = newest_sequence;
+	journal.sector = newest_sector;
+	journal.next_slot = last_used[newest_sector] + 1;
+	journal.erasing = 0;
+	journal.newest = newest_slot;
+
+	if(found){
 		stat = CONFIG_OK;
 	}
+	else{
+		memset(configuration->bytes,0xFF,CONFIG_SAVED_SIZE);
+	}
 
 	return stat;
 }
 
 configStatus_t write_config(configData_t* configuration){
 
+	uint8_t record[RECORD_SIZE];
+	uint8_t readback[RECORD_SIZE];
+	uint32_t sequence = journal.sequence + 1;
+	uint32_t crc;
+	uint8_t attempt;
+
+	record[0] = (RECORD_MAGIC >> 8) & 0xFF;
+	record[1] = RECORD_MAGIC & 0xFF;
+	record[2] = (sequence >> 24) & 0xFF;
+	record[3] = (sequence >> 16) & 0xFF;
+	record[4] = (sequence >> 8) & 0xFF;
+	record[5] = sequence & 0xFF;
+	record[6] = CONFIG_SAVED_SIZE;
+	record[7] = 0xFF;
+	memcpy(&record[RECORD_HEADER_SIZE],configuration->bytes,CONFIG_SAVED_SIZE);
+
+	crc = crc32(record,RECORD_HEADER_SIZE+CONFIG_SAVED_SIZE);
+	record[RECORD_HEADER_SIZE+CONFIG_SAVED_SIZE] = (crc >> 24) & 0xFF;
+	record[RECORD_HEADER_SIZE+CONFIG_SAVED_SIZE+1] = (crc >> 16) & 0xFF;
+	record[RECORD_HEADER_SIZE+CONFIG_SAVED_SIZE+2] = (crc >> 8) & 0xFF;
+	record[RECORD_HEADER_SIZE+CONFIG_SAVED_SIZE+3] = crc & 0xFF;
+
+	//A bad slot is skipped and the record written to the next one.
+	for(attempt=0;attempt<2;attempt++){
+
+		//Finish any background erase first.
+		finish_erase();
+
+		if(journal.next_slot >= JOURNAL_SLOTS_PER_SECTOR){
+
+			journal.sector = NEXT_SECTOR(journal.sector);
+			journal.next_slot = 0;
+
+			//Only happens if config_service() was not called in time.
+			if(!journal.blank[journal.sector] && erase_journal_sector(journal.sector) != FLASH_OK){
+				return CONFIG_ERROR;
+			}
+		}
 
-	FlashStatus_t result;
+		journal.blank[journal.sector] = 0;
 
-	configStatus_t stat = CONFIG_ERROR;
+		if(flash_program(FLASH_CLASS_CONFIG,SLOT_ADDRESS(journal.sector,journal.next_slot),record,RECORD_SIZE) != FLASH_OK){
+			return CONFIG_ERROR;
+		}
 
-	result = erase_param_sector(configuration->values.flash,0x00000000);
-	while(IS_DEVICE_BUSY(get_status_reg(configuration->values.flash))){}
+		journal.next_slot++;
 
-	if(result == FLASH_OK){
-	 result = program_page(configuration->values.flash,0x00000000,configuration->bytes,sizeof(configData_t)-(sizeof(FlashStruct_t*)+4));
+		if(flash_read(FLASH_CLASS_CONFIG,SLOT_ADDRESS(journal.sector,journal.next_slot-1),readback,RECORD_SIZE) == FLASH_OK
+				&& memcmp(record,readback,RECORD_SIZE) == 0){
 
-		while( IS_DEVICE_BUSY(get_status_reg(configuration->values.flash))){
-			stat = CONFIG_OK;
+			journal.sequence = sequence;
+			journal.newest = JOURNAL_SLOT(journal.sector,journal.next_slot-1);
+			return CONFIG_OK;
 		}
 	}
 
-	return stat;
+	return CONFIG_ERROR;
+}
+
+void config_service(configData_t* configuration){
+
+	uint8_t next = NEXT_SECTOR(journal.sector);
+
+	if(journal.erasing){
+
+		if(!journal.erase_pending){
+
+			journal.erasing = 0;
+			journal.blank[next] = 1;
+		}
+	}
+	else if(!journal.blank[next]){
+
+		//The newest record is always in the current sector, so the next one only holds old records.
+		if(flash_erase(FLASH_CLASS_ERASE,SECTOR_ADDRESS(next),&journal.erase_pending) == FLASH_OK){
+			journal.erasing = 1;
+		}
+	}
+}
+
+configStatus_t erase_config(configData_t* configuration){
+
+	uint8_t sector;
+
+	finish_erase();
+
+	for(sector=0;sector<JOURNAL_SECTORS;sector++){
+
+		if(erase_journal_sector(sector) != FLASH_OK){
+			return CONFIG_ERROR;
+		}
+	}
+
+	journal.sequence = 0;
+	journal.sector = 0;
+	journal.next_slot = 0;
+	journal.erasing = 0;
+	journal.newest = NO_SLOT;
+
+	return CONFIG_OK;
+}
+
+configStatus_t read_config_at(configData_t* configuration,uint16_t slot){
+
+	uint8_t records[2*JOURNAL_SLOT_SIZE];
+	uint8_t sector = slot / JOURNAL_SLOTS_PER_SECTOR;
+	uint16_t sector_slot = slot % JOURNAL_SLOTS_PER_SECTOR;
+	uint16_t length = JOURNAL_SLOT_SIZE;
+	uint16_t i;
+
+	if(sector >= JOURNAL_SECTORS){
+		return CONFIG_ERROR;
+	}
+
+	//Read the slot after it as well, if it is in the same sector.
+	if(sector_slot + 1 < JOURNAL_SLOTS_PER_SECTOR){
+		length = 2*JOURNAL_SLOT_SIZE;
+	}
+
+	if(flash_read(FLASH_CLASS_CONFIG,SLOT_ADDRESS(sector,sector_slot),records,length) != FLASH_OK || !record_valid(records)){
+		return CONFIG_ERROR;
+	}
+
+	for(i=JOURNAL_SLOT_SIZE;i<length;i++){
+
+		if(records[i] != 0xFF){
+			return CONFIG_ERROR;
+		}
+	}
+
+	memcpy(configuration->bytes,&records[RECORD_HEADER_SIZE],CONFIG_SAVED_SIZE);
+
+	//The other sectors were not read, so they are treated as not blank and erased before they are used.
+	for(i=0;i<JOURNAL_SECTORS;i++){
+		journal.blank[i] = 0;
+	}
+	journal.sequence = ((uint32_t)records[2] << 24) | ((uint32_t)records[3] << 16) | ((uint32_t)records[4] << 8) | records[5];
+	journal.sector = sector;
+	journal.next_slot = sector_slot + 1;
+	journal.erasing = 0;
+	journal.newest = slot;
+
+	return CONFIG_OK;
+}
+
+uint16_t config_journal_slot(void){
+
+	return journal.newest;
 }
 
 #endif
@@ -0,0 +1,116 @@
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// UMSATS 2018-2020
+//
+// Repository:
+//  UMSATS/Avionics-2019
+//
+// File Description:
+//  Source file for the CRC-32 functions.
+//
+// History
+// 2026-10-19
+// - Created.
+// - Added the CRC unit.
+// - Added crc16().
+// - The CRC unit is used inside a FreeRTOS critical section instead of with interrupts off, so the pyro timers still run.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include "crc.h"
+
+#if CRC_HARDWARE
+#include "stm32f4xx_hal.h"
+#include "cmsis_os.h"
+#endif
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// CONSTANTS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//CRC of each 4 bit value, so the CRC is done a nibble at a time with a small table.
+static const uint32_t crc_nibble_table[16] = {
+
+	0x00000000, 0x04C11DB7, 0x09823B6E, 0x0D4326D9, 0x130476DC, 0x17C56B6B, 0x1A864DB2, 0x1E475005,
+	0x2608EDB8, 0x22C9F00F, 0x2F8AD6D6, 0x2B4BCB61, 0x350C9B64, 0x31CD86D3, 0x3C8EA00A, 0x384FBDBD
+};
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// FUNCTIONS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+uint32_t crc32_update(uint32_t crc,const uint8_t * data,uint32_t length){
+
+	uint32_t i;
+
+	for(i=0;i<length;i++){
+
+		crc ^= (uint32_t)data[i] << 24;
+		crc = (crc << 4) ^ crc_nibble_table[crc >> 28];
+		crc = (crc << 4) ^ crc_nibble_table[crc >> 28];
+	}
+
+	return crc;
+}
+
+uint32_t crc32_software(const uint8_t * data,uint32_t length){
+
+	return crc32_update(CRC32_INIT,data,length);
+}
+
+#if CRC_HARDWARE
+uint32_t crc32_hardware(const uint8_t * data,uint32_t length){
+
+	uint32_t words = length/4;
+	uint32_t crc;
+	uint32_t i;
+
+	if(!(RCC->AHB1ENR & RCC_AHB1ENR_CRCEN)){
+		__HAL_RCC_CRC_CLK_ENABLE();
+	}
+
+	//Only masks interrupts up to configMAX_SYSCALL_INTERRUPT_PRIORITY, the pyro timers run above it.
+	taskENTER_CRITICAL();
+
+	CRC->CR = CRC_CR_RESET;
+
+	//The unit takes the most significant byte of a word first, so the bytes are put in big endian.
+	for(i=0;i<words;i++){
+
+		CRC->DR = ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) | ((uint32_t)data[2] << 8) | data[3];
+		data += 4;
+	}
+	crc = CRC->DR;
+
+	taskEXIT_CRITICAL();
+
+	return crc32_update(crc,data,length - words*4);
+}
+#endif
+
+uint32_t crc32(const uint8_t * data,uint32_t length){
+
+#if CRC_HARDWARE
+	return crc32_hardware(data,length);
+#else
+	return crc32_software(data,length);
+#endif
+}
+
+uint16_t crc16(const uint8_t * data,uint32_t length){
+
+	uint16_t crc = CRC16_INIT;
+	uint32_t i;
+	uint8_t bit;
+
+	for(i=0;i<length;i++){
+
+		crc ^= (uint16_t)data[i] << 8;
+		for(bit=0;bit<8;bit++){
+			crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+		}
+	}
+
+	return crc;
+}
@@ -10,12 +10,40 @@
 // History
 // 2019-04-10 by Joseph Howarth
 // - Created.
+// 2026-10-19
+// - Packet encoding, page buffering and flight detection moved to logPacket.c and flightState.c.
+// - Added profiling zones and periodic profile records.
+// - Added periodic task monitor records.
+// - The next configuration journal sector is erased while on the pad.
+// - Checkpoints of the flight state are saved at 10 Hz in flight, and logging carries on from one after a reset.
+// - E-matches are fired without waiting for the pulse. Deployment is confirmed from the pulse result events.
+// - Starts the backup timers directly instead of resuming the timer task.
+// - Logs each reading from the shared sensor queue as it comes, so the sensors can run at different rates.
+// - Measurement times are microsecond deltas, with sync records of the full time.
+// - Readings are averaged down to the logging rate of the flight phase before they are written.
+// - Launch, deployments and shocks write a window of readings at full rate from a RAM history.
+// - New flight events are written to the event journal straight away, before any more log data.
+// - Pages are written through the flash service.
+// - Each page is read back while the next one fills, and is programmed again or remapped if it does not match.
+// - The flight state, estimates and events are published to the telemetry task with every pressure reading.
+// - When not recording, every reading is sent on the live sensor stream instead of sending the log pages over UART.
+// - Page sequence numbers carry on from the pages already written after a reset.
+// - Events, the altitude estimate and health counters are written to the summary log in the internal flash.
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 // INCLUDES
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 #include "dataLogging.h"
+#include "profiler.h"
+#include "taskMonitor.h"
+#include "restart.h"
+#include "timer.h"
+#include "eventJournal.h"
+#include "logIndex.h"
+#include "telemetry.h"
+#include "liveStream.h"
+#include "summaryLog.h"
 
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -30,599 +58,647 @@
 // STRUCTS AND STRUCT TYPEDEFS
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 
+//Where full pages go.
+typedef struct{
+
+	configData_t * configParams;
+	uint32_t flash_address;
+
+}PageOutput_t;
+
+//The last page programmed, kept until its verify is done.
+typedef struct{
+
+	uint8_t active;						//1 while a verify has been started and not checked.
+	uint32_t address;
+	uint8_t data[FLASH_PAGE_SIZE];
+	volatile uint8_t pending;			//Cleared by the flash service when the verify is done.
+	FlashStatus_t result;
+
+}PageVerify_t;
+
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 // TYPEDEFS
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 
-//Checks if a measurement is empty. returns 0 if it is empty.
-uint8_t isMeasurementEmpty(Measurement_t * measurement){
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// CONSTANTS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
 
-	uint8_t result = 0;
-	int i;
+//Kept out of the task stack, the launch pad buffer alone is 25 pages.
+static LogWriter_t writer;
 
-	for(i=0;i<sizeof(Measurement_t);i++){
+//For building extended records.
+static uint8_t ext_payload[EXT_MAX_PAYLOAD];
+static uint8_t ext_record[HEADER_SIZE+EXT_MAX_PAYLOAD];
 
-		if(measurement->data[i] != 0){
-			result ++;
-		}
-	}
-	return result;
-}
-//-------------------------------------------------------------------------------------------------------------------------------------------------------------
-// FUNCTIONS
-//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+//Time and encoding of the measurements written.
+static LogClock_t log_clock;
+static Measurement_t measurement;
 
-void loggingTask(void * params){
+//Readings at full rate for the event capture windows.
+static eventCapture_t capture;
 
-	LoggingStruct_t * logStruct = (LoggingStruct_t *)params;
-	FlashStruct_t * flash_ptr = logStruct->flash_ptr;
-	UART_HandleTypeDef * huart = logStruct->uart;
-	configData_t * configParams = logStruct->flightCompConfig;
-	TaskHandle_t *timerTask_h = logStruct->timerTask_h;
-	uint32_t flash_address = FLASH_START_ADDRESS;
+//Events already in the event journal. Detections are reported with every reading until the deployment is confirmed.
+static uint32_t journaled_events;
 
-	if(IS_IN_FLIGHT(configParams->values.flags)){
+#if LOG_VERIFY_ENABLED
+static PageVerify_t verify;
+#endif
 
-		flash_address = configParams->values.end_data_address;
-	}
+//Readings since the last summary health record.
+static uint16_t summary_acc_readings;
+static uint16_t summary_bmp_readings;
 
-	//If start and end are equal there is no other flight data, otherwise start recording after already saved data.
-//	if(configParams->values.start_data_address == configParams->values.end_data_address){
-//
-//		flash_address = configParams->values.start_data_address;
-//	}else{
-//		flash_address = configParams->values.end_data_address;
-//	}
-
-//	int32_t velocity_a = 0;
-//	int32_t velocity_p = 0;
-//	int32_t acc_x_filtered;
-//	int32_t acc_y_filtered;
-	int32_t acc_z_filtered;
-	uint8_t acc_z_filter_index=0;
-	float altFiltered = 0;
-	uint8_t alt_filter_count=0;
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// FUNCTIONS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
 
-	uint8_t running = 1;
-	uint8_t data_bufferA[DATA_BUFFER_SIZE];			//This stores the data until we have enough to write to flash.
-	uint8_t	data_bufferB[DATA_BUFFER_SIZE]; 		//This stores the data until we have enough to write to flash.
-	uint16_t ring_buff_size  = DATA_BUFFER_SIZE*25;
-	uint8_t launchpadBuffer[ring_buff_size];
-	BufferSelection_t buffer_selection = BUFFER_A;
-	uint16_t buffer_index_curr = 0;					//The current index in the buffer.
+#if LOG_VERIFY_ENABLED
+//Starts reading back a page just programmed. The flash service does it while the logging task fills the next page.
+static void start_verify(uint32_t address,const uint8_t * page,FlashStatus_t program_result){
 
+	memcpy(verify.data,page,FLASH_PAGE_SIZE);
+	verify.address = address;
+	verify.active = 1;
 
-	uint8_t is_there_data; 				//Used to keep track of if the current measurement has data.
-	Measurement_t measurement;
-	uint8_t measurement_length = 0;
+	if(program_result != FLASH_OK){
+		verify.result = FLASH_ERROR;
+	}
+	else if(flash_verify(FLASH_CLASS_DATA,address,verify.data,FLASH_PAGE_SIZE,&verify.pending,&verify.result) == FLASH_BUSY){
+		verify.result = flash_verify(FLASH_CLASS_DATA,address,verify.data,FLASH_PAGE_SIZE,NULL,NULL);
+	}
+}
 
-	uint32_t prev_time_ticks = 0;	//Holds the previous time to calculate the change in time.
+//Checks the verify of the last page. A page that does not match is programmed again, which can only clear bits and so
+//finishes a page that was left partly programmed, and then moved to a spare page.
+static void check_verify(void){
 
-	char buf[120];
+	uint8_t retry;
 
-	HAL_GPIO_WritePin(USR_LED_PORT,USR_LED_PIN,GPIO_PIN_RESET);
+	if(!verify.active){
+		return;
+	}
 
-	//Make sure the measurement starts empty.
-	int i;
-	for(i=0;i<sizeof(Measurement_t);i++){
+	//Normally done long before the next page is full.
+	while(verify.pending){
+		osDelay(1);
+	}
+	verify.active = 0;
+
+	for(retry=0;retry<LOG_VERIFY_RETRIES && verify.result != FLASH_OK;retry++){
 
-		measurement.data[i] = 0;
+		if(flash_program(FLASH_CLASS_DATA,verify.address,verify.data,FLASH_PAGE_SIZE) == FLASH_OK){
+			verify.result = flash_verify(FLASH_CLASS_DATA,verify.address,verify.data,FLASH_PAGE_SIZE,NULL,NULL);
+		}
 	}
 
+	if(verify.result != FLASH_OK){
+		log_index_remap(verify.address,verify.data);
+	}
+}
+#endif
 
-	imu_data_struct  imu_reading;
+//Writes a full page to flash. When not recording the page is dropped, the readings went out on the live stream.
+static void write_page(void * context,uint8_t * page){
 
-	bmp_data_struct	bmp_reading;
+	PageOutput_t * output = (PageOutput_t *)context;
 
-	prev_time_ticks = xTaskGetTickCount();
+	if(IS_RECORDING(output->configParams->values.flags)){
 
+#if LOG_VERIFY_ENABLED
+		check_verify();
+		start_verify(output->flash_address,page,flash_program(FLASH_CLASS_DATA,output->flash_address,page,FLASH_PAGE_SIZE));
+#else
+		flash_program(FLASH_CLASS_DATA,output->flash_address,page,FLASH_PAGE_SIZE);
+#endif
 
-	alt_value altitude;
-	alt_value alt_prev;
-	alt_prev.float_val = 0;
-	uint8_t alt_count = 0;
-	uint8_t alt_main_count = 0;
-	uint16_t apogee_holdout_count = 0;
-	uint8_t landed_counter = 0;
+		output->flash_address += FLASH_PAGE_SIZE;
+		if(output->flash_address>=FLASH_SIZE_BYTES){
+			while(1);
+		}
+	}
+}
 
-	//buzz(250);
-	if(!IS_IN_FLIGHT(configParams->values.flags)){
-	recoverySelect_t event_d = DROGUE;
-	continuityStatus_t cont_d = check_continuity(event_d);
+//Adds a packet to the launch pad buffer while waiting for launch, otherwise to the page stream.
+static void append_packet(configData_t * configParams,const uint8_t * data,uint16_t length){
 
-	recoverySelect_t event_m = MAIN;
-	continuityStatus_t cont_m = check_continuity(event_m);
+	if(configParams->values.state == STATE_LAUNCHPAD_ARMED){
 
-	while(cont_m == OPEN_CIRCUIT || cont_d == OPEN_CIRCUIT){
+		log_writer_append_pad(&writer,data,length);
+	}
+	else{
 
-		cont_m = check_continuity(event_m);
-		cont_d = check_continuity(event_d);
+		log_writer_append(&writer,data,length);
 	}
-	configParams->values.state = STATE_LAUNCHPAD_ARMED;
-	write_config(configParams);}
+}
 
-	buzz(250); // CHANGE TO 2 SECONDS!!!!!!!
-	while(1){
+//Adds an extended record built from ext_payload. Extended records do not carry time, so they can go between any two measurements.
+static void append_ext(configData_t * configParams,uint8_t kind,uint8_t payload_length){
 
-		measurement_length=0;
+	uint8_t record_length = log_packet_ext(ext_record,kind,ext_payload,payload_length);
 
-		/* IMU READING*******************************************************************************************************************************/
+	if(payload_length > 0 && record_length > 0){
+		append_packet(configParams,ext_record,record_length);
+	}
+}
 
-		//Try and get data from the IMU queue. Block for up to a quarter of the time between the fastest measurement.
-		BaseType_t stat = xQueueReceive(logStruct->IMU_data_queue,&imu_reading,configParams->values.data_rate/4);
+//Writes a reading as a measurement, after a sync record if the clock needs one.
+static void append_reading(configData_t * configParams,const captureReading_t * reading,uint32_t events){
 
-		if(stat == pdPASS){
-			//We have read data from the IMU.
+	uint8_t sync_record[SYNC_RECORD_SIZE];
+	uint8_t sync_length;
+	uint16_t delta_t;
+	alt_value altitude;
 
-			//Check if the current measurement has data.
-			is_there_data = isMeasurementEmpty(&measurement);
+	PROFILE_BEGIN(PROFILE_PACKET_ENCODE);
+	sync_length = log_clock_stamp(&log_clock,reading->time_us,&delta_t,sync_record);
+	log_packet_begin(&measurement,delta_t);
 
-			if(!is_there_data){
+	if(reading->types & ACC_TYPE){
+		log_packet_add_acc(&measurement,reading->acc);
+	}
+	if(reading->types & GYRO_TYPE){
+		log_packet_add_gyro(&measurement,reading->gyro);
+	}
+	if(reading->types & PRES_TYPE){
+		altitude = altitude_approx((float)reading->pressure,(float)reading->temperature,configParams);
+		log_packet_set_pres(&measurement,reading->pressure,(uint32_t)reading->temperature,altitude.byte_val);
+	}
 
-				uint16_t delta_t = imu_reading.time_ticks-prev_time_ticks;
+	log_packet_add_event(&measurement,events);
+	PROFILE_END(PROFILE_PACKET_ENCODE);
 
-				uint32_t header  = (ACC_TYPE | GYRO_TYPE) + (delta_t & 0x0FFF);// Make sure time doesn't overwrite type and event bits.
+	if(sync_length > 0){
+		append_packet(configParams,sync_record,sync_length);
+	}
 
-				measurement.data[0] = (header >> 16) & 0xFF;
-				measurement.data[1] = (header >> 8) & 0xFF;
-				measurement.data[2] = (header) & 0xFF;
+	append_packet(configParams,measurement.data,log_packet_length(log_packet_header(measurement.data)));
+	log_packet_clear(&measurement);
+}
 
-				measurement_length = ACC_LENGTH + GYRO_LENGTH;
+//Writes the events that are not in the event journal yet. Called as soon as the events are known, so the record is in
+//flash before the page writes that follow.
+static void summary_event(uint8_t state,uint8_t events,uint32_t log_address){
 
-				prev_time_ticks = imu_reading.time_ticks;
+	summaryRecord_t record;
 
-				measurement.data[3] = ((uint16_t)imu_reading.data_acc.x) >>8;
-				measurement.data[4] = ((uint16_t)imu_reading.data_acc.x) & 0xFF;
+	memset(&record,0,sizeof(record));
+	record.kind = SUMMARY_KIND_EVENT;
+	record.state = state;
+	record.events = events;
+	record.log_address = log_address;
+	summary_log_put(&record);
+}
 
-				measurement.data[5] = ((uint16_t)imu_reading.data_acc.y) >>8;
-				measurement.data[6] = ((uint16_t)imu_reading.data_acc.y) & 0xFF;
+static void journal_events(const flightState_t * fs,uint8_t state,uint32_t events,uint32_t time_us,uint32_t flight_time,uint32_t log_address){
 
-				measurement.data[7] = ((uint16_t)imu_reading.data_acc.z) >>8;
-				measurement.data[8] = ((uint16_t)imu_reading.data_acc.z) & 0xFF;
+	eventRecord_t record;
 
-				measurement.data[9] = ((uint16_t)imu_reading.data_gyro.x) >>8;
-				measurement.data[10] = ((uint16_t)imu_reading.data_gyro.x) & 0xFF;
+	events &= EVENT_MASK & ~journaled_events;
+	if(events == 0){
+		return;
+	}
 
-				measurement.data[11] = ((uint16_t)imu_reading.data_gyro.y) >>8;
-				measurement.data[12] = ((uint16_t)imu_reading.data_gyro.y) & 0xFF;
+	record.time_us = time_us;
+	record.flight_time = flight_time;
+	record.events = events >> EXT_KIND_SHIFT;
+	record.state = state;
+	record.altitude = fs->altitude;
+	record.alt_filtered = fs->alt_filtered;
+	record.log_address = log_address;
 
-				measurement.data[13] = ((uint16_t)imu_reading.data_gyro.z) >>8;
-				measurement.data[14] = ((uint16_t)imu_reading.data_gyro.z) & 0xFF;
+	PROFILE_BEGIN(PROFILE_EVENT_JOURNAL);
+	event_journal_write(&record);
+	PROFILE_END(PROFILE_EVENT_JOURNAL);
 
-//				int32_t acc_z_temp = imu_reading.data_acc.z - 2732;
-//				acc_z_filtered += acc_z_temp;
-//				acc_z_filter_index ++;
-//				if(acc_z_filter_index == 8){
-//
-//					acc_z_filtered = acc_z_filtered >>3;
-//					acc_z_filter_index = 0;
-//
-//				}
+	summary_event(state,record.events,log_address);
 
+	journaled_events |= events;
+}
 
+static void summary_state(const flightState_t * fs,uint8_t state){
 
-//				sprintf(buf,"%d acc.z %ld acc.z filtered\n",imu_reading.data_acc.z,acc_z_filtered);
-//				transmit_line(huart, buf);
-			}
+	summaryRecord_t record;
 
+	memset(&record,0,sizeof(record));
+	record.kind = SUMMARY_KIND_STATE;
+	record.state = state;
+	record.altitude = fs->altitude;
+	record.alt_filtered = fs->alt_filtered;
+	summary_log_put(&record);
+}
 
-			HAL_GPIO_TogglePin(USR_LED_PORT,USR_LED_PIN);
-		}
-		else{
+static void summary_health(uint8_t state){
 
-			for(i=0;i<sizeof(Measurement_t);i++){
+	summaryRecord_t record;
+	flashClassStats_t stats;
+	uint32_t errors = 0;
+	uint16_t remapped = log_index_count();
+	uint8_t i;
 
-				measurement.data[i] = 0;
-			}
-			continue;
-		}
+	for(i=0;i<FLASH_CLASSES;i++){
+		flash_service_stats(i,&stats);
+		errors += stats.errors;
+	}
 
-		/* BMP READING*******************************************************************************************************************************/
-		//Try and get data from the BMP queue. Block for up to a quarter of the time between the fastest measurement.
-		stat = xQueueReceive(logStruct->PRES_data_queue,&bmp_reading,configParams->values.data_rate/4);
+	memset(&record,0,sizeof(record));
+	record.kind = SUMMARY_KIND_HEALTH;
+	record.state = state;
+	record.flash_errors = (errors > 0xFFFF) ? 0xFFFF : errors;
+	record.acc_readings = summary_acc_readings;
+	record.bmp_readings = summary_bmp_readings;
+	record.remapped = (remapped > 0xFF) ? 0xFF : remapped;
+	summary_log_put(&record);
+
+	summary_acc_readings = 0;
+	summary_bmp_readings = 0;
+}
 
-		if(stat == pdPASS){
+void loggingTask(void * params){
 
-			is_there_data = isMeasurementEmpty(&measurement);
+	LoggingStruct_t * logStruct = (LoggingStruct_t *)params;
+	configData_t * configParams = logStruct->flightCompConfig;
+	checkpoint_t * resume = logStruct->resume;
 
-			if(is_there_data){
-				//We already have a imu reading.
+	PageOutput_t output;
+	output.configParams = configParams;
+	output.flash_address = FLASH_START_ADDRESS;
 
-				measurement_length += (PRES_LENGTH + TEMP_LENGTH + ALT_LENGTH);
+	if(IS_IN_FLIGHT(configParams->values.flags)){
 
-				//Update the header bytes.
-				uint32_t header = (measurement.data[0]<<16)+(measurement.data[1]<<8) + measurement.data[2];
-				header |= PRES_TYPE | TEMP_TYPE;
+		output.flash_address = configParams->values.end_data_address;
+	}
 
-				measurement.data[0] = (header >> 16) & 0xFF;
-				measurement.data[1] = (header >> 8) & 0xFF;
-				measurement.data[2] = (header) & 0xFF;
+	checkpoint_t checkpoint;
+	uint32_t checkpoint_ticks;
+	uint32_t launch_ticks = 0;
+	uint32_t summary_state_ticks;
+	uint32_t summary_health_ticks;
 
-				measurement.data[15]= (((uint32_t)bmp_reading.data.pressure) >>16) &0xFF ;	//MSB
-				measurement.data[16]= (((uint32_t)bmp_reading.data.pressure) >> 8) & 0xFF;	//LSB
-				measurement.data[17]= ((uint32_t)bmp_reading.data.pressure) & 0xFF;		//XLSB
+	uint8_t running = 1;
+	uint32_t start_ticks;
+	logRate_t log_rate;
+	uint8_t phase;
+	uint8_t logged;				//Set when anything was written for this reading.
+	captureReading_t current;	//This reading.
+	captureReading_t mean;		//Averages to log with this reading.
+	uint8_t triggers;
+	uint16_t history;
+
+	flightState_t flight_state;
+	flightSample_t sample;
+	uint32_t events;
+	uint32_t telemetry_events = 0;	//Events since the last pressure reading.
+	telemetrySample_t telemetry;
+	pyroEvent_t pyro_event;
+
+	sensorReading_t reading;
+	alt_value altitude;
 
-				measurement.data[18]= (((uint32_t)bmp_reading.data.temperature) >>16) & 0xFF;	//MSB
-				measurement.data[19]= ((uint32_t)bmp_reading.data.temperature >> 8) & 0xFF;	//LSB
-				measurement.data[20]= (uint32_t)bmp_reading.data.temperature & 0xFF; //XLSB
+	HAL_GPIO_WritePin(USR_LED_PORT,USR_LED_PIN,GPIO_PIN_RESET);
 
-		    	altitude = altitude_approx((float)bmp_reading.data.pressure, (float)bmp_reading.data.temperature,configParams);
-		    	measurement.data[21] = (altitude.byte_val>>24) & 0xFF;
-		    	measurement.data[22] = (altitude.byte_val>>16) & 0xFF;
-		    	measurement.data[23] = (altitude.byte_val>>8) & 0xFF;
-		    	measurement.data[24] = (altitude.byte_val) & 0xFF;
+	//Pages are numbered from the start of the log, so after a reset the numbers carry on from the pages already written.
+	log_writer_init(&writer,write_page,&output,(output.flash_address - FLASH_START_ADDRESS)/FLASH_PAGE_SIZE);
+	log_packet_clear(&measurement);
+	log_clock_init(&log_clock);
+	capture_init(&capture,configParams->values.capture_pre,configParams->values.capture_post,
+			capture_shock_level(configParams->values.capture_shock,configParams->values.ac_range));
+	{
+		uint32_t periods[3] = { acquisition_period(ACQ_ACC), acquisition_period(ACQ_GYRO), acquisition_period(ACQ_BMP) };
+
+		log_rate_init(&log_rate,periods);
+		phase = log_rate_phase(configParams->values.state);
+		log_rate_set(&log_rate,phase,configParams->values.log_rate[phase]);
+	}
+	memset(&sample,0,sizeof(sample));		//Until the first reading of each sensor.
+	flight_state_init(&flight_state,&configParams->values.state,&configParams->values.flags);
 
+	start_ticks = xTaskGetTickCount();
+	checkpoint_ticks = start_ticks;
+	summary_state_ticks = start_ticks;
+	summary_health_ticks = start_ticks;
 
-		    	altFiltered = altFiltered + (altitude.float_val - altFiltered)*0.2;
+	if(resume != NULL){
 
-//		    	int16_t alt_int = altitude.float_val;
-//		    	int16_t alt_dec = (altitude.float_val*100)-(alt_int*100);
-//				int16_t alt_int = altFiltered;
-//				int16_t alt_dec = (altFiltered*100)-(alt_int*100);
-//		    	char c = ' ';
-//		    	if(alt_int < 0 ){
-//		    		alt_int = -alt_int;
-//		    		c = '-';
-//		    	}
-//		    	if(alt_dec < 0 ){
-//		    		alt_dec = -alt_dec;
-//		    		c = '-';
-//		    	}
-//
-//		    	sprintf(buf, "Altitude: %c%d.%02d [m]", c,alt_int,alt_dec);
-//		    	transmit_line(huart, buf);
+		//Carry on from the checkpoint. The time between the checkpoint and the reset is not known, up to CHECKPOINT_PERIOD.
+		uint32_t flight_time = resume->flight_time + restart_boot_time()/1000;
 
-			}
+		checkpoint_restore(resume,&flight_state);
+		launch_ticks = start_ticks - pdMS_TO_TICKS(flight_time);
 
+		if(resume->state == STATE_IN_FLIGHT_PRE_APOGEE || resume->state == STATE_IN_FLIGHT_POST_APOGEE){
 
+			backup_timer_start(flight_time);
 		}
-		else{
-			for(i=0;i<sizeof(Measurement_t);i++){
+	}
 
-				measurement.data[i] = 0;
-			}
-			continue;
-		}
+#if PROFILING_ENABLED && PROFILING_LOG_PERIOD > 0
+	uint32_t profile_log_ticks = start_ticks;
+#endif
+#if TASK_MONITOR_LOG_PERIOD > 0
+	uint32_t task_log_ticks = start_ticks;
+#endif
 
+	//buzz(250);
+	if(!IS_IN_FLIGHT(configParams->values.flags)){
+	recoverySelect_t event_d = DROGUE;
+	continuityStatus_t cont_d = check_continuity(event_d);
 
-		if(configParams->values.state == STATE_LAUNCHPAD_ARMED && imu_reading.data_acc.x>10892){
-			
-			buzz(250);
-			vTaskResume(*timerTask_h); //start fixed timers.
-			configParams->values.state = STATE_IN_FLIGHT_PRE_APOGEE;
-			configParams->values.flags = configParams->values.flags |  0x04;
-			//configParams->values.state = STATE_IN_FLIGHT_POST_APOGEE;
-			//Record the launch event.
-			uint32_t header = (measurement.data[0]<<16)+(measurement.data[1]<<8) + measurement.data[2];
-			header |= LAUNCH_DETECT;
-			configParams->values.flags = configParams->values.flags | 0x01;
-			write_config(configParams);
+	recoverySelect_t event_m = MAIN;
+	continuityStatus_t cont_m = check_continuity(event_m);
 
-			measurement.data[0] = (header >> 16) & 0xFF;
-			measurement.data[1] = (header >> 8) & 0xFF;
-			measurement.data[2] = (header) & 0xFF;
-			
-			int p;
-			uint16_t buff_end = (ring_buff_size);
-			for(p=0;p<25;p++){
-				//need to copy last portion into the bufferA. Make sure to start from right place, which wont be the next spot.
-
-				if((buffer_index_curr + 256) < buff_end){
-				FlashStatus_t stat_f2 = program_page(flash_ptr,flash_address,&launchpadBuffer[buffer_index_curr],DATA_BUFFER_SIZE);
-				while(IS_DEVICE_BUSY(stat_f2)){
-					  stat_f2 = get_status_reg(flash_ptr);
-					 vTaskDelay(1);
-				 }
-				 buffer_index_curr += 256;
-				}
-				else{
-
-					uint8_t buff_temp[256];
-					memcpy(&buff_temp,&launchpadBuffer[buffer_index_curr],buff_end-buffer_index_curr);
-					memcpy(&buff_temp[buff_end-buffer_index_curr],&launchpadBuffer,DATA_BUFFER_SIZE-(buff_end-buffer_index_curr));
-
-					FlashStatus_t stat_f2 = program_page(flash_ptr,flash_address,buff_temp,DATA_BUFFER_SIZE);
-					  while(IS_DEVICE_BUSY(stat_f2)){
-						  stat_f2 = get_status_reg(flash_ptr);
-						 vTaskDelay(1);
-					  }
-					  buffer_index_curr = DATA_BUFFER_SIZE-(buff_end-buffer_index_curr);
-				}
+	while(cont_m == OPEN_CIRCUIT || cont_d == OPEN_CIRCUIT){
 
-				flash_address += DATA_BUFFER_SIZE;
-			}
-			buffer_index_curr = 0 ;
-		}
+		cont_m = check_continuity(event_m);
+		cont_d = check_continuity(event_d);
+	}
+	configParams->values.state = STATE_LAUNCHPAD_ARMED;
+	write_config(configParams);
+	restart_clear();}
 
-		//Check if the rocket has landed.
- 		if(configParams->values.state == STATE_IN_FLIGHT_POST_MAIN){
+	//Drop the results of any test firing from the menu.
+	while(pyro_get_event(&pyro_event));
 
-			if(alt_count >0){
+	//Without recording the readings are only useful on the UART, which nothing else uses now.
+	if(!IS_RECORDING(configParams->values.flags)){
+		live_stream_start(logStruct->uart);
+	}
 
-				//If altitude is within a 1m range for 20 samples
-				if(altitude.float_val>(alt_prev.float_val - 1.0) && altitude.float_val < (alt_prev.float_val+1.0)){
-					alt_count++;
-					if(alt_count >245){
-						alt_count = 201;
-					}
-				}else{
-					alt_count = 0;
-				}
+	buzz(250); // CHANGE TO 2 SECONDS!!!!!!!
+	while(1){
 
-			}
-			else{
+		/* SENSOR READING****************************************************************************************************************************/
 
-				alt_prev.float_val = altitude.float_val;
-				alt_count++;
-				if(alt_count >245){
-					alt_count = 201;
-				}
-			}
+		//Readings come from the IMU and BMP388 tasks at their own rates. The flight state uses every reading, the log
+		//gets averages at the rate of the flight phase.
+		BaseType_t stat = xQueueReceive(logStruct->sensor_queue,&reading,portMAX_DELAY);
 
-			if((pow(imu_reading.data_gyro.x,2)+pow(imu_reading.data_gyro.y,2)+pow(imu_reading.data_gyro.z,2))<63075){
-			//If the gyro readings are all less than ~4.4 deg/sec and the altitude is not changing then the rocket has probably landed.
+		if(stat != pdPASS){
+			continue;
+		}
 
-				if(alt_count > 200){
+		if(reading.sensors & ACQ_ACC){
 
-					configParams->values.state = STATE_LANDED;
-					configParams->values.flags = configParams->values.flags & ~(0x01);
-					write_config(configParams);
-					uint32_t header = (measurement.data[0]<<16)+(measurement.data[1]<<8) + measurement.data[2];
-					header |= LAND_DETECT;
+			sample.acc[0] = reading.acc.x;
+			sample.acc[1] = reading.acc.y;
+			sample.acc[2] = reading.acc.z;
+		}
 
-					measurement.data[0] = (header >> 16) & 0xFF;
-					measurement.data[1] = (header >> 8) & 0xFF;
-					measurement.data[2] = (header) & 0xFF;
+		if(reading.sensors & ACQ_GYRO){
 
-					//Put everything into low power mode.
-					running = 0;
+			sample.gyro[0] = reading.gyro.x;
+			sample.gyro[1] = reading.gyro.y;
+			sample.gyro[2] = reading.gyro.z;
+		}
 
-				}
-			}
+		if(reading.sensors & ACQ_BMP){
+
+			altitude = altitude_approx((float)reading.bmp.pressure, (float)reading.bmp.temperature,configParams);
+			sample.altitude = altitude.float_val;
 		}
-		
-		
-		//Check if the altitude is below 1500ft, after the drogue has been deployed.
-		if(configParams->values.state == STATE_IN_FLIGHT_POST_APOGEE ){
-
-			if(altFiltered<375.0){
-				//375m ==  1230 ft
-				alt_main_count ++;
-			}
-			else{
-				alt_main_count = 0;
-			}
-			if(alt_main_count>5){
-				//deploy main
-				buzz(250);
-				recoverySelect_t event = MAIN;
-				enable_mosfet(event);
-				activate_mosfet(event);
-				continuityStatus_t cont = check_continuity(event);
-				uint32_t header = (measurement.data[0]<<16)+(measurement.data[1]<<8) + measurement.data[2];
-				header |= MAIN_DETECT;
-
-				measurement.data[0] = (header >> 16) & 0xFF;
-				measurement.data[1] = (header >> 8) & 0xFF;
-				measurement.data[2] = (header) & 0xFF;
-
-				if(cont == OPEN_CIRCUIT){
-
-					configParams->values.state =  STATE_IN_FLIGHT_POST_MAIN;
-					configParams->values.flags = configParams->values.flags |  0x10;
-					write_config(configParams);
-					uint32_t header = (measurement.data[0]<<16)+(measurement.data[1]<<8) + measurement.data[2];
-					header |= MAIN_DEPLOY;
-					measurement.data[0] = (header >> 16) & 0xFF;
-					measurement.data[1] = (header >> 8) & 0xFF;
-					measurement.data[2] = (header) & 0xFF;
 
-				}
-			}
+		current.time_us = reading.time_us;
+		current.types = 0;
+		if(reading.sensors & ACQ_ACC){
+			current.types |= ACC_TYPE;
+			memcpy(current.acc,sample.acc,sizeof(current.acc));
+		}
+		if(reading.sensors & ACQ_GYRO){
+			current.types |= GYRO_TYPE;
+			memcpy(current.gyro,sample.gyro,sizeof(current.gyro));
 		}
+		if(reading.sensors & ACQ_BMP){
+			current.types |= PRES_TYPE | TEMP_TYPE;
+			current.pressure = (uint32_t)reading.bmp.pressure;
+			current.temperature = (int32_t)reading.bmp.temperature;
+		}
+		capture_add(&capture,&current);
 
-		//check if rocket has reached apogee.
-		if(configParams->values.state == STATE_IN_FLIGHT_PRE_APOGEE){
+		/* FLIGHT EVENTS*****************************************************************************************************************************/
+		//The state machine counts samples, so it runs once per pressure reading with the latest IMU reading.
+		events = 0;
 
-			apogee_holdout_count ++;
-			if(apogee_holdout_count >(20*15)){
+		if(reading.sensors & ACQ_BMP){
 
-				uint64_t acc_mag = pow(imu_reading.data_acc.x,2)+pow(imu_reading.data_acc.y,2)+pow(imu_reading.data_acc.z,2);
-				if(acc_mag < 1 && altFiltered > 9000.0){
-					//5565132 = 3 * 1362^2 (aprox 0.5 g on all direction)
-					//2438m -> 8,000 ft
+			HAL_GPIO_TogglePin(USR_LED_PORT,USR_LED_PIN);
 
-					buzz(250);
-					recoverySelect_t event = DROGUE;
-					enable_mosfet(event);
-					activate_mosfet(event);
-					continuityStatus_t cont = check_continuity(event);
-					uint32_t header = (measurement.data[0]<<16)+(measurement.data[1]<<8) + measurement.data[2];
-					header |= DROGUE_DETECT;
-					measurement.data[0] = (header >> 16) & 0xFF;
-					measurement.data[1] = (header >> 8) & 0xFF;
-					measurement.data[2] = (header) & 0xFF;
-
-					if(cont == OPEN_CIRCUIT){
-						configParams->values.state =  STATE_IN_FLIGHT_POST_APOGEE;
-						configParams->values.flags = configParams->values.flags |  0x08;
-						write_config(configParams);
-
-						uint32_t header = (measurement.data[0]<<16)+(measurement.data[1]<<8) + measurement.data[2];
-						header |= DROGUE_DEPLOY;
-						measurement.data[0] = (header >> 16) & 0xFF;
-						measurement.data[1] = (header >> 8) & 0xFF;
-						measurement.data[2] = (header) & 0xFF;
-
-					}
+			PROFILE_BEGIN(PROFILE_FLIGHT_STATE);
+			events = flight_state_update(&flight_state,&sample);
+			PROFILE_END(PROFILE_FLIGHT_STATE);
 
-				}
-			}
+			//Before the launch handling below, which writes out the pad buffer.
+			journal_events(&flight_state,configParams->values.state,events,reading.time_us,
+					(events & LAUNCH_DETECT) ? 0 : reading.time_ticks - launch_ticks,output.flash_address);
 		}
 
+		if(events & LAUNCH_DETECT){
 
-		/* Fill Buffer and/or write to flash*********************************************************************************************************/
-		is_there_data = isMeasurementEmpty(&measurement);
+			launch_ticks = reading.time_ticks;
+			buzz(250);
+			backup_timer_start(0); //start fixed timers.
+			write_config(configParams);
 
-		if(is_there_data && configParams->values.state == STATE_LAUNCHPAD_ARMED && ((buffer_index_curr+measurement_length + HEADER_SIZE) <= ring_buff_size)){
+			//Save the data from before launch, then continue with this measurement.
+			log_writer_flush_pad(&writer);
+		}
+
+		if(events & LAND_DETECT){
 
-			//check if room in launchpad buffer.
+			write_config(configParams);
+			restart_clear();
+#if LOG_VERIFY_ENABLED
+			check_verify();
+#endif
 
+			//Put everything into low power mode.
+			running = 0;
+		}
 
-			memcpy(&launchpadBuffer[buffer_index_curr],&(measurement.data),measurement_length+HEADER_SIZE);
+		if(events & (MAIN_DETECT | DROGUE_DETECT)){
 
-			buffer_index_curr += (measurement_length+HEADER_SIZE);
-			buffer_index_curr = buffer_index_curr % (ring_buff_size);
+			recoverySelect_t event = (events & MAIN_DETECT) ? MAIN : DROGUE;
 
-			//Reset the measurement.
-			for(i=0;i<sizeof(Measurement_t);i++){
+			//Detection is reported until deployment is confirmed, so this fires again if the e-match is still closed
+			//after the last pulse.
+			if(!pyro_busy(event)){
 
-				measurement.data[i] = 0;
+				enable_mosfet(event);
+				if(activate_mosfet(event) == PYRO_OK){
+					buzz(250);
+				}
 			}
 		}
 
-//		else if (is_there_data && configParams->values.state == STATE_LAUNCHPAD_ARMED){
-//			uint8_t bytesInPrevBuffer = ring_buff_size - buffer_index_curr;
-//			uint8_t bytesLeft = (measurement_length+HEADER_SIZE)-bytesInPrevBuffer;
-//
-//			memcpy(&launchpadBuffer[buffer_index_curr],&(measurement.data),bytesInPrevBuffer);
-//			buffer_index_curr = 0;
-//			memcpy(&launchpadBuffer[buffer_index_curr],&(measurement.data[bytesInPrevBuffer]),bytesLeft);
-//
-//			buffer_index_curr = bytesLeft;
-//		}
-		else if(((buffer_index_curr+measurement_length + HEADER_SIZE) < DATA_BUFFER_SIZE) && (is_there_data)){
-
-			//There is room in the current buffer for the full measurement.
-
-			if(buffer_selection == BUFFER_A){
+		//Pulses that ended since the last measurement, from here or from the timer task.
+		while(pyro_get_event(&pyro_event)){
 
-				memcpy(&data_bufferA[buffer_index_curr],&(measurement.data),measurement_length+HEADER_SIZE);
-				//transmit_bytes(huart,&data_bufferA[buffer_index_curr],measurement_length+2);
-			}
-			else if(buffer_selection == BUFFER_B){
+			if(pyro_event.continuity == OPEN_CIRCUIT){
 
-				memcpy(&data_bufferB[buffer_index_curr],&(measurement.data),measurement_length+HEADER_SIZE);
-				//transmit_bytes(huart,&data_bufferB[buffer_index_curr],measurement_length+2);
+				events |= flight_state_deployed(&flight_state,(pyro_event.channel == MAIN) ? MAIN_DETECT : DROGUE_DETECT);
+				write_config(configParams);
 			}
 
-			buffer_index_curr += (measurement_length+HEADER_SIZE);
-
-			//Reset the measurement.
-			for(i=0;i<sizeof(Measurement_t);i++){
+			append_ext(configParams,EXT_KIND_PYRO,pyro_log_payload(ext_payload,&pyro_event));
+		}
 
-				measurement.data[i] = 0;
-			}
+		//Deployments confirmed by the pulses.
+		journal_events(&flight_state,configParams->values.state,events,reading.time_us,reading.time_ticks - launch_ticks,output.flash_address);
 
+		/* LIVE STREAM*******************************************************************************************************************************/
+		//Every reading as it came, when not recording. Does nothing otherwise.
+		live_stream_reading(&current,events);
 
+		/* TELEMETRY*********************************************************************************************************************************/
+		//The speed is worked out from the filtered altitude, which only changes with a pressure reading.
+		telemetry_events |= events;
+		if(reading.sensors & ACQ_BMP){
 
-		}else if(is_there_data){
+			telemetry.time_us = reading.time_us;
+			telemetry.events = telemetry_events;
+			telemetry.altitude = flight_state.altitude;
+			telemetry.alt_filtered = flight_state.alt_filtered;
+			memcpy(telemetry.acc,sample.acc,sizeof(telemetry.acc));
+			telemetry.flight_time = IS_IN_FLIGHT(configParams->values.flags) ? reading.time_ticks - launch_ticks : 0;
+			telemetry.log_address = output.flash_address;
+			telemetry_publish(&telemetry);
 
-			//Split measurement across the buffers, and write to flash.
-			uint8_t bytesInPrevBuffer = DATA_BUFFER_SIZE - buffer_index_curr;
-			uint8_t bytesLeft = (measurement_length+HEADER_SIZE)-bytesInPrevBuffer;
+			telemetry_events = 0;
+		}
 
-//			if((((measurement.data[1]<<8)+measurement.data[0])&0x0FFF)>300){
-//
-//				while(1);
-//			}
+		/* SUMMARY LOG*******************************************************************************************************************************/
+		//A few records a second in the internal flash, in case the external flash is lost. Slower on the pad.
+		if((reading.sensors & ACQ_ACC) && summary_acc_readings < 0xFFFF){
+			summary_acc_readings++;
+		}
+		if((reading.sensors & ACQ_BMP) && summary_bmp_readings < 0xFFFF){
+			summary_bmp_readings++;
+		}
 
-//			if((bytesLeft+bytesInPrevBuffer)!=20 && ((bytesLeft+bytesInPrevBuffer)!=14)){
-//
-//				while(1){}
-//			}
+		if(reading.time_ticks - summary_state_ticks >=
+				pdMS_TO_TICKS(IS_IN_FLIGHT(configParams->values.flags) ? SUMMARY_STATE_PERIOD : SUMMARY_PAD_PERIOD)){
 
-			//Put as much data as will fit into the almost full buffer.
-			if(buffer_selection == BUFFER_A){
+			summary_state(&flight_state,configParams->values.state);
+			summary_state_ticks = reading.time_ticks;
+		}
+		if(reading.time_ticks - summary_health_ticks >=
+				pdMS_TO_TICKS(IS_IN_FLIGHT(configParams->values.flags) ? SUMMARY_HEALTH_PERIOD : SUMMARY_PAD_PERIOD)){
 
-				memcpy(&data_bufferA[buffer_index_curr],&(measurement.data),bytesInPrevBuffer);
-				buffer_selection = BUFFER_B;
-				buffer_index_curr = 0;
+			summary_health(configParams->values.state);
+			summary_health_ticks = reading.time_ticks;
+		}
 
-			}
-			else if(buffer_selection == BUFFER_B){
+		//One double word each reading, a few tens of us.
+		PROFILE_BEGIN(PROFILE_SUMMARY_LOG);
+		summary_log_service();
+		PROFILE_END(PROFILE_SUMMARY_LOG);
 
-				memcpy(&data_bufferB[buffer_index_curr],&(measurement.data),bytesInPrevBuffer);
-				buffer_index_curr = BUFFER_A;
-				buffer_selection=0;
+		/* EVENT CAPTURE*****************************************************************************************************************************/
+		//A window that has ended is closed before this reading, which goes back to the normal stream.
+		if(capture_update(&capture,reading.time_us,ext_payload)){
+			append_ext(configParams,EXT_KIND_CAPTURE_END,CAPTURE_END_LENGTH);
+		}
 
-			}
+		triggers = capture_triggers(&capture,&current,events);
 
-			//Put the rest of the measurement in the next buffer.
-			if(buffer_selection == BUFFER_A){
+		/* LOG RATE**********************************************************************************************************************************/
+		phase = log_rate_phase(configParams->values.state);
+		if(phase != log_rate.phase){
+			log_rate_set(&log_rate,phase,configParams->values.log_rate[phase]);
+		}
 
-				memcpy(&data_bufferA[buffer_index_curr],&(measurement.data[bytesInPrevBuffer]),bytesLeft);
-				buffer_index_curr = bytesLeft;
+		/* Fill Buffer and/or write to flash*********************************************************************************************************/
+		if(capture.active){
 
+			//Every reading goes in the window, and the averages wait for it to end.
+			if(triggers){
+				capture_start(&capture,triggers,ext_payload);
 			}
-			else if(buffer_selection == BUFFER_B){
 
-				memcpy(&data_bufferB[buffer_index_curr],&(measurement.data[bytesInPrevBuffer]),bytesLeft);
-				buffer_index_curr = bytesLeft;
+			append_reading(configParams,&current,events);
+			logged = 1;
+		}
+		else{
 
-			}
+			//Blocks that are not full are logged early when there are events, so the events are not delayed, and
+			//before a capture window so the averages do not span it.
+			uint8_t force = (events != 0 || triggers != 0);
 
-			//reset the measurement.
-			for(i=0;i<sizeof(Measurement_t);i++){
+			mean.time_us = reading.time_us;
+			mean.types = 0;
 
-				measurement.data[i] = 0;
+			if((reading.sensors & ACQ_ACC) && log_rate_add_acc(&log_rate,current.acc,mean.acc,force)){
+				mean.types |= ACC_TYPE;
+			}
+			if((reading.sensors & ACQ_GYRO) && log_rate_add_gyro(&log_rate,current.gyro,mean.gyro,force)){
+				mean.types |= GYRO_TYPE;
+			}
+			if((reading.sensors & ACQ_BMP) && log_rate_add_bmp(&log_rate,current.pressure,current.temperature,&mean.pressure,&mean.temperature,force)){
+				mean.types |= PRES_TYPE | TEMP_TYPE;
 			}
 
-			measurement_length=0;
+			logged = (mean.types != 0);
+			if(logged){
+				append_reading(configParams,&mean,events);
+			}
 
-			//Flash write buffer not in use! then clear old buffer?
+			if(triggers){
 
-			if(buffer_selection == 0){
-				//We just switched to A so transmit B.
+				//The readings before the trigger, up to and including this one. The events are already in the normal stream.
+				history = capture_start(&capture,triggers,ext_payload);
+				append_ext(configParams,EXT_KIND_CAPTURE,CAPTURE_LENGTH);
 
-				if(IS_RECORDING(configParams->values.flags)){
+				while(history > 0){
+					history--;
+					append_reading(configParams,capture_history(&capture,history),0);
+				}
+			}
+		}
 
-					FlashStatus_t stat_f = program_page(flash_ptr,flash_address,data_bufferB,DATA_BUFFER_SIZE);
-					  while(IS_DEVICE_BUSY(stat_f)){
-						  stat_f = get_status_reg(flash_ptr);
-						  vTaskDelay(1);
-					  }
+		if(resume != NULL && logged){
 
-					flash_address += DATA_BUFFER_SIZE;
-					if(flash_address>=FLASH_SIZE_BYTES){
-						while(1);
-					}
+			//First measurement logged since the reset.
+			append_ext(configParams,EXT_KIND_RESTART,restart_log_payload(ext_payload,restart_boot_time(),resume));
+			resume = NULL;
+		}
 
-				}
-				else{
-					transmit_bytes(huart,data_bufferB,256);
-				}
-			}
-			else if (buffer_selection == 1){
-				//We just switched to B so transmit A
+		if(IS_IN_FLIGHT(configParams->values.flags) && reading.time_ticks - checkpoint_ticks >= pdMS_TO_TICKS(CHECKPOINT_PERIOD)){
 
-				if(IS_RECORDING(configParams->values.flags)){
-					FlashStatus_t stat_f2 = program_page(flash_ptr,flash_address,data_bufferA,DATA_BUFFER_SIZE);
-					  while(IS_DEVICE_BUSY(stat_f2)){
-						  stat_f2 = get_status_reg(flash_ptr);
-						  vTaskDelay(1);
-					  }
+			checkpoint_save(&checkpoint,&flight_state);
+			checkpoint.flash_address = output.flash_address;
+			checkpoint.flight_time = reading.time_ticks - launch_ticks;
+			checkpoint.config_slot = config_journal_slot();
+			restart_save(&checkpoint);
 
-					flash_address += DATA_BUFFER_SIZE;
+			checkpoint_ticks = reading.time_ticks;
 
-					if(flash_address>=FLASH_SIZE_BYTES){
-						while(1);
-					}
-				}
-				else{
-					transmit_bytes(huart,data_bufferA,256);
-				}
+#if RESTART_TEST_RESET_TIME > 0
+			if(logStruct->resume == NULL && checkpoint.flight_time >= RESTART_TEST_RESET_TIME){
+				NVIC_SystemReset();
 			}
+#endif
+		}
 
+#if PROFILING_ENABLED && PROFILING_LOG_PERIOD > 0
+		if(reading.time_ticks - profile_log_ticks >= PROFILING_LOG_PERIOD){
 
+			append_ext(configParams,EXT_KIND_PROFILE,profile_log_payload(ext_payload));
+			profile_log_ticks = reading.time_ticks;
 		}
+#endif
+#if TASK_MONITOR_LOG_PERIOD > 0
+		if(reading.time_ticks - task_log_ticks >= TASK_MONITOR_LOG_PERIOD){
 
-		for(i=0;i<sizeof(Measurement_t);i++){
-
-			measurement.data[i] = 0;
+			append_ext(configParams,EXT_KIND_TASKS,task_monitor_log_payload(ext_payload));
+			task_log_ticks = reading.time_ticks;
 		}
+#endif
 
-		measurement_length=0;
+		//Nothing else uses the flash while on the pad, so the journal sector erase can run then.
+		if(configParams->values.state == STATE_LAUNCHPAD_ARMED){
+			config_service(configParams);
+			event_journal_service();
+		}
 
 		if(!running){
 			vTaskSuspend(NULL);
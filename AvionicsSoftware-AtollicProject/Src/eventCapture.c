@@ -0,0 +1,159 @@
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// UMSATS 2018-2020
+//
+// Repository:
+//  UMSATS/Avionics-2019
+//
+// File Description:
+//  Source file for the event capture windows.
+//
+// History
+// 2026-10-19
+// - Created.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include "eventCapture.h"
+#include "logPacket.h"
+#include <string.h>
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// FUNCTIONS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+static void set_uint16(uint8_t * dest,uint16_t value){
+
+	dest[0] = value >> 8;
+	dest[1] = value & 0xFF;
+}
+
+void capture_init(eventCapture_t * capture,uint8_t pre,uint8_t post,uint32_t shock_level){
+
+	memset(capture,0,sizeof(eventCapture_t));
+
+	capture->pre_us = (uint32_t)pre*CAPTURE_WINDOW_UNIT*1000;
+	capture->post_us = (uint32_t)post*CAPTURE_WINDOW_UNIT*1000;
+	capture->shock_level = shock_level;
+}
+
+uint32_t capture_shock_level(uint8_t shock_g,uint8_t acc_range){
+
+	//The BMI088 ranges are 3, 6, 12 and 24 g for settings 0 to 3, over 32768 counts.
+	uint32_t range_g = 3 << (acc_range & 0x03);
+	uint32_t level;
+
+	if(shock_g == 0){
+		return 0;
+	}
+
+	level = (shock_g >= range_g) ? 32767 : ((uint32_t)shock_g*32768)/range_g;
+
+	return level*level;
+}
+
+void capture_add(eventCapture_t * capture,const captureReading_t * reading){
+
+	capture->history[capture->head] = *reading;
+	capture->head = (capture->head + 1) % CAPTURE_HISTORY_LENGTH;
+
+	if(capture->count < CAPTURE_HISTORY_LENGTH){
+		capture->count++;
+	}
+}
+
+uint8_t capture_triggers(const eventCapture_t * capture,const captureReading_t * reading,uint32_t events){
+
+	uint8_t triggers = 0;
+
+	if(capture->pre_us == 0 && capture->post_us == 0){
+		return 0;
+	}
+
+	if(events & LAUNCH_DETECT){
+		triggers |= CAPTURE_LAUNCH;
+	}
+	if(events & DROGUE_DEPLOY){
+		triggers |= CAPTURE_DROGUE;
+	}
+	if(events & MAIN_DEPLOY){
+		triggers |= CAPTURE_MAIN;
+	}
+
+	if(capture->shock_level != 0 && (reading->types & ACC_TYPE)){
+
+		uint32_t magnitude = 0;
+		uint8_t i;
+
+		//At most 3*32768^2, which fits.
+		for(i=0;i<3;i++){
+			magnitude += (uint32_t)((int32_t)reading->acc[i]*reading->acc[i]);
+		}
+
+		if(magnitude >= capture->shock_level){
+			triggers |= CAPTURE_SHOCK;
+		}
+	}
+
+	return triggers;
+}
+
+uint16_t capture_start(eventCapture_t * capture,uint8_t triggers,uint8_t * payload){
+
+	const captureReading_t * newest;
+	uint16_t count = 1;
+
+	if(capture->count == 0){
+		return 0;
+	}
+
+	newest = capture_history(capture,0);
+
+	if(capture->active){
+
+		capture->end_us = newest->time_us + capture->post_us;
+		return 0;
+	}
+
+	//Readings that are inside the window before the trigger.
+	while(count < capture->count && newest->time_us - capture_history(capture,count)->time_us <= capture->pre_us){
+		count++;
+	}
+
+	capture->active = 1;
+	capture->end_us = newest->time_us + capture->post_us;
+	capture->readings = count;
+
+	payload[0] = triggers;
+	set_uint16(&payload[1],count);
+	set_uint16(&payload[3],capture->pre_us/1000);
+	set_uint16(&payload[5],capture->post_us/1000);
+
+	return count;
+}
+
+const captureReading_t * capture_history(const eventCapture_t * capture,uint16_t age){
+
+	return &capture->history[(capture->head + CAPTURE_HISTORY_LENGTH - 1 - age) % CAPTURE_HISTORY_LENGTH];
+}
+
+uint8_t capture_update(eventCapture_t * capture,uint32_t time_us,uint8_t * payload){
+
+	if(!capture->active){
+		return 0;
+	}
+
+	if((int32_t)(time_us - capture->end_us) > 0){
+
+		capture->active = 0;
+		set_uint16(payload,capture->readings);
+		return 1;
+	}
+
+	if(capture->readings < 0xFFFF){
+		capture->readings++;
+	}
+
+	return 0;
+}
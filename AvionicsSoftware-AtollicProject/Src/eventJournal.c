@@ -0,0 +1,316 @@
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// UMSATS 2018-2020
+//
+// Repository:
+//  UMSATS/Avionics-2019
+//
+// File Description:
+//  Source file for the flight event journal.
+//
+//  Record layout, big endian:
+//   0  magic (2 bytes)
+//   2  sequence (4 bytes)
+//   6  time in us (4 bytes)
+//   10 flight time in ms (4 bytes)
+//   14 events (1 byte)
+//   15 state (1 byte)
+//   16 altitude, float bits (4 bytes)
+//   20 filtered altitude, float bits (4 bytes)
+//   24 log address (4 bytes)
+//   28 CRC-32 of the bytes before it (4 bytes)
+//
+// History
+// 2026-10-19
+// - Created.
+// - Flash access goes through the flash service.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include "eventJournal.h"
+#include "flashService.h"
+#include "crc.h"
+#include <string.h>
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// DEFINITIONS AND MACROS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#define EVENT_RECORD_MAGIC			0xE7E1
+#define EVENT_CRC_OFFSET			(EVENT_RECORD_SIZE-4)
+
+#define SECTOR_ADDRESS(sector)		(EVENT_JOURNAL_ADDRESS+((uint32_t)(sector)*FLASH_PARAM_SECTOR_SIZE))
+#define SLOT_ADDRESS(sector,slot)	(SECTOR_ADDRESS(sector)+((uint32_t)(slot)*EVENT_RECORD_SIZE))
+#define NEXT_SECTOR(sector)			(((sector)+1)%FLASH_EVENT_SECTORS)
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// STRUCTS AND STRUCT TYPEDEFS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//Where the next record goes. The record in slot n of a sector always has the sequence number of slot 0 plus n.
+typedef struct{
+
+	uint8_t found;								//1 once event_journal_init() has run.
+	uint32_t sequence;							//Sequence number of the next record.
+	uint8_t sector;								//Sector being written.
+	uint16_t next_slot;							//Next free slot in that sector.
+	uint8_t blank[FLASH_EVENT_SECTORS];			//1 if the sector is known to be erased.
+	uint8_t erasing;							//1 while event_journal_service() is erasing the next sector.
+	volatile uint8_t erase_pending;				//Cleared by the flash service when that erase is done.
+
+}eventJournal_t;
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// CONSTANTS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+static eventJournal_t journal;
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// FUNCTIONS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+static void set_uint32(uint8_t * dest,uint32_t value){
+
+	dest[0] = (value >> 24) & 0xFF;
+	dest[1] = (value >> 16) & 0xFF;
+	dest[2] = (value >> 8) & 0xFF;
+	dest[3] = value & 0xFF;
+}
+
+static uint32_t get_uint32(const uint8_t * src){
+
+	return ((uint32_t)src[0] << 24) | ((uint32_t)src[1] << 16) | ((uint32_t)src[2] << 8) | src[3];
+}
+
+static void encode(uint8_t * data,const eventRecord_t * record){
+
+	uint32_t bits;
+
+	data[0] = (EVENT_RECORD_MAGIC >> 8) & 0xFF;
+	data[1] = EVENT_RECORD_MAGIC & 0xFF;
+	set_uint32(&data[2],record->sequence);
+	set_uint32(&data[6],record->time_us);
+	set_uint32(&data[10],record->flight_time);
+	data[14] = record->events;
+	data[15] = record->state;
+	memcpy(&bits,&record->altitude,4);
+	set_uint32(&data[16],bits);
+	memcpy(&bits,&record->alt_filtered,4);
+	set_uint32(&data[20],bits);
+	set_uint32(&data[24],record->log_address);
+	set_uint32(&data[EVENT_CRC_OFFSET],crc32(data,EVENT_CRC_OFFSET));
+}
+
+//Returns 1 if the data holds a good record.
+static uint8_t decode(const uint8_t * data,eventRecord_t * record){
+
+	uint32_t bits;
+
+	if(((data[0] << 8) | data[1]) != EVENT_RECORD_MAGIC || crc32(data,EVENT_CRC_OFFSET) != get_uint32(&data[EVENT_CRC_OFFSET])){
+		return 0;
+	}
+
+	record->sequence = get_uint32(&data[2]);
+	record->time_us = get_uint32(&data[6]);
+	record->flight_time = get_uint32(&data[10]);
+	record->events = data[14];
+	record->state = data[15];
+	bits = get_uint32(&data[16]);
+	memcpy(&record->altitude,&bits,4);
+	bits = get_uint32(&data[20]);
+	memcpy(&record->alt_filtered,&bits,4);
+	record->log_address = get_uint32(&data[24]);
+
+	return 1;
+}
+
+static uint8_t slot_blank(uint8_t sector,uint16_t slot,uint8_t * data){
+
+	uint8_t i;
+
+	if(flash_read(FLASH_CLASS_EVENT,SLOT_ADDRESS(sector,slot),data,EVENT_RECORD_SIZE) != FLASH_OK){
+		memset(data,0,EVENT_RECORD_SIZE);
+	}
+
+	for(i=0;i<EVENT_RECORD_SIZE;i++){
+		if(data[i] != 0xFF){
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+eventJournalStatus_t event_journal_init(void){
+
+	uint8_t data[EVENT_RECORD_SIZE];
+	eventRecord_t record;
+	uint32_t first_sequence = 0;
+	uint8_t found = 0;
+	uint8_t sector;
+	uint16_t low;
+	uint16_t high;
+
+	memset(&journal,0,sizeof(journal));
+	journal.found = 1;
+
+	//Records are written from slot 0 up, so a sector with a blank first slot is blank, and the current sector is the
+	//one with the newest first record.
+	for(sector=0;sector<FLASH_EVENT_SECTORS;sector++){
+
+		journal.blank[sector] = slot_blank(sector,0,data);
+
+		if(!journal.blank[sector] && decode(data,&record) && (!found || record.sequence > first_sequence)){
+
+			found = 1;
+			first_sequence = record.sequence;
+			journal.sector = sector;
+		}
+	}
+
+	if(!found){
+		return EVENT_JOURNAL_OK;
+	}
+
+	//First blank slot after slot 0.
+	low = 1;
+	high = EVENT_SLOTS_PER_SECTOR;
+	while(low < high){
+
+		uint16_t middle = (low + high)/2;
+
+		if(slot_blank(journal.sector,middle,data)){
+			high = middle;
+		}
+		else{
+			low = middle + 1;
+		}
+	}
+
+	journal.next_slot = low;
+	journal.sequence = first_sequence + low;
+
+	return EVENT_JOURNAL_OK;
+}
+
+static FlashStatus_t erase_journal_sector(uint8_t sector){
+
+	FlashStatus_t result = flash_erase(FLASH_CLASS_EVENT,SECTOR_ADDRESS(sector),NULL);
+
+	if(result == FLASH_OK){
+		journal.blank[sector] = 1;
+	}
+
+	return result;
+}
+
+eventJournalStatus_t event_journal_write(eventRecord_t * record){
+
+	uint8_t data[EVENT_RECORD_SIZE];
+	FlashStatus_t result;
+
+	if(!journal.found){
+		return EVENT_JOURNAL_ERROR;
+	}
+
+	if(journal.erasing){
+
+		//A queued background erase must not run after records are written to the sector.
+		if(journal.next_slot >= EVENT_SLOTS_PER_SECTOR){
+			while(journal.erase_pending){
+				osDelay(1);
+			}
+		}
+
+		if(!journal.erase_pending){
+			journal.erasing = 0;
+			journal.blank[NEXT_SECTOR(journal.sector)] = 1;
+		}
+	}
+
+	if(journal.next_slot >= EVENT_SLOTS_PER_SECTOR){
+
+		journal.sector = NEXT_SECTOR(journal.sector);
+		journal.next_slot = 0;
+
+		//Only happens if event_journal_service() was not called in time.
+		if(!journal.blank[journal.sector] && erase_journal_sector(journal.sector) != FLASH_OK){
+			return EVENT_JOURNAL_ERROR;
+		}
+	}
+
+	journal.blank[journal.sector] = 0;
+
+	record->sequence = journal.sequence;
+	encode(data,record);
+
+	//The slot is used even if the program fails, so the sequence numbers stay in step with the slots.
+	result = flash_program(FLASH_CLASS_EVENT,SLOT_ADDRESS(journal.sector,journal.next_slot),data,EVENT_RECORD_SIZE);
+	journal.next_slot++;
+	journal.sequence++;
+
+	return (result == FLASH_OK) ? EVENT_JOURNAL_OK : EVENT_JOURNAL_ERROR;
+}
+
+void event_journal_service(void){
+
+	uint8_t next = NEXT_SECTOR(journal.sector);
+
+	if(!journal.found){
+		return;
+	}
+
+	if(journal.erasing){
+
+		if(!journal.erase_pending){
+
+			journal.erasing = 0;
+			journal.blank[next] = 1;
+		}
+	}
+	else if(!journal.blank[next] && journal.next_slot >= EVENT_SLOTS_PER_SECTOR/2){
+
+		//The older records are kept until the current sector is half full, which still leaves room for a flight.
+		if(flash_erase(FLASH_CLASS_ERASE,SECTOR_ADDRESS(next),&journal.erase_pending) == FLASH_OK){
+			journal.erasing = 1;
+		}
+	}
+}
+
+eventJournalStatus_t event_journal_erase(void){
+
+	uint8_t sector;
+
+	if(!journal.found){
+		return EVENT_JOURNAL_ERROR;
+	}
+
+	for(sector=0;sector<FLASH_EVENT_SECTORS;sector++){
+
+		if(erase_journal_sector(sector) != FLASH_OK){
+			return EVENT_JOURNAL_ERROR;
+		}
+	}
+
+	journal.sector = 0;
+	journal.next_slot = 0;
+	journal.erasing = 0;
+
+	return EVENT_JOURNAL_OK;
+}
+
+eventJournalStatus_t event_journal_read(uint16_t index,eventRecord_t * record){
+
+	uint8_t data[EVENT_RECORD_SIZE];
+	uint8_t sector = (journal.sector + 1 + index/EVENT_SLOTS_PER_SECTOR) % FLASH_EVENT_SECTORS;
+
+	if(!journal.found || index >= EVENT_JOURNAL_SLOTS){
+		return EVENT_JOURNAL_ERROR;
+	}
+
+	if(flash_read(FLASH_CLASS_READ,SLOT_ADDRESS(sector,index % EVENT_SLOTS_PER_SECTOR),data,EVENT_RECORD_SIZE) != FLASH_OK){
+		return EVENT_JOURNAL_ERROR;
+	}
+
+	return decode(data,record) ? EVENT_JOURNAL_OK : EVENT_JOURNAL_ERROR;
+}
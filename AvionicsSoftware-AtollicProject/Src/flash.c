@@ -10,18 +10,30 @@
 // History
 // 2019-03-29 by Joseph Howarth
 // - Created.
+// 2026-10-19
+// - Added a profiling zone to program_page.
+// - scan_flash can start from any page.
+// - Added erase suspend and resume.
+// - Added read_stream(). scan_flash_from() streams the pages instead of reading them one at a time.
+// - Added clear_status_reg().
+// - suspend_erase() has a timeout and checks the erase suspend bit. Added get_status_reg2().
+// - read_stream() blocks on the DMA complete callback with a timeout instead of polling the SPI state.
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 // INCLUDES
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 #include "flash.h"
+#include "profiler.h"
+#include "hrTimer.h"
+#include "cmsis_os.h"
 
 
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 // DEFINITIONS AND MACROS
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#define SCAN_BUFFER_PAGES	4
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 // ENUMS AND ENUM TYPEDEFS
@@ -52,6 +64,35 @@
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 FlashStatus_t		enable_write(FlashStruct_t * flash);
 
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Sets up the SPI1 receive and transmit DMA streams and links them to the flash SPI handle. In full duplex the HAL
+//	receives by DMA by also transmitting the buffer, so both are needed.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+static void init_dma(FlashStruct_t * flash);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Description:
+//  Waits for the DMA transfer on the flash SPI handle to finish. Once the scheduler is running the task blocks until the
+//	complete or error callback notifies it, before that it polls.
+//
+// Returns:
+//  FLASH_OK, or FLASH_ERROR if the transfer failed or took longer than FLASH_DMA_TIMEOUT_MS.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+static FlashStatus_t wait_dma(FlashStruct_t * flash);
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// CONSTANTS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+static DMA_HandleTypeDef dma_rx;
+static DMA_HandleTypeDef dma_tx;
+
+static SPI_HandleTypeDef * dma_spi;		//The flash SPI handle, to tell its callbacks apart.
+static TaskHandle_t dma_task;			//Notified when a transfer finishes, NULL before the scheduler starts.
+
+//Only the flash service scans, and its stack is small.
+static uint8_t scan_buffers[2][SCAN_BUFFER_PAGES*FLASH_PAGE_SIZE];
+
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 // FUNCTIONS
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -150,6 +191,71 @@ FlashStatus_t 	erase_device(FlashStruct_t * flash){
 	return result;
 }
 
+FlashStatus_t 	suspend_erase(FlashStruct_t * flash){
+
+	FlashStatus_t result = FLASH_ERROR;
+
+	uint8_t status_reg = get_status_reg(flash);
+
+
+	if(IS_DEVICE_BUSY(status_reg) && !WAS_ERASE_ERROR(status_reg)){
+
+		uint8_t command = ERASE_SUSPEND_COMMAND;
+		uint32_t start;
+
+		spi_send(flash->hspi,&command,1,NULL,0,10);
+
+		//Busy until the erase stops. A part that ignores the command stays busy, so the wait is limited.
+		result = FLASH_BUSY;
+		start = hr_timer_now();
+		do{
+
+			status_reg = get_status_reg(flash);
+
+			if(WAS_ERASE_ERROR(status_reg)){
+
+				result = FLASH_ERROR;
+			}
+			else if(!IS_DEVICE_BUSY(status_reg)){
+
+				//Not suspended if it finished before the command.
+				result = IS_ERASE_SUSPENDED(get_status_reg2(flash)) ? FLASH_OK : FLASH_ERROR;
+			}
+
+		}while(result == FLASH_BUSY && hr_timer_now() - start < FLASH_SUSPEND_TIMEOUT_US);
+	}
+	return result;
+}
+
+FlashStatus_t 	resume_erase(FlashStruct_t * flash){
+
+	FlashStatus_t result = FLASH_ERROR;
+
+	uint8_t status_reg = get_status_reg(flash);
+
+
+	if(IS_DEVICE_BUSY(status_reg)){
+
+		result = FLASH_BUSY;
+	}
+	else{
+
+		uint8_t command = ERASE_RESUME_COMMAND;
+
+		spi_send(flash->hspi,&command,1,NULL,0,10);
+
+		result = FLASH_OK;
+	}
+	return result;
+}
+
+void clear_status_reg(FlashStruct_t * flash){
+
+	uint8_t command = CLEAR_STATUS_COMMAND;
+
+	spi_send(flash->hspi,&command,1,NULL,0,10);
+}
+
 uint8_t get_status_reg(FlashStruct_t * flash){
 
 	uint8_t command = GET_STATUS_REG_COMMAND;
@@ -161,10 +267,22 @@ uint8_t get_status_reg(FlashStruct_t * flash){
 	return status_reg;
 }
 
+uint8_t get_status_reg2(FlashStruct_t * flash){
+
+	uint8_t command = GET_STATUS_REG2_COMMAND;
+	uint8_t status_reg;
+
+
+	spi_receive(flash->hspi,&command,1,&status_reg,1,10);
+
+	return status_reg;
+}
+
 FlashStatus_t program_page(FlashStruct_t * flash,uint32_t address,uint8_t * data_buffer,uint16_t num_bytes){
 
 	FlashStatus_t result = FLASH_ERROR;
 
+	PROFILE_BEGIN(PROFILE_PROGRAM_PAGE);
 	uint8_t status_reg = get_status_reg(flash);
 
 
@@ -182,6 +300,7 @@ FlashStatus_t program_page(FlashStruct_t * flash,uint32_t address,uint8_t * data
 		spi_send(flash->hspi,command_address,4,data_buffer,num_bytes,200);
 		result = FLASH_OK;
 	}
+	PROFILE_END(PROFILE_PROGRAM_PAGE);
 	return result;
 }
 FlashStatus_t 	read_page(FlashStruct_t * flash,uint32_t address,uint8_t * data_buffer,uint16_t num_bytes){
@@ -253,6 +372,7 @@ FlashStatus_t		initialize_flash(FlashStruct_t * flash){
     HAL_GPIO_WritePin(FLASH_HOLD_PORT,FLASH_HOLD_PIN,GPIO_PIN_SET);
 	//Set up the SPI interface
 	spi1_init(&(flash->hspi));
+	init_dma(flash);
 
     HAL_GPIO_WritePin(FLASH_SPI_CS_PORT,FLASH_SPI_CS_PIN,GPIO_PIN_SET);
 	FlashStatus_t result = FLASH_ERROR;
@@ -263,42 +383,210 @@ FlashStatus_t		initialize_flash(FlashStruct_t * flash){
 
 uint32_t scan_flash(FlashStruct_t * flash){
 
+	return scan_flash_from(flash,FLASH_START_ADDRESS);
+}
+
+//Stops the scan at the first page that is all 0xFF.
+static uint8_t scan_callback(void * context,uint32_t address,uint8_t * data,uint16_t length){
+
+	uint32_t * result = (uint32_t *)context;
+	uint16_t page;
+	uint16_t j;
+
+	for(page=0;page<length;page+=FLASH_PAGE_SIZE){
 
-	uint32_t result = 0;
+		for(j=0;j<FLASH_PAGE_SIZE && data[page+j] == 0xFF;j++);
+
+		if(j == FLASH_PAGE_SIZE){
+
+			*result = address + page;
+			return 0;
+		}
+	}
 
-	uint8_t dataRX[256];
+	return 1;
+}
+
+uint32_t scan_flash_from(FlashStruct_t * flash,uint32_t address){
+
+
+	uint32_t result = FLASH_SIZE_BYTES;	//ADDED AFTER RECOVERY!!!!
+	uint32_t read;
 	uint32_t i;
-	int j;
-	i=FLASH_START_ADDRESS;
-	while(i<FLASH_SIZE_BYTES){
+	FlashStream_t stream;
+
+	i=address & ~(FLASH_PAGE_SIZE-1);
+	if(i<FLASH_START_ADDRESS){
+		i=FLASH_START_ADDRESS;
+	}
+
+	stream.buffers[0] = scan_buffers[0];
+	stream.buffers[1] = scan_buffers[1];
+	stream.buffer_size = sizeof(scan_buffers[0]);
+	stream.callback = scan_callback;
+	stream.context = &result;
+
+	//Whole pages up to FLASH_SIZE_BYTES, so the callback only sees whole pages.
+	if(i<FLASH_SIZE_BYTES){
+		read_stream(flash,i,(FLASH_SIZE_BYTES-i) & ~(FLASH_PAGE_SIZE-1),&stream,&read);
+	}
+
+	return result;
+
+}
+
+FlashStatus_t read_stream(FlashStruct_t * flash,uint32_t address,uint32_t length,FlashStream_t * stream,uint32_t * read){
+
+	FlashStatus_t result = FLASH_OK;
+	uint8_t command_address [] = { FAST_READ_COMMAND, (address & (HIGH_BYTE_MASK_24B))>>16, (address & (MID_BYTE_MASK_24B))>>8, address & (LOW_BYTE_MASK_24B), 0x00};
+	uint16_t chunk[2] = {0,0};
+	uint32_t started = 0;		//Bytes the DMA has been started for.
+	uint8_t current = 0;
+
+	*read = 0;
+
+	if(IS_DEVICE_BUSY(get_status_reg(flash))){
+		return FLASH_BUSY;
+	}
+	if(length == 0){
+		return FLASH_OK;
+	}
+
+	dma_task = (xTaskGetSchedulerState() == taskSCHEDULER_RUNNING) ? xTaskGetCurrentTaskHandle() : NULL;
+
+	HAL_GPIO_WritePin(FLASH_SPI_CS_PORT,FLASH_SPI_CS_PIN,GPIO_PIN_RESET);
+	HAL_SPI_Transmit(&flash->hspi,command_address,sizeof(command_address),10);
+
+	chunk[0] = (length < stream->buffer_size) ? length : stream->buffer_size;
+	if(HAL_SPI_Receive_DMA(&flash->hspi,stream->buffers[0],chunk[0]) != HAL_OK){
+
+		HAL_GPIO_WritePin(FLASH_SPI_CS_PORT,FLASH_SPI_CS_PIN,GPIO_PIN_SET);
+		return FLASH_ERROR;
+	}
+	started = chunk[0];
+
+	while(1){
 
-		FlashStatus_t stat;
+		uint8_t carry_on;
 
-		for(j=0;j<256;j++){
-			dataRX[j] = 0;
+		if(wait_dma(flash) != FLASH_OK){
+
+			result = FLASH_ERROR;
+			break;
 		}
 
-		stat = read_page(flash,i,dataRX,256);
+		//Start on the other buffer before handing this one over.
+		if(started < length){
+
+			uint8_t next = current ^ 1;
 
-		uint16_t empty= 0xFFFF;
-		for(j=0;j<256;j++){
+			chunk[next] = (length - started < stream->buffer_size) ? (length - started) : stream->buffer_size;
+			if(HAL_SPI_Receive_DMA(&flash->hspi,stream->buffers[next],chunk[next]) != HAL_OK){
 
-			if(dataRX[j] != 0xFF){
-				empty --;
+				result = FLASH_ERROR;
+				break;
 			}
+			started += chunk[next];
 		}
 
-		if(empty == 0xFFFF){
+		carry_on = stream->callback(stream->context,address + *read,stream->buffers[current],chunk[current]);
+		*read += chunk[current];
 
-			result = i;
+		if(!carry_on || *read >= length){
 			break;
 		}
+		current ^= 1;
+	}
+
+	//A buffer may still be on its way if the callback stopped the stream. After an error it is stopped.
+	if(result != FLASH_OK || wait_dma(flash) != FLASH_OK){
 
-		i = i + 256;
+		HAL_SPI_Abort(&flash->hspi);
+		result = FLASH_ERROR;
 	}
+	HAL_GPIO_WritePin(FLASH_SPI_CS_PORT,FLASH_SPI_CS_PIN,GPIO_PIN_SET);
 
-	if (result == 0) result = FLASH_SIZE_BYTES; //ADDED AFTER RECOVERY!!!!
 	return result;
+}
+
+static void init_dma(FlashStruct_t * flash){
+
+	__HAL_RCC_DMA2_CLK_ENABLE();
+
+	//SPI1_RX is DMA2 stream 0 channel 3, SPI1_TX is DMA2 stream 3 channel 3.
+	dma_rx.Instance = DMA2_Stream0;
+	dma_rx.Init.Channel = DMA_CHANNEL_3;
+	dma_rx.Init.Direction = DMA_PERIPH_TO_MEMORY;
+	dma_rx.Init.PeriphInc = DMA_PINC_DISABLE;
+	dma_rx.Init.MemInc = DMA_MINC_ENABLE;
+	dma_rx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+	dma_rx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+	dma_rx.Init.Mode = DMA_NORMAL;
+	dma_rx.Init.Priority = DMA_PRIORITY_HIGH;
+	dma_rx.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+	if(HAL_DMA_Init(&dma_rx) != HAL_OK){
+		while(1);
+	}
+	__HAL_LINKDMA(&flash->hspi,hdmarx,dma_rx);
+
+	dma_tx.Instance = DMA2_Stream3;
+	dma_tx.Init = dma_rx.Init;
+	dma_tx.Init.Direction = DMA_MEMORY_TO_PERIPH;
+	dma_tx.Init.Priority = DMA_PRIORITY_LOW;
+	if(HAL_DMA_Init(&dma_tx) != HAL_OK){
+		while(1);
+	}
+	__HAL_LINKDMA(&flash->hspi,hdmatx,dma_tx);
+
+	HAL_NVIC_SetPriority(DMA2_Stream0_IRQn,FLASH_DMA_IRQ_PRIORITY,0);
+	HAL_NVIC_EnableIRQ(DMA2_Stream0_IRQn);
+	HAL_NVIC_SetPriority(DMA2_Stream3_IRQn,FLASH_DMA_IRQ_PRIORITY,0);
+	HAL_NVIC_EnableIRQ(DMA2_Stream3_IRQn);
+
+	dma_spi = &flash->hspi;
+}
+
+static FlashStatus_t wait_dma(FlashStruct_t * flash){
+
+	uint32_t start = HAL_GetTick();
+
+	while(HAL_SPI_GetState(&flash->hspi) != HAL_SPI_STATE_READY){
+
+		if(HAL_GetTick() - start >= FLASH_DMA_TIMEOUT_MS){
+			return FLASH_ERROR;
+		}
+		if(dma_task != NULL){
+			ulTaskNotifyTake(pdTRUE,pdMS_TO_TICKS(FLASH_DMA_TIMEOUT_MS));
+		}
+	}
+
+	return (flash->hspi.ErrorCode == HAL_SPI_ERROR_NONE) ? FLASH_OK : FLASH_ERROR;
+}
+
+//In full duplex the HAL receives by DMA as a transmit and receive, so this is the end of a read_stream() buffer.
+void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef * hspi){
+
+	BaseType_t woken = pdFALSE;
+
+	if(hspi == dma_spi && dma_task != NULL){
+
+		vTaskNotifyGiveFromISR(dma_task,&woken);
+		portYIELD_FROM_ISR(woken);
+	}
+}
+
+void HAL_SPI_ErrorCallback(SPI_HandleTypeDef * hspi){
+
+	HAL_SPI_TxRxCpltCallback(hspi);
+}
+
+void flash_dma_rx_irq(void){
+
+	HAL_DMA_IRQHandler(&dma_rx);
+}
+
+void flash_dma_tx_irq(void){
 
+	HAL_DMA_IRQHandler(&dma_tx);
 }
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,983 @@
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// UMSATS 2018-2020
+//
+// Repository:
+//  UMSATS/Avionics-2019
+//
+// File Description:
+//  Source file for the flash service task.
+//
+// History
+// 2026-10-19
+// - Created.
+// - Erases run in the background and are suspended for the other requests.
+// - Added streams, which give way to the higher classes between buffers.
+// - Added verifies. Program and erase errors are cleared and returned as FLASH_ERROR.
+// - Keeps the map of used sectors.
+// - flash_map_count() leaves out the map sector, so a blank flash counts 0.
+// - Programs are polled from a timer wheel timer, the task blocks between polls so the sensor tasks can run.
+// - Suspends that do not stop the erase turn suspending off. The end of an erase is checked for errors.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include "flashService.h"
+#include "hrTimer.h"
+#include "timerWheel.h"
+#include <string.h>
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// DEFINITIONS AND MACROS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#define FLASH_OP_READ		0
+#define FLASH_OP_PROGRAM	1
+#define FLASH_OP_ERASE		2
+#define FLASH_OP_SCAN		3
+#define FLASH_OP_STREAM		4
+#define FLASH_OP_VERIFY		5
+#define FLASH_OP_MAP_COMMIT	6
+
+#define ERASE_SIZE(address)	(((address) > FLASH_PARAM_END_ADDRESS) ? FLASH_SECTOR_SIZE : FLASH_PARAM_SECTOR_SIZE)
+#define ERASE_POLL_TICKS	1			//How often the end of an erase is checked for.
+#define POLL_TIMEOUT_TICKS	2			//Longest block for one poll, in case the timer is held up.
+
+//Map record: a byte set to MAP_COMPLETE once the rest is written, then a bit for each sector, 0 when it may hold data.
+#define MAP_BYTES			((FLASH_MAP_SECTORS+7)/8)
+#define MAP_RECORD_SIZE		(1+MAP_BYTES)
+#define MAP_RECORDS			(FLASH_SECTOR_SIZE/FLASH_PAGE_SIZE)		//One to a page.
+#define MAP_COMPLETE		0x00
+#define MAP_RECORD_ADDRESS(n)	(FLASH_MAP_ADDRESS+((uint32_t)(n)*FLASH_PAGE_SIZE))
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// STRUCTS AND STRUCT TYPEDEFS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+typedef struct{
+
+	uint8_t op;
+	uint8_t flash_class;
+	uint32_t address;					//For a scan, set to the end of the data when done.
+	uint8_t * data;
+	uint32_t length;					//Only a stream is longer than a page.
+	FlashStream_t * stream;
+	uint32_t queued;					//hr_timer_now() time it was queued.
+
+	SemaphoreHandle_t done;				//Given when finished, NULL for a background erase.
+	FlashStatus_t * result;
+	uint32_t * scan_end;
+	volatile uint8_t * pending;			//Cleared when a background erase is finished.
+
+}flashRequest_t;
+
+//The erase being run. Requests merged into it finish together.
+typedef struct{
+
+	uint8_t active;
+	uint8_t suspended;
+	uint8_t flash_class;
+	uint8_t count;
+	uint32_t address;					//Start of the sector.
+	uint32_t size;
+	uint32_t start;						//hr_timer_now() time it started.
+	uint32_t resumed;					//hr_timer_now() time it last started running.
+	flashRequest_t requests[FLASH_MERGE_MAX];
+
+}flashErase_t;
+
+//Passed to read_stream() in place of the caller's context.
+typedef struct{
+
+	FlashStream_t * stream;
+	uint8_t flash_class;
+	uint8_t stopped;					//Set when the caller's callback ends the stream.
+
+}flashStreamContext_t;
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// CONSTANTS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+static FlashStruct_t * flash;
+
+static QueueHandle_t queues[FLASH_CLASSES];
+static StaticQueue_t queue_buffers[FLASH_CLASSES];
+static uint8_t queue_storage[FLASH_CLASSES][FLASH_QUEUE_LENGTH*sizeof(flashRequest_t)];
+
+//Given with every request, the service then empties all the queues.
+static SemaphoreHandle_t work;
+static StaticSemaphore_t work_buffer;
+
+static flashClassStats_t stats[FLASH_CLASSES];
+
+//Data of merged programs.
+static uint8_t merge_buffer[FLASH_PAGE_SIZE];
+
+//What a verify reads back.
+static uint8_t verify_buffer[FLASH_PAGE_SIZE];
+
+static flashErase_t erase;
+static uint8_t suspend_works = 1;			//Cleared when the device does not stop for a suspend.
+
+static uint8_t map[MAP_BYTES];				//Bits as in the record, 1 for a blank sector.
+static int16_t map_record;					//The current record, -1 if there is none.
+static uint16_t map_next_record;			//The first blank page of the map sector.
+
+static wheelTimer_t poll_timer;				//Wakes the service for the next status poll.
+static TaskHandle_t poll_task;
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// FUNCTIONS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+static uint8_t scheduler_running(void){
+
+	return xTaskGetSchedulerState() == taskSCHEDULER_RUNNING;
+}
+
+//Runs in the timer wheel interrupt.
+static void poll_due(void * arg){
+
+	BaseType_t woken = pdFALSE;
+
+	vTaskNotifyGiveFromISR(poll_task,&woken);
+	portYIELD_FROM_ISR(woken);
+}
+
+//Blocks until time_us, so the tasks below the service can run. Spins before the scheduler starts.
+static void sleep_until(uint32_t time_us){
+
+	if(!scheduler_running()){
+
+		while((int32_t)(hr_timer_now() - time_us) < 0);
+		return;
+	}
+
+	poll_task = xTaskGetCurrentTaskHandle();
+
+	//A notification left over from an earlier timer only makes it check the time again.
+	while((int32_t)(hr_timer_now() - time_us) < 0){
+
+		wheel_timer_start_at(&poll_timer,time_us,0);
+		ulTaskNotifyTake(pdTRUE,POLL_TIMEOUT_TICKS);
+	}
+	wheel_timer_cancel(&poll_timer);
+}
+
+//Programs are polled every FLASH_POLL_US and erases every tick. Both block between polls once the scheduler is running.
+//After a program or erase error the device stays busy until the error is cleared, so that ends the wait too.
+static uint8_t wait_ready(uint8_t sleep){
+
+	uint8_t status = get_status_reg(flash);
+
+	while(IS_DEVICE_BUSY(status) && !WAS_PROGRAMING_ERROR(status) && !WAS_ERASE_ERROR(status)){
+
+		if(sleep && scheduler_running()){
+			vTaskDelay(1);
+		}
+		else{
+			sleep_until(hr_timer_now() + FLASH_POLL_US);
+		}
+		status = get_status_reg(flash);
+	}
+
+	return status;
+}
+
+static FlashStatus_t check_error(uint8_t status){
+
+	if(WAS_PROGRAMING_ERROR(status) || WAS_ERASE_ERROR(status)){
+
+		clear_status_reg(flash);
+		return FLASH_ERROR;
+	}
+
+	return FLASH_OK;
+}
+
+//The bit of the map for the erase sector holding address, -1 if it is not in the map.
+static int16_t map_sector(uint32_t address){
+
+	if(address < FLASH_START_ADDRESS || address > FLASH_END_ADDRESS ||
+			(address >= FLASH_MAP_ADDRESS && address < FLASH_MAP_ADDRESS + FLASH_SECTOR_SIZE)){
+		return -1;
+	}
+	if(address <= FLASH_PARAM_END_ADDRESS){
+		return (address - FLASH_START_ADDRESS)/FLASH_PARAM_SECTOR_SIZE;
+	}
+	return FLASH_MAP_PARAM_SECTORS + (address - (FLASH_PARAM_END_ADDRESS+1))/FLASH_SECTOR_SIZE;
+}
+
+static uint32_t map_sector_address(int16_t sector){
+
+	if(sector < FLASH_MAP_PARAM_SECTORS){
+		return FLASH_START_ADDRESS + (uint32_t)sector*FLASH_PARAM_SECTOR_SIZE;
+	}
+	return FLASH_PARAM_END_ADDRESS + 1 + (uint32_t)(sector - FLASH_MAP_PARAM_SECTORS)*FLASH_SECTOR_SIZE;
+}
+
+//Finds the current record. Pages are used in order, so the first blank one ends the list.
+static void map_load(void){
+
+	uint8_t record[MAP_RECORD_SIZE];
+	uint16_t n;
+	uint16_t i;
+
+	memset(map,0,sizeof(map));
+	map_record = -1;
+	map_next_record = MAP_RECORDS;
+
+	for(n=0;n<MAP_RECORDS;n++){
+
+		uint8_t blank = 1;
+
+		if(read_page(flash,MAP_RECORD_ADDRESS(n),record,MAP_RECORD_SIZE) != FLASH_OK){
+			break;
+		}
+		for(i=0;i<MAP_RECORD_SIZE;i++){
+			if(record[i] != 0xFF){
+				blank = 0;
+			}
+		}
+		if(blank){
+			map_next_record = n;
+			break;
+		}
+
+		//A record cut short by a reset is skipped.
+		if(record[0] == MAP_COMPLETE){
+			memcpy(map,&record[1],MAP_BYTES);
+			map_record = n;
+		}
+	}
+}
+
+//Clears the bit of a sector about to be programmed, in RAM and in the current record.
+static void map_mark_used(uint32_t address){
+
+	int16_t sector = map_sector(address);
+	uint8_t byte;
+
+	if(sector < 0 || !(map[sector/8] & (1 << (sector%8)))){
+		return;
+	}
+
+	map[sector/8] &= ~(1 << (sector%8));
+
+	//Bits already cleared in the record stay cleared, so the whole byte can be programmed.
+	if(map_record >= 0){
+
+		byte = map[sector/8];
+		program_page(flash,MAP_RECORD_ADDRESS(map_record) + 1 + sector/8,&byte,1);
+		check_error(wait_ready(0));
+	}
+}
+
+static void map_mark_blank(uint32_t address){
+
+	int16_t sector = map_sector(address);
+
+	if(sector >= 0){
+		map[sector/8] |= 1 << (sector%8);
+	}
+}
+
+static FlashStatus_t map_commit(void){
+
+	uint8_t record[MAP_RECORD_SIZE];
+	uint8_t complete = MAP_COMPLETE;
+	uint16_t n;
+
+	if(map_next_record >= MAP_RECORDS){
+
+		map_record = -1;
+		erase_sector(flash,FLASH_MAP_ADDRESS);
+		if(check_error(wait_ready(1)) != FLASH_OK){
+			return FLASH_ERROR;
+		}
+		map_next_record = 0;
+	}
+
+	n = map_next_record++;
+	record[0] = 0xFF;
+	memcpy(&record[1],map,MAP_BYTES);
+
+	program_page(flash,MAP_RECORD_ADDRESS(n),record,MAP_RECORD_SIZE);
+	if(check_error(wait_ready(0)) != FLASH_OK){
+		return FLASH_ERROR;
+	}
+	program_page(flash,MAP_RECORD_ADDRESS(n),&complete,1);
+	if(check_error(wait_ready(0)) != FLASH_OK){
+		return FLASH_ERROR;
+	}
+
+	map_record = n;
+	return FLASH_OK;
+}
+
+static void serve(uint8_t flash_class);
+static FlashStatus_t run_stream(flashRequest_t * request);
+
+static FlashStatus_t execute(flashRequest_t * request){
+
+	FlashStatus_t result = FLASH_OK;
+
+	//An error left by an earlier request is not this one's.
+	check_error(wait_ready(0));
+
+	switch(request->op){
+
+		case FLASH_OP_READ:
+			result = read_page(flash,request->address,request->data,request->length);
+			break;
+
+		case FLASH_OP_PROGRAM:
+			map_mark_used(request->address);
+			result = program_page(flash,request->address,request->data,request->length);
+			if(check_error(wait_ready(0)) != FLASH_OK){
+				result = FLASH_ERROR;
+			}
+			break;
+
+		case FLASH_OP_VERIFY:
+			result = read_page(flash,request->address,verify_buffer,request->length);
+			if(result == FLASH_OK && memcmp(verify_buffer,request->data,request->length) != 0){
+				result = FLASH_ERROR;
+			}
+			break;
+
+		case FLASH_OP_ERASE:
+			if(request->address > FLASH_PARAM_END_ADDRESS){
+				result = erase_sector(flash,request->address);
+			}
+			else{
+				result = erase_param_sector(flash,request->address);
+			}
+			if(check_error(wait_ready(1)) != FLASH_OK){
+				result = FLASH_ERROR;
+			}
+			if(result == FLASH_OK){
+				map_mark_blank(request->address);
+			}
+			break;
+
+		case FLASH_OP_MAP_COMMIT:
+			result = map_commit();
+			break;
+
+		case FLASH_OP_SCAN:
+			request->address = scan_flash_from(flash,request->address);
+			break;
+
+		case FLASH_OP_STREAM:
+			result = run_stream(request);
+			break;
+
+		default:
+			result = FLASH_ERROR;
+			break;
+	}
+
+	return result;
+}
+
+static void finish(const flashRequest_t * request,FlashStatus_t result){
+
+	if(request->result != NULL){
+		*request->result = result;
+	}
+	if(request->scan_end != NULL){
+		*request->scan_end = request->address;
+	}
+	if(request->pending != NULL){
+		*request->pending = 0;
+	}
+	if(request->done != NULL){
+		xSemaphoreGive(request->done);
+	}
+}
+
+//Checks if the next request in the queue can be done together with the ones taken so far.
+static uint8_t can_merge(const flashRequest_t * first,uint16_t length,const flashRequest_t * next){
+
+	uint32_t end = first->address + length;
+
+	if(next->op != first->op){
+		return 0;
+	}
+
+	if(first->op == FLASH_OP_ERASE){
+		return next->address == first->address;
+	}
+
+	if(first->op == FLASH_OP_PROGRAM){
+		return next->address == end && (first->address / FLASH_PAGE_SIZE) == ((end + next->length - 1) / FLASH_PAGE_SIZE);
+	}
+
+	return 0;
+}
+
+//Takes the next request of a class and the ones that can be merged with it.
+static uint8_t take(uint8_t flash_class,flashRequest_t * requests,flashRequest_t * combined){
+
+	flashRequest_t next;
+	uint16_t length;
+	uint8_t count = 1;
+
+	if(xQueueReceive(queues[flash_class],&requests[0],0) != pdPASS){
+		return 0;
+	}
+
+	*combined = requests[0];
+	length = requests[0].length;
+
+	while(count < FLASH_MERGE_MAX && xQueuePeek(queues[flash_class],&next,0) == pdPASS && can_merge(&requests[0],length,&next)){
+
+		xQueueReceive(queues[flash_class],&requests[count],0);
+
+		if(next.op == FLASH_OP_PROGRAM){
+
+			if(count == 1){
+				memcpy(merge_buffer,requests[0].data,requests[0].length);
+				combined->data = merge_buffer;
+			}
+			memcpy(&merge_buffer[length],next.data,next.length);
+			length += next.length;
+			combined->length = length;
+		}
+
+		count++;
+	}
+
+	return count;
+}
+
+//Updates the statistics and lets the callers know.
+static void complete(uint8_t flash_class,flashRequest_t * requests,uint8_t count,uint32_t address,FlashStatus_t result,uint32_t start){
+
+	flashClassStats_t * class_stats = &stats[flash_class];
+	uint32_t now = hr_timer_now();
+	uint8_t i;
+
+	for(i=0;i<count;i++){
+
+		uint32_t wait = start - requests[i].queued;
+
+		class_stats->count++;
+		class_stats->wait_total += wait;
+		if(wait > class_stats->wait_max){
+			class_stats->wait_max = wait;
+		}
+		if(erase.active && now - requests[i].queued > class_stats->erase_latency_max){
+			class_stats->erase_latency_max = now - requests[i].queued;
+		}
+
+		requests[i].address = address;
+		finish(&requests[i],result);
+	}
+
+	if(result != FLASH_OK){
+		class_stats->errors += count;
+	}
+	class_stats->merged += count - 1;
+	if(now - start > class_stats->busy_max){
+		class_stats->busy_max = now - start;
+	}
+}
+
+static void serve(uint8_t flash_class){
+
+	flashRequest_t requests[FLASH_MERGE_MAX];
+	flashRequest_t combined;
+	FlashStatus_t result;
+	uint32_t start;
+	uint8_t count = take(flash_class,requests,&combined);
+
+	if(count == 0){
+		return;
+	}
+
+	start = hr_timer_now();
+	result = execute(&combined);
+
+	complete(flash_class,requests,count,combined.address,result,start);
+}
+
+//Checks if a request can run now, with the erase suspended if there is one.
+static uint8_t can_run(const flashRequest_t * request){
+
+	if(!erase.active){
+		return 1;
+	}
+
+	if(!FLASH_ERASE_SUSPEND_ENABLED || !suspend_works || request->op == FLASH_OP_ERASE || request->op == FLASH_OP_SCAN || request->op == FLASH_OP_STREAM ||
+			request->op == FLASH_OP_MAP_COMMIT){
+		return 0;
+	}
+
+	return request->address + request->length <= erase.address || request->address >= erase.address + erase.size;
+}
+
+//Erases and streams are left for the main loop, so a stream is never nested or held up by an erase.
+static uint8_t higher_waiting(uint8_t flash_class){
+
+	flashRequest_t next;
+	uint8_t i;
+
+	for(i=0;i<flash_class;i++){
+
+		if(xQueuePeek(queues[i],&next,0) == pdPASS && next.op != FLASH_OP_ERASE && next.op != FLASH_OP_STREAM){
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+static void serve_higher(uint8_t flash_class){
+
+	while(higher_waiting(flash_class)){
+
+		uint8_t i;
+		flashRequest_t next;
+
+		for(i=0;i<flash_class;i++){
+
+			if(xQueuePeek(queues[i],&next,0) == pdPASS && next.op != FLASH_OP_ERASE && next.op != FLASH_OP_STREAM){
+
+				serve(i);
+				break;
+			}
+		}
+	}
+}
+
+//Hands each buffer to the caller, then ends the Fast Read if a higher class is waiting.
+static uint8_t stream_callback(void * context,uint32_t address,uint8_t * data,uint16_t length){
+
+	flashStreamContext_t * stream_context = (flashStreamContext_t *)context;
+	FlashStream_t * stream = stream_context->stream;
+
+	if(!stream->callback(stream->context,address,data,length)){
+
+		stream_context->stopped = 1;
+		return 0;
+	}
+
+	return !higher_waiting(stream_context->flash_class);
+}
+
+//Reads the range with as few Fast Reads as it can. Each time the stream gives way, the waiting requests are served and
+//a new Fast Read carries on from where it stopped.
+static FlashStatus_t run_stream(flashRequest_t * request){
+
+	FlashStatus_t result = FLASH_OK;
+	flashStreamContext_t context;
+	FlashStream_t stream;
+	uint32_t done = 0;
+	uint32_t read;
+
+	context.stream = request->stream;
+	context.flash_class = request->flash_class;
+	context.stopped = 0;
+
+	stream = *request->stream;
+	stream.callback = stream_callback;
+	stream.context = &context;
+
+	while(done < request->length && result == FLASH_OK && !context.stopped){
+
+		serve_higher(request->flash_class);
+		wait_ready(0);
+
+		result = read_stream(flash,request->address + done,request->length - done,&stream,&read);
+		done += read;
+	}
+
+	return result;
+}
+
+static void end_erase(FlashStatus_t result){
+
+	if(result == FLASH_OK){
+		map_mark_blank(erase.address);
+	}
+	erase.active = 0;
+	erase.suspended = 0;
+	complete(erase.flash_class,erase.requests,erase.count,erase.address,result,erase.start);
+}
+
+static void start_erase(uint8_t flash_class){
+
+	flashRequest_t combined;
+	FlashStatus_t result;
+
+	erase.count = take(flash_class,erase.requests,&combined);
+	if(erase.count == 0){
+		return;
+	}
+
+	erase.flash_class = flash_class;
+	erase.size = ERASE_SIZE(combined.address);
+	erase.address = combined.address & ~(erase.size - 1);
+	erase.start = hr_timer_now();
+	erase.resumed = erase.start;
+
+	wait_ready(0);
+	if(combined.address > FLASH_PARAM_END_ADDRESS){
+		result = erase_sector(flash,combined.address);
+	}
+	else{
+		result = erase_param_sector(flash,combined.address);
+	}
+
+	erase.active = 1;
+	erase.suspended = 0;
+
+	if(result != FLASH_OK){
+		end_erase(result);
+	}
+}
+
+//A suspended erase does not show as busy, so it is only checked while running.
+static void check_erase(void){
+
+	uint8_t status;
+
+	if(!erase.active || erase.suspended){
+		return;
+	}
+
+	status = get_status_reg(flash);
+	if(WAS_ERASE_ERROR(status)){
+		end_erase(check_error(status));
+	}
+	else if(!IS_DEVICE_BUSY(status)){
+
+		//A suspend that took effect after suspend_erase() gave up leaves the erase stopped, not finished.
+		if(IS_ERASE_SUSPENDED(get_status_reg2(flash))){
+			resume_erase(flash);
+			erase.resumed = hr_timer_now();
+		}
+		else{
+			end_erase(FLASH_OK);
+		}
+	}
+}
+
+//Returns 1 if the request can go ahead, 0 if it has to wait for the erase to finish.
+static uint8_t suspend(void){
+
+	FlashStatus_t result;
+
+	if(!erase.active || erase.suspended){
+		return 1;
+	}
+
+	//Let a resumed erase run for a while, so it still finishes when requests keep coming.
+	sleep_until(erase.resumed + FLASH_RESUME_RUN_US);
+
+	result = suspend_erase(flash);
+	if(result == FLASH_OK){
+
+		erase.suspended = 1;
+		stats[erase.flash_class].suspends++;
+	}
+	else if(result == FLASH_BUSY){
+
+		//The device did not stop, it may not support suspending. Every request waits for the erases from now on.
+		suspend_works = 0;
+		return 0;
+	}
+	else{
+		//Finished or failed before it could be suspended.
+		end_erase(check_error(get_status_reg(flash)));
+	}
+
+	return 1;
+}
+
+static void resume(void){
+
+	if(erase.active && erase.suspended){
+
+		resume_erase(flash);
+		erase.suspended = 0;
+		erase.resumed = hr_timer_now();
+	}
+}
+
+void vTask_flash_service(void * pvParameters){
+
+	flashRequest_t next;
+	uint8_t flash_class;
+
+	while(1){
+
+		//While an erase runs, wake up regularly to see if it has finished.
+		xSemaphoreTake(work,erase.active ? ERASE_POLL_TICKS : portMAX_DELAY);
+
+		check_erase();
+
+		//One request at a time, going back to the highest class after each one.
+		flash_class = 0;
+		while(flash_class < FLASH_CLASSES){
+
+			if(xQueuePeek(queues[flash_class],&next,0) == pdPASS && can_run(&next) && suspend()){
+
+				if(next.op == FLASH_OP_ERASE && !erase.active){
+					start_erase(flash_class);
+				}
+				else{
+					serve(flash_class);
+				}
+				flash_class = 0;
+			}
+			else{
+				flash_class++;
+			}
+		}
+
+		resume();
+	}
+}
+
+void flash_service_init(FlashStruct_t * flash_ptr){
+
+	uint8_t i;
+
+	flash = flash_ptr;
+
+	for(i=0;i<FLASH_CLASSES;i++){
+		queues[i] = xQueueCreateStatic(FLASH_QUEUE_LENGTH,sizeof(flashRequest_t),queue_storage[i],&queue_buffers[i]);
+	}
+	work = xSemaphoreCreateBinaryStatic(&work_buffer);
+	wheel_timer_setup(&poll_timer,poll_due,NULL);
+
+	flash_service_reset_stats();
+	map_load();
+}
+
+//Runs a request and waits for it. Before the scheduler starts it is run straight away.
+static FlashStatus_t submit(flashRequest_t * request){
+
+	FlashStatus_t result = FLASH_ERROR;
+	StaticSemaphore_t done_buffer;
+
+	request->result = &result;
+	request->queued = hr_timer_now();
+
+	if(!scheduler_running()){
+
+		result = execute(request);
+		finish(request,result);
+		return result;
+	}
+
+	request->done = xSemaphoreCreateBinaryStatic(&done_buffer);
+
+	if(xQueueSend(queues[request->flash_class],request,portMAX_DELAY) != pdPASS){
+		return FLASH_ERROR;
+	}
+	xSemaphoreGive(work);
+
+	xSemaphoreTake(request->done,portMAX_DELAY);
+
+	return result;
+}
+
+FlashStatus_t flash_read(uint8_t flash_class,uint32_t address,uint8_t * data,uint16_t length){
+
+	flashRequest_t request;
+
+	memset(&request,0,sizeof(request));
+	request.op = FLASH_OP_READ;
+	request.flash_class = flash_class;
+	request.address = address;
+	request.data = data;
+	request.length = length;
+
+	return submit(&request);
+}
+
+FlashStatus_t flash_program(uint8_t flash_class,uint32_t address,const uint8_t * data,uint16_t length){
+
+	flashRequest_t request;
+
+	memset(&request,0,sizeof(request));
+	request.op = FLASH_OP_PROGRAM;
+	request.flash_class = flash_class;
+	request.address = address;
+	request.data = (uint8_t *)data;		//Only read.
+	request.length = length;
+
+	return submit(&request);
+}
+
+FlashStatus_t flash_erase(uint8_t flash_class,uint32_t address,volatile uint8_t * pending){
+
+	flashRequest_t request;
+
+	memset(&request,0,sizeof(request));
+	request.op = FLASH_OP_ERASE;
+	request.flash_class = flash_class;
+	request.address = address;
+
+	if(pending == NULL || !scheduler_running()){
+		return submit(&request);
+	}
+
+	//Nothing waits for a background erase, so the request is copied into the queue and finishes on its own.
+	request.pending = pending;
+	request.queued = hr_timer_now();
+	*pending = 1;
+
+	if(xQueueSend(queues[flash_class],&request,0) != pdPASS){
+
+		*pending = 0;
+		return FLASH_BUSY;
+	}
+	xSemaphoreGive(work);
+
+	return FLASH_OK;
+}
+
+FlashStatus_t flash_stream(uint8_t flash_class,uint32_t address,uint32_t length,FlashStream_t * stream){
+
+	flashRequest_t request;
+
+	memset(&request,0,sizeof(request));
+	request.op = FLASH_OP_STREAM;
+	request.flash_class = flash_class;
+	request.address = address;
+	request.length = length;
+	request.stream = stream;
+
+	return submit(&request);
+}
+
+FlashStatus_t flash_verify(uint8_t flash_class,uint32_t address,const uint8_t * data,uint16_t length,volatile uint8_t * pending,FlashStatus_t * result){
+
+	flashRequest_t request;
+
+	memset(&request,0,sizeof(request));
+	request.op = FLASH_OP_VERIFY;
+	request.flash_class = flash_class;
+	request.address = address;
+	request.data = (uint8_t *)data;		//Only read.
+	request.length = length;
+
+	if(pending == NULL || !scheduler_running()){
+		return submit(&request);
+	}
+
+	//Like a background erase, except the caller also gets the result.
+	request.pending = pending;
+	request.result = result;
+	request.queued = hr_timer_now();
+	*pending = 1;
+
+	if(xQueueSend(queues[flash_class],&request,0) != pdPASS){
+
+		*pending = 0;
+		return FLASH_BUSY;
+	}
+	xSemaphoreGive(work);
+
+	return FLASH_OK;
+}
+
+uint32_t flash_scan(uint32_t address){
+
+	flashRequest_t request;
+	uint32_t end = address;
+
+	memset(&request,0,sizeof(request));
+	request.op = FLASH_OP_SCAN;
+	request.flash_class = FLASH_CLASS_READ;
+	request.address = address;
+	request.scan_end = &end;
+
+	submit(&request);
+
+	return end;
+}
+
+uint8_t flash_map_used(uint32_t address){
+
+	int16_t sector = map_sector(address);
+
+	return sector >= 0 && !(map[sector/8] & (1 << (sector%8)));
+}
+
+uint32_t flash_map_next(uint32_t address,uint32_t end,uint32_t * range_end){
+
+	int16_t sector;
+
+	if(address < FLASH_START_ADDRESS){
+		address = FLASH_START_ADDRESS;
+	}
+
+	while(address < end && !flash_map_used(address)){
+
+		sector = map_sector(address);
+		if(sector >= 0){
+			address = map_sector_address(sector + 1);
+		}
+		else{
+			//The map sector, or past the end of the flash.
+			address = (address < FLASH_MAP_ADDRESS + FLASH_SECTOR_SIZE) ? FLASH_MAP_ADDRESS + FLASH_SECTOR_SIZE : end;
+		}
+	}
+	if(address >= end){
+		*range_end = end;
+		return end;
+	}
+
+	*range_end = address;
+	while(*range_end < end && flash_map_used(*range_end)){
+		*range_end = map_sector_address(map_sector(*range_end) + 1);
+	}
+	if(*range_end > end){
+		*range_end = end;
+	}
+
+	return address;
+}
+
+uint16_t flash_map_count(void){
+
+	uint16_t count = 0;
+	int16_t sector;
+
+	//The bit for the map's own sector is never set, so it is left out.
+	for(sector=0;sector<FLASH_MAP_SECTORS;sector++){
+		if(map_sector(map_sector_address(sector)) >= 0){
+			count += !(map[sector/8] & (1 << (sector%8)));
+		}
+	}
+	return count;
+}
+
+FlashStatus_t flash_map_commit(void){
+
+	flashRequest_t request;
+
+	memset(&request,0,sizeof(request));
+	request.op = FLASH_OP_MAP_COMMIT;
+	request.flash_class = FLASH_CLASS_ERASE;
+
+	return submit(&request);
+}
+
+void flash_service_stats(uint8_t flash_class,flashClassStats_t * class_stats){
+
+	taskENTER_CRITICAL();
+	*class_stats = stats[flash_class];
+	taskEXIT_CRITICAL();
+}
+
+void flash_service_reset_stats(void){
+
+	taskENTER_CRITICAL();
+	memset(stats,0,sizeof(stats));
+	taskEXIT_CRITICAL();
+}
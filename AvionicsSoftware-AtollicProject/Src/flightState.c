@@ -0,0 +1,152 @@
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// UMSATS 2018-2020
+//
+// Repository:
+//  UMSATS/Avionics-2019
+//
+// File Description:
+//  Source file for the flight state machine (launch, apogee, main and landing detection).
+//
+// History
+// 2026-10-19
+// - Created. Detection logic moved out of loggingTask.
+// - A confirmed deployment only moves the state forward.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include "flightState.h"
+#include <math.h>
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// DEFINITIONS AND MACROS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#define ALT_COUNT_MAX		245		//alt_count wraps back to ALT_COUNT_WRAP so it stays above LANDED_ALTITUDE_SAMPLES.
+#define ALT_COUNT_WRAP		201
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// FUNCTIONS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+static uint64_t sum_of_squares(const int16_t v[3]){
+
+	return (uint64_t)((int32_t)v[0]*v[0]) + (uint64_t)((int32_t)v[1]*v[1]) + (uint64_t)((int32_t)v[2]*v[2]);
+}
+
+float pressure_altitude(float pressure,float temperature,float ref_pres,float ref_alt){
+
+	float p_term = pow((ref_pres/(pressure/100)),(1/5.257F))-1;
+	float t_term = (temperature/100)+273.15F;
+
+	return (p_term*t_term)/0.0065F+ref_alt;
+}
+
+void flight_state_init(flightState_t * fs,uint8_t * state,uint8_t * flags){
+
+	fs->state = state;
+	fs->flags = flags;
+
+	fs->altitude = 0;
+	fs->alt_filtered = 0;
+	fs->alt_prev = 0;
+	fs->alt_count = 0;
+	fs->alt_main_count = 0;
+	fs->apogee_holdout_count = 0;
+}
+
+uint32_t flight_state_update(flightState_t * fs,const flightSample_t * sample){
+
+	uint32_t events = 0;
+
+	fs->altitude = sample->altitude;
+	fs->alt_filtered = fs->alt_filtered + (sample->altitude - fs->alt_filtered)*ALTITUDE_FILTER_GAIN;
+
+	if(*fs->state == STATE_LAUNCHPAD_ARMED && sample->acc[0] > LAUNCH_ACC_THRESHOLD){
+
+		*fs->state = STATE_IN_FLIGHT_PRE_APOGEE;
+		*fs->flags |= FLAG_PRE_DROGUE | FLAG_IN_FLIGHT;
+		events |= LAUNCH_DETECT;
+	}
+
+	//Check if the rocket has landed.
+	if(*fs->state == STATE_IN_FLIGHT_POST_MAIN){
+
+		if(fs->alt_count > 0){
+
+			//If altitude is within a 1m range for 200 samples
+			if(fs->altitude > (fs->alt_prev - LANDED_ALTITUDE_WINDOW) && fs->altitude < (fs->alt_prev + LANDED_ALTITUDE_WINDOW)){
+				fs->alt_count++;
+				if(fs->alt_count > ALT_COUNT_MAX){
+					fs->alt_count = ALT_COUNT_WRAP;
+				}
+			}else{
+				fs->alt_count = 0;
+			}
+		}
+		else{
+
+			fs->alt_prev = fs->altitude;
+			fs->alt_count++;
+		}
+
+		//If the gyro readings are all less than ~4.4 deg/sec and the altitude is not changing then the rocket has probably landed.
+		if(sum_of_squares(sample->gyro) < LANDED_GYRO_THRESHOLD && fs->alt_count > LANDED_ALTITUDE_SAMPLES){
+
+			*fs->state = STATE_LANDED;
+			*fs->flags &= ~FLAG_IN_FLIGHT;
+			events |= LAND_DETECT;
+		}
+	}
+
+	//Check if the altitude is below 1500ft, after the drogue has been deployed.
+	if(*fs->state == STATE_IN_FLIGHT_POST_APOGEE){
+
+		if(fs->alt_filtered < MAIN_ALTITUDE){
+			fs->alt_main_count++;
+		}
+		else{
+			fs->alt_main_count = 0;
+		}
+		if(fs->alt_main_count > MAIN_ALTITUDE_SAMPLES){
+			events |= MAIN_DETECT;
+		}
+	}
+
+	//Check if rocket has reached apogee.
+	if(*fs->state == STATE_IN_FLIGHT_PRE_APOGEE){
+
+		fs->apogee_holdout_count++;
+		if(fs->apogee_holdout_count > APOGEE_HOLDOUT_SAMPLES){
+
+			if(sum_of_squares(sample->acc) < 1 && fs->alt_filtered > APOGEE_MIN_ALTITUDE){
+				events |= DROGUE_DETECT;
+			}
+		}
+	}
+
+	return events;
+}
+
+uint32_t flight_state_deployed(flightState_t * fs,uint32_t event){
+
+	//A late drogue pulse result after the main, from the backup timer or the altitude, must not bring back main detection.
+	if(event & MAIN_DETECT){
+
+		if(*fs->state < STATE_IN_FLIGHT_POST_MAIN){
+			*fs->state = STATE_IN_FLIGHT_POST_MAIN;
+		}
+		*fs->flags |= FLAG_POST_MAIN;
+		return MAIN_DEPLOY;
+	}
+	if(event & DROGUE_DETECT){
+
+		if(*fs->state < STATE_IN_FLIGHT_POST_APOGEE){
+			*fs->state = STATE_IN_FLIGHT_POST_APOGEE;
+		}
+		*fs->flags |= FLAG_POST_DROGUE;
+		return DROGUE_DEPLOY;
+	}
+
+	return 0;
+}
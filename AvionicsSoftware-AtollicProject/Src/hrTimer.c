@@ -0,0 +1,52 @@
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// UMSATS 2018-2020
+//
+// Repository:
+//  UMSATS/Avionics-2019
+//
+// File Description:
+//  Source file for the high resolution timer.
+//
+// History
+// 2026-10-19
+// - Created.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include "hrTimer.h"
+#include "stm32f4xx_hal.h"
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// FUNCTIONS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void hr_timer_init(void){
+
+	uint32_t timer_clock = HAL_RCC_GetPCLK1Freq();
+
+	if(TIM5->CR1 & TIM_CR1_CEN){
+		return;
+	}
+
+	//The APB1 timers run at twice the bus clock when the bus is divided down.
+	if((RCC->CFGR & RCC_CFGR_PPRE1) != RCC_HCLK_DIV1){
+		timer_clock *= 2;
+	}
+
+	__HAL_RCC_TIM5_CLK_ENABLE();
+
+	TIM5->CR1 = 0;
+	TIM5->PSC = (timer_clock/HR_TIMER_FREQ) - 1;
+	TIM5->ARR = 0xFFFFFFFF;
+	TIM5->CNT = 0;
+	TIM5->EGR = TIM_EGR_UG;		//Load the prescaler now instead of at the first overflow.
+	TIM5->SR = 0;
+	TIM5->CR1 |= TIM_CR1_CEN;
+}
+
+uint32_t hr_timer_now(void){
+
+	return TIM5->CNT;
+}
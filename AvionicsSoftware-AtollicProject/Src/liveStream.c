@@ -0,0 +1,171 @@
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// UMSATS 2018-2020
+//
+// Repository:
+//  UMSATS/Avionics-2019
+//
+// File Description:
+//  Source file for the live sensor stream.
+//
+// History
+// 2026-10-19
+// - Created.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include "liveStream.h"
+#include "logPacket.h"
+#include "cmsis_os.h"
+#include <string.h>
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// CONSTANTS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+static UART_HandleTypeDef * stream_uart = NULL;
+static DMA_HandleTypeDef dma_tx;
+
+static streamQueue_t queue;
+static volatile uint16_t sending = 0;		//Bytes of the DMA transfer under way, 0 when idle.
+
+static streamRecord_t record;
+static uint32_t stats_time_us;
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// FUNCTIONS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//Starts sending the oldest bytes of the queue if the UART is idle. Called with the interrupts held off.
+static void send_next(void){
+
+	const uint8_t * data;
+	uint16_t length;
+
+	if(sending != 0){
+		return;
+	}
+
+	length = stream_queue_chunk(&queue,&data);
+	if(length > 0 && HAL_UART_Transmit_DMA(stream_uart,(uint8_t *)data,length) == HAL_OK){
+		sending = length;
+	}
+}
+
+static void init_dma(UART_HandleTypeDef * huart){
+
+	__HAL_RCC_DMA2_CLK_ENABLE();
+
+	//USART6_TX is DMA2 stream 6 channel 5.
+	dma_tx.Instance = DMA2_Stream6;
+	dma_tx.Init.Channel = DMA_CHANNEL_5;
+	dma_tx.Init.Direction = DMA_MEMORY_TO_PERIPH;
+	dma_tx.Init.PeriphInc = DMA_PINC_DISABLE;
+	dma_tx.Init.MemInc = DMA_MINC_ENABLE;
+	dma_tx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+	dma_tx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+	dma_tx.Init.Mode = DMA_NORMAL;
+	dma_tx.Init.Priority = DMA_PRIORITY_LOW;
+	dma_tx.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+	if(HAL_DMA_Init(&dma_tx) != HAL_OK){
+		while(1);
+	}
+	__HAL_LINKDMA(huart,hdmatx,dma_tx);
+
+	HAL_NVIC_SetPriority(DMA2_Stream6_IRQn,LIVE_STREAM_IRQ_PRIORITY,0);
+	HAL_NVIC_EnableIRQ(DMA2_Stream6_IRQn);
+
+	//The end of a transfer is signalled by the UART once the last byte is out.
+	HAL_NVIC_SetPriority(USART6_IRQn,LIVE_STREAM_IRQ_PRIORITY,0);
+	HAL_NVIC_EnableIRQ(USART6_IRQn);
+}
+
+void live_stream_start(UART_HandleTypeDef * huart){
+
+	if(huart->Instance != USART6){
+		while(1);
+	}
+
+	if(huart->Init.BaudRate != LIVE_STREAM_BAUD_RATE){
+
+		huart->Init.BaudRate = LIVE_STREAM_BAUD_RATE;
+		if(HAL_UART_Init(huart) != HAL_OK){
+			while(1);
+		}
+	}
+
+	stream_queue_init(&queue);
+	sending = 0;
+	stream_uart = huart;
+	init_dma(huart);
+
+	stats_time_us = 0;
+	memset(&record,0,sizeof(record));
+}
+
+void live_stream_reading(const captureReading_t * reading,uint32_t events){
+
+	if(stream_uart == NULL){
+		return;
+	}
+
+	record.kind = STREAM_KIND_READING;
+	record.time_us = reading->time_us;
+	record.contents = 0;
+
+	if(reading->types & ACC_TYPE){
+		record.contents |= STREAM_HAS_ACC;
+		memcpy(record.acc,reading->acc,sizeof(record.acc));
+	}
+	if(reading->types & GYRO_TYPE){
+		record.contents |= STREAM_HAS_GYRO;
+		memcpy(record.gyro,reading->gyro,sizeof(record.gyro));
+	}
+	if(reading->types & PRES_TYPE){
+		record.contents |= STREAM_HAS_PRES;
+		record.pressure = reading->pressure;
+		record.temperature = reading->temperature;
+	}
+	if(events & EVENT_MASK){
+		record.contents |= STREAM_HAS_EVENTS;
+		record.events = (events & EVENT_MASK) >> EXT_KIND_SHIFT;
+	}
+
+	//Only the logging task puts records in and only the interrupt takes bytes out, so the queue needs no lock.
+	stream_queue_put(&queue,&record);
+
+	if(reading->time_us - stats_time_us >= LIVE_STREAM_STATS_PERIOD*1000){
+
+		record.kind = STREAM_KIND_STATS;
+		stream_queue_put(&queue,&record);
+		stats_time_us = reading->time_us;
+	}
+
+	taskENTER_CRITICAL();
+	send_next();
+	taskEXIT_CRITICAL();
+}
+
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef * huart){
+
+	if(huart != stream_uart){
+		return;
+	}
+
+	stream_queue_release(&queue,sending);
+	sending = 0;
+	send_next();
+}
+
+void live_stream_dma_irq(void){
+
+	HAL_DMA_IRQHandler(&dma_tx);
+}
+
+void live_stream_uart_irq(void){
+
+	if(stream_uart != NULL){
+		HAL_UART_IRQHandler(stream_uart);
+	}
+}
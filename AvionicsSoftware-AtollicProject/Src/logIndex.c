@@ -0,0 +1,171 @@
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// UMSATS 2018-2020
+//
+// Repository:
+//  UMSATS/Avionics-2019
+//
+// File Description:
+//  Source file for the log index.
+//
+//  Table layout: LOG_SPARE_PAGES entries of a big endian log address (4 bytes) from LOG_INDEX_ADDRESS. A blank entry
+//  (0xFFFFFFFF) ends the table.
+//
+// History
+// 2026-10-19
+// - Created.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include "logIndex.h"
+#include "flashService.h"
+#include <string.h>
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// DEFINITIONS AND MACROS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#define ENTRY_ADDRESS(n)			(LOG_INDEX_ADDRESS+((uint32_t)(n)*LOG_INDEX_ENTRY_SIZE))
+#define SPARE_ADDRESS(n)			(LOG_SPARE_ADDRESS+((uint32_t)(n)*FLASH_PAGE_SIZE))
+#define ENTRIES_PER_PAGE			(FLASH_PAGE_SIZE/LOG_INDEX_ENTRY_SIZE)
+#define BLANK_ENTRY					0xFFFFFFFF
+
+//Only whole log pages are remapped. Anything else is an entry that was cut short by a reset.
+#define VALID_ENTRY(address)		(((address) & (FLASH_PAGE_SIZE-1)) == 0 && (address) >= FLASH_START_ADDRESS && (address) < LOG_INDEX_ADDRESS)
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// STRUCTS AND STRUCT TYPEDEFS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+typedef struct{
+
+	uint16_t count;								//Entries in the table, the next spare page is the same number.
+	uint32_t entries[LOG_SPARE_PAGES];
+
+}logIndex_t;
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// CONSTANTS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+static logIndex_t table;
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// FUNCTIONS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+static void set_uint32(uint8_t * dest,uint32_t value){
+
+	dest[0] = (value >> 24) & 0xFF;
+	dest[1] = (value >> 16) & 0xFF;
+	dest[2] = (value >> 8) & 0xFF;
+	dest[3] = value & 0xFF;
+}
+
+static uint32_t get_uint32(const uint8_t * src){
+
+	return ((uint32_t)src[0] << 24) | ((uint32_t)src[1] << 16) | ((uint32_t)src[2] << 8) | src[3];
+}
+
+logIndexStatus_t log_index_init(void){
+
+	uint8_t data[FLASH_PAGE_SIZE];
+	uint16_t n;
+
+	memset(&table,0,sizeof(table));
+
+	for(n=0;n<LOG_SPARE_PAGES;n++){
+
+		uint32_t entry;
+
+		if(n % ENTRIES_PER_PAGE == 0 && flash_read(FLASH_CLASS_READ,ENTRY_ADDRESS(n),data,FLASH_PAGE_SIZE) != FLASH_OK){
+			return LOG_INDEX_ERROR;
+		}
+
+		entry = get_uint32(&data[(n % ENTRIES_PER_PAGE)*LOG_INDEX_ENTRY_SIZE]);
+		if(entry == BLANK_ENTRY){
+			break;
+		}
+
+		table.entries[n] = entry;
+	}
+
+	table.count = n;
+
+	return LOG_INDEX_OK;
+}
+
+uint32_t log_index_remap(uint32_t address,const uint8_t * page){
+
+	uint8_t entry[LOG_INDEX_ENTRY_SIZE];
+
+	set_uint32(entry,address);
+
+	while(table.count < LOG_SPARE_PAGES){
+
+		uint16_t n = table.count;
+
+		//The slot is used even if a program fails, so the entries stay in step with the spare pages.
+		table.entries[n] = address;
+		table.count++;
+
+		if(flash_program(FLASH_CLASS_DATA,ENTRY_ADDRESS(n),entry,LOG_INDEX_ENTRY_SIZE) == FLASH_OK
+				&& flash_program(FLASH_CLASS_DATA,SPARE_ADDRESS(n),page,FLASH_PAGE_SIZE) == FLASH_OK
+				&& flash_verify(FLASH_CLASS_DATA,SPARE_ADDRESS(n),page,FLASH_PAGE_SIZE,NULL,NULL) == FLASH_OK){
+
+			return SPARE_ADDRESS(n);
+		}
+	}
+
+	return 0;
+}
+
+uint32_t log_index_lookup(uint32_t address){
+
+	uint16_t n = table.count;
+
+	//The newest entry wins, if the first spare page failed too.
+	while(n > 0){
+
+		n--;
+		if(table.entries[n] == address){
+			return SPARE_ADDRESS(n);
+		}
+	}
+
+	return address;
+}
+
+uint32_t log_index_next(uint32_t address){
+
+	uint32_t next = BLANK_ENTRY;
+	uint16_t n;
+
+	for(n=0;n<table.count;n++){
+
+		if(VALID_ENTRY(table.entries[n]) && table.entries[n] >= address && table.entries[n] < next){
+			next = table.entries[n];
+		}
+	}
+
+	return next;
+}
+
+logIndexStatus_t log_index_erase(void){
+
+	if(flash_erase(FLASH_CLASS_ERASE,LOG_INDEX_ADDRESS,NULL) != FLASH_OK){
+		return LOG_INDEX_ERROR;
+	}
+
+	memset(&table,0,sizeof(table));
+
+	return LOG_INDEX_OK;
+}
+
+uint16_t log_index_count(void){
+
+	return table.count;
+}
+
+uint32_t log_index_entry(uint16_t n){
+
+	return (n < table.count) ? table.entries[n] : BLANK_ENTRY;
+}
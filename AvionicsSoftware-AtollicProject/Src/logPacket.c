@@ -0,0 +1,395 @@
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// UMSATS 2018-2020
+//
+// Repository:
+//  UMSATS/Avionics-2019
+//
+// File Description:
+//  Source file for the flight log packet encoder and page writer.
+//
+// History
+// 2026-10-19
+// - Created. Packet encoding and page buffering moved out of dataLogging.c.
+// - Measurements can hold any of the readings, so sensors can be logged at different rates.
+// - Added the microsecond clock and sync records.
+// - Pages end with a CRC-32.
+// - Pages start with a header with the page sequence number and the offset of the first packet.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include "logPacket.h"
+#include "crc.h"
+#include <string.h>
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// DEFINITIONS AND MACROS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#define PAD_BUFFER_SIZE	(LOG_PAGE_SIZE*LOG_PAD_PAGES)
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// FUNCTIONS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+static void set_header(Measurement_t * measurement,uint32_t header){
+
+	measurement->data[0] = (header >> 16) & 0xFF;
+	measurement->data[1] = (header >> 8) & 0xFF;
+	measurement->data[2] = (header) & 0xFF;
+}
+
+static void set_int16(uint8_t * dest,int16_t value){
+
+	dest[0] = ((uint16_t)value) >> 8;
+	dest[1] = ((uint16_t)value) & 0xFF;
+}
+
+//Length of the readings present in a measurement header, not counting the header.
+static uint8_t readings_length(uint32_t header){
+
+	uint8_t length = 0;
+
+	if(header & ACC_TYPE){
+		length += ACC_LENGTH;
+	}
+	if(header & GYRO_TYPE){
+		length += GYRO_LENGTH;
+	}
+	if(header & PRES_TYPE){
+		length += PRES_LENGTH;
+	}
+	if(header & TEMP_TYPE){
+		length += TEMP_LENGTH;
+	}
+	//The altitude is calculated from pressure and temperature so it is only present with both.
+	if((header & (PRES_TYPE | TEMP_TYPE)) == (PRES_TYPE | TEMP_TYPE)){
+		length += ALT_LENGTH;
+	}
+
+	return length;
+}
+
+void log_packet_clear(Measurement_t * measurement){
+
+	memset(measurement->data,0,sizeof(Measurement_t));
+}
+
+//Adds a reading of 3 axes after the ones already in the measurement.
+static void add_axes(Measurement_t * measurement,uint32_t type,const int16_t values[3]){
+
+	uint32_t header = log_packet_header(measurement->data);
+	uint8_t * dest = &measurement->data[HEADER_SIZE+readings_length(header)];
+	int i;
+
+	set_header(measurement,header | type);
+
+	for(i=0;i<3;i++){
+		set_int16(&dest[2*i],values[i]);
+	}
+}
+
+void log_packet_begin(Measurement_t * measurement,uint16_t delta_t){
+
+	log_packet_clear(measurement);
+
+	// Make sure time doesn't overwrite type and event bits.
+	set_header(measurement,delta_t & DELTA_T_MASK);
+}
+
+void log_packet_add_acc(Measurement_t * measurement,const int16_t acc[3]){
+
+	add_axes(measurement,ACC_TYPE,acc);
+}
+
+void log_packet_add_gyro(Measurement_t * measurement,const int16_t gyro[3]){
+
+	add_axes(measurement,GYRO_TYPE,gyro);
+}
+
+void log_packet_set_imu(Measurement_t * measurement,uint16_t delta_t,const int16_t acc[3],const int16_t gyro[3]){
+
+	log_packet_begin(measurement,delta_t);
+	log_packet_add_acc(measurement,acc);
+	log_packet_add_gyro(measurement,gyro);
+}
+
+void log_packet_set_pres(Measurement_t * measurement,uint32_t pressure,uint32_t temperature,uint32_t altitude_bits){
+
+	uint32_t header = log_packet_header(measurement->data);
+	uint8_t * dest = &measurement->data[HEADER_SIZE+readings_length(header)];
+
+	set_header(measurement,header | PRES_TYPE | TEMP_TYPE);
+
+	dest[0] = (pressure >> 16) & 0xFF;		//MSB
+	dest[1] = (pressure >> 8) & 0xFF;		//LSB
+	dest[2] = pressure & 0xFF;				//XLSB
+
+	dest[3] = (temperature >> 16) & 0xFF;	//MSB
+	dest[4] = (temperature >> 8) & 0xFF;	//LSB
+	dest[5] = temperature & 0xFF;			//XLSB
+
+	dest[6] = (altitude_bits >> 24) & 0xFF;
+	dest[7] = (altitude_bits >> 16) & 0xFF;
+	dest[8] = (altitude_bits >> 8) & 0xFF;
+	dest[9] = altitude_bits & 0xFF;
+}
+
+void log_packet_add_event(Measurement_t * measurement,uint32_t events){
+
+	set_header(measurement,log_packet_header(measurement->data) | (events & EVENT_MASK));
+}
+
+uint32_t log_packet_header(const uint8_t * packet){
+
+	return ((uint32_t)packet[0] << 16) + ((uint32_t)packet[1] << 8) + packet[2];
+}
+
+uint8_t log_packet_length(uint32_t header){
+
+	if((header & TYPE_MASK) == 0){
+
+		//Extended record.
+		if((header & EXT_KIND_MASK) == 0 || (header & EXT_LENGTH_MASK) > EXT_MAX_PAYLOAD){
+			return 0;
+		}
+		return HEADER_SIZE + (header & EXT_LENGTH_MASK);
+	}
+
+	return HEADER_SIZE + readings_length(header);
+}
+
+uint8_t log_packet_ext(uint8_t * dest,uint8_t kind,const uint8_t * payload,uint8_t length){
+
+	uint32_t header = ((uint32_t)kind << EXT_KIND_SHIFT) | length;
+
+	if(kind == 0 || length > EXT_MAX_PAYLOAD){
+		return 0;
+	}
+
+	dest[0] = (header >> 16) & 0xFF;
+	dest[1] = (header >> 8) & 0xFF;
+	dest[2] = (header) & 0xFF;
+	memcpy(&dest[HEADER_SIZE],payload,length);
+
+	return HEADER_SIZE + length;
+}
+
+void log_clock_init(LogClock_t * clock){
+
+	clock->time = 0;
+	clock->sync_time = 0;
+	clock->synced = 0;
+}
+
+uint8_t log_clock_stamp(LogClock_t * clock,uint32_t time_us,uint16_t * delta_t,uint8_t * sync_record){
+
+	uint32_t delta = time_us - clock->time;
+	uint8_t payload[SYNC_LENGTH];
+	uint8_t scale = 0;
+	uint32_t count;
+
+	//A reading from before the last one wraps around to a huge delta, so it gets a sync record too.
+	if(!clock->synced || delta > TIME_MAX_DELTA || time_us - clock->sync_time >= SYNC_PERIOD){
+
+		payload[0] = (time_us >> 24) & 0xFF;
+		payload[1] = (time_us >> 16) & 0xFF;
+		payload[2] = (time_us >> 8) & 0xFF;
+		payload[3] = time_us & 0xFF;
+
+		clock->time = time_us;
+		clock->sync_time = time_us;
+		clock->synced = 1;
+		*delta_t = 0;
+
+		return log_packet_ext(sync_record,EXT_KIND_SYNC,payload,SYNC_LENGTH);
+	}
+
+	//Smallest scale the delta fits in. It is rounded down, and the time the reader will see is kept so the
+	//remainder goes into the next delta instead of adding up.
+	while((delta >> (scale*TIME_SCALE_BITS)) > TIME_COUNT_MASK){
+		scale++;
+	}
+	count = delta >> (scale*TIME_SCALE_BITS);
+
+	clock->time += count << (scale*TIME_SCALE_BITS);
+	*delta_t = ((uint16_t)scale << TIME_SCALE_SHIFT) | count;
+
+	return 0;
+}
+
+uint32_t log_packet_delta_us(uint32_t header){
+
+	uint8_t scale = (header & DELTA_T_MASK) >> TIME_SCALE_SHIFT;
+
+	return (header & TIME_COUNT_MASK) << (scale*TIME_SCALE_BITS);
+}
+
+uint32_t log_packet_sync_time(const uint8_t * record){
+
+	const uint8_t * p = &record[HEADER_SIZE];
+
+	return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+void log_writer_init(LogWriter_t * writer,logPageHandler_t handler,void * context,uint16_t sequence){
+
+	memset(writer->buffers,0,sizeof(writer->buffers));
+	writer->buffer_selection = BUFFER_A;
+	writer->buffer_index = 0;
+	writer->page_sequence = sequence;
+	writer->first_packet = LOG_PAGE_NO_PACKET;
+
+	writer->pad_tail = 0;
+	writer->pad_used = 0;
+
+	writer->page_handler = handler;
+	writer->page_handler_context = context;
+}
+
+void log_writer_append(LogWriter_t * writer,const uint8_t * data,uint16_t length){
+
+	if(length > 0 && writer->first_packet == LOG_PAGE_NO_PACKET){
+		writer->first_packet = writer->buffer_index;
+	}
+
+	while(length > 0){
+
+		uint16_t room = LOG_PAGE_DATA_SIZE - writer->buffer_index;
+		uint16_t count = (length < room) ? length : room;
+
+		memcpy(&writer->buffers[writer->buffer_selection][LOG_PAGE_HEADER_SIZE + writer->buffer_index],data,count);
+		writer->buffer_index += count;
+		data += count;
+		length -= count;
+
+		if(writer->buffer_index == LOG_PAGE_DATA_SIZE){
+
+			//Switch buffers before handing off the full one, so the next packet never lands in the page being written.
+			BufferSelection_t full = writer->buffer_selection;
+			uint8_t * page = writer->buffers[full];
+			uint32_t crc;
+
+			page[0] = LOG_PAGE_FORMAT;
+			page[1] = (writer->page_sequence >> 8) & 0xFF;
+			page[2] = writer->page_sequence & 0xFF;
+			page[3] = writer->first_packet;
+
+			crc = crc32(page,LOG_PAGE_CRC_OFFSET);
+			page[LOG_PAGE_CRC_OFFSET] = (crc >> 24) & 0xFF;
+			page[LOG_PAGE_CRC_OFFSET+1] = (crc >> 16) & 0xFF;
+			page[LOG_PAGE_CRC_OFFSET+2] = (crc >> 8) & 0xFF;
+			page[LOG_PAGE_CRC_OFFSET+3] = crc & 0xFF;
+
+			writer->buffer_selection = (full == BUFFER_A) ? BUFFER_B : BUFFER_A;
+			writer->buffer_index = 0;
+			writer->page_sequence++;
+
+			//The rest of a packet split across pages is not a packet start, the next append is.
+			writer->first_packet = LOG_PAGE_NO_PACKET;
+
+			if(writer->page_handler != NULL){
+				writer->page_handler(writer->page_handler_context,writer->buffers[full]);
+			}
+		}
+	}
+}
+
+uint8_t log_page_check(const uint8_t * page){
+
+	const uint8_t * p = &page[LOG_PAGE_CRC_OFFSET];
+	uint32_t crc = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+
+	return page[0] == LOG_PAGE_FORMAT && crc32(page,LOG_PAGE_CRC_OFFSET) == crc;
+}
+
+uint16_t log_page_sequence(const uint8_t * page){
+
+	return ((uint16_t)page[1] << 8) | page[2];
+}
+
+uint8_t log_page_first_packet(const uint8_t * page){
+
+	return page[3];
+}
+
+void log_writer_append_pad(LogWriter_t * writer,const uint8_t * data,uint16_t length){
+
+	uint16_t head;
+	uint16_t first;
+
+	if(length == 0 || length > PAD_BUFFER_SIZE){
+		return;
+	}
+
+	//Drop whole packets from the tail until the new one fits, so the buffer always starts on a packet boundary.
+	while(writer->pad_used + length > PAD_BUFFER_SIZE){
+
+		uint8_t header_bytes[HEADER_SIZE];
+		uint8_t oldest_length;
+		int i;
+
+		for(i=0;i<HEADER_SIZE;i++){
+			header_bytes[i] = writer->pad_buffer[(writer->pad_tail + i) % PAD_BUFFER_SIZE];
+		}
+
+		oldest_length = log_packet_length(log_packet_header(header_bytes));
+		if(oldest_length == 0 || oldest_length > writer->pad_used){
+			//Should never happen, start over rather than write out garbage.
+			writer->pad_tail = 0;
+			writer->pad_used = 0;
+			break;
+		}
+
+		writer->pad_tail = (writer->pad_tail + oldest_length) % PAD_BUFFER_SIZE;
+		writer->pad_used -= oldest_length;
+	}
+
+	head = (writer->pad_tail + writer->pad_used) % PAD_BUFFER_SIZE;
+	first = PAD_BUFFER_SIZE - head;
+	if(first > length){
+		first = length;
+	}
+
+	memcpy(&writer->pad_buffer[head],data,first);
+	memcpy(writer->pad_buffer,&data[first],length - first);
+	writer->pad_used += length;
+}
+
+void log_writer_flush_pad(LogWriter_t * writer){
+
+	//One packet at a time, so the page headers point at packet starts. A packet that wraps around the end of the
+	//buffer is put back together first.
+	while(writer->pad_used > 0){
+
+		uint8_t packet[HEADER_SIZE+EXT_MAX_PAYLOAD];
+		uint16_t length;
+		uint16_t first;
+		int i;
+
+		for(i=0;i<HEADER_SIZE;i++){
+			packet[i] = writer->pad_buffer[(writer->pad_tail + i) % PAD_BUFFER_SIZE];
+		}
+
+		length = log_packet_length(log_packet_header(packet));
+		if(length == 0 || length > writer->pad_used){
+			break;
+		}
+
+		first = PAD_BUFFER_SIZE - writer->pad_tail;
+		if(first >= length){
+			log_writer_append(writer,&writer->pad_buffer[writer->pad_tail],length);
+		}
+		else{
+			memcpy(packet,&writer->pad_buffer[writer->pad_tail],first);
+			memcpy(&packet[first],writer->pad_buffer,length - first);
+			log_writer_append(writer,packet,length);
+		}
+
+		writer->pad_tail = (writer->pad_tail + length) % PAD_BUFFER_SIZE;
+		writer->pad_used -= length;
+	}
+
+	writer->pad_tail = 0;
+	writer->pad_used = 0;
+}
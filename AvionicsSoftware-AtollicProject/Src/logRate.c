@@ -0,0 +1,175 @@
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// UMSATS 2018-2020
+//
+// Repository:
+//  UMSATS/Avionics-2019
+//
+// File Description:
+//  Source file for the flight phase logging rates.
+//
+// History
+// 2026-10-19
+// - Created.
+// - The flash use includes the CRC at the end of each page.
+// - The flash use includes the page header.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include "logRate.h"
+#include "logPacket.h"
+#include "flightState.h"
+#include <string.h>
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// FUNCTIONS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//Adds values to a block. Returns 1 with the rounded mean in out, and starts a new block, when it is full or forced.
+static uint8_t mean_add(logMean_t * mean,const int32_t in[],int32_t out[],uint8_t axes,uint8_t force){
+
+	uint8_t i;
+
+	for(i=0;i<axes;i++){
+		mean->sum[i] += in[i];
+	}
+	mean->count++;
+
+	if(mean->count < mean->factor && !force){
+		return 0;
+	}
+
+	for(i=0;i<axes;i++){
+
+		int64_t half = (mean->sum[i] >= 0) ? mean->count/2 : -(mean->count/2);
+
+		out[i] = (int32_t)((mean->sum[i] + half)/mean->count);
+		mean->sum[i] = 0;
+	}
+	mean->count = 0;
+
+	return 1;
+}
+
+static uint8_t add_axes(logMean_t * mean,const int16_t in[3],int16_t out[3],uint8_t force){
+
+	int32_t values[3] = { in[0], in[1], in[2] };
+	int32_t means[3];
+	uint8_t i;
+
+	if(!mean_add(mean,values,means,3,force)){
+		return 0;
+	}
+
+	for(i=0;i<3;i++){
+		out[i] = (int16_t)means[i];
+	}
+
+	return 1;
+}
+
+uint8_t log_rate_phase(uint8_t state){
+
+	switch(state){
+
+		case STATE_IN_FLIGHT_PRE_APOGEE:
+			return LOG_PHASE_ASCENT;
+		case STATE_IN_FLIGHT_POST_APOGEE:
+			return LOG_PHASE_DROGUE;
+		case STATE_IN_FLIGHT_POST_MAIN:
+			return LOG_PHASE_MAIN;
+		default:
+			return LOG_PHASE_PAD;
+	}
+}
+
+uint16_t log_rate_factor(uint32_t sample_period_us,uint16_t log_rate){
+
+	uint32_t factor;
+
+	if(log_rate == 0 || sample_period_us == 0){
+		return 1;
+	}
+
+	//(1000000/log_rate)/sample_period, rounded.
+	factor = (1000000 + (log_rate*sample_period_us)/2)/(log_rate*sample_period_us);
+
+	if(factor < 1){
+		factor = 1;
+	}
+	if(factor > 0xFFFF){
+		factor = 0xFFFF;
+	}
+
+	return (uint16_t)factor;
+}
+
+void log_rate_init(logRate_t * lr,const uint32_t period_us[3]){
+
+	memset(lr,0,sizeof(logRate_t));
+	memcpy(lr->period,period_us,sizeof(lr->period));
+
+	lr->acc.factor = 1;
+	lr->gyro.factor = 1;
+	lr->bmp.factor = 1;
+}
+
+void log_rate_set(logRate_t * lr,uint8_t phase,uint16_t log_rate){
+
+	lr->phase = phase;
+	lr->acc.factor = log_rate_factor(lr->period[0],log_rate);
+	lr->gyro.factor = log_rate_factor(lr->period[1],log_rate);
+	lr->bmp.factor = log_rate_factor(lr->period[2],log_rate);
+}
+
+uint8_t log_rate_add_acc(logRate_t * lr,const int16_t in[3],int16_t out[3],uint8_t force){
+
+	return add_axes(&lr->acc,in,out,force);
+}
+
+uint8_t log_rate_add_gyro(logRate_t * lr,const int16_t in[3],int16_t out[3],uint8_t force){
+
+	return add_axes(&lr->gyro,in,out,force);
+}
+
+uint8_t log_rate_add_bmp(logRate_t * lr,uint32_t pressure,int32_t temperature,uint32_t * pressure_out,int32_t * temperature_out,uint8_t force){
+
+	int32_t values[2] = { (int32_t)pressure, temperature };
+	int32_t means[2];
+
+	if(!mean_add(&lr->bmp,values,means,2,force)){
+		return 0;
+	}
+
+	*pressure_out = (uint32_t)means[0];
+	*temperature_out = means[1];
+
+	return 1;
+}
+
+uint32_t log_rate_bytes_per_second(const uint32_t period_us[3],uint16_t log_rate){
+
+	uint32_t rate[3];
+	uint32_t bytes;
+	uint8_t i;
+
+	for(i=0;i<3;i++){
+		rate[i] = (period_us[i] == 0) ? 0 : 1000000/(period_us[i]*log_rate_factor(period_us[i],log_rate));
+	}
+
+	if(rate[0] == rate[1]){
+		bytes = rate[0]*(HEADER_SIZE+ACC_LENGTH+GYRO_LENGTH);
+	}
+	else{
+		bytes = rate[0]*(HEADER_SIZE+ACC_LENGTH) + rate[1]*(HEADER_SIZE+GYRO_LENGTH);
+	}
+
+	bytes += rate[2]*(HEADER_SIZE+PRES_LENGTH+TEMP_LENGTH+ALT_LENGTH);
+
+	//At least one sync record a second.
+	bytes += SYNC_RECORD_SIZE;
+
+	//Each page also has a header and a CRC.
+	return (bytes*LOG_PAGE_SIZE + LOG_PAGE_DATA_SIZE - 1)/LOG_PAGE_DATA_SIZE;
+}
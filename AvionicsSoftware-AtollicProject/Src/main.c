@@ -8,6 +8,19 @@
  *	History:
  *	- 2019-01-22
  *		Created by Joseph Howarth
+ *	- 2026-10-19
+ *		Starts the DWT cycle counter when profiling is enabled.
+ *		Added the task monitor.
+ *		All tasks and queues are statically allocated.
+ *		Carries on from the last checkpoint after a reset in flight, without scanning the journal or the log.
+ *		The sensor fail beeps are queued, buzz() does not block any more.
+ *		The backup deployment timer task is replaced by the timer wheel.
+ *		The IMU and BMP388 readings share one queue and are timed by the acquisition schedule.
+ *		Finds the end of the flight event journal.
+ *		Added the flash service task, the only task that uses the flash driver.
+ *		Reads the log index.
+ *		Added the telemetry task, which sends to the radio on UART1.
+ *		Starts the summary log in the internal flash with a boot record.
  *
  *
  */
@@ -17,6 +30,9 @@
 #include "configuration.h"
 #include "cmsis_os.h"
 #include "flash.h"
+#include "flashService.h"
+#include "eventJournal.h"
+#include "logIndex.h"
 #include "sensorAG.h"
 #include "pressure_sensor_bmp3.h"
 #include "dataLogging.h"
@@ -28,9 +44,50 @@
 #include "buzzer.h"
 #include "timer.h"
 #include "recovery.h"
+#include "profiler.h"
+#include "taskMonitor.h"
+#include "restart.h"
+#include "timerWheel.h"
+#include "acquisition.h"
+#include "telemetry.h"
+#include "summaryLog.h"
+
+/* Task stack sizes in words. Use the xtract tasks command to see how much of each is used. */
+#define DEFAULT_TASK_STACK_SIZE	128
+#define IMU_TASK_STACK_SIZE		1000
+#define LOGGING_TASK_STACK_SIZE	10000
+#define XTRACT_TASK_STACK_SIZE	1000
+#define BMP_TASK_STACK_SIZE		1000
+#define STARTER_TASK_STACK_SIZE	1000
+
+#define SENSOR_QUEUE_LENGTH		64		//About 30 ms of readings with the IMU at 2 kHz.
+
+/* Task stacks, control blocks and queue storage. These are allocated at link time so the memory used is known from the map file. */
+static StackType_t defaultTaskStack[DEFAULT_TASK_STACK_SIZE];
+static StaticTask_t defaultTaskBuffer;
+static StackType_t imuTaskStack[IMU_TASK_STACK_SIZE];
+static StaticTask_t imuTaskBuffer;
+static StackType_t loggingTaskStack[LOGGING_TASK_STACK_SIZE];
+static StaticTask_t loggingTaskBuffer;
+static StackType_t xtractTaskStack[XTRACT_TASK_STACK_SIZE];
+static StaticTask_t xtractTaskBuffer;
+static StackType_t bmpTaskStack[BMP_TASK_STACK_SIZE];
+static StaticTask_t bmpTaskBuffer;
+static StackType_t starterTaskStack[STARTER_TASK_STACK_SIZE];
+static StaticTask_t starterTaskBuffer;
+static StackType_t monitorTaskStack[TASK_MONITOR_STACK_SIZE];
+static StaticTask_t monitorTaskBuffer;
+static StackType_t flashServiceTaskStack[FLASH_SERVICE_STACK_SIZE];
+static StaticTask_t flashServiceTaskBuffer;
+static StackType_t telemetryTaskStack[TELEMETRY_STACK_SIZE];
+static StaticTask_t telemetryTaskBuffer;
+
+static uint8_t sensorQueueStorage[SENSOR_QUEUE_LENGTH*sizeof(sensorReading_t)];
+static StaticQueue_t sensorQueueBuffer;
 
 osThreadId defaultTaskHandle;
 UART_HandleTypeDef huart6_ptr; //global var to be passed to vTask_xtract
+UART_HandleTypeDef huart1_ptr; //radio modem
 
 SPI_HandleTypeDef flash_spi;
 FlashStruct_t flash;
@@ -38,7 +95,9 @@ ImuTaskStruct imuTaskParams ;
 LoggingStruct_t logParams;
 PressureTaskParams bmp388Params;
 xtractParams xtractParameters;
+TelemetryParams_t telemetryParams;
 configData_t flightCompConfig;
+checkpoint_t resumeCheckpoint;
 
 
 startParams tasks;
@@ -59,9 +118,20 @@ int main(void)
 	/* Reset of all peripherals, Initializes the Flash interface and the Systick. */
 	HAL_Init();
 
+#if PROFILING_ENABLED
+	profile_init();
+#endif
+
 	/* Configure the system clock */
 	SystemClock_Config();
 
+	/* Start timing here in case this is a reset in flight. */
+	restart_init();
+	timer_wheel_init();
+
+	/* Does not need the external flash, so it is there even if that fails. */
+	summary_log_init();
+
 	/* Initialize all configured peripherals */
 	MX_GPIO_Init(); //GPIO MUST be firstly initialized
 
@@ -70,22 +140,19 @@ int main(void)
 	MX_HAL_UART6_Init(&huart6_ptr); //UART uses GPIO pin 2 & 3
 	transmit_line(&huart6_ptr,"UMSATS ROCKETRY FLIGHT COMPUTER");
 
+	MX_HAL_UART1_Init(&huart1_ptr,TELEMETRY_BAUD_RATE);
+
 	buzzerInit();
 	//buzz(500);
 
-	QueueHandle_t imuQueue_h = xQueueCreate(10,sizeof(imu_data_struct));
-	if(imuQueue_h == NULL){
-	  while(1);
-	}
-
-	QueueHandle_t bmpQueue_h = xQueueCreate(10,sizeof(bmp_data_struct));
-	if(bmpQueue_h == NULL){
+	//Both sensor tasks send to this queue, so the logger gets the readings in the order they were taken.
+	QueueHandle_t sensorQueue_h = xQueueCreateStatic(SENSOR_QUEUE_LENGTH,sizeof(sensorReading_t),sensorQueueStorage,&sensorQueueBuffer);
+	if(sensorQueue_h == NULL){
 	  while(1);
 	}
 
 	//For debugging in Atollic.
-	//  vQueueAddToRegistry(imuQueue_h,"imu");
-	//  vQueueAddToRegistry(bmpQueue_h,"bmp");
+	//  vQueueAddToRegistry(sensorQueue_h,"sensors");
 
 	flash.hspi = flash_spi;
 
@@ -94,11 +161,19 @@ int main(void)
 	  while(1);
 	}
 	transmit_line(&huart6_ptr,"Flash ID read successful\n");
+
+	//Until the scheduler starts the requests run straight away.
+	flash_service_init(&flash);
+
 	//Initialize and get the flight computer parameters.
 
-	flightCompConfig.values.flash = &flash;
+	//A checkpoint is only kept in flight. It says where the newest configuration record is, so the journal is not scanned.
+	uint8_t warm_restart = restart_load(&resumeCheckpoint) && IS_IN_FLIGHT(resumeCheckpoint.flags);
+
+	if(!warm_restart || read_config_at(&flightCompConfig,resumeCheckpoint.config_slot) != CONFIG_OK){
 
-	read_config(&flightCompConfig);
+		read_config(&flightCompConfig);
+	}
 
 	char lines[50];
 	sprintf(lines,"ID :%d \n",flightCompConfig.values.id);
@@ -108,11 +183,16 @@ int main(void)
 		transmit_line(&huart6_ptr,"No config found in flash, reseting to default.\n");
 		init_config(&flightCompConfig);
 		write_config(&flightCompConfig);
+		read_config(&flightCompConfig);
+		warm_restart = 0;
 	}
 
-	read_config(&flightCompConfig);
+	if(warm_restart){
 
-	if(IS_POST_MAIN(flightCompConfig.values.flags)){
+		flightCompConfig.values.state = resumeCheckpoint.state;
+		flightCompConfig.values.flags = resumeCheckpoint.flags;
+	}
+	else if(IS_POST_MAIN(flightCompConfig.values.flags)){
 
 		flightCompConfig.values.state = STATE_IN_FLIGHT_POST_MAIN;
 	}
@@ -125,32 +205,52 @@ int main(void)
 		flightCompConfig.values.state = STATE_IN_FLIGHT_PRE_APOGEE;
 	}
 
-	uint32_t end_Address = scan_flash(&flash);
+	//The checkpoint is at most CHECKPOINT_PERIOD old, so the end of the log is a page or two after its address.
+	uint32_t end_Address = flash_scan(warm_restart ? resumeCheckpoint.flash_address : FLASH_START_ADDRESS);
 	sprintf(lines,"end address :%ld \n",end_Address);
 	transmit_line(&huart6_ptr,lines);
 	flightCompConfig.values.end_data_address = end_Address;
 
+	//Programmed by the logging task once it runs.
+	summary_log_boot(flightCompConfig.values.state,warm_restart,end_Address);
+
+	if(event_journal_init() != EVENT_JOURNAL_OK){
+		transmit_line(&huart6_ptr,"Event journal not found.\n");
+	}
+
+	if(log_index_init() != LOG_INDEX_OK){
+		transmit_line(&huart6_ptr,"Log index not read.\n");
+	}
+
 	recovery_init();
 	transmit_line(&huart6_ptr,"Recovery GPIO pins setup.");
 
+	//The backup timers set the state when they fire.
+	backup_timer_init();
+
+	//Sample rates are taken from the configuration now. Changes made in xtract apply after a reset.
+	acquisition_init(&flightCompConfig);
 
 
-	logParams.flash_ptr = &flash;
-	logParams.IMU_data_queue = imuQueue_h;
-	logParams.PRES_data_queue= bmpQueue_h;
+
+	logParams.sensor_queue = sensorQueue_h;
 	logParams.uart = &huart6_ptr;
 	logParams.flightCompConfig = &flightCompConfig;
+	logParams.resume = warm_restart ? &resumeCheckpoint : NULL;
 
 	bmp388Params.huart = &huart6_ptr;
-	bmp388Params.bmp388_queue =bmpQueue_h;
+	bmp388Params.bmp388_queue =sensorQueue_h;
 	bmp388Params.flightCompConfig = &flightCompConfig;
 
 	imuTaskParams.huart = &huart6_ptr;
-	imuTaskParams.imu_queue = imuQueue_h;
+	imuTaskParams.imu_queue = sensorQueue_h;
 	imuTaskParams.flightCompConfig = &flightCompConfig;
 
+	//Any UART that is set up can be used, the telemetry budget follows its baud rate.
+	telemetryParams.huart = &huart1_ptr;
+	telemetryParams.flightCompConfig = &flightCompConfig;
+
 	//xtractParams xtractParameters;
-	xtractParameters.flash = &flash;
 	xtractParameters.huart = &huart6_ptr;
 	xtractParameters.flightCompConfig = &flightCompConfig;
 
@@ -158,11 +258,8 @@ int main(void)
 	tasks.bmpTask_h = NULL;
 	tasks.imuTask_h = NULL;
 	tasks.xtractTask_h = NULL;
-	tasks.timerTask_h = NULL;
 	xtractParameters.startupTaskHandle = NULL;
 
-	logParams.timerTask_h = &tasks.timerTask_h;
-	tasks.flash_ptr = &flash;
 	tasks.huart_ptr = &huart6_ptr;
 	tasks.flightCompConfig = &flightCompConfig;
 
@@ -183,8 +280,8 @@ int main(void)
 
 		int i;
 		for(i=0;i<20;i++){
-			buzz(500);
-			HAL_Delay(500);
+			buzz_tone(FREQ,500,500);
+			HAL_Delay(1000);
 			flightCompConfig.values.state = STATE_XTRACT;
 		}
 	}
@@ -198,70 +295,105 @@ int main(void)
 
 	/* Create the thread(s) */
 	/* definition and creation of defaultTask */
-	osThreadDef(defaultTask, StartDefaultTask, osPriorityNormal, 0, 128);
+	osThreadStaticDef(defaultTask, StartDefaultTask, osPriorityNormal, 0, DEFAULT_TASK_STACK_SIZE, defaultTaskStack, &defaultTaskBuffer);
 	defaultTaskHandle = osThreadCreate(osThread(defaultTask), NULL);
 
 
-	if(xTaskCreate(	vTask_timer, 	 /* Pointer to the function that implements the task */
-	      		  	"timer", /* Text name for the task. This is only to facilitate debugging */
-	      		  	 1000,		 /* Stack depth - small microcontrollers will use much less stack than this */
-	  				 NULL,	/* pointer to the huart object */
-	  				 1,			 /* This task will run at priorirt 2. */
-	  				 &tasks.timerTask_h		 /* This example does not use the task handle. */
-	        	  	  ) == -1){
-	  	  Error_Handler();
-	    }
-
-	if( xTaskCreate(	vTask_sensorAG, 	 /* Pointer to the function that implements the task */
+	tasks.imuTask_h = xTaskCreateStatic(	vTask_sensorAG, 	 /* Pointer to the function that implements the task */
 			"acc and gyro sensor", /* Text name for the task. This is only to facilitate debugging */
-			 1000,		 /* Stack depth - small microcontrollers will use much less stack than this */
+			 IMU_TASK_STACK_SIZE,		 /* Stack depth - small microcontrollers will use much less stack than this */
 			 (void*) &imuTaskParams,	/* pointer to the huart object */
 			 2,			 /* This task will run at priorirt 2. */
-			 &tasks.imuTask_h		 /* This example does not use the task handle. */
-			  ) !=1){
-
+			 imuTaskStack,
+			 &imuTaskBuffer
+			  );
+	if(tasks.imuTask_h == NULL){
 		Error_Handler();
 	}
 
 
-	if(xTaskCreate(	loggingTask, 	 /* Pointer to the function that implements the task */
+	tasks.loggingTask_h = xTaskCreateStatic(	loggingTask, 	 /* Pointer to the function that implements the task */
 			"Logging task", /* Text name for the task. This is only to facilitate debugging */
-			 10000,		 /* Stack depth - small microcontrollers will use much less stack than this */
+			 LOGGING_TASK_STACK_SIZE,		 /* Stack depth - small microcontrollers will use much less stack than this */
 			 (void*) &logParams,	/* pointer to the huart object */
 			 2,			 /* This task will run at priorirt 2. */
-			 &tasks.loggingTask_h	 /* This example does not use the task handle. */
-			  ) != 1){
+			 loggingTaskStack,
+			 &loggingTaskBuffer
+			  );
+	if(tasks.loggingTask_h == NULL){
 		Error_Handler();
 	}
-	if(xTaskCreate(	vTask_xtract, 	 /* Pointer to the function that implements the task */
+
+	tasks.xtractTask_h = xTaskCreateStatic(	vTask_xtract, 	 /* Pointer to the function that implements the task */
 		"xtract uart cli", /* Text name for the task. This is only to facilitate debugging */
-		 1000,		 /* Stack depth - small microcontrollers will use much less stack than this */
+		 XTRACT_TASK_STACK_SIZE,		 /* Stack depth - small microcontrollers will use much less stack than this */
 		 (void*) &xtractParameters,	/* pointer to the huart object */
 		 1,			 /* This task will run at priorirt 1. */
-		 &tasks.xtractTask_h		 /* This example does not use the task handle. */
-	  ) == -1){
+		 xtractTaskStack,
+		 &xtractTaskBuffer
+	  );
+	if(tasks.xtractTask_h == NULL){
 		Error_Handler();
 	}
 
 
 
-	if(xTaskCreate(	vTask_pressure_sensor_bmp3, 	 /* Pointer to the function that implements the task */
+	tasks.bmpTask_h = xTaskCreateStatic(	vTask_pressure_sensor_bmp3, 	 /* Pointer to the function that implements the task */
 		"bmp388 pressure sensor", /* Text name for the task. This is only to facilitate debugging */
-		 1000,		 /* Stack depth - small microcontrollers will use much less stack than this */
+		 BMP_TASK_STACK_SIZE,		 /* Stack depth - small microcontrollers will use much less stack than this */
 		 (void*) &bmp388Params,	/* function arguments */
 		 2,			 /* This task will run at priority 1. */
-		 &tasks.bmpTask_h		 /* This example does not use the task handle. */
-		  ) != 1){
+		 bmpTaskStack,
+		 &bmpTaskBuffer
+		  );
+	if(tasks.bmpTask_h == NULL){
 		Error_Handler();
 	}
 
-	if(xTaskCreate(	vTask_starter, 	 /* Pointer to the function that implements the task */
+	xtractParameters.startupTaskHandle = xTaskCreateStatic(	vTask_starter, 	 /* Pointer to the function that implements the task */
 		"starter task", /* Text name for the task. This is only to facilitate debugging */
-		 1000,		 /* Stack depth - small microcontrollers will use much less stack than this */
+		 STARTER_TASK_STACK_SIZE,		 /* Stack depth - small microcontrollers will use much less stack than this */
 		 (void*)&tasks,	/* function arguments */
 		 1,			 /* This task will run at priority 1. */
-		 &xtractParameters.startupTaskHandle		 /* This example does not use the task handle. */
-		  ) == -1){
+		 starterTaskStack,
+		 &starterTaskBuffer
+		  );
+	if(xtractParameters.startupTaskHandle == NULL){
+		Error_Handler();
+	}
+
+	if(xTaskCreateStatic(	vTask_flash_service, 	 /* Pointer to the function that implements the task */
+		"flash service", /* Text name for the task. This is only to facilitate debugging */
+		 FLASH_SERVICE_STACK_SIZE,		 /* Stack depth - small microcontrollers will use much less stack than this */
+		 NULL,	/* function arguments */
+		 FLASH_SERVICE_PRIORITY,			 /* This task will run at priority 3. */
+		 flashServiceTaskStack,
+		 &flashServiceTaskBuffer
+		  ) == NULL){
+		Error_Handler();
+	}
+
+	//Runs from the start so the startup is measured too.
+	if(xTaskCreateStatic(	vTask_monitor, 	 /* Pointer to the function that implements the task */
+		"task monitor", /* Text name for the task. This is only to facilitate debugging */
+		 TASK_MONITOR_STACK_SIZE,		 /* Stack depth - small microcontrollers will use much less stack than this */
+		 NULL,	/* function arguments */
+		 TASK_MONITOR_PRIORITY,			 /* This task will run at priority 3. */
+		 monitorTaskStack,
+		 &monitorTaskBuffer
+		  ) == NULL){
+		Error_Handler();
+	}
+
+	//Runs in every state, so the ground station sees the flight computer on the pad too.
+	if(xTaskCreateStatic(	vTask_telemetry, 	 /* Pointer to the function that implements the task */
+		"telemetry", /* Text name for the task. This is only to facilitate debugging */
+		 TELEMETRY_STACK_SIZE,		 /* Stack depth - small microcontrollers will use much less stack than this */
+		 (void*)&telemetryParams,	/* function arguments */
+		 TELEMETRY_PRIORITY,			 /* This task will run at priority 1. */
+		 telemetryTaskStack,
+		 &telemetryTaskBuffer
+		  ) == NULL){
 		Error_Handler();
 	}
 
@@ -270,7 +402,6 @@ int main(void)
 	vTaskSuspend(tasks.imuTask_h);
 	vTaskSuspend(tasks.bmpTask_h);
 	vTaskSuspend(tasks.loggingTask_h);
-	vTaskSuspend(tasks.timerTask_h);
 	/* Start scheduler -- comment to not use FreeRTOS */
 
 
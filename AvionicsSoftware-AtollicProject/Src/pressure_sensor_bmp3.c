@@ -11,6 +11,11 @@
 // History
 // 2019-04-06 Eric Kapilik
 // - Created.
+// 2026-10-19
+// - Added a profiling zone around the sensor read.
+// - The sensor, device and SPI handles are statically allocated.
+// - Read at bmp_rate from the acquisition schedule.
+// - Readings are stamped with the microsecond timer.
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -18,6 +23,9 @@
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 #include <pressure_sensor_bmp3.h>
 #include <stdlib.h>
+#include "profiler.h"
+#include "acquisition.h"
+#include "hrTimer.h"
 
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -27,6 +35,11 @@ static UART_HandleTypeDef* uart;
 static char buf[128];
 static bmp3_sensor* static_bmp3_sensor;
 
+//There is only one BMP388, so its handles are allocated here instead of with malloc.
+static bmp3_sensor bmp3_sensor_storage;
+static struct bmp3_dev bmp3_dev_storage;
+static SPI_HandleTypeDef bmp3_hspi_storage;
+
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 // ENUMS AND ENUM TYPEDEFS
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -66,12 +79,11 @@ int8_t init_bmp3_sensor(bmp3_sensor* bmp3_sensor_ptr){
 	SPI_HandleTypeDef* hspi_ptr;
 
 	 //Initialize SPI Handler
-	hspi_ptr = malloc(sizeof(SPI_HandleTypeDef));
-	while(!hspi_ptr){} //Could not malloc a hspi
+	hspi_ptr = &bmp3_hspi_storage;
 	spi2_init(hspi_ptr);
 
 	//Initialize BMP3 Handler
-	bmp3_ptr = malloc(sizeof(struct bmp3_dev));
+	bmp3_ptr = &bmp3_dev_storage;
 
 	/* Set bmp3_sensor_ptr members to newly initialized handlers */
 	bmp3_sensor_ptr->bmp_ptr = bmp3_ptr;
@@ -139,7 +151,7 @@ static uint8_t bmp3_config(uint8_t iir,uint8_t os_pres, uint8_t os_temp, uint8_t
 }
 void init_bmp(configData_t * configParams){
 
-	bmp3_sensor* bmp3_sensor_ptr = malloc(sizeof(bmp3_sensor));
+	bmp3_sensor* bmp3_sensor_ptr = &bmp3_sensor_storage;
 	int8_t rslt;
 	rslt = init_bmp3_sensor(bmp3_sensor_ptr);
 	if(rslt != 0){
@@ -170,12 +182,17 @@ void vTask_pressure_sensor_bmp3(void *pvParameters){
 	int8_t rslt;
 
 	/* Variable used to store the compensated data */
-	bmp_data_struct dataStruct;
+	sensorReading_t reading;
 
 	TickType_t prevTime;
+	TickType_t period = acquisition_period(ACQ_BMP)/1000;
+
+	if(period == 0){
+		period = 1;
+	}
 
 
-	bmp3_sensor* bmp3_sensor_ptr = malloc(sizeof(bmp3_sensor));
+	bmp3_sensor* bmp3_sensor_ptr = &bmp3_sensor_storage;
 
 	rslt = init_bmp3_sensor(bmp3_sensor_ptr);
 	bmp3_print_rslt("init_bmp3_sensor", rslt);
@@ -189,20 +206,28 @@ void vTask_pressure_sensor_bmp3(void *pvParameters){
 	prevTime =xTaskGetTickCount();
 	int i;
 	for(i=0;i<3;i++){
-		get_sensor_data(static_bmp3_sensor->bmp_ptr, &dataStruct.data);
-		vTaskDelayUntil(&prevTime,configParams->values.data_rate);
+		get_sensor_data(static_bmp3_sensor->bmp_ptr, &reading.bmp);
+		vTaskDelayUntil(&prevTime,period);
 	}
 
 	if(!IS_IN_FLIGHT(configParams->values.flags)){
-		get_sensor_data(static_bmp3_sensor->bmp_ptr, &dataStruct.data);
-		configParams->values.ref_pres = dataStruct.data.pressure/100;
+		get_sensor_data(static_bmp3_sensor->bmp_ptr, &reading.bmp);
+		configParams->values.ref_pres = reading.bmp.pressure/100;
 	}
+
+	acquisition_start(ACQ_BMP);
+
     while(1){
 
-    	get_sensor_data(static_bmp3_sensor->bmp_ptr, &dataStruct.data);
-    	dataStruct.time_ticks = xTaskGetTickCount();
+    	reading.sensors = acquisition_wait();
 
-    	xQueueSend(bmp_queue,&dataStruct,1);
+    	PROFILE_BEGIN(PROFILE_BMP_READ);
+    	reading.time_us = hr_timer_now();
+    	get_sensor_data(static_bmp3_sensor->bmp_ptr, &reading.bmp);
+    	PROFILE_END(PROFILE_BMP_READ);
+    	reading.time_ticks = xTaskGetTickCount();
+
+    	xQueueSend(bmp_queue,&reading,0);
 
     	//sprintf(buf, "Pressure: %ld [Pa] at time: %d", (uint32_t)dataStruct.data.pressure,dataStruct.time_ticks);
     	//sprintf(buf, "P %d",dataStruct.time_ticks);
@@ -210,8 +235,6 @@ void vTask_pressure_sensor_bmp3(void *pvParameters){
 
     	//sprintf(buf, "Temperature: %ld [0.01 C]", (int32_t)dataStruct.data.temperature);
     	//transmit_line(uart, buf);
-
-    	vTaskDelayUntil(&prevTime,configParams->values.data_rate);
     }
 }
 
@@ -0,0 +1,157 @@
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// UMSATS 2018-2020
+//
+// Repository:
+//  UMSATS/Avionics-2019
+//
+// File Description:
+//  Source file for the hot path profiler.
+//
+// History
+// 2026-10-19
+// - Created.
+// - Added the event journal zone.
+// - Added the summary log zone.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include "profiler.h"
+#include <string.h>
+
+#if PROFILING_ENABLED
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// CONSTANTS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+static profileStats_t zones[PROFILE_ZONE_COUNT];
+
+static const char * const zone_names[PROFILE_ZONE_COUNT] = {
+
+	"packet encode",
+	"altitude",
+	"program page",
+	"imu read",
+	"bmp read",
+	"flight state",
+	"event journal",
+	"summary log"
+};
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// FUNCTIONS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+static void set_uint32(uint8_t * dest,uint32_t value){
+
+	dest[0] = (value >> 24) & 0xFF;
+	dest[1] = (value >> 16) & 0xFF;
+	dest[2] = (value >> 8) & 0xFF;
+	dest[3] = value & 0xFF;
+}
+
+void profile_init(void){
+
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+	profile_reset();
+}
+
+void profile_record(profileZone_t zone,uint32_t cycles){
+
+	profileStats_t * stats;
+	int32_t bin;
+	uint32_t primask;
+
+	if(zone >= PROFILE_ZONE_COUNT){
+		return;
+	}
+
+	stats = &zones[zone];
+
+	//Highest set bit, so bin n holds 2^(n+SHIFT) to 2^(n+SHIFT+1) cycles.
+	bin = (cycles == 0) ? 0 : (31 - (int32_t)__CLZ(cycles)) - PROFILE_HIST_SHIFT;
+	if(bin < 0){
+		bin = 0;
+	}
+	else if(bin >= PROFILE_HIST_BINS){
+		bin = PROFILE_HIST_BINS - 1;
+	}
+
+	//Masking interrupts directly instead of a critical section, this is used before the scheduler starts.
+	primask = __get_PRIMASK();
+	__disable_irq();
+
+	if(stats->count == 0 || cycles < stats->min){
+		stats->min = cycles;
+	}
+	if(cycles > stats->max){
+		stats->max = cycles;
+	}
+	stats->count++;
+	stats->total += cycles;
+	stats->histogram[bin]++;
+
+	__set_PRIMASK(primask);
+}
+
+void profile_reset(void){
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	memset(zones,0,sizeof(zones));
+
+	__set_PRIMASK(primask);
+}
+
+void profile_get(profileZone_t zone,profileStats_t * stats){
+
+	uint32_t primask;
+
+	if(zone >= PROFILE_ZONE_COUNT){
+		memset(stats,0,sizeof(profileStats_t));
+		return;
+	}
+
+	primask = __get_PRIMASK();
+	__disable_irq();
+
+	*stats = zones[zone];
+
+	__set_PRIMASK(primask);
+}
+
+const char * profile_zone_name(profileZone_t zone){
+
+	if(zone >= PROFILE_ZONE_COUNT){
+		return "unknown";
+	}
+	return zone_names[zone];
+}
+
+uint8_t profile_log_payload(uint8_t * payload){
+
+	profileStats_t stats;
+	uint8_t i;
+
+	for(i=0;i<PROFILE_ZONE_COUNT;i++){
+
+		uint8_t * dest = &payload[i*PROFILE_RECORD_ZONE_SIZE];
+
+		profile_get(i,&stats);
+
+		dest[0] = i;
+		set_uint32(&dest[1],stats.count);
+		set_uint32(&dest[5],stats.min);
+		set_uint32(&dest[9],stats.max);
+		set_uint32(&dest[13],(stats.count == 0) ? 0 : (uint32_t)(stats.total/stats.count));
+	}
+
+	return PROFILE_RECORD_SIZE;
+}
+
+#endif // PROFILING_ENABLED
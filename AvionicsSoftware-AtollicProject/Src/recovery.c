@@ -10,6 +10,8 @@
 // History
 // 2019-05-29 by Joseph Howarth
 // - Created.
+// 2026-10-19
+// - The e-match pulse is timed by a one shot timer per channel instead of vTaskDelay(), and the results are queued as events.
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -17,11 +19,16 @@
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 #include "recovery.h"
 #include "hardwareDefs.h"
+#include "hrTimer.h"
 #include "stm32f4xx_hal.h"
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 // DEFINITIONS AND MACROS
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#define PYRO_CHANNELS		2
+
+//Fails to compile if the pulse does not fit in the 16 bit timers at 1 MHz.
+typedef char pulse_fits_in_timer[(EMATCH_ON_TIME_US > 0 && EMATCH_ON_TIME_US <= 0x10000) ? 1 : -1];
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 // ENUMS AND ENUM TYPEDEFS
@@ -30,11 +37,38 @@
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 // STRUCTS AND STRUCT TYPEDEFS
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
+typedef struct{
+
+	GPIO_TypeDef * activate_port;
+	uint16_t activate_pin;
+	GPIO_TypeDef * enable_port;
+	uint16_t enable_pin;
+	TIM_TypeDef * timer;
+
+}pyroChannel_t;
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 // TYPEDEFS
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// CONSTANTS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+//Indexed by recoverySelect_t.
+static const pyroChannel_t channels[PYRO_CHANNELS] = {
+
+	{RECOV_DROGUE_ACTIVATE_PORT,RECOV_DROGUE_ACTIVATE_PIN,RECOV_DROGUE_ENABLE_PORT,RECOV_DROGUE_ENABLE_PIN,TIM9},
+	{RECOV_MAIN_ACTIVATE_PORT,RECOV_MAIN_ACTIVATE_PIN,RECOV_MAIN_ENABLE_PORT,RECOV_MAIN_ENABLE_PIN,TIM11}
+};
+
+static volatile uint8_t firing[PYRO_CHANNELS];
+static volatile uint32_t pulse_start[PYRO_CHANNELS];		//hr_timer_now() when the pulse started.
+
+//Event queue, filled by pyro_irq() and emptied by pyro_get_event().
+static pyroEvent_t event_queue[PYRO_EVENT_QUEUE_LENGTH];
+static volatile uint8_t event_head;
+static volatile uint8_t event_tail;
+
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 // FUNCTION PROTOTYPES
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -77,7 +111,38 @@ void recovery_init(){
 	GPIO_InitStruct3.Mode= GPIO_MODE_INPUT;
 	HAL_GPIO_Init(RECOV_MAIN_CONTINUITY_PORT,&GPIO_InitStruct3);
 
+	//Setup the pulse timers, counting at 1 MHz and stopping by themselves after one update.
+	__HAL_RCC_TIM9_CLK_ENABLE();
+	__HAL_RCC_TIM11_CLK_ENABLE();
+
+	//The APB2 timers run at twice the bus clock when the bus is divided down.
+	uint32_t timer_clock = HAL_RCC_GetPCLK2Freq();
+	if((RCC->CFGR & RCC_CFGR_PPRE2) != RCC_HCLK_DIV1){
+		timer_clock *= 2;
+	}
+
+	uint8_t i;
+	for(i=0;i<PYRO_CHANNELS;i++){
+
+		TIM_TypeDef * timer = channels[i].timer;
+
+		timer->CR1 = TIM_CR1_URS | TIM_CR1_OPM;		//Only overflows set the update flag, not the UG bit.
+		timer->PSC = (timer_clock/1000000) - 1;
+		timer->ARR = EMATCH_ON_TIME_US - 1;
+		timer->EGR = TIM_EGR_UG;
+		timer->SR = 0;
+		timer->DIER = TIM_DIER_UIE;
+
+		firing[i] = 0;
+	}
+
+	event_head = 0;
+	event_tail = 0;
 
+	HAL_NVIC_SetPriority(TIM1_BRK_TIM9_IRQn,PYRO_IRQ_PRIORITY,0);
+	HAL_NVIC_EnableIRQ(TIM1_BRK_TIM9_IRQn);
+	HAL_NVIC_SetPriority(TIM1_TRG_COM_TIM11_IRQn,PYRO_IRQ_PRIORITY,0);
+	HAL_NVIC_EnableIRQ(TIM1_TRG_COM_TIM11_IRQn);
 }
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 
@@ -95,40 +160,100 @@ void enable_mosfet(recoverySelect_t recov_event){
 }
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 
-void activate_mosfet(recoverySelect_t recov_event){
+pyroStatus_t activate_mosfet(recoverySelect_t recov_event){
 
-	if(recov_event == MAIN){
+	if(recov_event >= PYRO_CHANNELS){
+		return PYRO_ERROR;
+	}
+
+	const pyroChannel_t * channel = &channels[recov_event];
+	uint32_t primask = __get_PRIMASK();
+
+	//Nothing may come between raising the pin and starting the timer, or the pulse would be longer.
+	__disable_irq();
+
+	if(firing[recov_event]){
 
-		//Write pin low in case there was a fault.
-		HAL_GPIO_WritePin(RECOV_MAIN_ACTIVATE_PORT,RECOV_MAIN_ACTIVATE_PIN,GPIO_PIN_RESET);
+		__set_PRIMASK(primask);
+		return PYRO_BUSY;
+	}
+
+	firing[recov_event] = 1;
+
+	//Active high.
+	HAL_GPIO_WritePin(channel->activate_port,channel->activate_pin,GPIO_PIN_SET);
+	channel->timer->CNT = 0;
+	channel->timer->CR1 |= TIM_CR1_CEN;
+	pulse_start[recov_event] = hr_timer_now();
 
-		//Active high.
-		HAL_GPIO_WritePin(RECOV_MAIN_ACTIVATE_PORT,RECOV_MAIN_ACTIVATE_PIN,GPIO_PIN_SET);
+	__set_PRIMASK(primask);
 
-		vTaskDelay(EMATCH_ON_TIME);
+	return PYRO_OK;
+}
+
+void pyro_irq(recoverySelect_t recov_event){
 
-		//De-activate.
-		HAL_GPIO_WritePin(RECOV_MAIN_ACTIVATE_PORT,RECOV_MAIN_ACTIVATE_PIN,GPIO_PIN_RESET);
+	const pyroChannel_t * channel = &channels[recov_event];
 
-		//Disable driver.
-		HAL_GPIO_WritePin(RECOV_MAIN_ENABLE_PORT,RECOV_MAIN_ENABLE_PIN,GPIO_PIN_SET);
+	if(!(channel->timer->SR & TIM_SR_UIF)){
+		return;
 	}
-	else if(recov_event == DROGUE){
+	channel->timer->SR = 0;
+
+	//De-activate, reading the overcurrent flag first while the current is still on.
+	overcurrentStatus_t over = check_overcurrent(recov_event);
+	HAL_GPIO_WritePin(channel->activate_port,channel->activate_pin,GPIO_PIN_RESET);
+	uint32_t end = hr_timer_now();
+
+	//Disable driver.
+	HAL_GPIO_WritePin(channel->enable_port,channel->enable_pin,GPIO_PIN_SET);
+
+	uint8_t next = (event_head + 1) % PYRO_EVENT_QUEUE_LENGTH;
+
+	if(next != event_tail){
+
+		pyroEvent_t * event = &event_queue[event_head];
 
-		//Write pin low in case there was a fault.
-		HAL_GPIO_WritePin(RECOV_DROGUE_ACTIVATE_PORT,RECOV_DROGUE_ACTIVATE_PIN,GPIO_PIN_RESET);
+		event->channel = recov_event;
+		event->continuity = check_continuity(recov_event);
+		event->overcurrent = over;
+		event->pulse_width = end - pulse_start[recov_event];
+		event->time = end;
 
-		//Active high.
-		HAL_GPIO_WritePin(RECOV_DROGUE_ACTIVATE_PORT,RECOV_DROGUE_ACTIVATE_PIN,GPIO_PIN_SET);
+		event_head = next;
+	}
 
-		vTaskDelay(pdMS_TO_TICKS(EMATCH_ON_TIME));
+	firing[recov_event] = 0;
+}
 
-		//De-activate.
-		HAL_GPIO_WritePin(RECOV_DROGUE_ACTIVATE_PORT,RECOV_DROGUE_ACTIVATE_PIN,GPIO_PIN_RESET);
+uint8_t pyro_get_event(pyroEvent_t * event){
 
-		//Disable driver.
-		HAL_GPIO_WritePin(RECOV_DROGUE_ENABLE_PORT,RECOV_DROGUE_ENABLE_PIN,GPIO_PIN_SET);
+	if(event_tail == event_head){
+		return 0;
 	}
+
+	*event = event_queue[event_tail];
+	event_tail = (event_tail + 1) % PYRO_EVENT_QUEUE_LENGTH;
+
+	return 1;
+}
+
+uint8_t pyro_busy(recoverySelect_t recov_event){
+
+	return firing[recov_event];
+}
+
+uint8_t pyro_log_payload(uint8_t * payload,const pyroEvent_t * event){
+
+	payload[0] = event->channel;
+	payload[1] = event->continuity;
+	payload[2] = event->overcurrent;
+	payload[3] = (event->pulse_width >> 24) & 0xFF;
+	payload[4] = (event->pulse_width >> 16) & 0xFF;
+	payload[5] = (event->pulse_width >> 8) & 0xFF;
+	payload[6] = event->pulse_width & 0xFF;
+
+	return PYRO_RECORD_SIZE;
 }
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,129 @@
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// UMSATS 2018-2020
+//
+// Repository:
+//  UMSATS/Avionics-2019
+//
+// File Description:
+//  Source file for warm restarts.
+//
+// History
+// 2026-10-19
+// - Created.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include "restart.h"
+#include "hrTimer.h"
+#include "stm32f4xx_hal.h"
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// DEFINITIONS AND MACROS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#define RESTART_COPIES		2
+
+//The 20 backup registers are one after another, BKP0R to BKP19R.
+#define BACKUP_REGISTER(n)	((&RTC->BKP0R)[n])
+
+//Fails to compile if both copies do not fit in the backup registers.
+typedef char copies_fit_in_backup_registers[(RESTART_COPIES*CHECKPOINT_WORDS <= 20) ? 1 : -1];
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// CONSTANTS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+static uint32_t boot_time;
+static uint32_t sequence;
+static uint8_t next_copy;
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// FUNCTIONS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+static void set_uint32(uint8_t * dest,uint32_t value){
+
+	dest[0] = (value >> 24) & 0xFF;
+	dest[1] = (value >> 16) & 0xFF;
+	dest[2] = (value >> 8) & 0xFF;
+	dest[3] = value & 0xFF;
+}
+
+void restart_init(void){
+
+	hr_timer_init();
+	boot_time = hr_timer_now();
+
+	__HAL_RCC_PWR_CLK_ENABLE();
+	HAL_PWR_EnableBkUpAccess();
+}
+
+uint8_t restart_load(checkpoint_t * checkpoint){
+
+	uint32_t words[CHECKPOINT_WORDS];
+	checkpoint_t copy;
+	uint8_t found = 0;
+	uint8_t c;
+	uint8_t i;
+
+	for(c=0;c<RESTART_COPIES;c++){
+
+		for(i=0;i<CHECKPOINT_WORDS;i++){
+			words[i] = BACKUP_REGISTER(c*CHECKPOINT_WORDS + i);
+		}
+
+		if(checkpoint_unpack(words,&copy) && (!found || copy.sequence > checkpoint->sequence)){
+
+			*checkpoint = copy;
+			next_copy = (c + 1) % RESTART_COPIES;
+			found = 1;
+		}
+	}
+
+	if(found){
+		sequence = checkpoint->sequence;
+	}
+
+	return found;
+}
+
+void restart_save(checkpoint_t * checkpoint){
+
+	uint32_t words[CHECKPOINT_WORDS];
+	uint8_t i;
+
+	checkpoint->sequence = ++sequence;
+	checkpoint_pack(checkpoint,words);
+
+	for(i=0;i<CHECKPOINT_WORDS;i++){
+		BACKUP_REGISTER(next_copy*CHECKPOINT_WORDS + i) = words[i];
+	}
+
+	next_copy = (next_copy + 1) % RESTART_COPIES;
+}
+
+void restart_clear(void){
+
+	uint8_t i;
+
+	for(i=0;i<RESTART_COPIES*CHECKPOINT_WORDS;i++){
+		BACKUP_REGISTER(i) = 0;
+	}
+
+	sequence = 0;
+	next_copy = 0;
+}
+
+uint32_t restart_boot_time(void){
+
+	return hr_timer_now() - boot_time;
+}
+
+uint8_t restart_log_payload(uint8_t * payload,uint32_t recovery_time,const checkpoint_t * checkpoint){
+
+	set_uint32(&payload[0],recovery_time);
+	set_uint32(&payload[4],checkpoint->flight_time);
+	payload[8] = checkpoint->state;
+
+	return RESTART_RECORD_SIZE;
+}
@@ -13,12 +13,19 @@
 // History
 // 2019-03-29 by Benjamin Zacharias
 // - Created.
+// 2026-10-19
+// - Added a profiling zone around the SPI reads.
+// - The accelerometer and gyroscope are read at their own rates from the acquisition schedule.
+// - Readings are stamped with the microsecond timer.
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 // INCLUDES
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 #include "sensorAG.h"
+#include "profiler.h"
+#include "acquisition.h"
+#include "hrTimer.h"
 
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -85,9 +92,7 @@ void vTask_sensorAG(void *param){
 	configData_t * configParams = params->flightCompConfig;
 
 
-	TickType_t prevTime;
-
-	imu_data_struct dataStruct;
+	sensorReading_t reading;
 
 	//initialize the SPI
 	spi3_init(&hspi); //use the already made SPI interface
@@ -132,22 +137,30 @@ void vTask_sensorAG(void *param){
 	//main loop: continuously read sensor data
 	//vTaskDelay(pdMS_TO_TICKS(100));//Wait so to make sure the other tasks have started.
 
-	prevTime=xTaskGetTickCount();
+	acquisition_start(ACQ_ACC | ACQ_GYRO);
 
 	while(1){
 
-		rslt = bmi08a_get_data(&dataStruct.data_acc, &bmi088dev);
-		rslt = bmi08g_get_data(&dataStruct.data_gyro, &bmi088dev);
-		dataStruct.time_ticks = xTaskGetTickCount();
+		//Only the sensors that are due are read. Both are read back to back when they are due together.
+		reading.sensors = acquisition_wait();
+
+		PROFILE_BEGIN(PROFILE_IMU_READ);
+		reading.time_us = hr_timer_now();
+		if(reading.sensors & ACQ_ACC){
+			rslt = bmi08a_get_data(&reading.acc, &bmi088dev);
+		}
+		if(reading.sensors & ACQ_GYRO){
+			rslt = bmi08g_get_data(&reading.gyro, &bmi088dev);
+		}
+		PROFILE_END(PROFILE_IMU_READ);
+		reading.time_ticks = xTaskGetTickCount();
 
-		xQueueSend(queue,&dataStruct,1);
+		xQueueSend(queue,&reading,0);
 
 		//char data_str[100];
 		//sprintf(data_str,"x: %d y: %d z: %d  | Rx: %d Ry: %d Rz: %d, at time %lu",dataStruct.data_acc.x,dataStruct.data_acc.y,dataStruct.data_acc.z,dataStruct.data_gyro.x,dataStruct.data_gyro.y,dataStruct.data_gyro.z,dataStruct.time_ticks);
 		//sprintf(data_str,"i %d",dataStruct.time_ticks);
 		//transmit_line(uart_ptr,data_str);
-
-		vTaskDelayUntil(&prevTime,configParams->values.data_rate);
 	}
 }
 
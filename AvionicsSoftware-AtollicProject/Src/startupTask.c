@@ -10,12 +10,20 @@
 // History
 // 2019-04-19 by Joseph Howarth
 // - Created.
+// 2026-10-19
+// - The flash is checked and erased through the flash service.
+// - The log index is erased with the data.
+// - Only the sectors the flash service map has as used are erased.
+// - The summary log in the internal flash is erased with the data.
+// - Stops and reports a failed erase instead of committing the map.
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 // INCLUDES
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 #include "startupTask.h"
+#include "logIndex.h"
+#include "summaryLog.h"
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 // DEFINITIONS AND MACROS
@@ -40,8 +48,8 @@
 // Description:
 //  This task will check if the memory is empty and erase it if it is not.
 //
-//	Right now the function assumes that if the first page of memory is empty,
-//	then the whole memory is empty.
+//	Only the sectors that the used sector map of the flash service has as used are erased, including the log index.
+//	The map is saved afterwards. The summary log is erased too, unless it is blank.
 //
 // Returns:
 //
@@ -57,26 +65,14 @@ static void eraseFlash(startParams * params){
 
 	  FlashStatus_t stat;
 
-	  FlashStruct_t * flash = params->flash_ptr;
 	  UART_HandleTypeDef * huart = params->huart_ptr;
-	  configData_t * config = params->flightCompConfig;
 
 	  uint8_t dataRX[256];
 	  transmit_line(huart,"Checking flash memory...");
-	 // Read the first page of memory. If its empty, assume the whole memory is empty.
-	  stat = read_page(flash,config->values.start_data_address,dataRX,256);
-
-	  uint16_t good= 0xFFFF;
 
 	  int i;
-	  for(i=0;i<256;i++){
-
-		  if(dataRX[i] != 0xFF){
-			  good --;
-		  }
-	  }
 
-	  if(good == 0xFFFF){
+	  if(flash_map_count() == 0){
 		  		  transmit_line(huart,"flash empty.");
 		  		  HAL_GPIO_WritePin(USR_LED_PORT,USR_LED_PIN,GPIO_PIN_RESET);
 
@@ -84,50 +80,62 @@ static void eraseFlash(startParams * params){
 
 
 		  transmit_line(huart,"flash not empty.");
-		  //Erase the whole flash. This could take up to 2 minutes.
-	  	  //stat = erase_device(flash);
+		  //Erase the used sectors. Up to 2 minutes if they all are.
 		  uint32_t address = FLASH_START_ADDRESS;
+		  stat = FLASH_OK;
 
-		  while(address < config->values.end_data_address){
+		  while(address <= FLASH_END_ADDRESS && stat == FLASH_OK){
+
+			  //Waits for the erase to finish.
+			  if(flash_map_used(address)){
+				  stat = flash_erase(FLASH_CLASS_ERASE,address,NULL);
+			  }
 
 			  if(address>FLASH_PARAM_END_ADDRESS){
-			  stat = erase_sector(flash,address);
-			  address += FLASH_SECTOR_SIZE;
+				  address += FLASH_SECTOR_SIZE;
 			  }
 			  else{
-				  stat = erase_param_sector(flash,address);
 				  address += FLASH_PARAM_SECTOR_SIZE;
 			  }
-			  //Wait for erase to finish
-			  while(IS_DEVICE_BUSY(stat)){
+		  }
 
-				  stat = get_status_reg(flash);
+		  if(stat != FLASH_OK){
 
-				  vTaskDelay(pdMS_TO_TICKS(1));
-			  }
+			  //The map is not committed, so the sectors not erased still count as used.
+			  transmit_line(huart,"Flash erase failed.");
+		  }
+		  else{
 
+			  flash_map_commit();
 
-		  }
+			  //The spare pages of the log index were erased with the rest.
+			  log_index_init();
 
-		  read_page(flash,FLASH_START_ADDRESS,dataRX,256);
-		  uint16_t empty = 0xFFFF;
+			  flash_read(FLASH_CLASS_READ,FLASH_START_ADDRESS,dataRX,256);
+			  uint16_t empty = 0xFFFF;
 
-		  for(i=0;i<256;i++){
+			  for(i=0;i<256;i++){
 
-			  if(dataRX[i] != 0xFF){
-				 empty --;
+				  if(dataRX[i] != 0xFF){
+					 empty --;
+				  }
 			  }
-		  }
 
-		  if(empty == 0xFFFF){
+			  if(empty == 0xFFFF){
 
-			  transmit_line(huart,"Flash Erased Success!");
-			  HAL_GPIO_WritePin(USR_LED_PORT,USR_LED_PIN,GPIO_PIN_SET);
-			  HAL_Delay(1000);
-			  HAL_GPIO_WritePin(USR_LED_PORT,USR_LED_PIN,GPIO_PIN_RESET);
+				  transmit_line(huart,"Flash Erased Success!");
+				  HAL_GPIO_WritePin(USR_LED_PORT,USR_LED_PIN,GPIO_PIN_SET);
+				  HAL_Delay(1000);
+				  HAL_GPIO_WritePin(USR_LED_PORT,USR_LED_PIN,GPIO_PIN_RESET);
+			  }
 		  }
 
 	  }
+
+	  //Stalls the CPU for about a second, still on the ground. The boot record is still queued and is written after.
+	  if(summary_log_erase() != SUMMARY_LOG_OK){
+		  transmit_line(huart,"Summary log not erased.");
+	  }
 }
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -139,7 +147,6 @@ void vTask_starter(void * pvParams){
 	  TaskHandle_t bmpTask_h = sp->bmpTask_h;
 	  TaskHandle_t imuTask_h = sp->imuTask_h;
 	  TaskHandle_t xtractTask_h = sp->xtractTask_h;
-	  FlashStruct_t * flash = sp->flash_ptr;
 	  UART_HandleTypeDef * huart = sp->huart_ptr;
 	  configData_t * config = sp->flightCompConfig;
 
@@ -10,6 +10,8 @@
 // History
 // 2019-02-13 Eric Kapilik
 // - Created.
+// 2026-10-19
+// - Added MX_HAL_UART1_Init() for the radio.
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -130,6 +132,43 @@ void MX_HAL_UART6_Init(UART_HandleTypeDef* uart){
 	   }
 }
 
+void MX_HAL_UART1_Init(UART_HandleTypeDef* uart, uint32_t baud_rate){
+	__HAL_RCC_USART1_CLK_ENABLE();
+	GPIO_InitTypeDef GPIO_InitStruct;
+
+	__HAL_RCC_GPIOA_CLK_ENABLE();
+	__HAL_RCC_GPIOB_CLK_ENABLE();
+	/* Setup UART1 TX Pin */
+	  GPIO_InitStruct.Pin = RADIO_UART_TX_PIN;
+	  GPIO_InitStruct.Mode = GPIO_MODE_AF_PP;
+	  GPIO_InitStruct.Pull = GPIO_NOPULL;
+	  GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
+	  GPIO_InitStruct.Alternate = GPIO_AF7_USART1;
+	  HAL_GPIO_Init(RADIO_UART_TX_PORT, &GPIO_InitStruct);
+
+	   /* Setup UART1 RX Pin */
+	   GPIO_InitStruct.Pin = RADIO_UART_RX_PIN;
+	   GPIO_InitStruct.Mode = GPIO_MODE_AF_PP;
+	   GPIO_InitStruct.Pull = GPIO_PULLUP;		//The modem may be unplugged.
+	   GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
+	   GPIO_InitStruct.Alternate = GPIO_AF7_USART1;
+	   HAL_GPIO_Init(RADIO_UART_RX_PORT, &GPIO_InitStruct);
+
+	   /* Create UART struct */
+	   uart->Instance = USART1;
+	   uart->Init.BaudRate = baud_rate;
+	   uart->Init.WordLength = UART_WORDLENGTH_8B;
+	   uart->Init.StopBits = UART_STOPBITS_1;
+	   uart->Init.Parity = UART_PARITY_NONE;
+	   uart->Init.Mode = UART_MODE_TX_RX;
+	   uart->Init.HwFlowCtl = UART_HWCONTROL_NONE;
+	   uart->Init.OverSampling = UART_OVERSAMPLING_16;
+	   if (HAL_UART_Init(uart) != HAL_OK)
+	   {
+	 	  Error_Handler_UART();
+	   }
+}
+
 void transmit(UART_HandleTypeDef* uart, char* message){
 	int i;
 
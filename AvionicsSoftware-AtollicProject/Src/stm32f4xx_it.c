@@ -40,6 +40,12 @@
 #include "stm32f4xx_hal.h"
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "buzzer.h"
+#include "flash.h"
+#include "recovery.h"
+#include "timerWheel.h"
+#include "telemetry.h"
+#include "liveStream.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -191,5 +197,77 @@ void TIM1_UP_TIM10_IRQHandler(void)
 
 /* USER CODE BEGIN 1 */
 
+/**
+  * @brief This function handles TIM2 global interrupt, used to play the buzzer tones.
+  */
+void TIM2_IRQHandler(void)
+{
+  buzzer_irq();
+}
+
+/**
+  * @brief This function handles TIM9 global interrupt, used to time the drogue e-match pulse.
+  */
+void TIM1_BRK_TIM9_IRQHandler(void)
+{
+  pyro_irq(DROGUE);
+}
+
+/**
+  * @brief This function handles TIM11 global interrupt, used to time the main e-match pulse.
+  */
+void TIM1_TRG_COM_TIM11_IRQHandler(void)
+{
+  pyro_irq(MAIN);
+}
+
+/**
+  * @brief This function handles TIM5 global interrupt, used by the timer wheel.
+  */
+void TIM5_IRQHandler(void)
+{
+  timer_wheel_irq();
+}
+
+/**
+  * @brief This function handles DMA2 stream0 global interrupt, used to receive from the flash.
+  */
+void DMA2_Stream0_IRQHandler(void)
+{
+  flash_dma_rx_irq();
+}
+
+/**
+  * @brief This function handles DMA2 stream3 global interrupt, used to transmit to the flash.
+  */
+void DMA2_Stream3_IRQHandler(void)
+{
+  flash_dma_tx_irq();
+}
+
+/**
+  * @brief This function handles USART1 global interrupt, used to send the telemetry frames.
+  */
+void USART1_IRQHandler(void)
+{
+  telemetry_irq();
+}
+
+/**
+  * @brief This function handles DMA2 stream6 global interrupt, used to send the live sensor stream.
+  */
+void DMA2_Stream6_IRQHandler(void)
+{
+  live_stream_dma_irq();
+}
+
+/**
+  * @brief This function handles USART6 global interrupt, used to send the live sensor stream.
+  */
+void USART6_IRQHandler(void)
+{
+  live_stream_uart_irq();
+}
+
 /* USER CODE END 1 */
 /************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
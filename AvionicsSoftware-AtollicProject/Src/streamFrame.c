@@ -0,0 +1,344 @@
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// UMSATS 2018-2020
+//
+// Repository:
+//  UMSATS/Avionics-2019
+//
+// File Description:
+//  Source file for the live sensor stream records.
+//
+// History
+// 2026-10-19
+// - Created.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include "streamFrame.h"
+#include "crc.h"
+#include <string.h>
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// FUNCTIONS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+uint16_t cobs_encode(const uint8_t * src,uint16_t length,uint8_t * dest){
+
+	uint16_t code_pos = 0;		//Where the code byte of this block goes.
+	uint16_t out = 1;
+	uint8_t code = 1;
+	uint16_t i;
+
+	for(i=0;i<length;i++){
+
+		if(src[i] == 0){
+
+			dest[code_pos] = code;
+			code_pos = out++;
+			code = 1;
+		}
+		else{
+
+			dest[out++] = src[i];
+			code++;
+
+			//A full block of 254 bytes has no 0x00 after it.
+			if(code == 0xFF){
+				dest[code_pos] = code;
+				code_pos = out++;
+				code = 1;
+			}
+		}
+	}
+
+	dest[code_pos] = code;
+	return out;
+}
+
+uint16_t cobs_decode(const uint8_t * src,uint16_t length,uint8_t * dest){
+
+	uint16_t in = 0;
+	uint16_t out = 0;
+
+	while(in < length){
+
+		uint8_t code = src[in++];
+		uint8_t i;
+
+		if(code == 0 || in + code - 1 > length){
+			return 0;
+		}
+
+		for(i=1;i<code;i++){
+			if(src[in] == 0){
+				return 0;
+			}
+			dest[out++] = src[in++];
+		}
+
+		//Every block but a full one and the last ends with a 0x00.
+		if(code != 0xFF && in < length){
+			dest[out++] = 0;
+		}
+	}
+
+	return out;
+}
+
+static uint8_t put_value(uint8_t * dest,uint32_t value,uint8_t width){
+
+	uint8_t i;
+
+	for(i=0;i<width;i++){
+		dest[i] = (value >> (8*(width-1-i))) & 0xFF;
+	}
+	return width;
+}
+
+static uint32_t get_value(const uint8_t * src,uint8_t width){
+
+	uint32_t value = 0;
+	uint8_t i;
+
+	for(i=0;i<width;i++){
+		value = (value << 8) | src[i];
+	}
+	return value;
+}
+
+//Lays out the record with its CRC, and returns the length.
+static uint8_t encode_record(const streamRecord_t * record,uint8_t * dest){
+
+	uint8_t length = 0;
+	uint16_t crc;
+	uint8_t i;
+
+	dest[length++] = record->kind;
+	length += put_value(&dest[length],record->sequence,2);
+	length += put_value(&dest[length],record->time_us,4);
+
+	if(record->kind == STREAM_KIND_STATS){
+
+		length += put_value(&dest[length],record->queued,4);
+		length += put_value(&dest[length],record->dropped,4);
+	}
+	else{
+
+		dest[length++] = record->contents;
+
+		if(record->contents & STREAM_HAS_ACC){
+			for(i=0;i<3;i++){
+				length += put_value(&dest[length],(uint16_t)record->acc[i],2);
+			}
+		}
+		if(record->contents & STREAM_HAS_GYRO){
+			for(i=0;i<3;i++){
+				length += put_value(&dest[length],(uint16_t)record->gyro[i],2);
+			}
+		}
+		if(record->contents & STREAM_HAS_PRES){
+			length += put_value(&dest[length],record->pressure,4);
+			length += put_value(&dest[length],(uint32_t)record->temperature,4);
+		}
+		if(record->contents & STREAM_HAS_EVENTS){
+			dest[length++] = record->events;
+		}
+	}
+
+	crc = crc16(dest,length);
+	length += put_value(&dest[length],crc,2);
+
+	return length;
+}
+
+//Reads a record with its CRC checked. Returns 0 if the CRC or the length is wrong.
+static uint8_t decode_record(const uint8_t * src,uint16_t length,streamRecord_t * record){
+
+	uint16_t pos = STREAM_HEADER_SIZE;
+	uint16_t expected;
+	uint8_t i;
+
+	if(length < STREAM_HEADER_SIZE+1+STREAM_CRC_SIZE || length > STREAM_MAX_RECORD){
+		return 0;
+	}
+	if(crc16(src,length-STREAM_CRC_SIZE) != get_value(&src[length-STREAM_CRC_SIZE],2)){
+		return 0;
+	}
+
+	record->kind = src[0];
+	record->sequence = get_value(&src[1],2);
+	record->time_us = get_value(&src[3],4);
+
+	if(record->kind == STREAM_KIND_STATS){
+
+		if(length != STREAM_HEADER_SIZE+8+STREAM_CRC_SIZE){
+			return 0;
+		}
+		record->queued = get_value(&src[pos],4);
+		record->dropped = get_value(&src[pos+4],4);
+		return 1;
+	}
+
+	if(record->kind != STREAM_KIND_READING){
+		return 0;
+	}
+
+	record->contents = src[pos++];
+	expected = STREAM_HEADER_SIZE + 1 + STREAM_CRC_SIZE;
+	expected += (record->contents & STREAM_HAS_ACC) ? 6 : 0;
+	expected += (record->contents & STREAM_HAS_GYRO) ? 6 : 0;
+	expected += (record->contents & STREAM_HAS_PRES) ? 8 : 0;
+	expected += (record->contents & STREAM_HAS_EVENTS) ? 1 : 0;
+	if(length != expected){
+		return 0;
+	}
+
+	if(record->contents & STREAM_HAS_ACC){
+		for(i=0;i<3;i++){
+			record->acc[i] = (int16_t)get_value(&src[pos],2);
+			pos += 2;
+		}
+	}
+	if(record->contents & STREAM_HAS_GYRO){
+		for(i=0;i<3;i++){
+			record->gyro[i] = (int16_t)get_value(&src[pos],2);
+			pos += 2;
+		}
+	}
+	if(record->contents & STREAM_HAS_PRES){
+		record->pressure = get_value(&src[pos],4);
+		record->temperature = (int32_t)get_value(&src[pos+4],4);
+		pos += 8;
+	}
+	record->events = (record->contents & STREAM_HAS_EVENTS) ? src[pos] : 0;
+
+	return 1;
+}
+
+uint8_t stream_frame_build(const streamRecord_t * record,uint8_t * frame){
+
+	uint8_t raw[STREAM_MAX_RECORD];
+	uint8_t length = encode_record(record,raw);
+
+	length = cobs_encode(raw,length,frame);
+	frame[length++] = STREAM_DELIMITER;
+
+	return length;
+}
+
+void stream_queue_init(streamQueue_t * queue){
+
+	memset(queue,0,sizeof(streamQueue_t));
+
+	queue->buffer[0] = STREAM_DELIMITER;
+	queue->head = 1;
+}
+
+uint8_t stream_queue_put(streamQueue_t * queue,streamRecord_t * record){
+
+	uint8_t frame[STREAM_MAX_FRAME];
+	uint16_t used = (queue->head + STREAM_QUEUE_SIZE - queue->tail) % STREAM_QUEUE_SIZE;
+	uint16_t head = queue->head;
+	uint16_t space = STREAM_QUEUE_SIZE;
+	uint8_t length;
+	uint8_t i;
+
+	record->sequence = queue->sequence++;
+	if(record->kind == STREAM_KIND_STATS){
+		record->queued = queue->queued;
+		record->dropped = queue->dropped;
+	}
+	else{
+		//Readings leave room for a stats record, so the counts get through however full the queue is.
+		space -= STREAM_MAX_FRAME;
+	}
+
+	length = stream_frame_build(record,frame);
+
+	//One byte is always left empty, so a full queue is not mistaken for an empty one.
+	if(used + length >= space){
+		queue->dropped++;
+		return 0;
+	}
+
+	for(i=0;i<length;i++){
+		queue->buffer[head] = frame[i];
+		head = (head + 1) % STREAM_QUEUE_SIZE;
+	}
+	queue->head = head;
+	queue->queued++;
+	queue->bytes += length;
+
+	return 1;
+}
+
+uint16_t stream_queue_chunk(const streamQueue_t * queue,const uint8_t ** data){
+
+	uint16_t head = queue->head;
+	uint16_t tail = queue->tail;
+
+	*data = (const uint8_t *)&queue->buffer[tail];
+	return (head >= tail) ? head - tail : STREAM_QUEUE_SIZE - tail;
+}
+
+void stream_queue_release(streamQueue_t * queue,uint16_t length){
+
+	queue->tail = (queue->tail + length) % STREAM_QUEUE_SIZE;
+}
+
+void stream_decoder_init(streamDecoder_t * dec){
+
+	memset(dec,0,sizeof(streamDecoder_t));
+}
+
+uint8_t stream_decode(streamDecoder_t * dec,uint8_t byte){
+
+	uint8_t raw[STREAM_MAX_FRAME];
+	uint16_t length;
+	streamRecord_t record;
+
+	if(byte != STREAM_DELIMITER){
+
+		if(!dec->synced){
+			dec->skipped++;
+		}
+		else if(dec->length < sizeof(dec->buffer)){
+			dec->buffer[dec->length++] = byte;
+		}
+		else{
+			dec->overflow = 1;
+		}
+		return 0;
+	}
+
+	if(!dec->synced){
+		dec->synced = 1;
+		return 0;
+	}
+
+	//Two delimiters in a row, from the start of the stream or a damaged byte.
+	if(dec->length == 0 && !dec->overflow){
+		return 0;
+	}
+
+	length = dec->overflow ? 0 : cobs_decode(dec->buffer,dec->length,raw);
+	dec->length = 0;
+	dec->overflow = 0;
+
+	if(length == 0 || !decode_record(raw,length,&record)){
+		dec->bad++;
+		return 0;
+	}
+
+	if(dec->started && record.sequence != (uint16_t)(dec->sequence+1)){
+		dec->lost += (uint16_t)(record.sequence - dec->sequence - 1);
+	}
+
+	dec->started = 1;
+	dec->sequence = record.sequence;
+	dec->record = record;
+	dec->records++;
+
+	return 1;
+}
@@ -0,0 +1,358 @@
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// UMSATS 2018-2020
+//
+// Repository:
+//  UMSATS/Avionics-2019
+//
+// File Description:
+//  Source file for the summary log in the STM32's own flash.
+//
+//  Record layout, big endian:
+//   0  kind (1 byte)
+//   1  state (1 byte)
+//   2  time in ms since boot (4 bytes)
+//   6  body (8 bytes)
+//      boot:   reset flags (1), warm restart (1), 0 (2), log address (4)
+//      state:  altitude, float bits (4), filtered altitude, float bits (4)
+//      event:  events (1), 0 (3), log address (4)
+//      health: flash errors (2), accelerometer readings (2), BMP388 readings (2), remapped pages (1), dropped records (1)
+//   14 CRC-16 of the bytes before it (2 bytes)
+//
+// History
+// 2026-10-19
+// - Created.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include "summaryLog.h"
+#include "crc.h"
+#include "stm32f4xx_hal.h"
+#include <string.h>
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// DEFINITIONS AND MACROS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#define SUMMARY_LOG_SECTOR			FLASH_SECTOR_7
+#define SUMMARY_CRC_OFFSET			(SUMMARY_RECORD_SIZE-2)
+#define SUMMARY_WORDS				(SUMMARY_RECORD_SIZE/4)
+#define SUMMARY_BATCH_WORDS			2			//One double word.
+
+#define RECORD_ADDRESS(n)			(SUMMARY_LOG_ADDRESS+((uint32_t)(n)*SUMMARY_RECORD_SIZE))
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// CONSTANTS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+static uint8_t queue[SUMMARY_QUEUE_RECORDS][SUMMARY_RECORD_SIZE];
+static uint8_t queue_head;
+static uint8_t queue_tail;
+static uint8_t queue_count;
+
+static uint16_t next_record;		//Record being programmed, or the next one if none is.
+static uint8_t next_word;			//Word of that record to program next.
+static uint8_t dropped;
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// FUNCTIONS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+static void set_uint16(uint8_t * dest,uint16_t value){
+
+	dest[0] = (value >> 8) & 0xFF;
+	dest[1] = value & 0xFF;
+}
+
+static void set_uint32(uint8_t * dest,uint32_t value){
+
+	dest[0] = (value >> 24) & 0xFF;
+	dest[1] = (value >> 16) & 0xFF;
+	dest[2] = (value >> 8) & 0xFF;
+	dest[3] = value & 0xFF;
+}
+
+static uint16_t get_uint16(const uint8_t * src){
+
+	return ((uint16_t)src[0] << 8) | src[1];
+}
+
+static uint32_t get_uint32(const uint8_t * src){
+
+	return ((uint32_t)src[0] << 24) | ((uint32_t)src[1] << 16) | ((uint32_t)src[2] << 8) | src[3];
+}
+
+static void encode(uint8_t * data,const summaryRecord_t * record){
+
+	uint32_t bits;
+
+	memset(data,0,SUMMARY_RECORD_SIZE);
+	data[0] = record->kind;
+	data[1] = record->state;
+	set_uint32(&data[2],record->time_ms);
+
+	switch(record->kind){
+
+		case SUMMARY_KIND_BOOT:
+			data[6] = record->reset_flags;
+			data[7] = record->warm;
+			set_uint32(&data[10],record->log_address);
+			break;
+
+		case SUMMARY_KIND_STATE:
+			memcpy(&bits,&record->altitude,4);
+			set_uint32(&data[6],bits);
+			memcpy(&bits,&record->alt_filtered,4);
+			set_uint32(&data[10],bits);
+			break;
+
+		case SUMMARY_KIND_EVENT:
+			data[6] = record->events;
+			set_uint32(&data[10],record->log_address);
+			break;
+
+		case SUMMARY_KIND_HEALTH:
+			set_uint16(&data[6],record->flash_errors);
+			set_uint16(&data[8],record->acc_readings);
+			set_uint16(&data[10],record->bmp_readings);
+			data[12] = record->remapped;
+			data[13] = record->dropped;
+			break;
+	}
+
+	set_uint16(&data[SUMMARY_CRC_OFFSET],crc16(data,SUMMARY_CRC_OFFSET));
+}
+
+//Returns 1 if the data holds a good record.
+static uint8_t decode(const uint8_t * data,summaryRecord_t * record){
+
+	uint32_t bits;
+
+	if(crc16(data,SUMMARY_CRC_OFFSET) != get_uint16(&data[SUMMARY_CRC_OFFSET])){
+		return 0;
+	}
+
+	memset(record,0,sizeof(summaryRecord_t));
+	record->kind = data[0];
+	record->state = data[1];
+	record->time_ms = get_uint32(&data[2]);
+
+	switch(record->kind){
+
+		case SUMMARY_KIND_BOOT:
+			record->reset_flags = data[6];
+			record->warm = data[7];
+			record->log_address = get_uint32(&data[10]);
+			break;
+
+		case SUMMARY_KIND_STATE:
+			bits = get_uint32(&data[6]);
+			memcpy(&record->altitude,&bits,4);
+			bits = get_uint32(&data[10]);
+			memcpy(&record->alt_filtered,&bits,4);
+			break;
+
+		case SUMMARY_KIND_EVENT:
+			record->events = data[6];
+			record->log_address = get_uint32(&data[10]);
+			break;
+
+		case SUMMARY_KIND_HEALTH:
+			record->flash_errors = get_uint16(&data[6]);
+			record->acc_readings = get_uint16(&data[8]);
+			record->bmp_readings = get_uint16(&data[10]);
+			record->remapped = data[12];
+			record->dropped = data[13];
+			break;
+
+		default:
+			return 0;
+	}
+
+	return 1;
+}
+
+static uint8_t is_blank(uint16_t n){
+
+	const uint32_t * words = (const uint32_t *)RECORD_ADDRESS(n);
+	uint8_t i;
+
+	for(i=0;i<SUMMARY_WORDS;i++){
+		if(words[i] != 0xFFFFFFFF){
+			return 0;
+		}
+	}
+	return 1;
+}
+
+//The data cache may hold the words from before they were programmed or erased.
+static void flush_data_cache(void){
+
+	if(READ_BIT(FLASH->ACR,FLASH_ACR_DCEN) != RESET){
+
+		__HAL_FLASH_DATA_CACHE_DISABLE();
+		__HAL_FLASH_DATA_CACHE_RESET();
+		__HAL_FLASH_DATA_CACHE_ENABLE();
+	}
+}
+
+//Finds the first blank record.
+static void find_next(void){
+
+	uint16_t low = 0;
+	uint16_t high = SUMMARY_RECORDS;
+
+	//Records are written in order and the first word of a record is never blank, so the blank ones are all at the end.
+	while(low < high){
+
+		uint16_t mid = low + (high - low)/2;
+
+		if(is_blank(mid)){
+			high = mid;
+		}
+		else{
+			low = mid + 1;
+		}
+	}
+
+	next_record = low;
+	next_word = 0;
+}
+
+void summary_log_init(void){
+
+	find_next();
+	queue_head = 0;
+	queue_tail = 0;
+	queue_count = 0;
+	dropped = 0;
+}
+
+void summary_log_boot(uint8_t state,uint8_t warm,uint32_t log_address){
+
+	summaryRecord_t record;
+
+	memset(&record,0,sizeof(record));
+	record.kind = SUMMARY_KIND_BOOT;
+	record.state = state;
+	record.reset_flags = (RCC->CSR >> 24) & 0xFF;
+	record.warm = warm;
+	record.log_address = log_address;
+
+	__HAL_RCC_CLEAR_RESET_FLAGS();
+
+	summary_log_put(&record);
+}
+
+summaryLogStatus_t summary_log_put(summaryRecord_t * record){
+
+	record->time_ms = HAL_GetTick();
+	if(record->kind == SUMMARY_KIND_HEALTH){
+		record->dropped = dropped;
+	}
+
+	if(queue_count >= SUMMARY_QUEUE_RECORDS || (uint32_t)next_record + queue_count >= SUMMARY_RECORDS){
+
+		if(dropped < 0xFF){
+			dropped++;
+		}
+		return SUMMARY_LOG_ERROR;
+	}
+
+	encode(queue[queue_head],record);
+	queue_head = (queue_head + 1) % SUMMARY_QUEUE_RECORDS;
+	queue_count++;
+
+	return SUMMARY_LOG_OK;
+}
+
+void summary_log_service(void){
+
+	const uint8_t * data;
+	uint32_t address;
+	uint32_t word;
+	uint8_t failed = 0;
+	uint8_t i;
+
+	if(queue_count == 0){
+		return;
+	}
+
+	data = queue[queue_tail];
+	address = RECORD_ADDRESS(next_record) + (uint32_t)next_word*4;
+
+	//The CRC is in the last word, so a record cut short here fails its CRC.
+	HAL_FLASH_Unlock();
+	for(i=0;i<SUMMARY_BATCH_WORDS && !failed;i++){
+
+		memcpy(&word,&data[(next_word + i)*4],4);
+		if(HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD,address + (uint32_t)i*4,word) != HAL_OK){
+			failed = 1;
+		}
+	}
+	HAL_FLASH_Lock();
+
+	next_word += SUMMARY_BATCH_WORDS;
+
+	if(failed || next_word >= SUMMARY_WORDS){
+
+		//A failed record is left as it is and the next one goes after it.
+		if(failed && dropped < 0xFF){
+			dropped++;
+		}
+
+		next_record++;
+		next_word = 0;
+		queue_tail = (queue_tail + 1) % SUMMARY_QUEUE_RECORDS;
+		queue_count--;
+
+		flush_data_cache();
+	}
+}
+
+summaryLogStatus_t summary_log_erase(void){
+
+	FLASH_EraseInitTypeDef erase;
+	uint32_t bad_sector = 0xFFFFFFFF;
+	HAL_StatusTypeDef status;
+
+	if(next_record == 0 && next_word == 0){
+		return SUMMARY_LOG_OK;
+	}
+
+	erase.TypeErase = FLASH_TYPEERASE_SECTORS;
+	erase.Sector = SUMMARY_LOG_SECTOR;
+	erase.NbSectors = 1;
+	erase.VoltageRange = FLASH_VOLTAGE_RANGE_3;
+
+	HAL_FLASH_Unlock();
+	status = HAL_FLASHEx_Erase(&erase,&bad_sector);
+	HAL_FLASH_Lock();
+
+	//A record half programmed before the erase starts again from its first word.
+	next_record = 0;
+	next_word = 0;
+
+	if(status != HAL_OK){
+		find_next();
+		return SUMMARY_LOG_ERROR;
+	}
+
+	return SUMMARY_LOG_OK;
+}
+
+uint16_t summary_log_count(void){
+
+	return next_record + (next_word > 0);
+}
+
+summaryLogStatus_t summary_log_read(uint16_t index,summaryRecord_t * record){
+
+	if(index >= SUMMARY_RECORDS || is_blank(index)){
+		return SUMMARY_LOG_ERROR;
+	}
+	if(!decode((const uint8_t *)RECORD_ADDRESS(index),record)){
+		return SUMMARY_LOG_ERROR;
+	}
+
+	return SUMMARY_LOG_OK;
+}
@@ -0,0 +1,143 @@
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// UMSATS 2018-2020
+//
+// Repository:
+//  UMSATS/Avionics-2019
+//
+// File Description:
+//  Source file for the task monitor.
+//
+// History
+// 2026-10-19
+// - Created.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include "taskMonitor.h"
+#include <string.h>
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// CONSTANTS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//Kept out of the task stack.
+static TaskStatus_t task_status[TASK_MONITOR_MAX_TASKS];
+
+//Run time of each task at the previous sample, to find the CPU share over the period.
+static uint32_t prev_run_time[TASK_MONITOR_MAX_TASKS];
+static UBaseType_t prev_number[TASK_MONITOR_MAX_TASKS];
+static UBaseType_t prev_count = 0;
+static uint32_t prev_total_time = 0;
+
+//Latest sample, read by the other tasks.
+static taskMonitorEntry_t latest[TASK_MONITOR_MAX_TASKS];
+static uint8_t latest_count = 0;
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// FUNCTIONS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+static uint32_t find_prev_run_time(UBaseType_t number){
+
+	UBaseType_t i;
+
+	for(i=0;i<prev_count;i++){
+
+		if(prev_number[i] == number){
+			return prev_run_time[i];
+		}
+	}
+
+	//New task, it has run for the whole of its run time in this period.
+	return 0;
+}
+
+static void sample(void){
+
+	taskMonitorEntry_t entries[TASK_MONITOR_MAX_TASKS];
+	uint32_t total_time;
+	uint32_t period;
+	UBaseType_t count;
+	UBaseType_t i;
+
+	count = uxTaskGetSystemState(task_status,TASK_MONITOR_MAX_TASKS,&total_time);
+	period = total_time - prev_total_time;
+
+	for(i=0;i<count;i++){
+
+		uint32_t run_time = task_status[i].ulRunTimeCounter - find_prev_run_time(task_status[i].xTaskNumber);
+
+		strncpy(entries[i].name,task_status[i].pcTaskName,configMAX_TASK_NAME_LEN);
+		entries[i].name[configMAX_TASK_NAME_LEN-1] = '\0';
+		entries[i].number = task_status[i].xTaskNumber;
+		entries[i].state = task_status[i].eCurrentState;
+		entries[i].priority = task_status[i].uxCurrentPriority;
+		entries[i].cpu_permille = (period == 0) ? 0 : (uint16_t)(((uint64_t)run_time*1000)/period);
+		entries[i].stack_free = task_status[i].usStackHighWaterMark;
+	}
+
+	for(i=0;i<count;i++){
+
+		prev_number[i] = task_status[i].xTaskNumber;
+		prev_run_time[i] = task_status[i].ulRunTimeCounter;
+	}
+	prev_count = count;
+	prev_total_time = total_time;
+
+	taskENTER_CRITICAL();
+	memcpy(latest,entries,sizeof(taskMonitorEntry_t)*count);
+	latest_count = count;
+	taskEXIT_CRITICAL();
+}
+
+void vTask_monitor(void * pvParameters){
+
+	TickType_t prevTime;
+
+	//The first sample only sets the starting run times.
+	uxTaskGetSystemState(task_status,TASK_MONITOR_MAX_TASKS,&prev_total_time);
+	prev_count = 0;
+
+	prevTime = xTaskGetTickCount();
+
+	while(1){
+
+		vTaskDelayUntil(&prevTime,pdMS_TO_TICKS(TASK_MONITOR_PERIOD));
+		sample();
+	}
+}
+
+uint8_t task_monitor_get(taskMonitorEntry_t * entries,uint8_t max_entries){
+
+	uint8_t count;
+
+	taskENTER_CRITICAL();
+	count = (latest_count < max_entries) ? latest_count : max_entries;
+	memcpy(entries,latest,sizeof(taskMonitorEntry_t)*count);
+	taskEXIT_CRITICAL();
+
+	return count;
+}
+
+uint8_t task_monitor_log_payload(uint8_t * payload){
+
+	taskMonitorEntry_t entries[TASK_MONITOR_MAX_TASKS];
+	uint8_t count = task_monitor_get(entries,TASK_MONITOR_MAX_TASKS);
+	uint8_t i;
+
+	for(i=0;i<count;i++){
+
+		uint8_t * dest = &payload[i*TASK_RECORD_TASK_SIZE];
+
+		dest[0] = entries[i].number;
+		dest[1] = entries[i].cpu_permille >> 8;
+		dest[2] = entries[i].cpu_permille & 0xFF;
+		dest[3] = entries[i].stack_free >> 8;
+		dest[4] = entries[i].stack_free & 0xFF;
+		strncpy((char *)&dest[5],entries[i].name,TASK_RECORD_NAME_LENGTH);
+	}
+
+	return count*TASK_RECORD_TASK_SIZE;
+}
@@ -0,0 +1,192 @@
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// UMSATS 2018-2020
+//
+// Repository:
+//  UMSATS/Avionics-2019
+//
+// File Description:
+//  Source file for the telemetry task.
+//
+// History
+// 2026-10-19
+// - Created.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include "telemetry.h"
+#include "taskMonitor.h"
+#include "flashService.h"
+#include "recovery.h"
+#include <string.h>
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// CONSTANTS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//Latest sample from the logging task, with the speed worked out from it.
+static telemetrySample_t latest;
+static uint32_t latest_events;
+static float latest_velocity;
+static uint8_t published = 0;
+
+//Previous sample, only used by telemetry_publish().
+static float prev_alt_filtered;
+static uint32_t prev_time_us;
+
+//UART the frames are sent on, for the interrupt handler.
+static UART_HandleTypeDef * telemetry_uart = NULL;
+
+//Kept out of the task stack.
+static tlmScheduler_t scheduler;
+static taskMonitorEntry_t tasks[TASK_MONITOR_MAX_TASKS];
+static uint8_t frame[TLM_MAX_FRAME];
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// FUNCTIONS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+void telemetry_publish(const telemetrySample_t * sample){
+
+	float velocity = latest_velocity;
+	uint32_t dt = sample->time_us - prev_time_us;
+
+	if(published && dt > 0){
+		velocity += TELEMETRY_VELOCITY_GAIN*((sample->alt_filtered - prev_alt_filtered)*1000000.0f/dt - velocity);
+	}
+	prev_alt_filtered = sample->alt_filtered;
+	prev_time_us = sample->time_us;
+
+	taskENTER_CRITICAL();
+	latest = *sample;
+	latest_events |= sample->events;
+	latest_velocity = velocity;
+	published = 1;
+	taskEXIT_CRITICAL();
+}
+
+//Sets the health fields from the task monitor, the flash service and the e-match continuity.
+static void update_health(void){
+
+	flashClassStats_t stats;
+	uint32_t errors = 0;
+	uint16_t cpu = 0;
+	uint16_t stack_min = 0xFFFF;
+	uint8_t count = task_monitor_get(tasks,TASK_MONITOR_MAX_TASKS);
+	uint8_t i;
+
+	for(i=0;i<count;i++){
+
+		if(strcmp(tasks[i].name,"IDLE") != 0){
+			cpu += tasks[i].cpu_permille;
+		}
+		if(tasks[i].stack_free < stack_min){
+			stack_min = tasks[i].stack_free;
+		}
+	}
+
+	if(count > 0){
+		tlm_set(&scheduler,TLM_CPU_LOAD,cpu);
+		tlm_set(&scheduler,TLM_STACK_MIN,stack_min);
+	}
+
+	for(i=0;i<FLASH_CLASSES;i++){
+
+		flash_service_stats(i,&stats);
+		errors += stats.errors;
+	}
+	tlm_set(&scheduler,TLM_FLASH_ERRORS,errors);
+
+	tlm_set(&scheduler,TLM_CONTINUITY,(check_continuity(DROGUE) == SHORT_CIRCUIT ? 0x01 : 0) | (check_continuity(MAIN) == SHORT_CIRCUIT ? 0x02 : 0));
+}
+
+//Sets the fields that come from the logging task.
+static void update_flight(void){
+
+	telemetrySample_t sample;
+	uint32_t events;
+	float velocity;
+	uint8_t ready;
+
+	taskENTER_CRITICAL();
+	sample = latest;
+	events = latest_events;
+	velocity = latest_velocity;
+	ready = published;
+	taskEXIT_CRITICAL();
+
+	if(!ready){
+		return;
+	}
+
+	tlm_set(&scheduler,TLM_EVENTS,(events & EVENT_MASK) >> EXT_KIND_SHIFT);
+	tlm_set(&scheduler,TLM_ALTITUDE,(int32_t)(sample.alt_filtered*10));
+	tlm_set(&scheduler,TLM_VELOCITY,(int32_t)(velocity*10));
+	tlm_set(&scheduler,TLM_ACC_X,sample.acc[0]);
+	tlm_set(&scheduler,TLM_ACC_Y,sample.acc[1]);
+	tlm_set(&scheduler,TLM_ACC_Z,sample.acc[2]);
+	tlm_set(&scheduler,TLM_ALT_RAW,(int32_t)(sample.altitude*10));
+	tlm_set(&scheduler,TLM_FLIGHT_TIME,sample.flight_time);
+	tlm_set(&scheduler,TLM_LOG_ADDRESS,sample.log_address);
+}
+
+static IRQn_Type uart_irq_number(USART_TypeDef * instance){
+
+	if(instance == USART1){
+		return USART1_IRQn;
+	}
+	else if(instance == USART2){
+		return USART2_IRQn;
+	}
+	return USART6_IRQn;
+}
+
+void vTask_telemetry(void * pvParameters){
+
+	TelemetryParams_t * params = (TelemetryParams_t *)pvParameters;
+	TickType_t prevTime = xTaskGetTickCount();
+	uint8_t length;
+
+	telemetry_uart = params->huart;
+	HAL_NVIC_SetPriority(uart_irq_number(params->huart->Instance),TELEMETRY_IRQ_PRIORITY,0);
+	HAL_NVIC_EnableIRQ(uart_irq_number(params->huart->Instance));
+
+	tlm_init(&scheduler,tlm_budget(params->huart->Init.BaudRate,TELEMETRY_BUDGET_PERCENT),prevTime*portTICK_PERIOD_MS);
+
+	while(1){
+
+		vTaskDelayUntil(&prevTime,pdMS_TO_TICKS(TELEMETRY_FRAME_PERIOD));
+
+		//The budget leaves the last frame time to go out, unless the modem holds up the UART. Then nothing is built
+		//until it is done, so no frame is lost and the fields that are due wait for the next one.
+		if(params->huart->gState != HAL_UART_STATE_READY){
+			continue;
+		}
+
+		tlm_set(&scheduler,TLM_STATE,params->flightCompConfig->values.state);
+		tlm_set(&scheduler,TLM_FLAGS,params->flightCompConfig->values.flags);
+		update_flight();
+		update_health();
+
+		length = tlm_build(&scheduler,xTaskGetTickCount()*portTICK_PERIOD_MS,frame);
+		if(length > 0){
+			HAL_UART_Transmit_IT(params->huart,frame,length);
+		}
+	}
+}
+
+void telemetry_stats(uint32_t * frames,uint32_t * bytes){
+
+	taskENTER_CRITICAL();
+	*frames = scheduler.frames;
+	*bytes = scheduler.bytes;
+	taskEXIT_CRITICAL();
+}
+
+void telemetry_irq(void){
+
+	if(telemetry_uart != NULL){
+		HAL_UART_IRQHandler(telemetry_uart);
+	}
+}
@@ -0,0 +1,389 @@
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// UMSATS 2018-2020
+//
+// Repository:
+//  UMSATS/Avionics-2019
+//
+// File Description:
+//  Source file for the radio telemetry frames.
+//
+// History
+// 2026-10-19
+// - Created.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include "telemetryFrame.h"
+#include "crc.h"
+#include <string.h>
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// DEFINITIONS AND MACROS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#define MAX_ELAPSED			1000		//ms of budget that can build up, so a stalled task does not send a burst.
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// CONSTANTS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//At the default periods the fields take about 92 bytes/s with the frame overhead, well inside 9600 baud. When the
+//budget does not cover every field that is due, the lower priorities wait for the next frame.
+const tlmFieldInfo_t tlm_fields[TLM_FIELDS] = {
+
+	//name			width	signed	priority	on change	period
+	{"state",		1,		0,		0,			1,			1000},
+	{"flags",		1,		0,		0,			1,			1000},
+	{"events",		1,		0,		0,			1,			1000},
+	{"continuity",	1,		0,		1,			1,			2000},
+	{"altitude",	4,		1,		1,			0,			200},
+	{"velocity",	2,		1,		1,			0,			200},
+	{"acc_x",		2,		1,		2,			0,			500},
+	{"acc_y",		2,		1,		2,			0,			500},
+	{"acc_z",		2,		1,		2,			0,			500},
+	{"alt_raw",		4,		1,		3,			0,			1000},
+	{"flight_time",	4,		0,		2,			0,			1000},
+	{"log_address",	4,		0,		4,			0,			5000},
+	{"cpu_load",	2,		0,		4,			0,			5000},
+	{"stack_min",	2,		0,		4,			0,			5000},
+	{"flash_errors",2,		0,		4,			1,			5000},
+};
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// FUNCTIONS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//Limits a value to what the field can send in full, so the receiver ends up with the same value.
+static int32_t clamp(uint8_t field,int32_t value){
+
+	uint8_t bits = tlm_fields[field].width*8;
+	int32_t min;
+	int32_t max;
+
+	if(bits == 32){
+		return value;
+	}
+
+	min = tlm_fields[field].is_signed ? -((int32_t)1 << (bits-1)) : 0;
+	max = tlm_fields[field].is_signed ? ((int32_t)1 << (bits-1)) - 1 : ((int32_t)1 << bits) - 1;
+
+	return (value < min) ? min : (value > max) ? max : value;
+}
+
+static uint8_t field_coding(const tlmFieldState_t * f,uint8_t width){
+
+	int32_t delta = (int32_t)((uint32_t)f->value - (uint32_t)f->sent);
+
+	if(width == 1 || f->since_key >= TLM_KEY_INTERVAL){
+		return TLM_CODING_FULL;
+	}
+	if(delta >= -128 && delta <= 127){
+		return TLM_CODING_DELTA8;
+	}
+	if(width == 4 && delta >= -32768 && delta <= 32767){
+		return TLM_CODING_DELTA16;
+	}
+	return TLM_CODING_FULL;
+}
+
+static uint8_t coding_size(uint8_t coding,uint8_t width){
+
+	return 1 + ((coding == TLM_CODING_DELTA8) ? 1 : (coding == TLM_CODING_DELTA16) ? 2 : width);
+}
+
+static void put_value(uint8_t * dest,int32_t value,uint8_t width){
+
+	uint8_t i;
+
+	for(i=0;i<width;i++){
+		dest[i] = ((uint32_t)value >> (8*(width-1-i))) & 0xFF;
+	}
+}
+
+static int32_t get_value(const uint8_t * src,uint8_t width,uint8_t is_signed){
+
+	uint32_t value = 0;
+	uint8_t i;
+
+	for(i=0;i<width;i++){
+		value = (value << 8) | src[i];
+	}
+
+	if(is_signed && width < 4 && (value & ((uint32_t)1 << (width*8-1)))){
+		value |= ~(uint32_t)0 << (width*8);
+	}
+
+	return (int32_t)value;
+}
+
+uint32_t tlm_budget(uint32_t baud_rate,uint8_t percent){
+
+	return (baud_rate/10)*percent/100;
+}
+
+void tlm_init(tlmScheduler_t * sched,uint32_t bytes_per_second,uint32_t now){
+
+	uint8_t i;
+
+	memset(sched,0,sizeof(tlmScheduler_t));
+
+	for(i=0;i<TLM_FIELDS;i++){
+
+		sched->fields[i].sent_time = now - tlm_fields[i].period;
+		sched->fields[i].since_key = TLM_KEY_INTERVAL;
+	}
+
+	sched->bytes_per_second = bytes_per_second;
+	sched->last_time = now;
+}
+
+void tlm_set(tlmScheduler_t * sched,uint8_t field,int32_t value){
+
+	tlmFieldState_t * f = &sched->fields[field];
+
+	value = clamp(field,value);
+
+	if(!f->valid || f->value != value){
+		f->changed = 1;
+	}
+	f->value = value;
+	f->valid = 1;
+}
+
+uint8_t tlm_build(tlmScheduler_t * sched,uint32_t now,uint8_t * frame){
+
+	uint32_t elapsed = now - sched->last_time;
+	uint32_t picked = 0;
+	uint8_t space;
+	uint8_t length = 0;
+	uint16_t crc;
+	uint8_t i;
+
+	sched->last_time = now;
+	if(elapsed > MAX_ELAPSED){
+		elapsed = MAX_ELAPSED;
+	}
+
+	sched->credit += elapsed*sched->bytes_per_second;
+	if(sched->credit > TLM_MAX_FRAME*1000){
+		sched->credit = TLM_MAX_FRAME*1000;
+	}
+
+	//Not worth a frame without room for a change of one field.
+	if(sched->credit/1000 < TLM_OVERHEAD+2){
+		return 0;
+	}
+	space = sched->credit/1000 - TLM_OVERHEAD;
+	if(space > TLM_MAX_PAYLOAD){
+		space = TLM_MAX_PAYLOAD;
+	}
+
+	while(1){
+
+		int8_t best = -1;
+		int32_t best_late = 0;
+		uint8_t best_coding = TLM_CODING_FULL;
+
+		for(i=0;i<TLM_FIELDS;i++){
+
+			const tlmFieldInfo_t * info = &tlm_fields[i];
+			tlmFieldState_t * f = &sched->fields[i];
+			int32_t late = (int32_t)(now - f->sent_time) - info->period;
+			uint8_t coding;
+
+			if((picked & ((uint32_t)1 << i)) || !f->valid){
+				continue;
+			}
+
+			if(info->on_change && f->changed){
+				late = INT32_MAX;
+			}
+			else if(late < 0){
+				continue;
+			}
+
+			coding = field_coding(f,info->width);
+			if(length + coding_size(coding,info->width) > space){
+				continue;
+			}
+
+			if(best < 0 || info->priority < tlm_fields[best].priority || (info->priority == tlm_fields[best].priority && late > best_late)){
+
+				best = i;
+				best_late = late;
+				best_coding = coding;
+			}
+		}
+
+		if(best < 0){
+			break;
+		}
+
+		{
+			tlmFieldState_t * f = &sched->fields[best];
+			uint8_t * dest = &frame[TLM_HEADER_SIZE+length];
+			uint8_t width = tlm_fields[best].width;
+
+			dest[0] = best | (best_coding << TLM_CODING_SHIFT);
+
+			if(best_coding == TLM_CODING_FULL){
+				put_value(&dest[1],f->value,width);
+				f->since_key = 0;
+			}
+			else{
+				put_value(&dest[1],(int32_t)((uint32_t)f->value - (uint32_t)f->sent),(best_coding == TLM_CODING_DELTA8) ? 1 : 2);
+				f->since_key++;
+			}
+
+			length += coding_size(best_coding,width);
+			f->sent = f->value;
+			f->sent_time = now;
+			f->changed = 0;
+			picked |= (uint32_t)1 << best;
+		}
+	}
+
+	if(length == 0){
+		return 0;
+	}
+
+	frame[0] = TLM_SYNC;
+	frame[1] = length;
+	frame[2] = sched->sequence++;
+	frame[3] = (now >> 8) & 0xFF;
+	frame[4] = now & 0xFF;
+
+	crc = crc16(&frame[1],TLM_HEADER_SIZE-1+length);
+	frame[TLM_HEADER_SIZE+length] = crc >> 8;
+	frame[TLM_HEADER_SIZE+length+1] = crc & 0xFF;
+
+	length += TLM_OVERHEAD;
+	sched->credit -= (uint32_t)length*1000;
+	sched->frames++;
+	sched->bytes += length;
+
+	return length;
+}
+
+void tlm_decoder_init(tlmDecoder_t * dec){
+
+	memset(dec,0,sizeof(tlmDecoder_t));
+}
+
+static void drop(tlmDecoder_t * dec,uint8_t count){
+
+	memmove(dec->buffer,&dec->buffer[count],dec->length - count);
+	dec->length -= count;
+}
+
+//Checks the CRC and reads the fields of the frame at the start of the buffer.
+static uint8_t read_frame(tlmDecoder_t * dec){
+
+	const uint8_t * payload = &dec->buffer[TLM_HEADER_SIZE];
+	uint8_t length = dec->buffer[1];
+	uint16_t crc = ((uint16_t)payload[length] << 8) | payload[length+1];
+	uint8_t sequence = dec->buffer[2];
+	uint8_t pos = 0;
+	uint8_t i;
+
+	if(crc16(&dec->buffer[1],TLM_HEADER_SIZE-1+length) != crc){
+		return 0;
+	}
+
+	//The changes in a lost frame are not known, so every value waits for its next full send.
+	if(dec->started && sequence != (uint8_t)(dec->sequence+1)){
+
+		dec->lost += (uint8_t)(sequence - dec->sequence - 1);
+		for(i=0;i<TLM_FIELDS;i++){
+			dec->valid[i] = 0;
+		}
+	}
+
+	dec->started = 1;
+	dec->sequence = sequence;
+	dec->time = ((uint16_t)dec->buffer[3] << 8) | dec->buffer[4];
+	dec->updated = 0;
+
+	while(pos < length){
+
+		uint8_t field = payload[pos] & TLM_ID_MASK;
+		uint8_t coding = payload[pos] >> TLM_CODING_SHIFT;
+		uint8_t width;
+		uint8_t size;
+
+		if(field >= TLM_FIELDS || coding > TLM_CODING_DELTA16){
+			return 0;
+		}
+
+		width = tlm_fields[field].width;
+		size = coding_size(coding,width);
+		if(pos + size > length){
+			return 0;
+		}
+
+		if(coding == TLM_CODING_FULL){
+
+			dec->values[field] = get_value(&payload[pos+1],width,tlm_fields[field].is_signed);
+			dec->valid[field] = 1;
+			dec->updated |= (uint32_t)1 << field;
+		}
+		else if(dec->valid[field]){
+
+			int32_t delta = get_value(&payload[pos+1],size-1,1);
+
+			dec->values[field] = (int32_t)((uint32_t)dec->values[field] + (uint32_t)delta);
+			dec->updated |= (uint32_t)1 << field;
+		}
+
+		pos += size;
+	}
+
+	return 1;
+}
+
+uint8_t tlm_decode(tlmDecoder_t * dec,uint8_t byte){
+
+	dec->buffer[dec->length++] = byte;
+
+	while(dec->length > 0){
+
+		uint8_t frame_length;
+
+		if(dec->buffer[0] != TLM_SYNC){
+			drop(dec,1);
+			dec->skipped++;
+			continue;
+		}
+
+		if(dec->length < 2){
+			return 0;
+		}
+
+		if(dec->buffer[1] > TLM_MAX_PAYLOAD){
+			drop(dec,1);
+			dec->skipped++;
+			continue;
+		}
+
+		frame_length = TLM_OVERHEAD + dec->buffer[1];
+		if(dec->length < frame_length){
+			return 0;
+		}
+
+		if(read_frame(dec)){
+
+			//Bytes after the frame are looked at with the next byte.
+			drop(dec,frame_length);
+			dec->frames++;
+			return 1;
+		}
+
+		//A 0xA5 inside another frame, or a damaged frame. Look for the next start from the byte after.
+		dec->bad++;
+		drop(dec,1);
+		dec->skipped++;
+	}
+
+	return 0;
+}
@@ -10,6 +10,10 @@
 // History
 // 2019-03-13 by Benjamin Zacharias
 // - Created.
+// 2026-10-19
+// - The drogue and main steps are timed from launch so they can carry on after a reset in flight.
+// - The backup timer task is replaced by two timer wheel timers.
+// - The timers only fire the e-matches. The logging task moves the flight state when the pulse result arrives.
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -20,11 +24,14 @@
 #include "timer.h"
 #include "cmsis_os.h"
 #include "buzzer.h"
+#include "hrTimer.h"
+#include "timerWheel.h"
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 // DEFINITIONS AND MACROS
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
-static UART_HandleTypeDef* uart;
+static wheelTimer_t drogue_timer;
+static wheelTimer_t main_timer;
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 // ENUMS AND ENUM TYPEDEFS
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -80,64 +87,48 @@ void Timer_GPIO_Init(void){
   HAL_GPIO_Init(INPUT_PORT, &GPIO_InitStruct);
 }
 
-void vTask_timer(void *param){
-
-	//taskENABLE_INTERRUPTS();
-	configData_t * configParams = (configData_t *)param;
-
-	//Set both of the outputs to 0 for setup
-	HAL_GPIO_WritePin(OUTPUT1_PORT,OUTPUT1_PIN, GPIO_PIN_RESET); //turn Output 1 off
-	HAL_GPIO_WritePin(OUTPUT2_PORT,OUTPUT2_PIN, GPIO_PIN_RESET); //turn Output 2 off
-	TickType_t prevTime;
-	prevTime = xTaskGetTickCount();
-	/* As per most FreeRTOS tasks, this task is implemented in an infinite loop. */
-
-
-				//TODO check how long outputs should be on for
-				//TODO check in init that outputs are off before connecting to e-matches
-
-				vTaskDelayUntil(&prevTime,pdMS_TO_TICKS(TIME_INTERVAL1)); //wait for the first time interval
-				recoverySelect_t event = DROGUE;
-				enable_mosfet(event);
-				activate_mosfet(event);
-
-				configParams->values.state = STATE_IN_FLIGHT_POST_APOGEE;
-
-				buzz(250);
-				vTaskDelayUntil(&prevTime,pdMS_TO_TICKS(250));
-				buzz(250);
-				vTaskDelayUntil(&prevTime,pdMS_TO_TICKS(250));
-
-				vTaskDelayUntil(&prevTime,pdMS_TO_TICKS(TIME_INTERVAL2)); //wait for the first time interval
-				event = MAIN;
-				enable_mosfet(event);
-				activate_mosfet(event);
-				configParams->values.state = STATE_IN_FLIGHT_POST_MAIN;
-				buzz(250);
-				vTaskDelayUntil(&prevTime,pdMS_TO_TICKS(250));
-				buzz(250);
-				vTaskDelayUntil(&prevTime,pdMS_TO_TICKS(250));
-				buzz(250);
-				vTaskDelayUntil(&prevTime,pdMS_TO_TICKS(250));
-				buzz(250);
-				vTaskDelayUntil(&prevTime,pdMS_TO_TICKS(250));
-				buzz(250);
-				vTaskDelayUntil(&prevTime,pdMS_TO_TICKS(250));
-				buzz(250);
-				vTaskDelayUntil(&prevTime,pdMS_TO_TICKS(250));
-
-				vTaskDelete(NULL);
-
-//				vTaskDelay(pdMS_TO_TICKS(TIME_INTERVAL2)); //keep Output on for the designated time
-//				HAL_GPIO_WritePin(OUTPUT1_PORT,OUTPUT1_PIN, GPIO_PIN_RESET); //turn Output 1 off
-//
-//
-//				vTaskDelay(pdMS_TO_TICKS(TIME_INTERVAL3)); //wait for the second time interval
-//				HAL_GPIO_WritePin(OUTPUT2_PORT,OUTPUT2_PIN, GPIO_PIN_SET); //turn Output 2 on
-//				vTaskDelay(pdMS_TO_TICKS(TIME_INTERVAL4)); //keep Output 2 on for the desired time
-//				HAL_GPIO_WritePin(OUTPUT2_PORT,OUTPUT2_PIN, GPIO_PIN_RESET); //turn Output 2 off
+//The flight state is left to flight_state_deployed() in the logging task, which only moves it forward.
+static void backup_drogue(void * arg){
+
+	enable_mosfet(DROGUE);
+	activate_mosfet(DROGUE);
+
+	buzz(250);
+	buzz(250);
+}
+
+static void backup_main(void * arg){
+
+	uint8_t i;
+
+	enable_mosfet(MAIN);
+	activate_mosfet(MAIN);
+
+	for(i=0;i<6;i++){
+		buzz(250);
+	}
+}
+
+void backup_timer_init(void){
+
+	wheel_timer_setup(&drogue_timer,backup_drogue,NULL);
+	wheel_timer_setup(&main_timer,backup_main,NULL);
+}
+
+void backup_timer_start(uint32_t elapsed_ms){
+
+	//TODO check how long outputs should be on for
+	//TODO check in init that outputs are off before connecting to e-matches
+	uint32_t launch_time = hr_timer_now() - elapsed_ms*1000;
+	uint32_t main_time = TIME_INTERVAL1 + 2*BACKUP_BEEP_TIME + TIME_INTERVAL2;
 
+	if(elapsed_ms < TIME_INTERVAL1){
+		wheel_timer_start_at(&drogue_timer,launch_time + (uint32_t)TIME_INTERVAL1*1000,0);
+	}
 
+	if(elapsed_ms < main_time){
+		wheel_timer_start_at(&main_timer,launch_time + main_time*1000,0);
+	}
 }
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
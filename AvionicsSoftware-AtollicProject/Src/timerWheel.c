@@ -0,0 +1,325 @@
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// UMSATS 2018-2020
+//
+// Repository:
+//  UMSATS/Avionics-2019
+//
+// File Description:
+//  Source file for the timer wheel.
+//
+// History
+// 2026-10-19
+// - Created.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include "timerWheel.h"
+#include "hrTimer.h"
+#include "stm32f4xx_hal.h"
+#include <stddef.h>
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// DEFINITIONS AND MACROS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#define LEVEL_BITS		6
+#define SLOT_MASK		(TIMER_WHEEL_SLOTS - 1)
+
+//Fails to compile if the levels do not cover the 32 bit time.
+typedef char levels_cover_time[(TIMER_WHEEL_LEVELS*LEVEL_BITS >= 32 && (1 << LEVEL_BITS) == TIMER_WHEEL_SLOTS) ? 1 : -1];
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// CONSTANTS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+static wheelTimer_t * slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+static uint64_t occupied[TIMER_WHEEL_LEVELS];		//Bit n is set when slot n of the level has a timer.
+
+//Every timer due before this has been run. Placement in the wheel is relative to it.
+static uint32_t wheel_time;
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// FUNCTIONS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+static void unlink(wheelTimer_t * timer){
+
+	if(timer->prev != NULL){
+		timer->prev->next = timer->next;
+	}
+	else{
+		slots[timer->level][timer->slot] = timer->next;
+		if(timer->next == NULL){
+			occupied[timer->level] &= ~((uint64_t)1 << timer->slot);
+		}
+	}
+
+	if(timer->next != NULL){
+		timer->next->prev = timer->prev;
+	}
+
+	timer->next = NULL;
+	timer->prev = NULL;
+}
+
+static void insert(wheelTimer_t * timer){
+
+	uint32_t place = timer->expiry;
+	uint32_t diff;
+	uint8_t level = 0;
+
+	//Already due, it goes in the current slot of level 0. The expiry is kept so periodic timers do not drift.
+	if((int32_t)(place - wheel_time) < 0){
+		place = wheel_time;
+	}
+
+	//The level is set by the highest group of bits that differs from the wheel time.
+	diff = place ^ wheel_time;
+	if(diff != 0){
+		level = (31 - __builtin_clz(diff)) / LEVEL_BITS;
+	}
+
+	timer->level = level;
+	timer->slot = (place >> (level*LEVEL_BITS)) & SLOT_MASK;
+	timer->prev = NULL;
+	timer->next = slots[level][timer->slot];
+
+	if(timer->next != NULL){
+		timer->next->prev = timer;
+	}
+
+	slots[level][timer->slot] = timer;
+	occupied[level] |= (uint64_t)1 << timer->slot;
+}
+
+//Time the slot is reached: the wheel time with the bits of this level set to the slot and the ones below cleared.
+static uint32_t slot_time(uint8_t level,uint8_t slot){
+
+	uint8_t shift = level*LEVEL_BITS;
+	uint32_t above = 0;
+
+	if(shift + LEVEL_BITS < 32){
+		above = wheel_time & ~((((uint32_t)1) << (shift + LEVEL_BITS)) - 1);
+	}
+
+	return above | ((uint32_t)slot << shift);
+}
+
+//Finds the next slot to handle, at any level.
+//Returns 1 and the time, level and slot of the next one, or 0 if the wheel is empty.
+static uint8_t next_slot(uint32_t * time,uint8_t * level,uint8_t * slot){
+
+	uint8_t found = 0;
+	int32_t best = 0;
+	int8_t l;
+
+	//From the top, so slots that must be moved down come before level 0 timers due at the same time.
+	for(l=TIMER_WHEEL_LEVELS-1;l>=0;l--){
+
+		if(occupied[l] == 0){
+			continue;
+		}
+
+		uint8_t current = (wheel_time >> (l*LEVEL_BITS)) & SLOT_MASK;
+		uint64_t ahead = occupied[l] >> current;
+		uint8_t s;
+
+		//Slots behind the current one are only used at the top level, by times after the 32 bit wrap around.
+		if(ahead != 0){
+			s = current + __builtin_ctzll(ahead);
+		}
+		else{
+			s = __builtin_ctzll(occupied[l]);
+		}
+
+		uint32_t t = slot_time(l,s);
+		int32_t until = (int32_t)(t - wheel_time);
+
+		if(until < 0){
+			until = 0;
+		}
+
+		if(!found || until < best){
+
+			found = 1;
+			best = until;
+			*time = t;
+			*level = l;
+			*slot = s;
+		}
+	}
+
+	return found;
+}
+
+//Sets the compare register for the next slot, or pends the interrupt if it is already due.
+static void reprogram(void){
+
+	uint32_t time;
+	uint8_t level;
+	uint8_t slot;
+
+	if(!next_slot(&time,&level,&slot)){
+
+		TIM5->DIER &= ~TIM_DIER_CC1IE;
+		return;
+	}
+
+	if((int32_t)(time - wheel_time) < 0){
+		time = wheel_time;
+	}
+
+	TIM5->CCR1 = time;
+	TIM5->SR = ~TIM_SR_CC1IF;
+	TIM5->DIER |= TIM_DIER_CC1IE;
+
+	//Checked after setting the compare so a match is not missed while it was being set.
+	if((int32_t)(time - hr_timer_now()) <= 0){
+		NVIC_SetPendingIRQ(TIM5_IRQn);
+	}
+}
+
+void timer_wheel_init(void){
+
+	uint8_t l;
+	uint8_t s;
+
+	hr_timer_init();
+
+	for(l=0;l<TIMER_WHEEL_LEVELS;l++){
+		for(s=0;s<TIMER_WHEEL_SLOTS;s++){
+			slots[l][s] = NULL;
+		}
+		occupied[l] = 0;
+	}
+
+	wheel_time = hr_timer_now();
+
+	//Channel 1 as a frozen output compare, only the interrupt is used.
+	TIM5->CCMR1 &= ~(TIM_CCMR1_CC1S | TIM_CCMR1_OC1M);
+	TIM5->CCER &= ~TIM_CCER_CC1E;
+	TIM5->DIER &= ~TIM_DIER_CC1IE;
+	TIM5->SR = ~TIM_SR_CC1IF;
+
+	HAL_NVIC_SetPriority(TIM5_IRQn,TIMER_WHEEL_IRQ_PRIORITY,0);
+	HAL_NVIC_EnableIRQ(TIM5_IRQn);
+}
+
+void wheel_timer_setup(wheelTimer_t * timer,wheelCallback_t callback,void * arg){
+
+	timer->next = NULL;
+	timer->prev = NULL;
+	timer->callback = callback;
+	timer->arg = arg;
+	timer->period = 0;
+	timer->active = 0;
+}
+
+void wheel_timer_start_at(wheelTimer_t * timer,uint32_t time_us,uint32_t period_us){
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	if(timer->active){
+		unlink(timer);
+	}
+
+	timer->expiry = time_us;
+	timer->period = period_us;
+	timer->active = 1;
+	insert(timer);
+
+	reprogram();
+
+	__set_PRIMASK(primask);
+}
+
+void wheel_timer_start(wheelTimer_t * timer,uint32_t delay_us,uint32_t period_us){
+
+	if(delay_us > TIMER_WHEEL_MAX_DELAY){
+		delay_us = TIMER_WHEEL_MAX_DELAY;
+	}
+
+	wheel_timer_start_at(timer,hr_timer_now() + delay_us,period_us);
+}
+
+void wheel_timer_cancel(wheelTimer_t * timer){
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	if(timer->active){
+
+		unlink(timer);
+		timer->active = 0;
+		reprogram();
+	}
+
+	__set_PRIMASK(primask);
+}
+
+uint8_t wheel_timer_active(const wheelTimer_t * timer){
+
+	return timer->active;
+}
+
+void timer_wheel_irq(void){
+
+	uint32_t primask;
+	uint32_t now;
+	uint32_t time;
+	uint8_t level;
+	uint8_t slot;
+	wheelTimer_t * timer;
+
+	//The flag is not set when the interrupt was pended by reprogram().
+	TIM5->SR = ~TIM_SR_CC1IF;
+
+	primask = __get_PRIMASK();
+	__disable_irq();
+
+	now = hr_timer_now();
+
+	while(next_slot(&time,&level,&slot) && (int32_t)(time - now) <= 0){
+
+		if((int32_t)(time - wheel_time) > 0){
+			wheel_time = time;
+		}
+
+		//Timers are taken off one at a time, so a callback can start or cancel any timer, including this one.
+		while((timer = slots[level][slot]) != NULL){
+
+			unlink(timer);
+
+			if(level > 0){
+
+				//Moves down a level now that the time is in its slot.
+				insert(timer);
+				continue;
+			}
+
+			if(timer->period > 0){
+
+				timer->expiry += timer->period;
+				insert(timer);
+			}
+			else{
+				timer->active = 0;
+			}
+
+			//Interrupts are allowed while the callback runs.
+			__set_PRIMASK(primask);
+			timer->callback(timer->arg);
+			__disable_irq();
+		}
+	}
+
+	//Nothing else is due before now.
+	if((int32_t)(now - wheel_time) > 0){
+		wheel_time = now;
+	}
+
+	reprogram();
+
+	__set_PRIMASK(primask);
+}
@@ -10,6 +10,29 @@
 // History
 // 2019-02-15 by Eric Kapilik
 // - Created.
+// 2026-10-19
+// - Added the prof and profreset commands.
+// - Added the tasks and top commands.
+// - Removed the command buffer malloc, receive_command returns its own buffer.
+// - Memory menu d erases the configuration journal.
+// - Added the buzztest command.
+// - E-match menu g and i print the result of the pulse.
+// - Config menu a, o and p set the accelerometer, gyroscope and BMP388 sample rates.
+// - Config menu r, s, t and u set the logging rate of each flight phase, v shows the flash capacity.
+// - Config menu w, x and y set the event capture windows and shock level.
+// - Memory menu f shows the flight event journal and g erases it.
+// - Flash access goes through the flash service. Added the flash and flashreset commands.
+// - The flash command shows the latency while an erase was running and the erase suspends.
+// - read streams the log with one Fast Read instead of reading 5 pages at a time.
+// - read sends remapped pages from their spare pages. Memory menu h shows the log index.
+// - The flash command shows the errors of each class.
+// - Added the verify command, which checks the CRC of every log page, and the crcbench command.
+// - Added the radio command.
+// - verify also counts pages whose header sequence number does not match where they are.
+// - Memory menu c only erases used sectors. read ends at the last page with data instead of the first blank block.
+// - Added the summary command, which prints the summary log in the internal flash. Memory menu i erases it.
+//   Added the reads command, which only sends the used parts of the log.
+// - The flash command also prints the sensor readings missed.
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -22,6 +45,19 @@
 #include "xtract.h"
 #include "buttonpress.h"
 #include "cmsis_os.h"
+#include "profiler.h"
+#include "taskMonitor.h"
+#include "buzzer.h"
+#include "hrTimer.h"
+#include "acquisition.h"
+#include "eventCapture.h"
+#include "eventJournal.h"
+#include "logPacket.h"
+#include "flashService.h"
+#include "logIndex.h"
+#include "crc.h"
+#include "telemetry.h"
+#include "summaryLog.h"
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 // DEFINITIONS AND MACROS
@@ -36,6 +72,17 @@
 // STRUCTS AND STRUCT TYPEDEFS
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 
+//Page counts of the verify command.
+typedef struct{
+
+	uint32_t pages;
+	uint32_t bad;
+	uint32_t first_bad;			//Log address of the first page with a bad CRC.
+	uint32_t misplaced;			//Pages with a good CRC but the sequence number of another page.
+	uint32_t first_misplaced;
+
+}verifyCount_t;
+
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 // TYPEDEFS
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -55,8 +102,24 @@
 //    const void * param2  // Enter description of param2.
 //    );
 
+static uint32_t log_data_end(void);
+
 uint16_t delay_ematch_menu_fire = 10000;
 
+//Read 5 pages from flash at a time, one buffer is sent while the other is read.
+static uint8_t read_buffers[2][256*5];
+
+static const struct { uint32_t bit; const char * name; } event_names[] = {
+	{LAUNCH_DETECT,"launch"},
+	{DROGUE_DETECT,"drogue detect"},
+	{DROGUE_DEPLOY,"drogue deploy"},
+	{MAIN_DETECT,"main detect"},
+	{MAIN_DEPLOY,"main deploy"},
+	{LAND_DETECT,"land"},
+	{POWER_FAIL,"power fail"},
+	{OVERCURRENT_EVENT,"overcurrent"},
+};
+
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
 // FUNCTIONS
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -65,11 +128,10 @@ void vTask_xtract(void *pvParameters){
 	xtractParams * params = (xtractParams *)pvParameters;
 
 	UART_HandleTypeDef * uart = params->huart;
-	FlashStruct_t * flash = params->flash;
 
 	menuState_t state = MAIN_MENU;
 	intro(uart); //display help on start up
-	char *cmd_buf = (char*) malloc(sizeof(char) * BUFFER_SIZE); //command buffer
+	char *cmd_buf; //command buffer, owned by receive_command
 	state = MAIN_MENU;
 	/* As per most FreeRTOS tasks, this task is implemented in an infinite loop. */
 	while(1){
@@ -83,7 +145,6 @@ void handle_command(char* command,xtractParams * params,menuState_t * state){
 
 
 	UART_HandleTypeDef * uart = params->huart;
-	FlashStruct_t * flash = params->flash;
 	configData_t * config = params->flightCompConfig;
 	TaskHandle_t startupTaskHandle = params->startupTaskHandle;
 
@@ -96,6 +157,9 @@ void handle_command(char* command,xtractParams * params,menuState_t * state){
 	else if((strcmp(command, "read") == 0 && *state == MAIN_MENU )|| *state == READ_MENU){
 		read(params);
 	}
+	else if((strcmp(command, "reads") == 0 && *state == MAIN_MENU )){
+		read_sparse(params);
+	}
 	else if((strcmp(command, "config") == 0 && *state == MAIN_MENU )|| *state == CONFIG_MENU){
 
 		if(strcmp(command,"return")==0){
@@ -131,6 +195,55 @@ void handle_command(char* command,xtractParams * params,menuState_t * state){
 		write_config(config);
 
 	}
+	else if((strcmp(command, "prof") == 0 && *state == MAIN_MENU )){
+		profile_report(uart);
+	}
+	else if((strcmp(command, "profreset") == 0 && *state == MAIN_MENU )){
+#if PROFILING_ENABLED
+		profile_reset();
+		transmit_line(uart, "Profiling statistics cleared.");
+#else
+		transmit_line(uart, "Profiling is not enabled in this build.");
+#endif
+	}
+	else if((strcmp(command, "tasks") == 0 && *state == MAIN_MENU )){
+		task_report(uart);
+	}
+	else if((strcmp(command, "flash") == 0 && *state == MAIN_MENU )){
+		flash_service_report(uart);
+	}
+	else if((strcmp(command, "flashreset") == 0 && *state == MAIN_MENU )){
+		flash_service_reset_stats();
+		transmit_line(uart, "Flash service statistics cleared.");
+	}
+	else if((strcmp(command, "verify") == 0 && *state == MAIN_MENU )){
+		verify_flight(uart);
+	}
+	else if((strcmp(command, "crcbench") == 0 && *state == MAIN_MENU )){
+		crc_benchmark(uart);
+	}
+	else if((strcmp(command, "radio") == 0 && *state == MAIN_MENU )){
+		telemetry_report(uart);
+	}
+	else if((strcmp(command, "summary") == 0 && *state == MAIN_MENU )){
+		summary_log_report(uart);
+	}
+	else if((strcmp(command, "top") == 0 && *state == MAIN_MENU )){
+
+		uint8_t c = 0;
+
+		//Refresh with every new sample until a key is pressed.
+		while(HAL_UART_Receive(uart, &c, 1, 0) != HAL_OK){
+
+			transmit(uart, "\x1b[2J\x1b[H");
+			task_report(uart);
+			transmit_line(uart, "Press any key to stop.");
+			vTaskDelay(pdMS_TO_TICKS(TASK_MONITOR_PERIOD));
+		}
+	}
+	else if((strcmp(command, "buzztest") == 0 && *state == MAIN_MENU )){
+		buzzer_test(uart);
+	}
 	else if((strcmp(command, "start") == 0 && *state == MAIN_MENU )){
 
 		config->values.state = STATE_LAUNCHPAD_ARMED;
@@ -158,10 +271,22 @@ void help(UART_HandleTypeDef * uart){
 	transmit_line(uart, "Commands:\r\n"
 					"\t[help] - displays the help menu and more commands\r\n"
 					"\t[read] - Downloads flight data\r\n"
+					"\t[reads] - Downloads only the used parts of the flight data, for Tools/sparseDump\r\n"
 					"\t[config] - Setup flight computer\r\n"
 					"\t[ematch] - check and fire ematches\r\n"
 					"\t[mem] - Check on and erase the flash memory\r\n"
 					"\t[save] - Save all setting to the flight computer\r\n"
+					"\t[prof] - Show the profiling zone timings\r\n"
+					"\t[profreset] - Clear the profiling zone timings\r\n"
+					"\t[tasks] - Show the CPU use and free stack of each task\r\n"
+					"\t[top] - Keep showing the tasks until a key is pressed\r\n"
+					"\t[flash] - Show the flash service queue times of each request class\r\n"
+					"\t[flashreset] - Clear the flash service queue times\r\n"
+					"\t[verify] - Check the CRC of every log page without downloading them\r\n"
+					"\t[crcbench] - Compare the speed of the CRC unit and the software CRC\r\n"
+					"\t[radio] - Show the telemetry frames sent and the link budget\r\n"
+					"\t[summary] - Download the summary log from the internal flash\r\n"
+					"\t[buzztest] - Check that beeping does not hold up the tasks\r\n"
 					"\t[start] - Start the flight computer\r\n"
 					);
 }
@@ -170,7 +295,6 @@ void help(UART_HandleTypeDef * uart){
 void memory_menu(char* command, xtractParams * params){
 
 	UART_HandleTypeDef * uart = params->huart;
-	FlashStruct_t * flash = params->flash;
 	configData_t * config = params->flightCompConfig;
 
 	char output [256];
@@ -184,6 +308,10 @@ void memory_menu(char* command, xtractParams * params){
 						"\t[c] - Erase data section\r\n"
 						"\t[d] - Erase config section.\r\n"
 						"\t[e] - Erase all flash memory.\r\n"
+						"\t[f] - Show the flight event journal.\r\n"
+						"\t[g] - Erase the flight event journal.\r\n"
+						"\t[h] - Show the log pages moved to spare pages.\r\n"
+						"\t[i] - Erase the summary log in the internal flash.\r\n"
 						);
 
 	}
@@ -208,16 +336,7 @@ void memory_menu(char* command, xtractParams * params){
 			uint8_t data_rx[FLASH_PAGE_SIZE];
 
 			FlashStatus_t stat;
-			stat = read_page(flash,value,data_rx,FLASH_PAGE_SIZE);
-
-			uint8_t busy = stat;
-
-			while(IS_DEVICE_BUSY(busy)){
-
-				busy = get_status_reg(flash);
-
-				vTaskDelay(pdMS_TO_TICKS(1));
-			}
+			stat = flash_read(FLASH_CLASS_READ,value,data_rx,FLASH_PAGE_SIZE);
 
 			if(stat == FLASH_OK){
 				sprintf(output,"Success:");
@@ -252,10 +371,13 @@ void memory_menu(char* command, xtractParams * params){
 	else if (command[0] == 'b'){
 
 
-		uint32_t end_Address = scan_flash(flash);
+		uint32_t end_Address = flash_scan(FLASH_START_ADDRESS);
 		sprintf(output,"end address :%ld \n",end_Address);
 		transmit_line(uart,output);
 
+		sprintf(output,"%u of %u sectors used, log data up to %lu.",flash_map_count(),FLASH_MAP_SECTORS,log_data_end());
+		transmit_line(uart,output);
+
 		}
 	else if (command[0] == 'c'){
 
@@ -265,31 +387,38 @@ void memory_menu(char* command, xtractParams * params){
 			transmit_line(uart,output);
 
 			  uint32_t address = FLASH_START_ADDRESS;
-			  FlashStatus_t stat;
+			  FlashStatus_t stat = FLASH_OK;
+			  uint16_t erased = 0;
 			  while(address <= FLASH_END_ADDRESS){
 
+				  //Blank sectors are skipped. Waits for the erase to finish.
+				  if(flash_map_used(address)){
+
+					  sprintf(output,"Erasing sector %ld ...",address);
+					  transmit_line(uart,output);
+
+					  if(flash_erase(FLASH_CLASS_ERASE,address,NULL) != FLASH_OK){
+						  stat = FLASH_ERROR;
+					  }
+					  erased++;
+					  HAL_GPIO_TogglePin(USR_LED_PORT,USR_LED_PIN);
+				  }
+
 				  if(address>FLASH_PARAM_END_ADDRESS){
-				  stat = erase_sector(flash,address);
-				  address += FLASH_SECTOR_SIZE;
+					  address += FLASH_SECTOR_SIZE;
 				  }
 				  else{
-					  stat = erase_param_sector(flash,address);
 					  address += FLASH_PARAM_SECTOR_SIZE;
 				  }
-				  //Wait for erase to finish
-				  while(IS_DEVICE_BUSY(stat)){
-
-					  stat = get_status_reg(flash);
-
-					  vTaskDelay(pdMS_TO_TICKS(1));
-				  }
+			  }
 
-				  HAL_GPIO_TogglePin(USR_LED_PORT,USR_LED_PIN);
-					sprintf(output,"Erasing sector %ld ...",address);
-					transmit_line(uart,output);
+			  if(flash_map_commit() != FLASH_OK){
+				  stat = FLASH_ERROR;
 			  }
+			  sprintf(output,"%u of %u sectors erased, the rest were blank.",erased,FLASH_MAP_SECTORS);
+			  transmit_line(uart,output);
 
-			  read_page(flash,FLASH_START_ADDRESS,dataRX,256);
+			  flash_read(FLASH_CLASS_READ,FLASH_START_ADDRESS,dataRX,256);
 			  uint16_t empty = 0xFFFF;
 			  	  int i;
 			  for(i=0;i<256;i++){
@@ -304,6 +433,9 @@ void memory_menu(char* command, xtractParams * params){
 				  transmit_line(uart,"Flash Erased Success!");
 			  }
 
+			  //The log index sector was erased with the rest.
+			  log_index_init();
+
 			if(stat == FLASH_OK){
 				sprintf(output,"Success:");
 			}
@@ -318,9 +450,44 @@ void memory_menu(char* command, xtractParams * params){
 		}
 	else if (command[0] == 'd'){
 
+			configStatus_t stat = erase_config(config);
+
+			if(stat == CONFIG_OK){
+				sprintf(output,"Config Erased Success!");
+			}
+			else{
+				sprintf(output,"Failed:");
+			}
+			transmit_line(uart,output);
 		}
 	else if (command[0] == 'f'){
 
+			event_journal_report(uart);
+		}
+	else if (command[0] == 'g'){
+
+			if(event_journal_erase() == EVENT_JOURNAL_OK){
+				sprintf(output,"Event Journal Erased Success!");
+			}
+			else{
+				sprintf(output,"Failed:");
+			}
+			transmit_line(uart,output);
+		}
+	else if (command[0] == 'h'){
+
+			log_index_report(uart);
+		}
+	else if (command[0] == 'i'){
+
+			//The CPU stalls for about a second.
+			if(summary_log_erase() == SUMMARY_LOG_OK){
+				sprintf(output,"Summary Log Erased Success!");
+			}
+			else{
+				sprintf(output,"Failed:");
+			}
+			transmit_line(uart,output);
 		}
 
 }
@@ -328,7 +495,6 @@ void memory_menu(char* command, xtractParams * params){
 void ematch(char* command, xtractParams * params){
 
 	UART_HandleTypeDef * uart = params->huart;
-	FlashStruct_t * flash = params->flash;
 	configData_t * config = params->flightCompConfig;
 
 	char output [256];
@@ -445,7 +611,7 @@ void ematch(char* command, xtractParams * params){
 				sprintf(output,"DROGUE WILL FIRE IN %d SECONDS!.\n",time_left/1000);
 				transmit_line(uart,output);
 			}
-			activate_mosfet(event);
+			fire_ematch(uart,event);
 		}
 	else if (command[0] == 'i'){
 
@@ -463,7 +629,7 @@ void ematch(char* command, xtractParams * params){
 			sprintf(output,"MAIN WILL FIRE IN %d SECONDS!.\n",time_left/1000);
 			transmit_line(uart,output);
 		}
-			activate_mosfet(event);
+			fire_ematch(uart,event);
 
 		}
 	else if (command[0] == 'j'){
@@ -490,7 +656,6 @@ void ematch(char* command, xtractParams * params){
 void configure(char* command,xtractParams * params){
 
 	UART_HandleTypeDef * uart = params->huart;
-	FlashStruct_t * flash = params->flash;
 	configData_t * config = params->flightCompConfig;
 
 	char output [256];
@@ -500,7 +665,20 @@ void configure(char* command,xtractParams * params){
 		transmit_line(uart, "Commands:\r\n"
 						"\t[help] - displays the help menu and more commands\r\n"
 						"\t[return] - Return to main menu\r\n"
-						"\t[a] - Set data rate Hz(0-100)\r\n"
+						"\t[a] - Set accelerometer sample rate Hz(1-2000)\r\n"
+						"\t[o] - Set gyroscope sample rate Hz(1-2000)\r\n"
+						"\t[p] - Set BMP388 sample rate Hz(1-200)\r\n"
+						"\t(Sample rates apply after a reset. Set the sensor odr at least as high.)\r\n"
+						"\t[r] - Set logging rate on the pad Hz(0-2000)\r\n"
+						"\t[s] - Set logging rate in the ascent Hz(0-2000)\r\n"
+						"\t[t] - Set logging rate under the drogue Hz(0-2000)\r\n"
+						"\t[u] - Set logging rate under the main Hz(0-2000)\r\n"
+						"\t(Readings are averaged down to the logging rate, 0 logs every reading.)\r\n"
+						"\t[v] - Show the flash used by each flight phase and how much flight fits\r\n"
+						"\t[w] - Set the capture window before launch, deployments and shocks ms(0-2550)\r\n"
+						"\t[x] - Set the capture window after them ms(0-2550)\r\n"
+						"\t[y] - Set the shock that starts a capture window g(0-24, 0 for none)\r\n"
+						"\t(Every reading in the windows is logged. Before is limited by the 256 readings kept in RAM.)\r\n"
 						"\t[z] - Set the initial time to wait (0-10000000)\r\n"
 						"\t[b] - set if recording to flash (1/0)\r\n"
 						"\t[c] - set accelerometer bandwidth (0,2,4)\r\n"
@@ -527,16 +705,107 @@ void configure(char* command,xtractParams * params){
 		strcpy(val_str,&command[1]);
 
 		int value = atoi(val_str);
-		if( value >0 && value <=100){
+		if( value >0 && value <=ACQ_MAX_IMU_RATE){
 
-			sprintf(output,"Setting data rate to %d Hz.\n",value);
+			sprintf(output,"Setting accelerometer sample rate to %d Hz.\n",value);
 
 			transmit_line(uart,output);
-			config->values.data_rate = 1000/value;
+			config->values.acc_rate = value;
 
 		}
 
 
+	}
+	else if (command[0] == 'o'){
+
+		char val_str[10];
+
+		strcpy(val_str,&command[1]);
+
+		int value = atoi(val_str);
+		if( value >0 && value <=ACQ_MAX_IMU_RATE){
+
+			sprintf(output,"Setting gyroscope sample rate to %d Hz.\n",value);
+
+			transmit_line(uart,output);
+			config->values.gyro_rate = value;
+
+		}
+	}
+	else if (command[0] == 'p'){
+
+		char val_str[10];
+
+		strcpy(val_str,&command[1]);
+
+		int value = atoi(val_str);
+		if( value >0 && value <=ACQ_MAX_BMP_RATE){
+
+			sprintf(output,"Setting BMP388 sample rate to %d Hz.\n",value);
+
+			transmit_line(uart,output);
+			config->values.bmp_rate = value;
+
+		}
+	}
+	else if (command[0] >= 'r' && command[0] <= 'u'){
+
+		static const char * phase_names[LOG_PHASES] = { "on the pad", "in the ascent", "under the drogue", "under the main" };
+		uint8_t phase = LOG_PHASE_PAD + (command[0] - 'r');
+
+		char val_str[10];
+
+		strcpy(val_str,&command[1]);
+
+		int value = atoi(val_str);
+		if(val_str[0] >= '0' && val_str[0] <= '9' && value <= LOG_RATE_MAX){
+
+			sprintf(output,"Setting logging rate %s to %d Hz.\n",phase_names[phase],value);
+
+			transmit_line(uart,output);
+			config->values.log_rate[phase] = value;
+		}
+	}
+	else if (command[0] == 'v'){
+
+		log_capacity_report(uart,config);
+	}
+	else if (command[0] == 'w' || command[0] == 'x'){
+
+		char val_str[10];
+
+		strcpy(val_str,&command[1]);
+
+		int value = atoi(val_str);
+		if(val_str[0] >= '0' && val_str[0] <= '9' && value <= 255*CAPTURE_WINDOW_UNIT){
+
+			value /= CAPTURE_WINDOW_UNIT;
+
+			sprintf(output,"Setting capture window %s to %d ms.\n",(command[0] == 'w') ? "before" : "after",value*CAPTURE_WINDOW_UNIT);
+
+			transmit_line(uart,output);
+			if(command[0] == 'w'){
+				config->values.capture_pre = value;
+			}
+			else{
+				config->values.capture_post = value;
+			}
+		}
+	}
+	else if (command[0] == 'y'){
+
+		char val_str[10];
+
+		strcpy(val_str,&command[1]);
+
+		int value = atoi(val_str);
+		if(val_str[0] >= '0' && val_str[0] <= '9' && value <= 24){
+
+			sprintf(output,"Setting capture shock level to %d g.\n",value);
+
+			transmit_line(uart,output);
+			config->values.capture_shock = value;
+		}
 	}
 	else if (command[0] == 'z'){
 
@@ -1033,7 +1302,18 @@ void configure(char* command,xtractParams * params){
 		sprintf(output,"ID: %d \tIntitial Time To Wait: %ld \r\n",config->values.id,config->values.initial_time_to_wait);
 		transmit_line(uart,output);
 
-		sprintf(output,"data rate: %d Hz \tSet to record: %d \r\n",1000/config->values.data_rate,IS_RECORDING(config->values.flags));
+		sprintf(output,"acc rate: %d Hz \tgyro rate: %d Hz \tBMP388 rate: %d Hz \r\n",config->values.acc_rate,config->values.gyro_rate,config->values.bmp_rate);
+		transmit_line(uart,output);
+
+		sprintf(output,"Set to record: %d \r\n",IS_RECORDING(config->values.flags));
+		transmit_line(uart,output);
+
+		sprintf(output,"logging rates: pad %d Hz \tascent %d Hz \tdrogue %d Hz \tmain %d Hz \r\n",config->values.log_rate[LOG_PHASE_PAD],
+				config->values.log_rate[LOG_PHASE_ASCENT],config->values.log_rate[LOG_PHASE_DROGUE],config->values.log_rate[LOG_PHASE_MAIN]);
+		transmit_line(uart,output);
+
+		sprintf(output,"capture windows: before %d ms \tafter %d ms \tshock %d g \r\n",config->values.capture_pre*CAPTURE_WINDOW_UNIT,
+				config->values.capture_post*CAPTURE_WINDOW_UNIT,config->values.capture_shock);
 		transmit_line(uart,output);
 
 		sprintf(output,"start of data: %ld \tend of data: %ld \r\n",config->values.start_data_address,config->values.end_data_address);
@@ -1074,46 +1354,597 @@ void configure(char* command,xtractParams * params){
 
 }
 
+//Sends each buffer of the stream, run by the flash service task.
+static uint8_t read_callback(void * context,uint32_t address,uint8_t * data,uint16_t length){
+
+	transmit_bytes((UART_HandleTypeDef *)context,data,length);
+
+	return 1;
+}
+
+//Streams the log from start up to end. A remapped page is read from its spare page into the first buffer and given to
+//the callback in its place.
+static void stream_log(uint32_t start,uint32_t end,FlashStream_t * stream){
+
+	uint32_t address = start;
+
+	while(address < end){
+
+		uint32_t remapped = log_index_next(address);
+
+		if(remapped > end){
+			remapped = end;
+		}
+		if(remapped > address){
+			flash_stream(FLASH_CLASS_READ,address,remapped - address,stream);
+		}
+		if(remapped < end){
+
+			flash_read(FLASH_CLASS_READ,log_index_lookup(remapped),stream->buffers[0],FLASH_PAGE_SIZE);
+			stream->callback(stream->context,remapped,stream->buffers[0],FLASH_PAGE_SIZE);
+			remapped += FLASH_PAGE_SIZE;
+		}
+		address = remapped;
+	}
+}
+
+//Counts the pages of each buffer with a bad CRC, and the ones left from an earlier log or written to the wrong place.
+static uint8_t verify_callback(void * context,uint32_t address,uint8_t * data,uint16_t length){
+
+	verifyCount_t * count = (verifyCount_t *)context;
+	uint16_t i;
+
+	for(i=0;i + LOG_PAGE_SIZE <= length;i+=LOG_PAGE_SIZE){
+
+		uint16_t sequence = (address + i - FLASH_START_ADDRESS)/LOG_PAGE_SIZE;
+
+		if(!log_page_check(&data[i])){
+
+			if(count->bad == 0){
+				count->first_bad = address + i;
+			}
+			count->bad++;
+		}
+		else if(log_page_sequence(&data[i]) != sequence){
+
+			if(count->misplaced == 0){
+				count->first_misplaced = address + i;
+			}
+			count->misplaced++;
+		}
+		count->pages++;
+	}
+
+	return 1;
+}
+
+//Finds the end of the last page with data in a range, reading back from its end.
+static uint32_t trim_range(uint32_t start,uint32_t end){
+
+	uint8_t * data = read_buffers[0];
+
+	while(end > start){
+
+		uint16_t length = (end - start < sizeof(read_buffers[0])) ? end - start : sizeof(read_buffers[0]);
+		uint16_t i;
+
+		flash_read(FLASH_CLASS_READ,end - length,data,length);
+
+		for(i=length;i>0;i--){
+			if(data[i-1] != 0xFF){
+				return end - length + ((i + FLASH_PAGE_SIZE - 1)/FLASH_PAGE_SIZE)*FLASH_PAGE_SIZE;
+			}
+		}
+		end -= length;
+	}
+
+	return start;
+}
+
+//The end of the last page with data in the used sectors of the log. Blank sectors before it are not a stop.
+static uint32_t log_data_end(void){
+
+	uint32_t address = FLASH_START_ADDRESS;
+	uint32_t last = FLASH_START_ADDRESS;
+	uint32_t range_end;
+
+	while((address = flash_map_next(address,FLASH_SIZE_BYTES,&range_end)) < FLASH_SIZE_BYTES){
+
+		uint32_t data_end = trim_range(address,range_end);
+
+		if(data_end > address){
+			last = data_end;
+		}
+		address = range_end;
+	}
+
+	return last;
+}
+
+static void send_range_header(UART_HandleTypeDef * uart,uint32_t address,uint32_t length){
+
+	uint8_t header[XTRACT_RANGE_HEADER_SIZE];
+	uint8_t i;
+
+	memcpy(header,XTRACT_RANGE_MARKER,4);
+	for(i=0;i<4;i++){
+		header[4+i] = (address >> (24-8*i)) & 0xFF;
+		header[8+i] = (length >> (24-8*i)) & 0xFF;
+	}
+	transmit_bytes(uart,header,XTRACT_RANGE_HEADER_SIZE);
+}
+
+void read_sparse(xtractParams * params){
+
+	UART_HandleTypeDef * uart = params->huart;
+	FlashStream_t stream;
+	uint32_t address = FLASH_START_ADDRESS;
+	uint32_t range_end;
+
+	HAL_GPIO_WritePin(USR_LED_PORT,USR_LED_PIN,GPIO_PIN_RESET);
+	transmit_line(uart, "Data transfer will start in 10 seconds. The LED will turn off when the transfer is complete.");
+
+	stream.buffers[0] = read_buffers[0];
+	stream.buffers[1] = read_buffers[1];
+	stream.buffer_size = sizeof(read_buffers[0]);
+	stream.callback = read_callback;
+	stream.context = uart;
+
+	vTaskDelay(pdMS_TO_TICKS(1000*10));
+
+	HAL_GPIO_WritePin(USR_LED_PORT,USR_LED_PIN,GPIO_PIN_SET);
+
+	while((address = flash_map_next(address,FLASH_SIZE_BYTES,&range_end)) < FLASH_SIZE_BYTES){
+
+		uint32_t data_end = trim_range(address,range_end);
+
+		if(data_end > address){
+			send_range_header(uart,address,data_end - address);
+			stream_log(address,data_end,&stream);
+		}
+		address = range_end;
+	}
+	send_range_header(uart,address,0);
+
+	HAL_GPIO_WritePin(USR_LED_PORT,USR_LED_PIN,GPIO_PIN_RESET);
+}
+
 void read(xtractParams * params){
 
 	UART_HandleTypeDef * uart = params->huart;
-	FlashStruct_t * flash = params->flash;
 	configData_t * config = params->flightCompConfig;
 
 	HAL_GPIO_WritePin(USR_LED_PORT,USR_LED_PIN,GPIO_PIN_RESET);
 	transmit_line(uart, "Data transfer will start in 20 seconds. The LED will turn off when the transfer is complete.");
 
-	uint8_t buffer[256*5]; 	//Read 5 pages from flash at a time;
+	FlashStream_t stream;
 
-	uint32_t bytesRead = 0;
-	uint32_t currentAddress = FLASH_START_ADDRESS;
+	stream.buffers[0] = read_buffers[0];
+	stream.buffers[1] = read_buffers[1];
+	stream.buffer_size = sizeof(read_buffers[0]);
+	stream.callback = read_callback;
+	stream.context = uart;
 
 	vTaskDelay(pdMS_TO_TICKS(1000*10));	//Delay 10 seconds
 
 	HAL_GPIO_WritePin(USR_LED_PORT,USR_LED_PIN,GPIO_PIN_SET);
-	uint32_t endAddress = scan_flash(flash);
-	while (bytesRead < endAddress){
+	uint32_t endAddress = log_data_end();
 
-		read_page(flash,currentAddress,buffer,256*5);
+	stream_log(FLASH_START_ADDRESS,endAddress,&stream);
 
-		int i;
-		uint16_t empty =0 ;
-		for(i=0;i<256*5;i++){
+	HAL_GPIO_WritePin(USR_LED_PORT,USR_LED_PIN,GPIO_PIN_RESET);
+}
+
+void profile_report(UART_HandleTypeDef * uart){
+
+#if PROFILING_ENABLED
+	char output[128];
+	profileStats_t stats;
+	uint32_t cycles_per_us = SystemCoreClock/1000000;
+	uint8_t zone;
+	uint8_t bin;
+
+	sprintf(output,"Zone             count        min       mean        max  (cycles, %lu per us)",(unsigned long)cycles_per_us);
+	transmit_line(uart,output);
+
+	for(zone=0;zone<PROFILE_ZONE_COUNT;zone++){
+
+		profile_get(zone,&stats);
+
+		uint32_t mean = (stats.count == 0) ? 0 : (uint32_t)(stats.total/stats.count);
+
+		sprintf(output,"%-14s %7lu %10lu %10lu %10lu  (%lu/%lu/%lu us)",profile_zone_name(zone),(unsigned long)stats.count,
+				(unsigned long)stats.min,(unsigned long)mean,(unsigned long)stats.max,
+				(unsigned long)(stats.min/cycles_per_us),(unsigned long)(mean/cycles_per_us),(unsigned long)(stats.max/cycles_per_us));
+		transmit_line(uart,output);
+
+		for(bin=0;bin<PROFILE_HIST_BINS;bin++){
 
-			if(buffer[i] == 0xFF){
-				empty += 1;
+			if(stats.histogram[bin] != 0){
+
+				//Bin 0 also holds everything below its lower limit.
+				uint32_t upper = 1UL << (bin + PROFILE_HIST_SHIFT + 1);
+				uint32_t lower = (bin == 0) ? 0 : upper/2;
+
+				if(bin == PROFILE_HIST_BINS - 1){
+					sprintf(output,"    >= %lu: %lu",(unsigned long)lower,(unsigned long)stats.histogram[bin]);
+				}
+				else{
+					sprintf(output,"    %lu - %lu: %lu",(unsigned long)lower,(unsigned long)(upper-1),(unsigned long)stats.histogram[bin]);
+				}
+				transmit_line(uart,output);
 			}
 		}
-		if(empty == (256*5)){
-			break;
-		}
-		transmit_bytes(uart,buffer,256*5);
+	}
+#else
+	transmit_line(uart, "Profiling is not enabled in this build. Rebuild with PROFILING_ENABLED set to 1.");
+#endif
+}
+
+void task_report(UART_HandleTypeDef * uart){
 
-		currentAddress += (256*5);
-		currentAddress = currentAddress % FLASH_SIZE_BYTES;
+	static const char * const state_names[] = {"running","ready","blocked","suspended","deleted"};
+
+	char output[128];
+	taskMonitorEntry_t entries[TASK_MONITOR_MAX_TASKS];
+	uint8_t count = task_monitor_get(entries,TASK_MONITOR_MAX_TASKS);
+	uint8_t i;
+
+	if(count == 0){
+		transmit_line(uart,"No task statistics yet.");
+		return;
+	}
+
+	transmit_line(uart,"  # Task             State      Prio    CPU  Free stack (words)");
+
+	for(i=0;i<count;i++){
+
+		const char * state = (entries[i].state <= eDeleted) ? state_names[entries[i].state] : "?";
+
+		sprintf(output,"%3u %-16s %-10s %4u %3u.%u%%  %u",entries[i].number,entries[i].name,state,entries[i].priority,
+				entries[i].cpu_permille/10,entries[i].cpu_permille%10,entries[i].stack_free);
+		transmit_line(uart,output);
+	}
+}
+
+void buzzer_test(UART_HandleTypeDef * uart){
+
+	char output[128];
+	uint32_t start;
+	uint32_t prev;
+	uint32_t now;
+	uint32_t gap;
+	uint32_t max_gap = 0;
+	uint32_t loops = 0;
+
+	transmit_line(uart,"Beeping for 1 s...");
+
+	//Stands in for a sensor task sampling at 1 kHz.
+	buzz(1000);
+	start = hr_timer_now();
+	prev = start;
+	now = start;
+
+	while(buzzer_busy()){
 
-		bytesRead += 256*5;
 		vTaskDelay(1);
+
+		now = hr_timer_now();
+		gap = now - prev;
+		if(gap > max_gap){
+			max_gap = gap;
+		}
+		prev = now;
+		loops++;
 	}
-	HAL_GPIO_WritePin(USR_LED_PORT,USR_LED_PIN,GPIO_PIN_RESET);
+
+	sprintf(output,"Beep took %lu us. The 1 ms loop ran %lu times, longest gap %lu us: %s",now - start,loops,max_gap,
+			(max_gap < 2000 && loops > 900) ? "PASS" : "FAIL");
+	transmit_line(uart,output);
+}
+
+void fire_ematch(UART_HandleTypeDef * uart,recoverySelect_t event){
+
+	char output[128];
+	pyroEvent_t result;
+	uint16_t waited = 0;
+
+	if(activate_mosfet(event) != PYRO_OK){
+
+		transmit_line(uart,"The e-match is already firing.");
+		return;
+	}
+
+	//The pulse is timed in the background, wait for its result.
+	while(!pyro_get_event(&result)){
+
+		if(waited++ > EMATCH_ON_TIME + 100){
+
+			transmit_line(uart,"No result from the e-match pulse.");
+			return;
+		}
+		vTaskDelay(pdMS_TO_TICKS(1));
+	}
+
+	sprintf(output,"%s pulse %lu us, %s, %s.",(result.channel == MAIN) ? "MAIN" : "DROGUE",result.pulse_width,
+			(result.continuity == OPEN_CIRCUIT) ? "no continuity after" : "continuity after (did not fire or driver not armed)",
+			(result.overcurrent == OVERCURRENT) ? "overcurrent" : "no overcurrent");
+	transmit_line(uart,output);
+}
+
+void log_capacity_report(UART_HandleTypeDef * uart,configData_t * config){
+
+	static const char * phase_names[LOG_PHASES] = { "pad", "ascent", "drogue", "main" };
+	static const uint16_t projection_times[LOG_PHASES] = { 0, PROJECTION_ASCENT_TIME, PROJECTION_DROGUE_TIME, PROJECTION_MAIN_TIME };
+
+	char output[128];
+	uint32_t periods[3];
+	uint32_t free_bytes = 0;
+	uint32_t flight_bytes = LOG_PAD_PAGES*LOG_PAGE_SIZE;		//The pad buffer is written out at launch.
+	uint8_t phase;
+
+	periods[0] = acquisition_rate_period(config->values.acc_rate,ACQ_MAX_IMU_RATE);
+	periods[1] = acquisition_rate_period(config->values.gyro_rate,ACQ_MAX_IMU_RATE);
+	periods[2] = acquisition_rate_period(config->values.bmp_rate,ACQ_MAX_BMP_RATE);
+
+	if(config->values.end_data_address < FLASH_SIZE_BYTES){
+		free_bytes = FLASH_SIZE_BYTES - config->values.end_data_address;
+	}
+
+	sprintf(output,"Free flash: %lu bytes.\r\nphase \tlog Hz \tbytes/s \tminutes that fit",free_bytes);
+	transmit_line(uart,output);
+
+	for(phase=0;phase<LOG_PHASES;phase++){
+
+		uint32_t rate = log_rate_bytes_per_second(periods,config->values.log_rate[phase]);
+
+		if(phase == LOG_PHASE_PAD){
+
+			//Only the last LOG_PAD_PAGES pages on the pad go to flash.
+			sprintf(output,"%s \t%d \t%lu \t(%lu s kept in RAM)",phase_names[phase],config->values.log_rate[phase],rate,
+					(uint32_t)(LOG_PAD_PAGES*LOG_PAGE_SIZE)/rate);
+		}
+		else{
+
+			flight_bytes += rate*projection_times[phase];
+			sprintf(output,"%s \t%d \t%lu \t%lu",phase_names[phase],config->values.log_rate[phase],rate,free_bytes/rate/60);
+		}
+		transmit_line(uart,output);
+	}
+
+	sprintf(output,"A flight of %d s ascent, %d s drogue and %d s main uses %lu bytes, %lu%% of the free flash.",
+			PROJECTION_ASCENT_TIME,PROJECTION_DROGUE_TIME,PROJECTION_MAIN_TIME,flight_bytes,
+			(free_bytes == 0) ? 100 : (uint32_t)(((uint64_t)flight_bytes*100)/free_bytes));
+	transmit_line(uart,output);
+}
+
+void event_journal_report(UART_HandleTypeDef * uart){
+
+	char output[160];
+	eventRecord_t record;
+	uint16_t count = 0;
+	uint16_t i;
+	uint8_t k;
+
+	transmit_line(uart,"seq 	time us 	flight ms 	state 	alt m 	filtered m 	log address 	events");
+
+	for(i=0;i<EVENT_JOURNAL_SLOTS;i++){
+
+		if(event_journal_read(i,&record) != EVENT_JOURNAL_OK){
+			continue;
+		}
+
+		int length = sprintf(output,"%lu \t%lu \t%lu \t%d \t%ld \t%ld \t%lu \t",record.sequence,record.time_us,record.flight_time,record.state,
+				(int32_t)record.altitude,(int32_t)record.alt_filtered,record.log_address);
+
+		for(k=0;k<sizeof(event_names)/sizeof(event_names[0]);k++){
+			if(((uint32_t)record.events << EXT_KIND_SHIFT) & event_names[k].bit){
+				length += sprintf(&output[length],"%s ",event_names[k].name);
+			}
+		}
+
+		transmit_line(uart,output);
+		count++;
+	}
+
+	sprintf(output,"%d events.",count);
+	transmit_line(uart,output);
+}
+
+void flash_service_report(UART_HandleTypeDef * uart){
+
+	static const char * class_names[FLASH_CLASSES] = {"event","config","data","erase","read"};
+
+	char output[128];
+	flashClassStats_t stats;
+	uint8_t i;
+
+	transmit_line(uart,"class \tcount \tmerged \tmean wait us \tmax wait us \tmax busy us \tmax us in erase \tsuspends \terrors");
+
+	for(i=0;i<FLASH_CLASSES;i++){
+
+		flash_service_stats(i,&stats);
+
+		sprintf(output,"%s \t%lu \t%lu \t%lu \t%lu \t%lu \t%lu \t%lu \t%lu",class_names[i],stats.count,stats.merged,
+				(stats.count == 0) ? 0 : (uint32_t)(stats.wait_total/stats.count),stats.wait_max,stats.busy_max,
+				stats.erase_latency_max,stats.suspends,stats.errors);
+		transmit_line(uart,output);
+	}
+
+	//The service runs above the sensor tasks, so readings missed while it is busy show up here.
+	sprintf(output,"readings missed 	acc %lu 	gyro %lu 	bmp %lu",acquisition_missed(ACQ_ACC),acquisition_missed(ACQ_GYRO),
+			acquisition_missed(ACQ_BMP));
+	transmit_line(uart,output);
+}
+
+void log_index_report(UART_HandleTypeDef * uart){
+
+	char output[64];
+	uint16_t count = log_index_count();
+	uint16_t n;
+
+	transmit_line(uart,"log page \tspare page");
+
+	for(n=0;n<count;n++){
+
+		sprintf(output,"%lu \t%lu",log_index_entry(n),(uint32_t)LOG_SPARE_ADDRESS + (uint32_t)n*FLASH_PAGE_SIZE);
+		transmit_line(uart,output);
+	}
+
+	sprintf(output,"%d pages remapped, %d spare pages left.",count,LOG_SPARE_PAGES - count);
+	transmit_line(uart,output);
+}
+
+void verify_flight(UART_HandleTypeDef * uart){
+
+	char output[128];
+	verifyCount_t count;
+	FlashStream_t stream;
+	uint32_t end;
+	uint32_t start;
+	uint32_t elapsed;
+
+	memset(&count,0,sizeof(count));
+
+	stream.buffers[0] = read_buffers[0];
+	stream.buffers[1] = read_buffers[1];
+	stream.buffer_size = sizeof(read_buffers[0]);
+	stream.callback = verify_callback;
+	stream.context = &count;
+
+	start = hr_timer_now();
+	end = flash_scan(FLASH_START_ADDRESS);
+	stream_log(FLASH_START_ADDRESS,end,&stream);
+	elapsed = hr_timer_now() - start;
+
+	if(count.bad == 0){
+		sprintf(output,"%lu pages checked, all good.",count.pages);
+	}
+	else{
+		sprintf(output,"%lu pages checked, %lu with a bad CRC. The first is at %lu.",count.pages,count.bad,count.first_bad);
+	}
+	transmit_line(uart,output);
+
+	if(count.misplaced > 0){
+		sprintf(output,"%lu pages out of place. The first is at %lu.",count.misplaced,count.first_misplaced);
+		transmit_line(uart,output);
+	}
+
+	sprintf(output,"Took %lu ms, %lu KB/s.",elapsed/1000,(elapsed == 0) ? 0 : (uint32_t)(((uint64_t)count.pages*LOG_PAGE_SIZE*1000)/elapsed));
+	transmit_line(uart,output);
+}
+
+void crc_benchmark(UART_HandleTypeDef * uart){
+
+	static const uint16_t runs = 100;
+
+	char output[128];
+	uint8_t * data = read_buffers[0];
+	uint32_t length = sizeof(read_buffers);
+	uint32_t crc_software = 0;
+	uint32_t crc_hardware = 0;
+	uint32_t software_us;
+	uint32_t hardware_us;
+	uint32_t start;
+	uint32_t i;
+
+	//Same data every time, a hash of the index.
+	for(i=0;i<length;i++){
+		data[i] = (i*1103515245 + 12345) >> 16;
+	}
+
+	start = hr_timer_now();
+	for(i=0;i<runs;i++){
+		crc_software = crc32_software(data,length);
+	}
+	software_us = hr_timer_now() - start;
+
+	start = hr_timer_now();
+	for(i=0;i<runs;i++){
+		crc_hardware = crc32_hardware(data,length);
+	}
+	hardware_us = hr_timer_now() - start;
+
+	//Bytes per us is MB/s.
+	sprintf(output,"software: %lu bytes x %d in %lu us, %lu.%02lu MB/s",length,runs,software_us,
+			(length*runs)/software_us,(((length*runs)%software_us)*100)/software_us);
+	transmit_line(uart,output);
+	sprintf(output,"hardware: %lu bytes x %d in %lu us, %lu.%02lu MB/s",length,runs,hardware_us,
+			(length*runs)/hardware_us,(((length*runs)%hardware_us)*100)/hardware_us);
+	transmit_line(uart,output);
+	sprintf(output,"CRCs %s (%08lX, %08lX).",(crc_software == crc_hardware) ? "match" : "DO NOT MATCH",crc_software,crc_hardware);
+	transmit_line(uart,output);
+}
+
+void telemetry_report(UART_HandleTypeDef * uart){
+
+	char output[128];
+	uint32_t frames;
+	uint32_t bytes;
+	uint32_t seconds = xTaskGetTickCount()/configTICK_RATE_HZ;
+
+	telemetry_stats(&frames,&bytes);
+
+	sprintf(output,"%lu frames, %lu bytes in %lu s, %lu bytes/s.",frames,bytes,seconds,(seconds == 0) ? 0 : bytes/seconds);
+	transmit_line(uart,output);
+	sprintf(output,"Budget %lu bytes/s, %d%% of %d baud.",tlm_budget(TELEMETRY_BAUD_RATE,TELEMETRY_BUDGET_PERCENT),
+			TELEMETRY_BUDGET_PERCENT,TELEMETRY_BAUD_RATE);
+	transmit_line(uart,output);
+}
+
+void summary_log_report(UART_HandleTypeDef * uart){
+
+	char output[160];
+	summaryRecord_t record;
+	uint16_t count = summary_log_count();
+	uint16_t bad = 0;
+	uint16_t i;
+	uint8_t k;
+
+	transmit_line(uart,"record \ttime ms \tstate \tkind \tvalues");
+
+	for(i=0;i<count;i++){
+
+		int length = sprintf(output,"%u \t",i);
+
+		if(summary_log_read(i,&record) != SUMMARY_LOG_OK){
+
+			sprintf(&output[length],"- \t- \tbad");
+			transmit_line(uart,output);
+			bad++;
+			continue;
+		}
+
+		length += sprintf(&output[length],"%lu \t%d \t",record.time_ms,record.state);
+
+		switch(record.kind){
+
+			case SUMMARY_KIND_BOOT:
+				sprintf(&output[length],"boot \treset flags 0x%02X \twarm %d \tlog address %lu",record.reset_flags,record.warm,record.log_address);
+				break;
+
+			case SUMMARY_KIND_STATE:
+				sprintf(&output[length],"state \talt cm %ld \tfiltered cm %ld",(int32_t)(record.altitude*100),(int32_t)(record.alt_filtered*100));
+				break;
+
+			case SUMMARY_KIND_EVENT:
+				length += sprintf(&output[length],"event \tlog address %lu \t",record.log_address);
+				for(k=0;k<sizeof(event_names)/sizeof(event_names[0]);k++){
+					if(((uint32_t)record.events << EXT_KIND_SHIFT) & event_names[k].bit){
+						length += sprintf(&output[length],"%s ",event_names[k].name);
+					}
+				}
+				break;
+
+			case SUMMARY_KIND_HEALTH:
+				sprintf(&output[length],"health \tflash errors %u \tacc %u \tbmp %u \tremapped %u \tdropped %u",record.flash_errors,
+						record.acc_readings,record.bmp_readings,record.remapped,record.dropped);
+				break;
+		}
+
+		transmit_line(uart,output);
+	}
+
+	sprintf(output,"%u records, %u bad, %u left.",count,bad,SUMMARY_RECORDS - count);
+	transmit_line(uart,output);
 }
@@ -0,0 +1,495 @@
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// UMSATS 2018-2020
+//
+// Repository:
+//  UMSATS/Avionics-2019
+//
+// File Description:
+//  Host emulator of the flash service scheduling, for the write latency while the journals are being erased.
+//
+//  Models the flash memory (SPI transfer time, page program time, erase time, suspend time) and follows the same
+//  rules as flashService.c: one queue per request class served in class order, erases run in the background and are
+//  suspended for requests outside the sector being erased, a resumed erase runs for at least FLASH_RESUME_RUN_US, and
+//  the service only sees the end of an erase on a request or on the next tick. Log pages, event records and
+//  configuration records are queued at the given rates while erases are queued back to back, the worst case.
+//  The same requests are run with and without erase suspend, and the latency from queuing to finishing of each
+//  class is printed.
+//
+//  The service runs above the sensor tasks. While it holds the CPU a sensor that comes due twice only gets one
+//  notification, so a reading is missed. It holds the CPU for the SPI transfers, and blocks between status polls every
+//  FLASH_POLL_US. A third run holds the CPU until each program ends, as the service did before it blocked between
+//  polls, to compare the readings missed.
+//
+//  Build (from the repository root):
+//   gcc -O2 Tools/flashLatency.c -o flashLatency
+//
+// History
+// 2026-10-19
+// - The default SPI clock is 10.5 MHz, the same as SPI1.
+// - -V reads back each log page after it is programmed, as the logging task does, and the flash busy time is printed.
+// - Created.
+// - Counts the IMU readings missed while the service holds the CPU, -I sets the IMU rate.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// DEFINITIONS AND MACROS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//Must match flashService.h and flash.h.
+#define FLASH_CLASS_EVENT			0
+#define FLASH_CLASS_CONFIG			1
+#define FLASH_CLASS_DATA			2
+#define FLASH_CLASS_ERASE			3
+#define FLASH_CLASSES				4			//No reads are modelled.
+#define FLASH_SUSPEND_TIME_US		45
+#define FLASH_RESUME_RUN_US			100
+#define FLASH_POLL_US				100
+#define TICK_US						1000
+
+//Data sheet times.
+#define PROGRAM_TIME_TYP_US			700
+#define PROGRAM_TIME_MAX_US			3000
+#define ERASE_TIME_TYP_US			500000		//64 KB sector.
+#define ERASE_TIME_MAX_US			2000000
+
+#define SPI_CLOCK_KHZ				10500		//SPI1 at /8.
+#define COMMAND_BYTES				4
+#define EVENT_RECORD_SIZE			32
+#define CONFIG_RECORD_SIZE			64
+
+#define MAX_QUEUED					4096
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// STRUCTS AND STRUCT TYPEDEFS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+typedef struct{
+
+	int64_t queued;
+	uint16_t bytes;				//Bytes programmed, 0 for an erase.
+	uint8_t in_erase;			//1 if it is for the sector being erased.
+	uint8_t verify;				//1 to read the bytes back instead of programming them.
+
+}request_t;
+
+typedef struct{
+
+	request_t items[MAX_QUEUED];
+	int head;
+	int count;
+
+}queue_t;
+
+typedef struct{
+
+	int64_t * latency;
+	size_t count;
+	size_t size;
+
+}latencies_t;
+
+typedef struct{
+
+	int64_t duration;			//us
+	int64_t data_period;		//us between log pages.
+	int64_t event_period;		//Mean us between event records.
+	int64_t config_period;		//us between configuration records.
+	uint32_t spi_khz;
+	uint8_t program_max;		//1 to use the longest program time for every program.
+	uint8_t erase_max;
+	uint8_t verify;				//1 to read back each log page.
+	uint32_t imu_rate;			//Hz, 0 to not count missed readings.
+	uint32_t seed;
+
+}settings_t;
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// FUNCTIONS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+static uint32_t next_random(uint32_t * state){
+
+	*state ^= *state << 13;
+	*state ^= *state >> 17;
+	*state ^= *state << 5;
+	return *state;
+}
+
+static int64_t random_between(uint32_t * state,int64_t low,int64_t high){
+
+	return low + (int64_t)(next_random(state) % (uint32_t)(high - low + 1));
+}
+
+static void push(queue_t * q,request_t request){
+
+	if(q->count < MAX_QUEUED){
+		q->items[(q->head + q->count) % MAX_QUEUED] = request;
+		q->count++;
+	}
+}
+
+static request_t * peek(queue_t * q){
+
+	return (q->count > 0) ? &q->items[q->head] : NULL;
+}
+
+static void pop(queue_t * q){
+
+	q->head = (q->head + 1) % MAX_QUEUED;
+	q->count--;
+}
+
+static void record(latencies_t * l,int64_t latency){
+
+	if(l->count == l->size){
+		l->size = l->size ? 2*l->size : 1024;
+		l->latency = realloc(l->latency,l->size*sizeof(int64_t));
+		if(l->latency == NULL){
+			exit(1);
+		}
+	}
+	l->latency[l->count++] = latency;
+}
+
+static int compare(const void * a,const void * b){
+
+	int64_t x = *(const int64_t *)a;
+	int64_t y = *(const int64_t *)b;
+
+	return (x > y) - (x < y);
+}
+
+static int64_t transfer_time(const settings_t * s,uint16_t bytes){
+
+	return ((int64_t)(COMMAND_BYTES + bytes)*8*1000)/s->spi_khz;
+}
+
+//IMU readings missed while the CPU is held from from to to, all but the first one due in that time.
+static int64_t held(const settings_t * s,int64_t from,int64_t to){
+
+	int64_t period;
+	int64_t due;
+
+	if(s->imu_rate == 0 || to <= from){
+		return 0;
+	}
+
+	period = 1000000/s->imu_rate;
+	due = (to + period - 1)/period - (from + period - 1)/period;
+
+	return (due > 1) ? due - 1 : 0;
+}
+
+//polled is 1 to hold the CPU until each program ends instead of blocking between status polls.
+static int64_t run(const settings_t * s,int suspend_enabled,int polled,latencies_t * results,int64_t * missed){
+
+	static queue_t queues[FLASH_CLASSES];
+	uint32_t rng = s->seed;
+	int64_t now = 0;
+	int64_t next_data = 0;
+	int64_t next_event = 0;
+	int64_t next_config = 0;
+	int64_t next_tick = TICK_US;
+
+	//The erase being run.
+	int erase_active = 0;
+	int suspended = 0;
+	int64_t erase_queued = 0;
+	int64_t erase_end = 0;			//When it finishes if it is not suspended again.
+	int64_t erase_left = 0;			//Time left while suspended.
+	int64_t resumed = 0;
+
+	int64_t busy = 0;				//us the flash spent on requests other than erases.
+	int verify_queued = 0;
+	int i;
+
+	memset(queues,0,sizeof(queues));
+	*missed = 0;
+
+	//Erases are always waiting.
+	push(&queues[FLASH_CLASS_ERASE],(request_t){0,0,0,0});
+
+	while(now < s->duration){
+
+		int flash_class;
+
+		//Requests queued by now.
+		while(next_data <= now){
+			push(&queues[FLASH_CLASS_DATA],(request_t){next_data,256,0,0});
+			next_data += s->data_period;
+		}
+		while(next_event <= now){
+			push(&queues[FLASH_CLASS_EVENT],(request_t){next_event,EVENT_RECORD_SIZE,0,0});
+			next_event += random_between(&rng,1,2*s->event_period);
+		}
+		while(next_config <= now){
+			push(&queues[FLASH_CLASS_CONFIG],(request_t){next_config,CONFIG_RECORD_SIZE,0,0});
+			next_config += s->config_period;
+		}
+
+		//check_erase()
+		if(erase_active && !suspended && now >= erase_end){
+
+			erase_active = 0;
+			record(&results[FLASH_CLASS_ERASE],now - erase_queued);
+			push(&queues[FLASH_CLASS_ERASE],(request_t){now,0,0,0});
+		}
+
+		flash_class = 0;
+		while(flash_class < FLASH_CLASSES){
+
+			request_t * next = peek(&queues[flash_class]);
+			int runnable = (next != NULL) && (!erase_active || (suspend_enabled && next->bytes != 0 && !next->in_erase));
+
+			if(!runnable){
+				flash_class++;
+				continue;
+			}
+
+			//suspend()
+			if(erase_active && !suspended){
+
+				if(now < resumed + FLASH_RESUME_RUN_US){
+					if(polled){
+						*missed += held(s,now,resumed + FLASH_RESUME_RUN_US);
+					}
+					now = resumed + FLASH_RESUME_RUN_US;
+				}
+
+				if(now >= erase_end){
+					erase_active = 0;
+					record(&results[FLASH_CLASS_ERASE],now - erase_queued);
+					push(&queues[FLASH_CLASS_ERASE],(request_t){now,0,0,0});
+				}
+				else{
+					erase_left = erase_end - now;
+					suspended = 1;
+					*missed += held(s,now,now + FLASH_SUSPEND_TIME_US);
+					now += FLASH_SUSPEND_TIME_US;
+				}
+			}
+
+			if(next->bytes == 0){
+
+				//start_erase()
+				erase_active = 1;
+				suspended = 0;
+				erase_queued = next->queued;
+				*missed += held(s,now,now + transfer_time(s,0));
+				now += transfer_time(s,0);
+				resumed = now;
+				erase_end = now + (s->erase_max ? ERASE_TIME_MAX_US : random_between(&rng,ERASE_TIME_TYP_US,ERASE_TIME_MAX_US));
+			}
+			else{
+
+				//serve()
+				int64_t start = now;
+
+				now += transfer_time(s,next->bytes);
+				if(!next->verify){
+
+					int64_t program = s->program_max ? PROGRAM_TIME_MAX_US : random_between(&rng,PROGRAM_TIME_TYP_US,PROGRAM_TIME_MAX_US);
+
+					//Blocking between polls, the end is seen at the first poll after it.
+					if(polled){
+						now += program;
+					}
+					else{
+						now += ((program + FLASH_POLL_US - 1)/FLASH_POLL_US)*FLASH_POLL_US;
+					}
+					*missed += held(s,start,polled ? now : start + transfer_time(s,next->bytes));
+					record(&results[flash_class],now - next->queued);
+
+					//The logging task queues the read back as soon as its program is done.
+					if(s->verify && flash_class == FLASH_CLASS_DATA){
+						verify_queued = 1;
+					}
+				}
+				else{
+					*missed += held(s,start,now);
+				}
+				busy += now - start;
+			}
+			pop(&queues[flash_class]);
+
+			if(verify_queued){
+				push(&queues[FLASH_CLASS_DATA],(request_t){now,256,0,1});
+				verify_queued = 0;
+			}
+
+			//More requests may have come while it ran.
+			while(next_data <= now){
+				push(&queues[FLASH_CLASS_DATA],(request_t){next_data,256,0,0});
+				next_data += s->data_period;
+			}
+			while(next_event <= now){
+				push(&queues[FLASH_CLASS_EVENT],(request_t){next_event,EVENT_RECORD_SIZE,0,0});
+				next_event += random_between(&rng,1,2*s->event_period);
+			}
+			while(next_config <= now){
+				push(&queues[FLASH_CLASS_CONFIG],(request_t){next_config,CONFIG_RECORD_SIZE,0,0});
+				next_config += s->config_period;
+			}
+
+			flash_class = 0;
+		}
+
+		//resume()
+		if(erase_active && suspended){
+
+			suspended = 0;
+			resumed = now;
+			erase_end = now + erase_left;
+		}
+
+		//Sleep until the next request, or the next tick while an erase runs.
+		{
+			int64_t wake = next_data;
+
+			if(next_event < wake){
+				wake = next_event;
+			}
+			if(next_config < wake){
+				wake = next_config;
+			}
+			if(erase_active){
+
+				while(next_tick <= now){
+					next_tick += TICK_US;
+				}
+				if(next_tick < wake){
+					wake = next_tick;
+				}
+			}
+			if(wake > now){
+				now = wake;
+			}
+		}
+	}
+
+	for(i=0;i<FLASH_CLASSES;i++){
+		qsort(results[i].latency,results[i].count,sizeof(int64_t),compare);
+	}
+
+	return busy;
+}
+
+static void report(const char * title,latencies_t * results,int64_t busy,int64_t missed,const settings_t * s){
+
+	static const char * names[FLASH_CLASSES] = {"event","config","data","erase"};
+	int i;
+
+	printf("%s\n",title);
+	printf("  class     count    mean us     99%% us      max us\n");
+
+	for(i=0;i<FLASH_CLASSES;i++){
+
+		latencies_t * l = &results[i];
+		double total = 0;
+		size_t k;
+
+		if(l->count == 0){
+			printf("  %-8s %6d\n",names[i],0);
+			continue;
+		}
+
+		for(k=0;k<l->count;k++){
+			total += l->latency[k];
+		}
+
+		printf("  %-8s %6zu %10.0f %10lld %11lld\n",names[i],l->count,total/l->count,
+				(long long)l->latency[(l->count*99)/100],(long long)l->latency[l->count-1]);
+	}
+	printf("  flash busy with programs and reads %.1f%% of the time\n",(100.0*busy)/s->duration);
+	if(s->imu_rate != 0){
+		printf("  IMU readings missed at %u Hz: %lld of %lld\n",s->imu_rate,(long long)missed,
+				(long long)(s->duration*s->imu_rate/1000000));
+	}
+}
+
+static void usage(const char * name){
+
+	fprintf(stderr,
+		"Usage: %s [options]\n"
+		"  -t s       time to emulate (default 60)\n"
+		"  -d ms      time between log pages (default 10)\n"
+		"  -e ms      mean time between event records (default 50)\n"
+		"  -c ms      time between configuration records (default 1000)\n"
+		"  -s kHz     flash SPI clock (default %d)\n"
+		"  -P         every program takes the longest time\n"
+		"  -E         every erase takes the longest time\n"
+		"  -V         read back each log page after it is programmed\n"
+		"  -I Hz      IMU rate for the readings missed, 0 for none (default 1000)\n"
+		"  -S seed    random seed (default 1)\n",
+		name,SPI_CLOCK_KHZ);
+}
+
+int main(int argc,char ** argv){
+
+	settings_t s;
+	latencies_t with[FLASH_CLASSES];
+	latencies_t without[FLASH_CLASSES];
+	latencies_t polled[FLASH_CLASSES];
+	int64_t busy_with;
+	int64_t busy_without;
+	int64_t busy_polled;
+	int64_t missed_with;
+	int64_t missed_without;
+	int64_t missed_polled;
+	int opt;
+
+	s.duration = 60*1000000LL;
+	s.data_period = 10000;
+	s.event_period = 50000;
+	s.config_period = 1000000;
+	s.spi_khz = SPI_CLOCK_KHZ;
+	s.program_max = 0;
+	s.erase_max = 0;
+	s.verify = 0;
+	s.imu_rate = 1000;
+	s.seed = 1;
+
+	while((opt = getopt(argc,argv,"t:d:e:c:s:PEVI:S:")) != -1){
+		switch(opt){
+			case 't': s.duration = strtoll(optarg,NULL,0)*1000000LL; break;
+			case 'd': s.data_period = strtoll(optarg,NULL,0)*1000; break;
+			case 'e': s.event_period = strtoll(optarg,NULL,0)*1000; break;
+			case 'c': s.config_period = strtoll(optarg,NULL,0)*1000; break;
+			case 's': s.spi_khz = strtoul(optarg,NULL,0); break;
+			case 'P': s.program_max = 1; break;
+			case 'E': s.erase_max = 1; break;
+			case 'V': s.verify = 1; break;
+			case 'I': s.imu_rate = strtoul(optarg,NULL,0); break;
+			case 'S': s.seed = strtoul(optarg,NULL,0); break;
+			default: usage(argv[0]); return 2;
+		}
+	}
+
+	if(s.duration <= 0 || s.data_period <= 0 || s.event_period <= 0 || s.config_period <= 0 || s.spi_khz == 0 || s.seed == 0){
+		usage(argv[0]);
+		return 2;
+	}
+
+	memset(with,0,sizeof(with));
+	memset(without,0,sizeof(without));
+	memset(polled,0,sizeof(polled));
+
+	busy_without = run(&s,0,0,without,&missed_without);
+	busy_with = run(&s,1,0,with,&missed_with);
+	busy_polled = run(&s,1,1,polled,&missed_polled);
+
+	report("Erases run to the end:",without,busy_without,missed_without,&s);
+	report("Erases suspended:",with,busy_with,missed_with,&s);
+	report("Erases suspended, CPU held until each program ends:",polled,busy_polled,missed_polled,&s);
+
+	return 0;
+}
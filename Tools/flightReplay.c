@@ -0,0 +1,666 @@
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// UMSATS 2018-2020
+//
+// Repository:
+//  UMSATS/Avionics-2019
+//
+// File Description:
+//  Host replay harness for the flight logic in loggingTask.
+//
+//  Feeds recorded flight data (a dump from the xtract read command, or a sensor CSV) through the same flightState.c and
+//  logPacket.c used by the firmware. Time is taken from the samples, so a full flight replays in milliseconds.
+//  Prints a timeline of flight events and writes the flash image the firmware would have written.
+//
+//  Build (from the repository root):
+//   gcc -O2 -IAvionicsSoftware-AtollicProject/Inc Tools/flightReplay.c AvionicsSoftware-AtollicProject/Src/flightState.c
+//       AvionicsSoftware-AtollicProject/Src/logPacket.c AvionicsSoftware-AtollicProject/Src/checkpoint.c
+//       AvionicsSoftware-AtollicProject/Src/crc.c -lm -o flightReplay
+//
+// History
+// 2026-10-19
+// - Created.
+// - Added a simulated reset in flight (-r), carrying on from the last checkpoint like the firmware does.
+// - Times are written as microsecond deltas with sync records, and dumps are read with any mix of readings.
+// - Readings from before the trigger of a capture window are skipped when reading a dump.
+// - The data starts after the event journal sectors.
+// - The CRC at the end of each page is checked and taken out of the dump, and the image is written with them.
+// - Bad, erased and out of place pages in a dump are skipped, and reading carries on at the first packet in the next
+//   good page.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "logPacket.h"
+#include "flightState.h"
+#include "checkpoint.h"
+#include "eventCapture.h"
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// DEFINITIONS AND MACROS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//Must match flash.h and configuration.h.
+#define FLASH_PAGE_SIZE			256
+#define FLASH_START_ADDRESS		0x6000
+#define FLASH_SIZE_BYTES		(8000000-FLASH_START_ADDRESS)
+#define GND_PRES				101325
+#define GND_ALT					0
+
+#define BACKUP_MAIN_DELAY		(BACKUP_DROGUE_TIME + 2*BACKUP_BEEP_TIME + BACKUP_MAIN_TIME)
+#define RECOVERY_TIME			50			//Default time from a reset until the logging task has the first sample again, in ms.
+#define EVENT_NAMES				6
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// STRUCTS AND STRUCT TYPEDEFS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+typedef struct{
+
+	uint32_t time_ms;
+	int16_t acc[3];
+	int16_t gyro[3];
+	uint32_t pressure;		//0.01 Pa
+	int32_t temperature;	//0.01 deg C
+
+}replaySample_t;
+
+typedef struct{
+
+	replaySample_t * samples;
+	size_t count;
+
+	float ref_pres;
+	float ref_alt;
+	int ematch_fails;		//Continuity never opens after firing.
+	int verbose;
+
+	uint8_t * image;		//Flash contents from FLASH_START_ADDRESS.
+	uint32_t flash_address;
+	int flash_full;
+
+	int64_t reset_time;		//Time of the simulated reset in ms, or -1.
+	uint32_t recovery_time;	//Samples up to this long after the reset are lost.
+	int64_t event_times[EVENT_NAMES];	//First time each event in event_names was seen, or -1.
+
+}replay_t;
+
+static const struct { uint32_t bit; const char * name; } event_names[EVENT_NAMES] = {
+	{LAUNCH_DETECT,"LAUNCH_DETECT"},
+	{DROGUE_DETECT,"DROGUE_DETECT"},
+	{DROGUE_DEPLOY,"DROGUE_DEPLOY"},
+	{MAIN_DETECT,"MAIN_DETECT"},
+	{MAIN_DEPLOY,"MAIN_DEPLOY"},
+	{LAND_DETECT,"LAND_DETECT"},
+};
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// FUNCTIONS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+static void write_page(void * context,uint8_t * page){
+
+	replay_t * r = (replay_t *)context;
+
+	if(r->flash_address + FLASH_PAGE_SIZE > FLASH_SIZE_BYTES){
+		r->flash_full = 1;
+		return;
+	}
+	memcpy(&r->image[r->flash_address - FLASH_START_ADDRESS],page,FLASH_PAGE_SIZE);
+	r->flash_address += FLASH_PAGE_SIZE;
+}
+
+static void timeline(const replay_t * r,uint32_t time_ms,const char * what,uint8_t state,const flightState_t * fs){
+
+	if(r->verbose){
+		printf("%10.3f s  %-16s state=%u alt=%9.2f filtered=%9.2f\n",time_ms/1000.0,what,state,fs->altitude,fs->alt_filtered);
+	}
+}
+
+static void timeline_events(replay_t * r,uint32_t time_ms,uint32_t events,uint8_t state,const flightState_t * fs){
+
+	size_t i;
+
+	for(i=0;i<EVENT_NAMES;i++){
+		if(events & event_names[i].bit){
+			timeline(r,time_ms,event_names[i].name,state,fs);
+			if(r->event_times[i] < 0){
+				r->event_times[i] = time_ms;
+			}
+		}
+	}
+}
+
+//Same steps as loggingTask, with the hardware replaced by the virtual clock.
+static size_t run_replay(replay_t * r){
+
+	static LogWriter_t writer;
+	Measurement_t measurement;
+	flightState_t fs;
+	flightSample_t sample;
+	uint8_t state = STATE_LAUNCHPAD_ARMED;
+	uint8_t flags = FLAG_RECORDING;
+	LogClock_t clock;
+	uint8_t sync_record[SYNC_RECORD_SIZE];
+	uint8_t sync_length;
+	uint16_t delta_t;
+	int64_t launch_time = -1;
+	int backup_stage = 0;
+	checkpoint_t checkpoint;
+	uint32_t checkpoint_words[CHECKPOINT_WORDS];	//Stands in for the backup registers.
+	uint32_t checkpoint_time = 0;
+	int reset_done = (r->reset_time < 0);
+	size_t i;
+
+	//Erase what the previous run wrote.
+	memset(r->image,0xFF,r->flash_address - FLASH_START_ADDRESS);
+	r->flash_address = FLASH_START_ADDRESS;
+	r->flash_full = 0;
+	memset(checkpoint_words,0,sizeof(checkpoint_words));
+	memset(&checkpoint,0,sizeof(checkpoint));
+	for(i=0;i<EVENT_NAMES;i++){
+		r->event_times[i] = -1;
+	}
+
+	log_writer_init(&writer,write_page,r,0);
+	log_packet_clear(&measurement);
+	log_clock_init(&clock);
+	flight_state_init(&fs,&state,&flags);
+
+	for(i=0;i<r->count && !r->flash_full;i++){
+
+		const replaySample_t * s = &r->samples[i];
+		uint32_t events;
+		int k;
+
+		if(!reset_done && s->time_ms >= r->reset_time){
+
+			reset_done = 1;
+			timeline(r,s->time_ms,"RESET",state,&fs);
+
+			//Everything in RAM is gone: the page being filled, the pad buffer and the flight state. Samples that come in
+			//before the logging task is running again are lost.
+			log_writer_init(&writer,write_page,r,(r->flash_address - FLASH_START_ADDRESS)/FLASH_PAGE_SIZE);
+			log_clock_init(&clock);
+			flight_state_init(&fs,&state,&flags);
+			while(i < r->count && r->samples[i].time_ms < r->reset_time + r->recovery_time){
+				i++;
+			}
+			if(i == r->count){
+				break;
+			}
+			s = &r->samples[i];
+
+			if(checkpoint_unpack(checkpoint_words,&checkpoint) && IS_IN_FLIGHT(checkpoint.flags)){
+
+				//Same estimate as loggingTask, the checkpoint flight time plus the time since the reset.
+				uint32_t flight_time = checkpoint.flight_time + r->recovery_time;
+
+				checkpoint_restore(&checkpoint,&fs);
+				launch_time = (int64_t)s->time_ms - flight_time;
+				backup_stage = (flight_time >= BACKUP_MAIN_DELAY) ? 2 : (flight_time >= BACKUP_DROGUE_TIME) ? 1 : 0;
+
+				if(r->verbose){
+					printf("%10.3f s  %-16s state=%u checkpoint %u ms old, %u ms after launch\n",s->time_ms/1000.0,"RESUMED",state,
+						(unsigned)(r->reset_time - checkpoint_time),(unsigned)checkpoint.flight_time);
+				}
+			}
+			else{
+
+				//Not in flight, the board goes back to waiting on the pad.
+				state = STATE_LAUNCHPAD_ARMED;
+				flags = FLAG_RECORDING;
+				launch_time = -1;
+				backup_stage = 0;
+				timeline(r,s->time_ms,"COLD START",state,&fs);
+			}
+		}
+
+		//Backup timer task, started at launch.
+		if(launch_time >= 0 && backup_stage == 0 && s->time_ms >= launch_time + BACKUP_DROGUE_TIME){
+			state = STATE_IN_FLIGHT_POST_APOGEE;
+			backup_stage = 1;
+			timeline(r,launch_time + BACKUP_DROGUE_TIME,"BACKUP_DROGUE",state,&fs);
+		}
+		if(launch_time >= 0 && backup_stage == 1 && s->time_ms >= launch_time + BACKUP_MAIN_DELAY){
+			state = STATE_IN_FLIGHT_POST_MAIN;
+			backup_stage = 2;
+			timeline(r,launch_time + BACKUP_MAIN_DELAY,"BACKUP_MAIN",state,&fs);
+		}
+
+		for(k=0;k<3;k++){
+			sample.acc[k] = s->acc[k];
+			sample.gyro[k] = s->gyro[k];
+		}
+		sync_length = log_clock_stamp(&clock,s->time_ms*1000,&delta_t,sync_record);
+		log_packet_set_imu(&measurement,delta_t,sample.acc,sample.gyro);
+
+		sample.altitude = pressure_altitude((float)s->pressure,(float)s->temperature,r->ref_pres,r->ref_alt);
+		{
+			union { float f; uint32_t u; } alt_bits;
+			alt_bits.f = sample.altitude;
+			log_packet_set_pres(&measurement,s->pressure,(uint32_t)s->temperature,alt_bits.u);
+		}
+
+		events = flight_state_update(&fs,&sample);
+
+		if(events & LAUNCH_DETECT){
+			launch_time = s->time_ms;
+			log_writer_flush_pad(&writer);
+		}
+		if((events & (MAIN_DETECT | DROGUE_DETECT)) && !r->ematch_fails){
+			events |= flight_state_deployed(&fs,events);
+		}
+
+		timeline_events(r,s->time_ms,events,state,&fs);
+		log_packet_add_event(&measurement,events);
+
+		if(sync_length > 0){
+			if(state == STATE_LAUNCHPAD_ARMED){
+				log_writer_append_pad(&writer,sync_record,sync_length);
+			}
+			else{
+				log_writer_append(&writer,sync_record,sync_length);
+			}
+		}
+
+		if(state == STATE_LAUNCHPAD_ARMED){
+			log_writer_append_pad(&writer,measurement.data,log_packet_length(log_packet_header(measurement.data)));
+		}
+		else{
+			log_writer_append(&writer,measurement.data,log_packet_length(log_packet_header(measurement.data)));
+		}
+		log_packet_clear(&measurement);
+
+		if(IS_IN_FLIGHT(flags) && s->time_ms - checkpoint_time >= CHECKPOINT_PERIOD){
+
+			checkpoint_save(&checkpoint,&fs);
+			checkpoint.flash_address = r->flash_address;
+			checkpoint.flight_time = s->time_ms - launch_time;
+			checkpoint.config_slot = CHECKPOINT_NO_CONFIG;
+			checkpoint.sequence++;
+			checkpoint_pack(&checkpoint,checkpoint_words);
+			checkpoint_time = s->time_ms;
+		}
+
+		if(events & LAND_DETECT){
+			//The logging task suspends itself after landing.
+			i++;
+			break;
+		}
+	}
+
+	if(r->flash_full && r->verbose){
+		printf("Flash full at sample %zu, the firmware stops here.\n",i);
+	}
+
+	return i;
+}
+
+static int add_sample(replay_t * r,size_t * capacity,const replaySample_t * s){
+
+	if(r->count == *capacity){
+		*capacity = (*capacity == 0) ? 4096 : (*capacity * 2);
+		r->samples = realloc(r->samples,*capacity * sizeof(replaySample_t));
+		if(r->samples == NULL){
+			return -1;
+		}
+	}
+	r->samples[r->count++] = *s;
+	return 0;
+}
+
+//CSV columns: time_ms,acc_x,acc_y,acc_z,gyro_x,gyro_y,gyro_z,pressure,temperature
+//Raw sensor units, pressure in 0.01 Pa and temperature in 0.01 deg C. Lines that do not parse are skipped.
+static int load_csv(replay_t * r,const char * path){
+
+	FILE * f = fopen(path,"r");
+	char line[256];
+	size_t capacity = 0;
+
+	if(f == NULL){
+		perror(path);
+		return -1;
+	}
+
+	while(fgets(line,sizeof(line),f) != NULL){
+
+		replaySample_t s;
+		int a[3],g[3];
+		unsigned long t,p;
+		long temp;
+
+		if(sscanf(line,"%lu,%d,%d,%d,%d,%d,%d,%lu,%ld",&t,&a[0],&a[1],&a[2],&g[0],&g[1],&g[2],&p,&temp) != 9){
+			continue;
+		}
+		s.time_ms = t;
+		s.acc[0] = a[0];	s.acc[1] = a[1];	s.acc[2] = a[2];
+		s.gyro[0] = g[0];	s.gyro[1] = g[1];	s.gyro[2] = g[2];
+		s.pressure = p;
+		s.temperature = temp;
+
+		if(add_sample(r,&capacity,&s) != 0){
+			fclose(f);
+			return -1;
+		}
+	}
+
+	fclose(f);
+	return 0;
+}
+
+//Binary dump of the data section, as sent by the xtract read command. A sample is replayed for each pressure reading,
+//with the latest accelerometer and gyroscope readings. Time starts at the first sync record, measurements before it are
+//skipped. Other extended records are skipped. After a page that is skipped, time starts again at the next sync record.
+static int load_dump(replay_t * r,const char * path){
+
+	FILE * f = fopen(path,"rb");
+	uint8_t * data;
+	long * gaps;				//Where the packets after each run of skipped pages start.
+	long gap_count = 0;
+	long gap = 0;
+	int in_gap = 0;
+	long size;
+	long pages;
+	long bad = 0;
+	long erased = 0;
+	long pos = 0;
+	long out = 0;
+	uint64_t time_us = 0;		//Sync times are unwrapped, the microsecond timer wraps after about 71 minutes.
+	uint64_t start_us = 0;
+	int synced = 0;				//Cleared after skipped pages, until the next sync record.
+	int started = 0;			//Set at the first sync record.
+	uint32_t history = 0;		//Readings from before the trigger of a capture window still to come.
+	size_t capacity = 0;
+	replaySample_t s;
+
+	memset(&s,0,sizeof(s));
+
+	if(f == NULL){
+		perror(path);
+		return -1;
+	}
+	fseek(f,0,SEEK_END);
+	size = ftell(f);
+	fseek(f,0,SEEK_SET);
+
+	data = malloc(size > 0 ? size : 1);
+	if(data == NULL || fread(data,1,size,f) != (size_t)size){
+		fclose(f);
+		free(data);
+		return -1;
+	}
+	fclose(f);
+
+	pages = size/LOG_PAGE_SIZE;
+	gaps = malloc((pages + 1)*sizeof(long));
+	if(gaps == NULL){
+		free(data);
+		return -1;
+	}
+
+	//Take the header and CRC off each page, so the packets run on from page to page. A page with a bad CRC, or that is
+	//not where its sequence number says, is left out along with the end of the packet before it, and the packets carry
+	//on at the first packet start in the next good page.
+	for(pos=0;pos<pages;pos++){
+
+		const uint8_t * page = &data[pos*LOG_PAGE_SIZE];
+		uint8_t first = 0;
+
+		if(!log_page_check(page) || log_page_sequence(page) != (uint16_t)pos){
+
+			if(page[0] == 0xFF && page[LOG_PAGE_SIZE-1] == 0xFF){
+				erased++;
+			}
+			else{
+				bad++;
+			}
+			if(!in_gap){
+				gaps[gap_count++] = out;
+				in_gap = 1;
+			}
+			continue;
+		}
+
+		if(in_gap){
+			first = log_page_first_packet(page);
+			if(first == LOG_PAGE_NO_PACKET){
+				continue;
+			}
+			in_gap = 0;
+		}
+
+		memmove(&data[out],&page[LOG_PAGE_HEADER_SIZE + first],LOG_PAGE_DATA_SIZE - first);
+		out += LOG_PAGE_DATA_SIZE - first;
+	}
+	size = out;
+	pos = 0;
+
+	printf("Read %ld pages, %ld with a bad CRC or out of place, %ld erased.\n",pages,bad,erased);
+
+	while(pos + HEADER_SIZE <= size){
+
+		uint32_t header = log_packet_header(&data[pos]);
+		uint8_t length = log_packet_length(header);
+		const uint8_t * p = &data[pos + HEADER_SIZE];
+		long end = (gap < gap_count) ? gaps[gap] : size;
+		int k;
+
+		if(length == 0 || header == 0xFFFFFF || pos + length > end){
+
+			if(end == size){
+				//Erased flash or a cut off packet, end of the data.
+				break;
+			}
+
+			//The packet runs into skipped pages. Carry on after them, and wait for a sync record to know the time.
+			pos = end;
+			gap++;
+			synced = 0;
+			continue;
+		}
+
+		if((header & TYPE_MASK) == 0){
+
+			if(((header & EXT_KIND_MASK) >> EXT_KIND_SHIFT) == EXT_KIND_SYNC && length == SYNC_RECORD_SIZE){
+
+				uint32_t sync = log_packet_sync_time(&data[pos]);
+				uint64_t unwrapped = (time_us & ~(uint64_t)0xFFFFFFFF) | sync;
+
+				if(started && unwrapped + 0x80000000ULL < time_us){
+					unwrapped += 0x100000000ULL;
+				}
+				if(!started){
+					start_us = unwrapped;
+				}
+				time_us = unwrapped;
+				synced = 1;
+				started = 1;
+			}
+			else if(((header & EXT_KIND_MASK) >> EXT_KIND_SHIFT) == EXT_KIND_CAPTURE && length == HEADER_SIZE+CAPTURE_LENGTH){
+
+				//The firmware already had these readings, in the averages before the window.
+				history = ((uint32_t)p[1] << 8) | p[2];
+			}
+			pos += length;
+			continue;
+		}
+
+		time_us += log_packet_delta_us(header);
+
+		if(history > 0){
+			history--;
+			pos += length;
+			continue;
+		}
+
+		if(header & ACC_TYPE){
+			for(k=0;k<3;k++){
+				s.acc[k] = (int16_t)((p[2*k] << 8) | p[2*k+1]);
+			}
+			p += ACC_LENGTH;
+		}
+		if(header & GYRO_TYPE){
+			for(k=0;k<3;k++){
+				s.gyro[k] = (int16_t)((p[2*k] << 8) | p[2*k+1]);
+			}
+			p += GYRO_LENGTH;
+		}
+
+		if(synced && (header & (PRES_TYPE | TEMP_TYPE)) == (PRES_TYPE | TEMP_TYPE)){
+
+			s.time_ms = (time_us - start_us)/1000;
+			s.pressure = ((uint32_t)p[0] << 16) | (p[1] << 8) | p[2];
+			s.temperature = ((int32_t)(((uint32_t)p[3] << 24) | (p[4] << 16) | (p[5] << 8))) >> 8;	//Sign extend 24 bits.
+
+			if(add_sample(r,&capacity,&s) != 0){
+				free(data);
+				free(gaps);
+				return -1;
+			}
+		}
+		pos += length;
+	}
+
+	free(data);
+	free(gaps);
+	return 0;
+}
+
+static void usage(const char * name){
+
+	fprintf(stderr,
+		"Usage: %s (-c samples.csv | -d dump.bin) [options]\n"
+		"  -o file    write the flash image (from address 0x%X) to file\n"
+		"  -p pa      ground reference pressure in Pa (default %d)\n"
+		"  -a m       ground reference altitude in m (default %d)\n"
+		"  -f         e-matches fail, continuity never opens\n"
+		"  -n count   replay count times and report the replay rate\n"
+		"  -r ms      reset the flight computer at this time and carry on from the last checkpoint\n"
+		"  -R ms      time from the reset until logging starts again (default %d)\n"
+		"  -q         do not print the timeline\n",
+		name,FLASH_START_ADDRESS,GND_PRES,GND_ALT,RECOVERY_TIME);
+}
+
+int main(int argc,char ** argv){
+
+	replay_t r;
+	const char * csv_path = NULL;
+	const char * dump_path = NULL;
+	const char * image_path = NULL;
+	long repeat = 1;
+	size_t used = 0;
+	long n;
+	int opt;
+	struct timespec start,end;
+	double seconds;
+	int64_t reference_times[EVENT_NAMES];
+
+	memset(&r,0,sizeof(r));
+	r.ref_pres = GND_PRES;
+	r.ref_alt = GND_ALT;
+	r.verbose = 1;
+	r.reset_time = -1;
+	r.recovery_time = RECOVERY_TIME;
+
+	while((opt = getopt(argc,argv,"c:d:o:p:a:fn:r:R:q")) != -1){
+		switch(opt){
+			case 'c': csv_path = optarg; break;
+			case 'd': dump_path = optarg; break;
+			case 'o': image_path = optarg; break;
+			case 'p': r.ref_pres = strtof(optarg,NULL); break;
+			case 'a': r.ref_alt = strtof(optarg,NULL); break;
+			case 'f': r.ematch_fails = 1; break;
+			case 'n': repeat = strtol(optarg,NULL,0); break;
+			case 'r': r.reset_time = strtol(optarg,NULL,0); break;
+			case 'R': r.recovery_time = strtoul(optarg,NULL,0); break;
+			case 'q': r.verbose = 0; break;
+			default: usage(argv[0]); return 2;
+		}
+	}
+
+	if((csv_path == NULL) == (dump_path == NULL) || repeat < 1){
+		usage(argv[0]);
+		return 2;
+	}
+	if((csv_path != NULL ? load_csv(&r,csv_path) : load_dump(&r,dump_path)) != 0){
+		fprintf(stderr,"Could not load the input.\n");
+		return 1;
+	}
+
+	r.image = malloc(FLASH_SIZE_BYTES - FLASH_START_ADDRESS);
+	if(r.image == NULL){
+		return 1;
+	}
+	memset(r.image,0xFF,FLASH_SIZE_BYTES - FLASH_START_ADDRESS);
+	r.flash_address = FLASH_START_ADDRESS;
+
+	//Run once without the reset to compare the event times against.
+	if(r.reset_time >= 0){
+
+		int verbose = r.verbose;
+		int64_t reset_time = r.reset_time;
+
+		r.verbose = 0;
+		r.reset_time = -1;
+		run_replay(&r);
+		memcpy(reference_times,r.event_times,sizeof(reference_times));
+		r.verbose = verbose;
+		r.reset_time = reset_time;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC,&start);
+	for(n=0;n<repeat;n++){
+		used = run_replay(&r);
+		r.verbose = 0;
+	}
+	clock_gettime(CLOCK_MONOTONIC,&end);
+	seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec)/1e9;
+
+	printf("Replayed %zu of %zu samples, %u pages written.\n",used,r.count,(r.flash_address - FLASH_START_ADDRESS)/FLASH_PAGE_SIZE);
+	if(repeat > 1 || seconds > 0){
+		printf("%.0f samples/s (%ld runs in %.3f s)\n",(double)used*repeat/seconds,repeat,seconds);
+	}
+
+	if(r.reset_time >= 0){
+
+		printf("Event times with the reset at %.3f s:\n",r.reset_time/1000.0);
+		for(n=0;n<EVENT_NAMES;n++){
+
+			if(r.event_times[n] < 0 && reference_times[n] < 0){
+				continue;
+			}
+			printf("  %-14s",event_names[n].name);
+			if(r.event_times[n] < 0){
+				printf("  missed (%.3f s without the reset)\n",reference_times[n]/1000.0);
+			}
+			else if(reference_times[n] < 0){
+				printf("  %.3f s (not seen without the reset)\n",r.event_times[n]/1000.0);
+			}
+			else{
+				printf("  %.3f s (%+.3f s)\n",r.event_times[n]/1000.0,(r.event_times[n] - reference_times[n])/1000.0);
+			}
+		}
+	}
+
+	if(image_path != NULL){
+
+		FILE * f = fopen(image_path,"wb");
+		if(f == NULL){
+			perror(image_path);
+			return 1;
+		}
+		fwrite(r.image,1,r.flash_address - FLASH_START_ADDRESS,f);
+		fclose(f);
+	}
+
+	free(r.image);
+	free(r.samples);
+	return 0;
+}
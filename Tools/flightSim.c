@@ -0,0 +1,862 @@
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// UMSATS 2018-2020
+//
+// Repository:
+//  UMSATS/Avionics-2019
+//
+// File Description:
+//  Monte Carlo flight simulator for the deployment logic.
+//
+//  Generates synthetic flights (1D vertical or planar 3DOF) with dispersed motor thrust, drag, wind and sensor noise and bias,
+//  samples them the way the BMI088 and BMP388 are configured on the flight computer, and runs every flight through
+//  flightState.c. Flights run in parallel on a work-stealing thread pool. Each flight has its own random seed, so the
+//  results do not depend on the number of threads.
+//
+//  Build (from the repository root):
+//   gcc -O2 -pthread -IAvionicsSoftware-AtollicProject/Inc Tools/flightSim.c AvionicsSoftware-AtollicProject/Src/flightState.c
+//       AvionicsSoftware-AtollicProject/Src/logPacket.c AvionicsSoftware-AtollicProject/Src/crc.c -lm -o flightSim
+//
+// History
+// 2026-10-19
+// - Created.
+// - The accelerometer, gyroscope and BMP388 are sampled at their own rates, and the flight state runs once per pressure
+//   reading with the latest IMU values, as in dataLogging.c.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bmi08x_defs.h"
+#include "bmp3_defs.h"
+#include "flightState.h"
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// DEFINITIONS AND MACROS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//Defaults from configuration.h.
+#define ACC_RATE				100			//Hz
+#define GYRO_RATE				100
+#define BMP_RATE				20
+#define MAX_IMU_RATE			2000		//Must match acquisition.h.
+#define MAX_BMP_RATE			200
+#define ACC_RANGE				BMI088_ACCEL_RANGE_12G
+#define GYRO_RANGE				BMI08X_GYRO_RANGE_1000_DPS
+#define BMP_ODR					BMP3_ODR_50_HZ
+#define PRES_OS					BMP3_OVERSAMPLING_4X
+#define BMP_IIR					BMP3_IIR_FILTER_COEFF_15
+
+#define GRAVITY					9.80665
+#define SEA_LEVEL_PRESSURE		101325.0
+#define SIM_STEP				0.001		//s
+#define SIM_MAX_TIME			900.0		//s
+#define PAD_TIME				20.0		//s on the pad before ignition, plus up to 1s.
+#define RAIL_LENGTH				5.0			//m
+#define CHUTE_OPEN_TIME			0.5			//s from firing to a fully open parachute.
+#define LANDED_EXTRA_TIME		30.0		//s simulated after touchdown.
+
+#define MAX_THREADS				256
+#define HISTOGRAM_BINS			12
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// STRUCTS AND STRUCT TYPEDEFS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//Nominal vehicle and sensor setup, and the spread (1 sigma) of each dispersed parameter.
+typedef struct{
+
+	int planar;					//0 for 1D vertical flights.
+
+	double mass;				//kg at liftoff
+	double propellant;			//kg
+	double thrust;				//N average
+	double burn_time;			//s
+	double cd;
+	double diameter;			//m
+	double drogue_cda;			//m^2
+	double main_cda;			//m^2
+	double rail_angle;			//deg from vertical
+	double wind;				//m/s at 10m
+	double site_altitude;		//m above sea level
+	double pad_temperature;		//deg C
+
+	double thrust_sigma;		//fraction
+	double burn_sigma;			//fraction
+	double mass_sigma;			//fraction
+	double cd_sigma;			//fraction
+	double wind_sigma;			//m/s
+	double gust_sigma;			//m/s
+	double pad_knock_rate;		//knocks per second on the pad.
+
+	double acc_noise;			//g rms
+	double acc_bias;			//g, 1 sigma
+	double gyro_noise;			//dps rms
+	double gyro_bias;			//dps, 1 sigma
+	double pres_noise;			//Pa rms at no oversampling.
+	double pres_bias;			//Pa, 1 sigma
+
+	uint8_t ac_range;			//Same codes as the configuration.
+	uint8_t gy_range;
+	uint8_t bmp_odr;
+	uint8_t pres_os;
+	uint8_t iir_coef;
+	uint16_t acc_rate;			//Hz
+	uint16_t gyro_rate;
+	uint16_t bmp_rate;
+
+	int ematch_fail_percent;	//Chance that continuity does not open after firing.
+	uint64_t seed;
+
+}simConfig_t;
+
+typedef struct{
+
+	double ignition;
+	double apogee_time;
+	double apogee_altitude;
+	double touchdown;
+
+	double launch_detect;		//Negative if the event never happened.
+	double drogue_fire;
+	double drogue_altitude;
+	double drogue_velocity;
+	double main_fire;
+	double main_altitude;
+	double land_detect;
+	double land_altitude;
+
+	int drogue_backup;			//1 if the backup timer fired the drogue first.
+	int main_backup;
+
+}simResult_t;
+
+typedef struct{
+
+	uint64_t state;
+	int have_spare;
+	double spare;
+
+}rng_t;
+
+//One deque per worker. The owner takes from the front, thieves take half from the back.
+typedef struct{
+
+	pthread_mutex_t lock;
+	size_t begin;
+	size_t end;
+	char pad[64];			//Keep each lock on its own cache line.
+
+}workQueue_t;
+
+typedef struct{
+
+	const simConfig_t * config;
+	simResult_t * results;
+	workQueue_t * queues;
+	int count;
+	int id;
+	size_t steals;
+
+}worker_t;
+
+typedef struct{
+
+	const char * name;
+	double * values;
+	size_t n;
+
+}metric_t;
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// CONSTANTS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+static const double acc_range_g[] = {3,6,12,24};
+static const double gyro_range_dps[] = {2000,1000,500,250,125};
+static const double bmp_odr_hz[] = {200,100,50,25,12.5,6.25,3.1,1.5,0.78,0.39,0.2,0.1};
+static const int iir_coefficient[] = {0,1,3,7,15,31,63,127};
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// FUNCTIONS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+static uint64_t splitmix64(uint64_t * x){
+
+	uint64_t z = (*x += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+static double rng_uniform(rng_t * rng){
+
+	return (splitmix64(&rng->state) >> 11) * (1.0/9007199254740992.0);
+}
+
+static double rng_gauss(rng_t * rng){
+
+	double u,v,s;
+
+	if(rng->have_spare){
+		rng->have_spare = 0;
+		return rng->spare;
+	}
+	do{
+		u = 2*rng_uniform(rng) - 1;
+		v = 2*rng_uniform(rng) - 1;
+		s = u*u + v*v;
+	}while(s >= 1 || s == 0);
+
+	s = sqrt(-2*log(s)/s);
+	rng->spare = v*s;
+	rng->have_spare = 1;
+	return u*s;
+}
+
+//International Standard Atmosphere, troposphere only.
+static double isa_pressure(double altitude){
+
+	return SEA_LEVEL_PRESSURE*pow(1 - 2.25577e-5*altitude,5.25588);
+}
+
+//Exponential fit to the standard atmosphere density, good to a few percent below 6km.
+static double air_density(double altitude){
+
+	return 1.225*exp(-altitude/9200);
+}
+
+static int16_t to_counts(double value,double range){
+
+	double counts = value*32768.0/range;
+
+	if(counts > 32767){
+		return 32767;
+	}
+	if(counts < -32768){
+		return -32768;
+	}
+	return (int16_t)lround(counts);
+}
+
+static void simulate_flight(const simConfig_t * c,uint64_t index,simResult_t * result){
+
+	rng_t rng = {c->seed ^ (index*0xD1B54A32D192ED03ULL),0,0};
+
+	//Dispersed parameters for this flight.
+	double thrust = c->thrust*(1 + c->thrust_sigma*rng_gauss(&rng));
+	double burn_time = c->burn_time*(1 + c->burn_sigma*rng_gauss(&rng));
+	double dry_mass = (c->mass - c->propellant)*(1 + c->mass_sigma*rng_gauss(&rng));
+	double cd = c->cd*(1 + c->cd_sigma*rng_gauss(&rng));
+	double area = M_PI*c->diameter*c->diameter/4;
+	double wind = c->planar ? fabs(c->wind + c->wind_sigma*rng_gauss(&rng)) : 0;
+	double rail = c->planar ? c->rail_angle*M_PI/180 : 0;
+	double acc_bias[3],gyro_bias[3];
+	double pres_bias = c->pres_bias*rng_gauss(&rng);
+	int k;
+
+	double acc_range = acc_range_g[c->ac_range & 0x03];
+	double gyro_range = gyro_range_dps[c->gy_range <= 4 ? c->gy_range : 1];
+	double bmp_period = 1.0/bmp_odr_hz[c->bmp_odr <= 11 ? c->bmp_odr : 2];
+	double pres_noise = c->pres_noise/sqrt((double)(1 << (c->pres_os & 0x07)));
+	int iir = iir_coefficient[c->iir_coef & 0x07];
+
+	//Vehicle state.
+	long step = 0;
+	double t = 0,x = 0,z = 0,vx = 0,vz = 0;
+	double theta = rail,omega = 0;
+	double mass = dry_mass + c->propellant;
+	double gust = 0;
+	double wind_profile = 0;
+	double rail_travel = 0;
+	int on_ground = 1;
+	int landed = 0;
+	double drogue_open = -1,main_open = -1;
+
+	//Sensor state.
+	double board_temp = c->pad_temperature;
+	double next_sample = 0,next_bmp = 0,next_acc = 0,next_gyro = 0;
+	double bmp_pressure = -1,bmp_temperature = 0;
+	double knock = 0;
+
+	//Firmware state.
+	uint8_t state = STATE_LAUNCHPAD_ARMED;
+	uint8_t flags = FLAG_RECORDING;
+	flightState_t fs;
+	flightSample_t sample;
+	float ref_pres = 0;
+	int logging = 1;
+	int backup_stage = 0;
+
+	for(k=0;k<3;k++){
+		acc_bias[k] = c->acc_bias*rng_gauss(&rng);
+		gyro_bias[k] = c->gyro_bias*rng_gauss(&rng);
+	}
+
+	memset(result,0,sizeof(*result));
+	result->ignition = PAD_TIME + rng_uniform(&rng);
+	result->launch_detect = result->drogue_fire = result->main_fire = result->land_detect = -1;
+	result->touchdown = -1;
+
+	flight_state_init(&fs,&state,&flags);
+
+	while(t < SIM_MAX_TIME && !(landed && t > result->touchdown + LANDED_EXTRA_TIME)){
+
+		double burning = (t >= result->ignition && t < result->ignition + burn_time);
+		double f_thrust = burning ? thrust : 0;
+		double wind_speed = wind_profile + gust;
+		double ax_air = vx - wind_speed;
+		double speed = sqrt(ax_air*ax_air + vz*vz);
+		double rho = air_density(c->site_altitude + z);
+		double cda = cd*area;
+		double fx,fz;			//Specific force (no gravity), m/s^2.
+
+		if(drogue_open >= 0 && t >= drogue_open){
+			cda += c->drogue_cda;
+		}
+		if(main_open >= 0 && t >= main_open){
+			cda += c->main_cda;
+		}
+
+		fx = f_thrust*sin(theta)/mass - 0.5*rho*cda*speed*ax_air/mass;
+		fz = f_thrust*cos(theta)/mass - 0.5*rho*cda*speed*vz/mass;
+
+		if(on_ground){
+
+			//Resting on the pad or the ground, the normal force holds the rocket up.
+			if(!landed && fz > GRAVITY){
+				on_ground = 0;
+			}
+			else{
+				fx = 0;
+				fz = GRAVITY;
+				vx = vz = 0;
+			}
+		}
+		else if(rail_travel < RAIL_LENGTH){
+
+			//On the rail, only motion along the rail.
+			double along = fx*sin(rail) + fz*cos(rail) - GRAVITY*cos(rail);
+			double v = sqrt(vx*vx + vz*vz) + along*SIM_STEP;
+			rail_travel += v*SIM_STEP;
+			vx = v*sin(rail);
+			vz = v*cos(rail);
+		}
+		else{
+			vx += fx*SIM_STEP;
+			vz += (fz - GRAVITY)*SIM_STEP;
+
+			if(drogue_open >= 0 && t >= drogue_open){
+				//Swinging under the parachute.
+				double target = 0.35*exp(-(t - drogue_open)/20)*sin(2*M_PI*0.5*(t - drogue_open));
+				omega = (target - theta)/0.2;
+			}
+			else if(c->planar && speed > 1){
+				//Weathercock towards the air relative velocity.
+				omega = (atan2(ax_air,vz) - theta)/0.15;
+			}
+			else{
+				omega = 0;
+			}
+			theta += omega*SIM_STEP;
+		}
+
+		x += vx*SIM_STEP;
+		z += vz*SIM_STEP;
+
+		if(z > result->apogee_altitude){
+			result->apogee_altitude = z;
+			result->apogee_time = t;
+		}
+		if(!landed && t > result->ignition + 1 && z <= 0){
+			z = 0;
+			landed = 1;
+			on_ground = 1;
+			omega = 0;
+			theta = 0;
+			result->touchdown = t;
+		}
+
+		if(burning){
+			mass -= c->propellant/burn_time*SIM_STEP;
+		}
+		if(c->planar && (step % 100) == 0){
+			//Wind changes slowly compared to the simulation step.
+			wind_profile = wind*pow((z > 1 ? z : 1)/10.0,1.0/7);
+			gust += -gust*0.1 + c->gust_sigma*0.45*rng_gauss(&rng);
+		}
+
+		//Electronics bay temperature lags the outside air.
+		board_temp += ((c->pad_temperature - 0.0065*z) - board_temp)*SIM_STEP/120;
+
+		//Handling knocks on the pad.
+		if(t < result->ignition && rng_uniform(&rng) < c->pad_knock_rate*SIM_STEP){
+			knock = (1 + 3*rng_uniform(&rng))*GRAVITY;
+		}
+
+		//BMP388 conversion with the IIR filter.
+		if(t >= next_bmp){
+			double p = isa_pressure(c->site_altitude + z) + pres_bias + pres_noise*rng_gauss(&rng);
+			bmp_pressure = (bmp_pressure < 0 || iir == 0) ? p : (bmp_pressure*iir + p)/(iir + 1);
+			bmp_temperature = board_temp;
+			next_bmp += bmp_period;
+		}
+
+		//The IMU readings only update the sample, the flight state runs with each pressure reading.
+		if(t >= next_acc && logging){
+
+			//Body x points along the rocket, y across it.
+			double bx = (fx*sin(theta) + fz*cos(theta))/GRAVITY + knock/GRAVITY;
+			double by = (fx*cos(theta) - fz*sin(theta))/GRAVITY;
+
+			sample.acc[0] = to_counts(bx + acc_bias[0] + c->acc_noise*rng_gauss(&rng),acc_range);
+			sample.acc[1] = to_counts(by + acc_bias[1] + c->acc_noise*rng_gauss(&rng),acc_range);
+			sample.acc[2] = to_counts(acc_bias[2] + c->acc_noise*rng_gauss(&rng),acc_range);
+			knock = 0;
+			next_acc += 1.0/c->acc_rate;
+		}
+
+		if(t >= next_gyro && logging){
+
+			double rate = omega*180/M_PI;
+
+			sample.gyro[0] = to_counts(gyro_bias[0] + c->gyro_noise*rng_gauss(&rng),gyro_range);
+			sample.gyro[1] = to_counts(gyro_bias[1] + c->gyro_noise*rng_gauss(&rng),gyro_range);
+			sample.gyro[2] = to_counts(rate + gyro_bias[2] + c->gyro_noise*rng_gauss(&rng),gyro_range);
+			next_gyro += 1.0/c->gyro_rate;
+		}
+
+		if(t >= next_sample && logging){
+
+			float pressure = (float)(uint32_t)(bmp_pressure*100);
+			float temperature = (float)(int32_t)(bmp_temperature*100);
+			uint32_t events;
+			double now_z = z;
+
+			//The pressure task sets the reference from its first reading.
+			if(ref_pres == 0){
+				ref_pres = pressure/100;
+			}
+			sample.altitude = pressure_altitude(pressure,temperature,ref_pres,0);
+
+			//Backup timer task.
+			if(backup_stage == 1 && t >= result->launch_detect + BACKUP_DROGUE_TIME/1000.0){
+				state = STATE_IN_FLIGHT_POST_APOGEE;
+				backup_stage = 2;
+				if(drogue_open < 0){
+					result->drogue_fire = t;
+					result->drogue_altitude = now_z;
+					result->drogue_velocity = vz;
+					result->drogue_backup = 1;
+					drogue_open = t + CHUTE_OPEN_TIME;
+				}
+			}
+			if(backup_stage == 2 && t >= result->launch_detect + (BACKUP_DROGUE_TIME + 2*BACKUP_BEEP_TIME + BACKUP_MAIN_TIME)/1000.0){
+				state = STATE_IN_FLIGHT_POST_MAIN;
+				backup_stage = 3;
+				if(main_open < 0){
+					result->main_fire = t;
+					result->main_altitude = now_z;
+					result->main_backup = 1;
+					main_open = t + CHUTE_OPEN_TIME;
+				}
+			}
+
+			events = flight_state_update(&fs,&sample);
+
+			if(events & LAUNCH_DETECT){
+				result->launch_detect = t;
+				backup_stage = 1;
+			}
+			if(events & (DROGUE_DETECT | MAIN_DETECT)){
+
+				if(events & DROGUE_DETECT && drogue_open < 0){
+					result->drogue_fire = t;
+					result->drogue_altitude = now_z;
+					result->drogue_velocity = vz;
+					drogue_open = t + CHUTE_OPEN_TIME;
+				}
+				if(events & MAIN_DETECT && main_open < 0){
+					result->main_fire = t;
+					result->main_altitude = now_z;
+					main_open = t + CHUTE_OPEN_TIME;
+				}
+				if((int)(rng_uniform(&rng)*100) >= c->ematch_fail_percent){
+					flight_state_deployed(&fs,events);
+				}
+			}
+			if(events & LAND_DETECT){
+				result->land_detect = t;
+				result->land_altitude = now_z;
+				logging = 0;
+			}
+
+			next_sample += 1.0/c->bmp_rate;
+		}
+
+		step++;
+		t = step*SIM_STEP;
+	}
+}
+
+static int take_work(workQueue_t * q,size_t * index){
+
+	int found = 0;
+
+	pthread_mutex_lock(&q->lock);
+	if(q->begin < q->end){
+		*index = q->begin++;
+		found = 1;
+	}
+	pthread_mutex_unlock(&q->lock);
+	return found;
+}
+
+//Moves half of the work left in a victim's queue into the thief's queue.
+static int steal_work(worker_t * w){
+
+	int i;
+
+	for(i=1;i<w->count;i++){
+
+		workQueue_t * victim = &w->queues[(w->id + i) % w->count];
+		size_t begin = 0,end = 0;
+
+		pthread_mutex_lock(&victim->lock);
+		if(victim->end > victim->begin){
+			size_t half = (victim->end - victim->begin + 1)/2;
+			end = victim->end;
+			begin = end - half;
+			victim->end = begin;
+		}
+		pthread_mutex_unlock(&victim->lock);
+
+		if(end > begin){
+			pthread_mutex_lock(&w->queues[w->id].lock);
+			w->queues[w->id].begin = begin;
+			w->queues[w->id].end = end;
+			pthread_mutex_unlock(&w->queues[w->id].lock);
+			w->steals++;
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static void * worker_main(void * param){
+
+	worker_t * w = (worker_t *)param;
+	size_t index;
+
+	while(1){
+
+		while(take_work(&w->queues[w->id],&index)){
+			simulate_flight(w->config,index,&w->results[index]);
+		}
+		if(!steal_work(w)){
+			break;
+		}
+	}
+	return NULL;
+}
+
+//Runs all flights and returns the wall time in seconds.
+static double run_pool(const simConfig_t * config,simResult_t * results,size_t flights,int threads,size_t * steals){
+
+	pthread_t handles[MAX_THREADS];
+	worker_t workers[MAX_THREADS];
+	workQueue_t * queues = calloc(threads,sizeof(workQueue_t));
+	struct timespec start,end;
+	int i;
+
+	//Start with an even split, stealing evens out flights that take longer.
+	for(i=0;i<threads;i++){
+		pthread_mutex_init(&queues[i].lock,NULL);
+		queues[i].begin = flights*i/threads;
+		queues[i].end = flights*(i + 1)/threads;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC,&start);
+	for(i=0;i<threads;i++){
+		workers[i].config = config;
+		workers[i].results = results;
+		workers[i].queues = queues;
+		workers[i].count = threads;
+		workers[i].id = i;
+		workers[i].steals = 0;
+		pthread_create(&handles[i],NULL,worker_main,&workers[i]);
+	}
+	*steals = 0;
+	for(i=0;i<threads;i++){
+		pthread_join(handles[i],NULL);
+		*steals += workers[i].steals;
+	}
+	clock_gettime(CLOCK_MONOTONIC,&end);
+
+	for(i=0;i<threads;i++){
+		pthread_mutex_destroy(&queues[i].lock);
+	}
+	free(queues);
+
+	return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec)/1e9;
+}
+
+static int compare_double(const void * a,const void * b){
+
+	double x = *(const double *)a;
+	double y = *(const double *)b;
+	return (x > y) - (x < y);
+}
+
+static double percentile(const double * sorted,size_t n,double p){
+
+	double pos = p*(n - 1);
+	size_t i = (size_t)pos;
+
+	if(i + 1 >= n){
+		return sorted[n - 1];
+	}
+	return sorted[i] + (pos - i)*(sorted[i + 1] - sorted[i]);
+}
+
+static void print_metric(metric_t * m,int histogram){
+
+	double sum = 0,sq = 0,mean,std;
+	size_t i;
+
+	if(m->n == 0){
+		printf("%-28s %7s\n",m->name,"-");
+		return;
+	}
+
+	qsort(m->values,m->n,sizeof(double),compare_double);
+	for(i=0;i<m->n;i++){
+		sum += m->values[i];
+		sq += m->values[i]*m->values[i];
+	}
+	mean = sum/m->n;
+	std = sqrt(fabs(sq/m->n - mean*mean));
+
+	printf("%-28s %7zu %9.2f %9.2f %9.2f %9.2f %9.2f %9.2f %9.2f\n",m->name,m->n,mean,std,m->values[0],
+			percentile(m->values,m->n,0.05),percentile(m->values,m->n,0.5),percentile(m->values,m->n,0.95),m->values[m->n - 1]);
+
+	if(histogram && m->values[m->n - 1] > m->values[0]){
+
+		size_t bins[HISTOGRAM_BINS] = {0};
+		size_t largest = 0;
+		double low = m->values[0];
+		double width = (m->values[m->n - 1] - low)/HISTOGRAM_BINS;
+
+		for(i=0;i<m->n;i++){
+			size_t b = (size_t)((m->values[i] - low)/width);
+			bins[b < HISTOGRAM_BINS ? b : HISTOGRAM_BINS - 1]++;
+		}
+		for(i=0;i<HISTOGRAM_BINS;i++){
+			if(bins[i] > largest){
+				largest = bins[i];
+			}
+		}
+		for(i=0;i<HISTOGRAM_BINS;i++){
+			int bar = (int)(40.0*bins[i]/largest);
+			printf("    %9.2f | %-40.*s %zu\n",low + i*width,bar,"########################################",bins[i]);
+		}
+	}
+}
+
+static void report(const simResult_t * results,size_t flights,int histogram){
+
+	metric_t metrics[] = {
+		{"launch detect latency [ms]",NULL,0},
+		{"apogee altitude [m]",NULL,0},
+		{"drogue time - apogee [s]",NULL,0},
+		{"drogue alt - apogee [m]",NULL,0},
+		{"drogue vertical speed [m/s]",NULL,0},
+		{"main alt - target [m]",NULL,0},
+		{"land detect latency [s]",NULL,0},
+	};
+	size_t count = sizeof(metrics)/sizeof(metrics[0]);
+	size_t no_launch = 0,early_launch = 0,climbing_drogue = 0,backup_drogue = 0,backup_main = 0,high_main = 0,no_main = 0,false_land = 0;
+	size_t i;
+
+	for(i=0;i<count;i++){
+		metrics[i].values = malloc(flights*sizeof(double));
+	}
+
+	for(i=0;i<flights;i++){
+
+		const simResult_t * r = &results[i];
+
+		if(r->launch_detect < 0){
+			no_launch++;
+			continue;
+		}
+		if(r->launch_detect < r->ignition){
+			early_launch++;
+		}
+		else{
+			metrics[0].values[metrics[0].n++] = (r->launch_detect - r->ignition)*1000;
+		}
+		metrics[1].values[metrics[1].n++] = r->apogee_altitude;
+
+		if(r->drogue_fire >= 0){
+			metrics[2].values[metrics[2].n++] = r->drogue_fire - r->apogee_time;
+			metrics[3].values[metrics[3].n++] = r->drogue_altitude - r->apogee_altitude;
+			metrics[4].values[metrics[4].n++] = r->drogue_velocity;
+			climbing_drogue += (r->drogue_velocity > 0);
+			backup_drogue += r->drogue_backup;
+		}
+		if(r->main_fire >= 0){
+			metrics[5].values[metrics[5].n++] = r->main_altitude - MAIN_ALTITUDE;
+			backup_main += r->main_backup;
+			high_main += (r->main_altitude > 2*MAIN_ALTITUDE);
+		}
+		else{
+			no_main++;
+		}
+		if(r->land_detect >= 0){
+			if(r->touchdown < 0 || r->land_detect < r->touchdown){
+				false_land++;
+			}
+			else{
+				metrics[6].values[metrics[6].n++] = r->land_detect - r->touchdown;
+			}
+		}
+	}
+
+	printf("%-28s %7s %9s %9s %9s %9s %9s %9s %9s\n","metric","n","mean","std","min","p5","p50","p95","max");
+	for(i=0;i<count;i++){
+		print_metric(&metrics[i],histogram);
+		free(metrics[i].values);
+	}
+
+	printf("\nFalse or missed triggers out of %zu flights:\n",flights);
+	printf("  launch not detected:           %zu\n",no_launch);
+	printf("  launch detected on the pad:    %zu\n",early_launch);
+	printf("  drogue fired while climbing:   %zu\n",climbing_drogue);
+	printf("  drogue fired by backup timer:  %zu\n",backup_drogue);
+	printf("  main not fired:                %zu\n",no_main);
+	printf("  main fired above %4.0f m:       %zu\n",2*MAIN_ALTITUDE,high_main);
+	printf("  main fired by backup timer:    %zu\n",backup_main);
+	printf("  landing detected in the air:   %zu\n",false_land);
+}
+
+static void usage(const char * name){
+
+	fprintf(stderr,
+		"Usage: %s [options]\n"
+		"  -n flights      number of flights (default 1000)\n"
+		"  -j threads      worker threads (default: all cores)\n"
+		"  -S              run with 1..threads workers and report the speedup\n"
+		"  -s seed         random seed\n"
+		"  -1              1D vertical flights (no wind, no rail angle)\n"
+		"  -H              print histograms\n"
+		"  -T N -B s       average thrust [N] and burn time [s]\n"
+		"  -M kg -P kg     liftoff mass and propellant mass [kg]\n"
+		"  -w m/s          mean wind speed at 10 m\n"
+		"  -A range        accelerometer range code (ac_range, default %d)\n"
+		"  -G range        gyroscope range code (gy_range, default %d)\n"
+		"  -O os           pressure oversampling code (pres_os, default %d)\n"
+		"  -I coef         IIR filter code (iir_coef, default %d)\n"
+		"  -R odr          BMP388 ODR code (bmp_odr, default %d)\n"
+		"  -a Hz           accelerometer sample rate (acc_rate, default %d, up to %d)\n"
+		"  -g Hz           gyroscope sample rate (gyro_rate, default %d, up to %d)\n"
+		"  -b Hz           BMP388 sample rate (bmp_rate, default %d, up to %d)\n"
+		"  -k rate         pad knocks per second\n"
+		"  -e percent      chance an e-match does not open after firing\n",
+		name,ACC_RANGE,GYRO_RANGE,PRES_OS,BMP_IIR,BMP_ODR,ACC_RATE,MAX_IMU_RATE,GYRO_RATE,MAX_IMU_RATE,BMP_RATE,MAX_BMP_RATE);
+}
+
+int main(int argc,char ** argv){
+
+	simConfig_t config = {
+		.planar = 1,
+		.mass = 24.0, .propellant = 4.2, .thrust = 2000, .burn_time = 4.0,
+		.cd = 0.45, .diameter = 0.152, .drogue_cda = 0.6, .main_cda = 10.0,
+		.rail_angle = 4, .wind = 4, .site_altitude = 1400, .pad_temperature = 30,
+		.thrust_sigma = 0.05, .burn_sigma = 0.03, .mass_sigma = 0.02, .cd_sigma = 0.08,
+		.wind_sigma = 2.5, .gust_sigma = 1.5, .pad_knock_rate = 0.01,
+		.acc_noise = 0.005, .acc_bias = 0.02, .gyro_noise = 0.1, .gyro_bias = 0.5,
+		.pres_noise = 3.0, .pres_bias = 30,
+		.ac_range = ACC_RANGE, .gy_range = GYRO_RANGE, .bmp_odr = BMP_ODR, .pres_os = PRES_OS,
+		.iir_coef = BMP_IIR, .acc_rate = ACC_RATE, .gyro_rate = GYRO_RATE, .bmp_rate = BMP_RATE,
+		.ematch_fail_percent = 0, .seed = 2020,
+	};
+	size_t flights = 1000;
+	int threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	int scaling = 0;
+	int histogram = 0;
+	simResult_t * results;
+	size_t steals;
+	double seconds;
+	int opt;
+
+	while((opt = getopt(argc,argv,"n:j:Ss:1HT:B:M:P:w:A:G:O:I:R:a:g:b:k:e:")) != -1){
+		switch(opt){
+			case 'n': flights = strtoul(optarg,NULL,0); break;
+			case 'j': threads = atoi(optarg); break;
+			case 'S': scaling = 1; break;
+			case 's': config.seed = strtoull(optarg,NULL,0); break;
+			case '1': config.planar = 0; break;
+			case 'H': histogram = 1; break;
+			case 'T': config.thrust = atof(optarg); break;
+			case 'B': config.burn_time = atof(optarg); break;
+			case 'M': config.mass = atof(optarg); break;
+			case 'P': config.propellant = atof(optarg); break;
+			case 'w': config.wind = atof(optarg); break;
+			case 'A': config.ac_range = atoi(optarg); break;
+			case 'G': config.gy_range = atoi(optarg); break;
+			case 'O': config.pres_os = atoi(optarg); break;
+			case 'I': config.iir_coef = atoi(optarg); break;
+			case 'R': config.bmp_odr = atoi(optarg); break;
+			case 'a': config.acc_rate = atoi(optarg); break;
+			case 'g': config.gyro_rate = atoi(optarg); break;
+			case 'b': config.bmp_rate = atoi(optarg); break;
+			case 'k': config.pad_knock_rate = atof(optarg); break;
+			case 'e': config.ematch_fail_percent = atoi(optarg); break;
+			default: usage(argv[0]); return 2;
+		}
+	}
+	if(flights == 0 || threads < 1 || threads > MAX_THREADS ||
+			config.acc_rate == 0 || config.acc_rate > MAX_IMU_RATE || config.gyro_rate == 0 || config.gyro_rate > MAX_IMU_RATE ||
+			config.bmp_rate == 0 || config.bmp_rate > MAX_BMP_RATE){
+		usage(argv[0]);
+		return 2;
+	}
+
+	results = calloc(flights,sizeof(simResult_t));
+	if(results == NULL){
+		return 1;
+	}
+
+	if(scaling){
+
+		double base = 0;
+		int t;
+
+		printf("%7s %10s %12s %8s %7s\n","threads","time [s]","flights/s","speedup","steals");
+		for(t=1;t<=threads;t++){
+			seconds = run_pool(&config,results,flights,t,&steals);
+			if(t == 1){
+				base = seconds;
+			}
+			printf("%7d %10.3f %12.1f %8.2f %7zu\n",t,seconds,flights/seconds,base/seconds,steals);
+		}
+		printf("\n");
+	}
+	else{
+		seconds = run_pool(&config,results,flights,threads,&steals);
+		printf("%zu flights on %d threads in %.3f s (%.1f flights/s, %zu steals)\n\n",flights,threads,seconds,flights/seconds,steals);
+	}
+
+	report(results,flights,histogram);
+
+	free(results);
+	return 0;
+}
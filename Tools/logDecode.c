@@ -0,0 +1,852 @@
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// UMSATS 2018-2020
+//
+// Repository:
+//  UMSATS/Avionics-2019
+//
+// File Description:
+//  Parallel decoder for a dump of the flight log, as sent by the xtract read command.
+//
+//  Every page starts with its sequence number and the offset of the first packet that starts in it (logPacket.h), so
+//  the dump is split into runs of pages and each thread decodes its own run: it starts at the first packet of its first
+//  good page and finishes the packet that runs over the end of its run. A page with a bad CRC, erased, or with the
+//  sequence number of another page is skipped, and decoding carries on at the first packet of the next good page.
+//  Times come from the sync records. Measurements before the first sync record of a run are timed from the start of
+//  the run, and get their time from the run before once all the threads are done. After a skipped page the time is
+//  not known until the next sync record. The output is the same whatever the number of threads.
+//
+//  Writes every packet to a CSV, prints the page and packet counts, and can damage the dump first (-x, -z) to show what
+//  is recovered, or time the decode with different numbers of threads (-b).
+//
+//  Build (from the repository root):
+//   gcc -O2 -pthread -IAvionicsSoftware-AtollicProject/Inc Tools/logDecode.c AvionicsSoftware-AtollicProject/Src/logPacket.c
+//       AvionicsSoftware-AtollicProject/Src/crc.c -o logDecode
+//
+// History
+// 2026-10-19
+// - Created.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#define _DEFAULT_SOURCE
+#include <pthread.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "logPacket.h"
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// DEFINITIONS AND MACROS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//Must match flash.h.
+#define FLASH_START_ADDRESS		0x6000
+
+#define MAX_THREADS				64
+#define MAX_LINE				160			//Longest CSV line.
+#define MAX_PACKET				(HEADER_SIZE+EXT_MAX_PAYLOAD)
+
+#define CSV_HEADER	"time_us,address,kind,events,acc_x,acc_y,acc_z,gyro_x,gyro_y,gyro_z,pressure,temperature,altitude\n"
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// ENUMS AND ENUM TYPEDEFS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+typedef enum{
+
+	PAGE_GOOD,
+	PAGE_BAD,				//Bad CRC.
+	PAGE_ERASED,
+	PAGE_MISPLACED,			//Good CRC, but the sequence number of another page.
+
+}pageStatus_t;
+
+typedef enum{
+
+	CLOCK_UNKNOWN,			//At the start of the log or after a skipped page, until a sync record.
+	CLOCK_RELATIVE,			//From the start of the run of pages, until a sync record.
+	CLOCK_KNOWN,
+
+}clockState_t;
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// STRUCTS AND STRUCT TYPEDEFS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+typedef struct{
+
+	uint32_t address;			//Flash address of the packet.
+	uint32_t header;
+	uint32_t time_us;
+	uint8_t clock;				//clockState_t of time_us.
+	int16_t acc[3];
+	int16_t gyro[3];
+	uint32_t pressure;
+	int32_t temperature;
+	float altitude;
+
+}decodedPacket_t;
+
+typedef struct{
+
+	const uint8_t * image;
+	long pages;					//Pages in the whole dump.
+	long first_page;			//Run of pages decoded by this thread.
+	long end_page;
+
+	decodedPacket_t * packets;
+	long count;
+	long capacity;
+	long page_counts[4];		//Pages of the run with each pageStatus_t.
+	long cut;					//Packets cut off by a skipped page.
+
+	clockState_t start_clock;	//Clock at the first packet of the run.
+	clockState_t clock;			//Clock after the last packet.
+	uint32_t time_us;
+	int end_clean;				//Set when the last packet ends where the next run starts, with no skipped page.
+
+	char * text;
+	size_t text_length;
+
+	double decode_cpu;			//s of thread CPU time.
+	double format_cpu;
+
+}decodeRun_t;
+
+typedef struct{
+
+	decodeRun_t runs[MAX_THREADS];
+	int threads;
+	double merge_wall;			//s
+
+}decodeJob_t;
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// FUNCTIONS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+static double now_s(clockid_t id){
+
+	struct timespec t;
+
+	clock_gettime(id,&t);
+	return t.tv_sec + t.tv_nsec*1e-9;
+}
+
+static pageStatus_t page_status(const uint8_t * image,long index){
+
+	const uint8_t * page = &image[index*LOG_PAGE_SIZE];
+	int i;
+
+	if(log_page_check(page)){
+		return (log_page_sequence(page) == (uint16_t)index) ? PAGE_GOOD : PAGE_MISPLACED;
+	}
+	for(i=0;i<LOG_PAGE_SIZE;i++){
+		if(page[i] != 0xFF){
+			return PAGE_BAD;
+		}
+	}
+	return PAGE_ERASED;
+}
+
+//Status of a page, from the statuses of the run when it is in the run.
+static pageStatus_t status_of(const decodeRun_t * run,const uint8_t * statuses,long index){
+
+	if(index >= run->first_page && index < run->end_page){
+		return statuses[index - run->first_page];
+	}
+	return page_status(run->image,index);
+}
+
+//Copies length packet bytes from *page, *offset on, into dest, moving on to the next page at the end of one.
+//Returns 0 if a page it needs is skipped or past the end of the dump, and leaves *page at that page.
+static int read_bytes(const decodeRun_t * run,const uint8_t * statuses,long * page,uint16_t * offset,uint8_t * dest,uint16_t length){
+
+	while(length > 0){
+
+		uint16_t count;
+
+		if(*offset == LOG_PAGE_DATA_SIZE){
+
+			(*page)++;
+			*offset = 0;
+			if(*page >= run->pages || status_of(run,statuses,*page) != PAGE_GOOD){
+				return 0;
+			}
+		}
+
+		count = LOG_PAGE_DATA_SIZE - *offset;
+		if(count > length){
+			count = length;
+		}
+		memcpy(dest,&run->image[*page*LOG_PAGE_SIZE + LOG_PAGE_HEADER_SIZE + *offset],count);
+		dest += count;
+		*offset += count;
+		length -= count;
+	}
+
+	return 1;
+}
+
+//Finds the first packet start from page on, before the end of the run. A skipped page on the way loses the clock.
+static int find_start(decodeRun_t * run,const uint8_t * statuses,long * page,uint16_t * offset){
+
+	for(;*page<run->end_page;(*page)++){
+
+		if(statuses[*page - run->first_page] != PAGE_GOOD){
+			run->clock = CLOCK_UNKNOWN;
+			continue;
+		}
+		if(log_page_first_packet(&run->image[*page*LOG_PAGE_SIZE]) < LOG_PAGE_DATA_SIZE){
+			*offset = log_page_first_packet(&run->image[*page*LOG_PAGE_SIZE]);
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static int add_packet(decodeRun_t * run,uint32_t address,const uint8_t * data,uint8_t length){
+
+	uint32_t header = log_packet_header(data);
+	decodedPacket_t * d;
+	const uint8_t * p = &data[HEADER_SIZE];
+	int k;
+
+	if(run->count == run->capacity){
+
+		long capacity = run->capacity ? 2*run->capacity : 4096;
+		decodedPacket_t * packets = realloc(run->packets,capacity*sizeof(decodedPacket_t));
+
+		if(packets == NULL){
+			return -1;
+		}
+		run->packets = packets;
+		run->capacity = capacity;
+	}
+
+	d = &run->packets[run->count++];
+	memset(d,0,sizeof(decodedPacket_t));
+	d->address = address;
+	d->header = header;
+
+	if((header & TYPE_MASK) == 0){
+
+		if(((header & EXT_KIND_MASK) >> EXT_KIND_SHIFT) == EXT_KIND_SYNC && length == SYNC_RECORD_SIZE){
+			run->time_us = log_packet_sync_time(data);
+			run->clock = CLOCK_KNOWN;
+		}
+		d->time_us = run->time_us;
+		d->clock = run->clock;
+		return 0;
+	}
+
+	run->time_us += log_packet_delta_us(header);
+	d->time_us = run->time_us;
+	d->clock = run->clock;
+
+	if(header & ACC_TYPE){
+		for(k=0;k<3;k++){
+			d->acc[k] = (int16_t)((p[2*k] << 8) | p[2*k+1]);
+		}
+		p += ACC_LENGTH;
+	}
+	if(header & GYRO_TYPE){
+		for(k=0;k<3;k++){
+			d->gyro[k] = (int16_t)((p[2*k] << 8) | p[2*k+1]);
+		}
+		p += GYRO_LENGTH;
+	}
+	if(header & PRES_TYPE){
+		d->pressure = ((uint32_t)p[0] << 16) | (p[1] << 8) | p[2];
+		p += PRES_LENGTH;
+	}
+	if(header & TEMP_TYPE){
+		d->temperature = ((int32_t)(((uint32_t)p[0] << 24) | (p[1] << 16) | (p[2] << 8))) >> 8;	//Sign extend 24 bits.
+		p += TEMP_LENGTH;
+	}
+	if((header & (PRES_TYPE | TEMP_TYPE)) == (PRES_TYPE | TEMP_TYPE)){
+
+		uint32_t bits = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+		memcpy(&d->altitude,&bits,sizeof(float));
+	}
+
+	return 0;
+}
+
+//Decodes the packets that start in the pages of a run.
+static void decode_run(decodeRun_t * run){
+
+	uint8_t * statuses = malloc(run->end_page - run->first_page + 1);
+	uint8_t packet[MAX_PACKET];
+	long page = run->first_page;
+	uint16_t offset = 0;
+	long i;
+
+	run->count = 0;
+	run->cut = 0;
+	run->end_clean = 0;
+	memset(run->page_counts,0,sizeof(run->page_counts));
+
+	for(i=run->first_page;i<run->end_page;i++){
+		statuses[i - run->first_page] = page_status(run->image,i);
+		run->page_counts[statuses[i - run->first_page]]++;
+	}
+
+	//The first run starts with no time, the others with the time from the start of the run until the merge.
+	run->clock = (run->first_page == 0) ? CLOCK_UNKNOWN : CLOCK_RELATIVE;
+	run->time_us = 0;
+
+	if(!find_start(run,statuses,&page,&offset)){
+		run->start_clock = run->clock;
+		free(statuses);
+		return;
+	}
+	run->start_clock = run->clock;
+
+	while(1){
+
+		long start_page;
+		uint16_t start_offset;
+		uint32_t header;
+		uint8_t length;
+
+		//Any packet starting after the run belongs to the next one.
+		if(offset == LOG_PAGE_DATA_SIZE){
+			page++;
+			offset = 0;
+			if(page >= run->end_page){
+				run->end_clean = 1;
+				break;
+			}
+			if(statuses[page - run->first_page] != PAGE_GOOD){
+				if(!find_start(run,statuses,&page,&offset)){
+					break;
+				}
+			}
+		}
+		if(page >= run->end_page){
+			run->end_clean = 1;
+			break;
+		}
+
+		start_page = page;
+		start_offset = offset;
+
+		if(!read_bytes(run,statuses,&page,&offset,packet,HEADER_SIZE)){
+			length = 0;
+		}
+		else{
+			header = log_packet_header(packet);
+			length = (header == 0xFFFFFF) ? 0 : log_packet_length(header);
+			if(length > 0 && !read_bytes(run,statuses,&page,&offset,&packet[HEADER_SIZE],length - HEADER_SIZE)){
+				length = 0;
+			}
+		}
+
+		if(length == 0){
+
+			//Cut off by a skipped page, or not a packet. Carry on at the next packet start.
+			run->cut++;
+			run->clock = CLOCK_UNKNOWN;
+			page = (page > start_page) ? page : start_page + 1;
+			if(page >= run->end_page || !find_start(run,statuses,&page,&offset)){
+				break;
+			}
+			continue;
+		}
+
+		if(add_packet(run,FLASH_START_ADDRESS + start_page*LOG_PAGE_SIZE + LOG_PAGE_HEADER_SIZE + start_offset,packet,length) != 0){
+			break;
+		}
+	}
+
+	free(statuses);
+}
+
+static void format_run(decodeRun_t * run){
+
+	char * out;
+	long i;
+
+	run->text = malloc(run->count*MAX_LINE + 1);
+	run->text_length = 0;
+	if(run->text == NULL){
+		return;
+	}
+	out = run->text;
+
+	for(i=0;i<run->count;i++){
+
+		const decodedPacket_t * d = &run->packets[i];
+		uint32_t header = d->header;
+
+		if(d->clock == CLOCK_KNOWN){
+			out += sprintf(out,"%lu",(unsigned long)d->time_us);
+		}
+		out += sprintf(out,",%lu,",(unsigned long)d->address);
+
+		if((header & TYPE_MASK) == 0){
+			out += sprintf(out,"x%02lX,,,,,,,,,,\n",(unsigned long)((header & EXT_KIND_MASK) >> EXT_KIND_SHIFT));
+			continue;
+		}
+
+		out += sprintf(out,"m,%02lX",(unsigned long)((header & EVENT_MASK) >> EXT_KIND_SHIFT));
+		if(header & ACC_TYPE){
+			out += sprintf(out,",%d,%d,%d",d->acc[0],d->acc[1],d->acc[2]);
+		}
+		else{
+			out += sprintf(out,",,,");
+		}
+		if(header & GYRO_TYPE){
+			out += sprintf(out,",%d,%d,%d",d->gyro[0],d->gyro[1],d->gyro[2]);
+		}
+		else{
+			out += sprintf(out,",,,");
+		}
+		out += (header & PRES_TYPE) ? sprintf(out,",%lu",(unsigned long)d->pressure) : sprintf(out,",");
+		out += (header & TEMP_TYPE) ? sprintf(out,",%ld",(long)d->temperature) : sprintf(out,",");
+		out += ((header & (PRES_TYPE | TEMP_TYPE)) == (PRES_TYPE | TEMP_TYPE)) ? sprintf(out,",%.2f\n",d->altitude) : sprintf(out,",\n");
+	}
+
+	run->text_length = out - run->text;
+}
+
+static void * decode_thread(void * arg){
+
+	decodeRun_t * run = (decodeRun_t *)arg;
+	double start = now_s(CLOCK_THREAD_CPUTIME_ID);
+
+	decode_run(run);
+	run->decode_cpu = now_s(CLOCK_THREAD_CPUTIME_ID) - start;
+	return NULL;
+}
+
+static void * format_thread(void * arg){
+
+	decodeRun_t * run = (decodeRun_t *)arg;
+	double start = now_s(CLOCK_THREAD_CPUTIME_ID);
+
+	format_run(run);
+	run->format_cpu = now_s(CLOCK_THREAD_CPUTIME_ID) - start;
+	return NULL;
+}
+
+//Gives each run the time from the end of the run before, in page order.
+static void merge_runs(decodeJob_t * job){
+
+	clockState_t clock = CLOCK_UNKNOWN;
+	uint32_t time_us = 0;
+	int t;
+
+	for(t=0;t<job->threads;t++){
+
+		decodeRun_t * run = &job->runs[t];
+		long i;
+
+		if(run->start_clock == CLOCK_RELATIVE){
+
+			for(i=0;i<run->count && run->packets[i].clock == CLOCK_RELATIVE;i++){
+				run->packets[i].clock = clock;
+				run->packets[i].time_us += time_us;
+			}
+			if(run->clock == CLOCK_RELATIVE){
+				run->clock = clock;
+				run->time_us += time_us;
+			}
+		}
+
+		//The time carries on into the next run only if nothing was skipped at the end of this one.
+		clock = run->end_clean ? run->clock : CLOCK_UNKNOWN;
+		time_us = run->time_us;
+	}
+}
+
+static void run_threads(decodeJob_t * job,void * (*function)(void *)){
+
+	pthread_t threads[MAX_THREADS];
+	int t;
+
+	for(t=1;t<job->threads;t++){
+		pthread_create(&threads[t],NULL,function,&job->runs[t]);
+	}
+	function(&job->runs[0]);
+	for(t=1;t<job->threads;t++){
+		pthread_join(threads[t],NULL);
+	}
+}
+
+//Decodes the dump with the given number of threads, each with an equal run of pages.
+static void decode_job(decodeJob_t * job,const uint8_t * image,long pages,int threads){
+
+	double start;
+	int t;
+
+	if(threads > pages){
+		threads = (pages > 0) ? pages : 1;
+	}
+	job->threads = threads;
+
+	for(t=0;t<threads;t++){
+
+		decodeRun_t * run = &job->runs[t];
+
+		free(run->text);
+		run->text = NULL;
+		run->image = image;
+		run->pages = pages;
+		run->first_page = pages*t/threads;
+		run->end_page = pages*(t+1)/threads;
+	}
+
+	run_threads(job,decode_thread);
+
+	start = now_s(CLOCK_MONOTONIC);
+	merge_runs(job);
+	job->merge_wall = now_s(CLOCK_MONOTONIC) - start;
+
+	run_threads(job,format_thread);
+}
+
+static void free_job(decodeJob_t * job){
+
+	int t;
+
+	for(t=0;t<MAX_THREADS;t++){
+		free(job->runs[t].packets);
+		free(job->runs[t].text);
+	}
+	memset(job,0,sizeof(decodeJob_t));
+}
+
+static long job_sum(const decodeJob_t * job,size_t field){
+
+	long sum = 0;
+	int t;
+
+	for(t=0;t<job->threads;t++){
+		sum += *(const long *)((const char *)&job->runs[t] + field);
+	}
+	return sum;
+}
+
+//Returns 1 if both decodes wrote the same CSV.
+static int same_output(const decodeJob_t * a,const decodeJob_t * b){
+
+	size_t ia = 0,ib = 0;
+	size_t oa = 0,ob = 0;
+
+	while(ia < (size_t)a->threads && ib < (size_t)b->threads){
+
+		const decodeRun_t * ra = &a->runs[ia];
+		const decodeRun_t * rb = &b->runs[ib];
+		size_t n = ra->text_length - oa;
+
+		if(rb->text_length - ob < n){
+			n = rb->text_length - ob;
+		}
+		if(memcmp(&ra->text[oa],&rb->text[ob],n) != 0){
+			return 0;
+		}
+		oa += n;
+		ob += n;
+		if(oa == ra->text_length){
+			ia++;
+			oa = 0;
+		}
+		if(ob == rb->text_length){
+			ib++;
+			ob = 0;
+		}
+	}
+
+	//Skip empty runs at the end.
+	while(ia < (size_t)a->threads && a->runs[ia].text_length == oa){
+		ia++;
+		oa = 0;
+	}
+	while(ib < (size_t)b->threads && b->runs[ib].text_length == ob){
+		ib++;
+		ob = 0;
+	}
+	return ia == (size_t)a->threads && ib == (size_t)b->threads;
+}
+
+static const decodedPacket_t * find_packet(const decodeJob_t * job,uint32_t address){
+
+	int t;
+
+	for(t=0;t<job->threads;t++){
+
+		const decodeRun_t * run = &job->runs[t];
+		long low = 0;
+		long high = run->count;
+
+		if(run->count == 0 || address > run->packets[run->count-1].address){
+			continue;
+		}
+		while(low < high){
+
+			long mid = (low + high)/2;
+
+			if(run->packets[mid].address < address){
+				low = mid + 1;
+			}
+			else{
+				high = mid;
+			}
+		}
+		return (run->packets[low].address == address) ? &run->packets[low] : NULL;
+	}
+	return NULL;
+}
+
+static void print_counts(const decodeJob_t * job){
+
+	long packets = job_sum(job,offsetof(decodeRun_t,count));
+	long timed = 0;
+	int t;
+	long i;
+
+	for(t=0;t<job->threads;t++){
+		for(i=0;i<job->runs[t].count;i++){
+			timed += (job->runs[t].packets[i].clock == CLOCK_KNOWN);
+		}
+	}
+
+	printf("Pages: %ld good, %ld bad CRC, %ld erased, %ld out of place.\n",
+		job_sum(job,offsetof(decodeRun_t,page_counts[PAGE_GOOD])),job_sum(job,offsetof(decodeRun_t,page_counts[PAGE_BAD])),
+		job_sum(job,offsetof(decodeRun_t,page_counts[PAGE_ERASED])),job_sum(job,offsetof(decodeRun_t,page_counts[PAGE_MISPLACED])));
+	printf("Packets: %ld decoded, %ld with a time, %ld cut off by a skipped page.\n",packets,timed,job_sum(job,offsetof(decodeRun_t,cut)));
+}
+
+//Compares the decode of the damaged dump against the decode of the original.
+static void print_recovery(const decodeJob_t * damaged,const decodeJob_t * original){
+
+	long kept = 0;
+	long wrong = 0;
+	long untimed = 0;
+	long total = job_sum(original,offsetof(decodeRun_t,count));
+	int t;
+	long i;
+
+	for(t=0;t<damaged->threads;t++){
+		for(i=0;i<damaged->runs[t].count;i++){
+
+			const decodedPacket_t * d = &damaged->runs[t].packets[i];
+			const decodedPacket_t * o = find_packet(original,d->address);
+
+			if(o == NULL || o->header != d->header || memcmp(o->acc,d->acc,sizeof(o->acc)) != 0 ||
+					memcmp(o->gyro,d->gyro,sizeof(o->gyro)) != 0 || o->pressure != d->pressure || o->temperature != d->temperature){
+				wrong++;
+			}
+			else if(d->clock != CLOCK_KNOWN){
+				untimed++;
+			}
+			else if(d->time_us != o->time_us){
+				wrong++;
+			}
+			else{
+				kept++;
+			}
+		}
+	}
+
+	printf("Recovered %ld of %ld packets with their time, %ld more without a time, %ld wrong.\n",kept,total,untimed,wrong);
+}
+
+//Flips a bit in count pages chosen at random, and erases a run of pages.
+static void damage(uint8_t * image,long pages,long count,long erase_first,long erase_count){
+
+	long i;
+
+	for(i=0;i<count && pages > 0;i++){
+
+		long page = rand() % pages;
+		image[page*LOG_PAGE_SIZE + rand() % LOG_PAGE_SIZE] ^= 1 << (rand() % 8);
+	}
+	for(i=erase_first;i<erase_first + erase_count && i < pages;i++){
+		memset(&image[i*LOG_PAGE_SIZE],0xFF,LOG_PAGE_SIZE);
+	}
+}
+
+static int write_csv(const decodeJob_t * job,const char * path){
+
+	FILE * f = fopen(path,"w");
+	int t;
+
+	if(f == NULL){
+		perror(path);
+		return -1;
+	}
+	fputs(CSV_HEADER,f);
+	for(t=0;t<job->threads;t++){
+		fwrite(job->runs[t].text,1,job->runs[t].text_length,f);
+	}
+	fclose(f);
+	return 0;
+}
+
+//Times the decode with 1 thread and with twice as many each time up to threads, and checks the output is the same.
+//The critical path is the slowest thread of each step plus the merge, which is the time the decode would take with a
+//core for each thread.
+static void benchmark(const uint8_t * image,long pages,int threads,long repeat){
+
+	static decodeJob_t reference;
+	static decodeJob_t job;
+	double single = 0;
+	int n;
+
+	printf("%ld cores online.\n",sysconf(_SC_NPROCESSORS_ONLN));
+	printf("threads   wall ms   MB/s   cpu ms   critical ms   speedup   same\n");
+
+	decode_job(&reference,image,pages,1);
+
+	for(n=1;;n=(n*2 < threads) ? n*2 : threads){
+
+		double wall = 0;
+		double cpu = 0;
+		double critical = 0;
+		long r;
+		int t;
+
+		for(r=0;r<repeat;r++){
+
+			double start = now_s(CLOCK_MONOTONIC);
+			double decode_max = 0;
+			double format_max = 0;
+
+			decode_job(&job,image,pages,n);
+			wall += now_s(CLOCK_MONOTONIC) - start;
+
+			for(t=0;t<job.threads;t++){
+				cpu += job.runs[t].decode_cpu + job.runs[t].format_cpu;
+				decode_max = (job.runs[t].decode_cpu > decode_max) ? job.runs[t].decode_cpu : decode_max;
+				format_max = (job.runs[t].format_cpu > format_max) ? job.runs[t].format_cpu : format_max;
+			}
+			critical += decode_max + job.merge_wall + format_max;
+		}
+
+		wall /= repeat;
+		cpu /= repeat;
+		critical /= repeat;
+		if(n == 1){
+			single = critical;
+		}
+
+		printf("%7d %9.2f %6.0f %8.2f %13.2f %9.2f   %s\n",job.threads,wall*1e3,pages*LOG_PAGE_SIZE/wall/1e6,cpu*1e3,critical*1e3,
+				single/critical,same_output(&job,&reference) ? "yes" : "NO");
+
+		if(n >= threads){
+			break;
+		}
+	}
+
+	free_job(&job);
+	free_job(&reference);
+}
+
+static void usage(const char * name){
+
+	fprintf(stderr,
+		"Usage: %s -d dump.bin [options]\n"
+		"  -j threads   decode with this many threads (default the number of cores)\n"
+		"  -o file      write every packet to a CSV\n"
+		"  -x count     flip a bit in count pages chosen at random first\n"
+		"  -z page:n    erase n pages from this page first\n"
+		"  -s seed      seed for -x (default 1)\n"
+		"  -b           time the decode with 1 to threads threads\n"
+		"  -n count     decodes averaged for each number of threads with -b (default 20)\n",
+		name);
+}
+
+int main(int argc,char ** argv){
+
+	static decodeJob_t job;
+	static decodeJob_t original;
+	const char * dump_path = NULL;
+	const char * csv_path = NULL;
+	int threads = sysconf(_SC_NPROCESSORS_ONLN);
+	long flips = 0;
+	long erase_first = 0;
+	long erase_count = 0;
+	unsigned seed = 1;
+	int bench = 0;
+	long repeat = 20;
+	uint8_t * image;
+	long size;
+	long pages;
+	FILE * f;
+	int opt;
+
+	while((opt = getopt(argc,argv,"d:j:o:x:z:s:bn:")) != -1){
+		switch(opt){
+			case 'd': dump_path = optarg; break;
+			case 'j': threads = strtol(optarg,NULL,0); break;
+			case 'o': csv_path = optarg; break;
+			case 'x': flips = strtol(optarg,NULL,0); break;
+			case 'z':
+				if(sscanf(optarg,"%ld:%ld",&erase_first,&erase_count) != 2){
+					usage(argv[0]);
+					return 2;
+				}
+				break;
+			case 's': seed = strtoul(optarg,NULL,0); break;
+			case 'b': bench = 1; break;
+			case 'n': repeat = strtol(optarg,NULL,0); break;
+			default: usage(argv[0]); return 2;
+		}
+	}
+
+	if(dump_path == NULL || threads < 1 || threads > MAX_THREADS || repeat < 1){
+		usage(argv[0]);
+		return 2;
+	}
+
+	f = fopen(dump_path,"rb");
+	if(f == NULL){
+		perror(dump_path);
+		return 1;
+	}
+	fseek(f,0,SEEK_END);
+	size = ftell(f);
+	fseek(f,0,SEEK_SET);
+	pages = size/LOG_PAGE_SIZE;
+	image = malloc(size > 0 ? size : 1);
+	if(image == NULL || fread(image,1,size,f) != (size_t)size){
+		fprintf(stderr,"Could not read %s.\n",dump_path);
+		return 1;
+	}
+	fclose(f);
+
+	if(bench){
+		benchmark(image,pages,threads,repeat);
+		return 0;
+	}
+
+	if(flips > 0 || erase_count > 0){
+		decode_job(&original,image,pages,threads);
+		srand(seed);
+		damage(image,pages,flips,erase_first,erase_count);
+	}
+
+	decode_job(&job,image,pages,threads);
+	printf("Decoded %ld pages with %d threads.\n",pages,job.threads);
+	print_counts(&job);
+
+	if(flips > 0 || erase_count > 0){
+		print_recovery(&job,&original);
+	}
+
+	if(csv_path != NULL && write_csv(&job,csv_path) != 0){
+		return 1;
+	}
+
+	free_job(&job);
+	free_job(&original);
+	free(image);
+	return 0;
+}
@@ -0,0 +1,388 @@
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// UMSATS 2018-2020
+//
+// Repository:
+//  UMSATS/Avionics-2019
+//
+// File Description:
+//  Puts the flash image back together from a download of the xtract reads command, and a test of the used sector map.
+//
+//  The reads command only sends the runs of sectors that the flash service map has as used, each after a range header
+//  (see xtract.h). With -i the ranges are written to an image from FLASH_START_ADDRESS with 0xFF in between, the same
+//  as a dump from the read command, for flightReplay and logDecode.
+//  With -t it takes an image (from flightReplay -o or a read dump), works out the map the flight computer would have
+//  for it, sends it the way reads does and puts it back together, then compares the sectors erased by memory menu c and
+//  the bytes sent by read before and after the map with the sparse download.
+//
+//  Build (from the repository root):
+//   gcc -O2 -IAvionicsSoftware-AtollicProject/Inc Tools/sparseDump.c -o sparseDump
+//
+// History
+// 2026-10-19
+// - Created.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// DEFINITIONS AND MACROS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//Must match flash.h, flashService.h and xtract.h.
+#define FLASH_PAGE_SIZE			256
+#define FLASH_PARAM_SECTOR_SIZE	(FLASH_PAGE_SIZE*16)
+#define FLASH_SECTOR_SIZE		(FLASH_PAGE_SIZE*256)
+#define FLASH_START_ADDRESS		0x6000
+#define FLASH_SIZE_BYTES		(8000000-FLASH_START_ADDRESS)
+#define FLASH_PARAM_END_ADDRESS	0x1FFFF
+#define FLASH_END_ADDRESS		0x7FFFFF
+#define FLASH_MAP_SECTORS		152
+#define RANGE_MARKER			"RNG:"
+#define RANGE_HEADER_SIZE		12
+
+//Typical erase times from the data sheet.
+#define PARAM_ERASE_US			50000
+#define SECTOR_ERASE_US			500000
+
+#define UART_BAUD				115200
+#define UART_BITS				10			//Start, 8 data and stop bits.
+
+#define IMAGE_SIZE				(FLASH_SIZE_BYTES-FLASH_START_ADDRESS)
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// FUNCTIONS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+static uint32_t get_uint32(const uint8_t * src){
+
+	return ((uint32_t)src[0] << 24) | ((uint32_t)src[1] << 16) | ((uint32_t)src[2] << 8) | src[3];
+}
+
+static void put_uint32(uint8_t * dest,uint32_t value){
+
+	dest[0] = (value >> 24) & 0xFF;
+	dest[1] = (value >> 16) & 0xFF;
+	dest[2] = (value >> 8) & 0xFF;
+	dest[3] = value & 0xFF;
+}
+
+static uint32_t sector_size(uint32_t address){
+
+	return (address > FLASH_PARAM_END_ADDRESS) ? FLASH_SECTOR_SIZE : FLASH_PARAM_SECTOR_SIZE;
+}
+
+static int is_blank(const uint8_t * data,uint32_t length){
+
+	uint32_t i;
+
+	for(i=0;i<length;i++){
+		if(data[i] != 0xFF){
+			return 0;
+		}
+	}
+	return 1;
+}
+
+//image holds the flash from FLASH_START_ADDRESS up to end.
+static int sector_used(const uint8_t * image,uint32_t end,uint32_t address){
+
+	uint32_t stop = address + sector_size(address);
+
+	if(address >= end){
+		return 0;
+	}
+	return !is_blank(&image[address - FLASH_START_ADDRESS],((stop < end) ? stop : end) - address);
+}
+
+//Same as trim_range() in xtract.c.
+static uint32_t trim_range(const uint8_t * image,uint32_t start,uint32_t end){
+
+	while(end > start && is_blank(&image[end - FLASH_PAGE_SIZE - FLASH_START_ADDRESS],FLASH_PAGE_SIZE)){
+		end -= FLASH_PAGE_SIZE;
+	}
+	return end;
+}
+
+static long load_file(const char * path,uint8_t ** data){
+
+	FILE * f = fopen(path,"rb");
+	long size;
+
+	if(f == NULL){
+		perror(path);
+		return -1;
+	}
+	fseek(f,0,SEEK_END);
+	size = ftell(f);
+	fseek(f,0,SEEK_SET);
+
+	*data = malloc(size > 0 ? size : 1);
+	if(*data == NULL || fread(*data,1,size,f) != (size_t)size){
+		fclose(f);
+		return -1;
+	}
+	fclose(f);
+	return size;
+}
+
+//Puts the ranges of a reads download into an image. Anything before a range header, such as the text the command
+//prints first, is skipped. Returns the image length, up to the end of the last range, or -1 if the download is cut off.
+static long rebuild(const uint8_t * capture,long size,uint8_t * image,int verbose){
+
+	long pos = 0;
+	long length = 0;
+	long ranges = 0;
+	long bytes = 0;
+
+	memset(image,0xFF,IMAGE_SIZE);
+
+	while(1){
+
+		uint32_t address;
+		uint32_t count;
+
+		while(pos + RANGE_HEADER_SIZE <= size && memcmp(&capture[pos],RANGE_MARKER,4) != 0){
+			pos++;
+		}
+		if(pos + RANGE_HEADER_SIZE > size){
+			fprintf(stderr,"The download has no end marker, it was cut off.\n");
+			return -1;
+		}
+
+		address = get_uint32(&capture[pos+4]);
+		count = get_uint32(&capture[pos+8]);
+		pos += RANGE_HEADER_SIZE;
+
+		if(count == 0){
+			break;
+		}
+		if(address < FLASH_START_ADDRESS || address + count > FLASH_SIZE_BYTES || pos + count > size){
+			fprintf(stderr,"Range 0x%06X + %u is outside the log or cut off.\n",address,count);
+			return -1;
+		}
+
+		memcpy(&image[address - FLASH_START_ADDRESS],&capture[pos],count);
+		pos += count;
+		ranges++;
+		bytes += count;
+		if((long)(address + count - FLASH_START_ADDRESS) > length){
+			length = address + count - FLASH_START_ADDRESS;
+		}
+		if(verbose){
+			printf("  0x%06X to 0x%06X\n",address,address + count);
+		}
+	}
+
+	printf("%ld ranges, %ld bytes of data, image of %ld bytes.\n",ranges,bytes,length);
+	return length;
+}
+
+static int run_rebuild(const char * in_path,const char * out_path,int verbose){
+
+	uint8_t * capture;
+	uint8_t * image = malloc(IMAGE_SIZE);
+	long size = load_file(in_path,&capture);
+	long length;
+	FILE * f;
+
+	if(size < 0 || image == NULL){
+		return 1;
+	}
+
+	length = rebuild(capture,size,image,verbose);
+	if(length < 0){
+		return 1;
+	}
+
+	f = fopen(out_path,"wb");
+	if(f == NULL){
+		perror(out_path);
+		return 1;
+	}
+	fwrite(image,1,length,f);
+	fclose(f);
+
+	free(capture);
+	free(image);
+	return 0;
+}
+
+static int run_test(const char * in_path,long gap_page,long gap_pages,const char * capture_path,uint32_t baud,int verbose){
+
+	uint8_t * loaded;
+	uint8_t * image = malloc(IMAGE_SIZE);
+	uint8_t * rebuilt = malloc(IMAGE_SIZE);
+	uint8_t * capture = malloc(IMAGE_SIZE + RANGE_HEADER_SIZE*(FLASH_MAP_SECTORS+1));
+	long size = load_file(in_path,&loaded);
+	long capture_size = 0;
+	uint32_t end;
+	uint32_t address;
+	uint32_t scan_end;
+	uint32_t data_end = FLASH_START_ADDRESS;
+	uint16_t used = 0;
+	uint64_t erase_all_us = 0;
+	uint64_t erase_used_us = 0;
+	double byte_s;
+	long length;
+	long i;
+
+	if(size < 0 || image == NULL || rebuilt == NULL || capture == NULL){
+		return 1;
+	}
+
+	memset(image,0xFF,IMAGE_SIZE);
+	memcpy(image,loaded,(size < IMAGE_SIZE) ? size : IMAGE_SIZE);
+	end = FLASH_START_ADDRESS + ((size < IMAGE_SIZE) ? size : IMAGE_SIZE);
+	end -= (end - FLASH_START_ADDRESS) % FLASH_PAGE_SIZE;
+
+	for(i=gap_page;i<gap_page + gap_pages && (FLASH_START_ADDRESS + (i+1)*FLASH_PAGE_SIZE) <= end;i++){
+		memset(&image[i*FLASH_PAGE_SIZE],0xFF,FLASH_PAGE_SIZE);
+	}
+
+	//Memory menu c, before and after the map. The log index and map sectors are left out of both.
+	for(address=FLASH_START_ADDRESS;address<FLASH_END_ADDRESS+1-2*FLASH_SECTOR_SIZE;address+=sector_size(address)){
+
+		uint32_t erase_us = (address > FLASH_PARAM_END_ADDRESS) ? SECTOR_ERASE_US : PARAM_ERASE_US;
+
+		erase_all_us += erase_us;
+		if(sector_used(image,end,address)){
+			erase_used_us += erase_us;
+			used++;
+		}
+	}
+
+	//The reads command: each run of used sectors up to its last page with data.
+	address = FLASH_START_ADDRESS;
+	while(address < end){
+
+		uint32_t range_end = address;
+		uint32_t trimmed;
+
+		if(!sector_used(image,end,address)){
+			address += sector_size(address);
+			continue;
+		}
+		while(range_end < end && sector_used(image,end,range_end)){
+			range_end += sector_size(range_end);
+		}
+		if(range_end > end){
+			range_end = end;
+		}
+
+		trimmed = trim_range(image,address,range_end);
+		if(trimmed > address){
+
+			memcpy(&capture[capture_size],RANGE_MARKER,4);
+			put_uint32(&capture[capture_size+4],address);
+			put_uint32(&capture[capture_size+8],trimmed - address);
+			capture_size += RANGE_HEADER_SIZE;
+			memcpy(&capture[capture_size],&image[address - FLASH_START_ADDRESS],trimmed - address);
+			capture_size += trimmed - address;
+			data_end = trimmed;
+		}
+		address = range_end;
+	}
+	memcpy(&capture[capture_size],RANGE_MARKER,4);
+	put_uint32(&capture[capture_size+4],address);
+	put_uint32(&capture[capture_size+8],0);
+	capture_size += RANGE_HEADER_SIZE;
+
+	//The read command before the map stopped at the first blank page.
+	for(scan_end=FLASH_START_ADDRESS;scan_end<end && !is_blank(&image[scan_end - FLASH_START_ADDRESS],FLASH_PAGE_SIZE);scan_end+=FLASH_PAGE_SIZE);
+
+	length = rebuild(capture,capture_size,rebuilt,verbose);
+	if(length < 0){
+		return 1;
+	}
+
+	byte_s = (double)baud/UART_BITS;
+	printf("Used sectors: %u of %u.\n",used,FLASH_MAP_SECTORS - 2);
+	printf("Erase (memory menu c): all sectors %.1f s, used sectors %.1f s.\n",erase_all_us/1e6,erase_used_us/1e6);
+	printf("Download at %u baud:\n",baud);
+	printf("  read to the first blank page   %8u bytes %7.1f s%s\n",scan_end - FLASH_START_ADDRESS,(scan_end - FLASH_START_ADDRESS)/byte_s,
+			(scan_end < data_end) ? ", cut off" : "");
+	printf("  read to the last page of data  %8u bytes %7.1f s\n",data_end - FLASH_START_ADDRESS,(data_end - FLASH_START_ADDRESS)/byte_s);
+	printf("  reads, used sectors only       %8ld bytes %7.1f s\n",capture_size,capture_size/byte_s);
+	printf("Rebuilt image %s the original.\n",
+			(length == (long)(data_end - FLASH_START_ADDRESS) && memcmp(rebuilt,image,length) == 0) ? "matches" : "DOES NOT MATCH");
+
+	if(capture_path != NULL){
+
+		FILE * f = fopen(capture_path,"wb");
+
+		if(f == NULL){
+			perror(capture_path);
+			return 1;
+		}
+		fwrite(capture,1,capture_size,f);
+		fclose(f);
+	}
+
+	free(loaded);
+	free(image);
+	free(rebuilt);
+	free(capture);
+	return 0;
+}
+
+static void usage(const char * name){
+
+	fprintf(stderr,
+		"Usage: %s -i download.bin -o image.bin [-v]\n"
+		"       %s -t image.bin [-z page:n] [-b baud] [-w download.bin] [-v]\n"
+		"  -i file    download from the xtract reads command\n"
+		"  -o file    image from FLASH_START_ADDRESS, the same as a read dump\n"
+		"  -t file    test with this image\n"
+		"  -z page:n  blank n pages from this page of the image first\n"
+		"  -b baud    xtract UART baud rate for the download times (default %d)\n"
+		"  -w file    write the reads download of the test image\n"
+		"  -v         print each range\n",
+		name,name,UART_BAUD);
+}
+
+int main(int argc,char ** argv){
+
+	const char * in_path = NULL;
+	const char * out_path = NULL;
+	const char * test_path = NULL;
+	const char * capture_path = NULL;
+	long gap_page = 0;
+	long gap_pages = 0;
+	uint32_t baud = UART_BAUD;
+	int verbose = 0;
+	int opt;
+
+	while((opt = getopt(argc,argv,"i:o:t:z:b:w:v")) != -1){
+		switch(opt){
+			case 'i': in_path = optarg; break;
+			case 'o': out_path = optarg; break;
+			case 't': test_path = optarg; break;
+			case 'z':
+				if(sscanf(optarg,"%ld:%ld",&gap_page,&gap_pages) != 2){
+					usage(argv[0]);
+					return 2;
+				}
+				break;
+			case 'b': baud = strtoul(optarg,NULL,0); break;
+			case 'w': capture_path = optarg; break;
+			case 'v': verbose = 1; break;
+			default: usage(argv[0]); return 2;
+		}
+	}
+
+	if(test_path != NULL){
+		return run_test(test_path,gap_page,gap_pages,capture_path,baud,verbose);
+	}
+	if(in_path == NULL || out_path == NULL || baud == 0){
+		usage(argv[0]);
+		return 2;
+	}
+	return run_rebuild(in_path,out_path,verbose);
+}
@@ -0,0 +1,747 @@
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// UMSATS 2018-2020
+//
+// Repository:
+//  UMSATS/Avionics-2019
+//
+// File Description:
+//  Viewer and recorder for the live sensor stream, and a test of the stream over a pseudo terminal.
+//
+//  With -p it reads the records from the xtract serial port while the flight computer is set not to record, prints the
+//  rate of each sensor, the latest readings and the records dropped and lost once a second, and with -o writes every
+//  reading to a CSV. With -c it plays the sensor CSV at the sensor rates through the record queue of the firmware, sends
+//  the frames into a pseudo terminal at the baud rate and reads them from the other end, then prints the rates
+//  achieved, the records dropped on board and lost on the link, and checks every reading against what was sent.
+//
+//  Build (from the repository root):
+//   gcc -O2 -pthread -IAvionicsSoftware-AtollicProject/Inc Tools/streamView.c AvionicsSoftware-AtollicProject/Src/streamFrame.c
+//       AvionicsSoftware-AtollicProject/Src/crc.c -o streamView
+//
+// History
+// 2026-10-19
+// - Created.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#define _XOPEN_SOURCE 600
+#define _DEFAULT_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "streamFrame.h"
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// DEFINITIONS AND MACROS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//Must match liveStream.h and configuration.h.
+#define STREAM_BAUD_RATE		921600
+#define STATS_PERIOD			1000		//ms
+#define ACC_RATE				100			//Hz
+#define GYRO_RATE				100
+#define BMP_RATE				20
+
+#define UART_BATCH				64			//Most bytes written to the pseudo terminal at once.
+#define IDLE_TIMEOUT			500			//ms without bytes after the sender is done before the test ends.
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// STRUCTS AND STRUCT TYPEDEFS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+typedef struct{
+
+	uint32_t time_ms;
+	int16_t acc[3];
+	int16_t gyro[3];
+	uint32_t pressure;		//0.01 Pa
+	int32_t temperature;	//0.01 deg C
+
+}streamSample_t;
+
+//Counts of what was received, for the rates.
+typedef struct{
+
+	uint32_t records;
+	uint32_t acc;
+	uint32_t gyro;
+	uint32_t pres;
+	uint32_t events;
+	uint32_t bytes;
+
+}streamCounts_t;
+
+//Stream test shared between the sender, the UART model and the reader.
+typedef struct{
+
+	streamSample_t * samples;
+	size_t count;
+	uint32_t rates[3];		//Hz of the accelerometer, gyroscope and BMP388.
+	uint32_t baud;
+	double speed;			//Times faster than real time.
+	double error_rate;		//Chance of each byte being damaged.
+	int master;				//Pseudo terminal the frames are written to.
+
+	pthread_mutex_t lock;
+	streamQueue_t queue;
+	int sender_done;
+	int uart_done;
+
+	double start;			//Wall time of time 0, in s.
+	uint32_t end_us;		//Time of the last reading.
+	streamCounts_t sent;
+	uint32_t damaged;
+
+}streamTest_t;
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// CONSTANTS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+static volatile sig_atomic_t stop = 0;
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// FUNCTIONS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+static double now_s(void){
+
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC,&t);
+	return t.tv_sec + t.tv_nsec/1e9;
+}
+
+static void sleep_until(double t){
+
+	double wait = t - now_s();
+
+	if(wait > 0){
+
+		struct timespec d;
+		d.tv_sec = (time_t)wait;
+		d.tv_nsec = (long)((wait - d.tv_sec)*1e9);
+		nanosleep(&d,NULL);
+	}
+}
+
+static void on_signal(int sig){
+
+	(void)sig;
+	stop = 1;
+}
+
+static speed_t baud_code(uint32_t baud){
+
+	switch(baud){
+		case 9600: return B9600;
+		case 19200: return B19200;
+		case 38400: return B38400;
+		case 57600: return B57600;
+		case 115200: return B115200;
+		case 230400: return B230400;
+		case 460800: return B460800;
+		case 921600: return B921600;
+		default: return B0;
+	}
+}
+
+static int set_raw(int fd,uint32_t baud){
+
+	struct termios tio;
+
+	if(tcgetattr(fd,&tio) != 0){
+		return -1;
+	}
+	cfmakeraw(&tio);
+	tio.c_cc[VMIN] = 0;
+	tio.c_cc[VTIME] = 0;
+	if(baud_code(baud) != B0){
+		cfsetispeed(&tio,baud_code(baud));
+		cfsetospeed(&tio,baud_code(baud));
+	}
+	return tcsetattr(fd,TCSANOW,&tio);
+}
+
+static void count_record(streamCounts_t * c,const streamRecord_t * r){
+
+	c->records++;
+	if(r->kind != STREAM_KIND_READING){
+		return;
+	}
+	c->acc += (r->contents & STREAM_HAS_ACC) ? 1 : 0;
+	c->gyro += (r->contents & STREAM_HAS_GYRO) ? 1 : 0;
+	c->pres += (r->contents & STREAM_HAS_PRES) ? 1 : 0;
+	c->events += (r->contents & STREAM_HAS_EVENTS) ? 1 : 0;
+}
+
+//Writes a reading as a line of the CSV. Parts the reading does not have are left empty.
+static void write_reading(FILE * out,const streamRecord_t * r){
+
+	fprintf(out,"%u,%u",r->sequence,r->time_us);
+
+	if(r->contents & STREAM_HAS_ACC){
+		fprintf(out,",%d,%d,%d",r->acc[0],r->acc[1],r->acc[2]);
+	}
+	else{
+		fprintf(out,",,,");
+	}
+	if(r->contents & STREAM_HAS_GYRO){
+		fprintf(out,",%d,%d,%d",r->gyro[0],r->gyro[1],r->gyro[2]);
+	}
+	else{
+		fprintf(out,",,,");
+	}
+	if(r->contents & STREAM_HAS_PRES){
+		fprintf(out,",%u,%d",r->pressure,r->temperature);
+	}
+	else{
+		fprintf(out,",,");
+	}
+	if(r->contents & STREAM_HAS_EVENTS){
+		fprintf(out,",0x%02X\n",r->events);
+	}
+	else{
+		fprintf(out,",\n");
+	}
+}
+
+static FILE * open_output(const char * path){
+
+	FILE * out;
+
+	if(path == NULL){
+		return NULL;
+	}
+	out = fopen(path,"w");
+	if(out == NULL){
+		perror(path);
+		return NULL;
+	}
+	fprintf(out,"sequence,time_us,acc_x,acc_y,acc_z,gyro_x,gyro_y,gyro_z,pressure,temperature,events\n");
+	return out;
+}
+
+//Reads records from a serial port until Ctrl-C. Prints every record with verbose, otherwise the rates and the latest
+//readings once a second.
+static int run_viewer(const char * path,uint32_t baud,const char * out_path,int verbose){
+
+	streamDecoder_t dec;
+	streamCounts_t total;
+	streamCounts_t last;
+	streamRecord_t latest;
+	streamRecord_t stats;
+	uint8_t buffer[4096];
+	double start = now_s();
+	double last_print = start;
+	FILE * out = open_output(out_path);
+	int fd = open(path,O_RDONLY | O_NOCTTY);
+
+	if(fd < 0){
+		perror(path);
+		return 1;
+	}
+	if(set_raw(fd,baud) != 0){
+		fprintf(stderr,"%s: could not set the baud rate, reading as is.\n",path);
+	}
+
+	stream_decoder_init(&dec);
+	memset(&total,0,sizeof(total));
+	memset(&last,0,sizeof(last));
+	memset(&latest,0,sizeof(latest));
+	memset(&stats,0,sizeof(stats));
+	signal(SIGINT,on_signal);
+
+	while(!stop){
+
+		struct pollfd p = { fd, POLLIN, 0 };
+		ssize_t n;
+		ssize_t i;
+		double now;
+
+		if(poll(&p,1,200) > 0){
+
+			n = read(fd,buffer,sizeof(buffer));
+			if(n < 0 && errno != EAGAIN && errno != EINTR){
+				perror(path);
+				break;
+			}
+
+			for(i=0;i<n;i++){
+
+				if(!stream_decode(&dec,buffer[i])){
+					continue;
+				}
+				count_record(&total,&dec.record);
+
+				if(dec.record.kind == STREAM_KIND_STATS){
+					stats = dec.record;
+				}
+				else{
+					latest = dec.record;
+					if(out != NULL){
+						write_reading(out,&dec.record);
+					}
+				}
+
+				if(verbose){
+					printf("%10.6f s seq %5u kind %u contents 0x%02X\n",dec.record.time_us/1e6,dec.record.sequence,dec.record.kind,dec.record.contents);
+				}
+			}
+			if(n > 0){
+				total.bytes += n;
+			}
+		}
+
+		now = now_s();
+		if(!verbose && now - last_print >= 1.0){
+
+			double dt = now - last_print;
+
+			printf("%9.3f s  acc %6.1f/s  gyro %6.1f/s  pres %5.1f/s  %6.0f B/s  lost %u  bad %u  dropped on board %u",latest.time_us/1e6,
+					(total.acc - last.acc)/dt,(total.gyro - last.gyro)/dt,(total.pres - last.pres)/dt,(total.bytes - last.bytes)/dt,
+					dec.lost,dec.bad,stats.dropped);
+			if(latest.contents & STREAM_HAS_ACC){
+				printf("  acc %d %d %d",latest.acc[0],latest.acc[1],latest.acc[2]);
+			}
+			if(latest.contents & STREAM_HAS_PRES){
+				printf("  %.2f Pa %.2f C",latest.pressure/100.0,latest.temperature/100.0);
+			}
+			printf("\n");
+
+			last = total;
+			last_print = now;
+		}
+	}
+
+	close(fd);
+	if(out != NULL){
+		fclose(out);
+	}
+	printf("%u bytes in %.1f s, %u records (%u acc, %u gyro, %u pres, %u with events), %u lost, %u bad, %u bytes skipped.\n",
+			total.bytes,now_s() - start,dec.records,total.acc,total.gyro,total.pres,total.events,dec.lost,dec.bad,dec.skipped);
+	printf("Last stats record: %u records queued, %u dropped on board.\n",stats.queued,stats.dropped);
+	return 0;
+}
+
+//The UART and its DMA: sends the bytes of the queue into the pseudo terminal at the baud rate, damaging some if asked to.
+static void * uart_thread(void * arg){
+
+	streamTest_t * t = (streamTest_t *)arg;
+	double bytes_per_s = t->baud/10.0*t->speed;
+	double next = now_s();
+
+	while(1){
+
+		uint8_t batch[UART_BATCH];
+		const uint8_t * data;
+		uint16_t length;
+		uint16_t i;
+		int done;
+
+		pthread_mutex_lock(&t->lock);
+		length = stream_queue_chunk(&t->queue,&data);
+		if(length > UART_BATCH){
+			length = UART_BATCH;
+		}
+		memcpy(batch,data,length);
+		done = t->sender_done && length == 0;
+		pthread_mutex_unlock(&t->lock);
+
+		if(length > 0){
+
+			for(i=0;i<length;i++){
+				if(t->error_rate > 0 && rand()/(RAND_MAX + 1.0) < t->error_rate){
+					batch[i] ^= 1 << (rand() % 8);
+					t->damaged++;
+				}
+			}
+
+			//A byte takes 10 bit times on the wire. The bytes leave the queue as they go out.
+			next += length/bytes_per_s;
+			sleep_until(next);
+			if(write(t->master,batch,length) != length){
+				break;
+			}
+
+			pthread_mutex_lock(&t->lock);
+			stream_queue_release(&t->queue,length);
+			pthread_mutex_unlock(&t->lock);
+		}
+		else if(done){
+			break;
+		}
+		else{
+			usleep(200);
+			next = now_s();
+		}
+	}
+
+	pthread_mutex_lock(&t->lock);
+	t->uart_done = 1;
+	pthread_mutex_unlock(&t->lock);
+	return NULL;
+}
+
+//Latest sample at a time, as the sensors would read it.
+static const streamSample_t * sample_at(const streamTest_t * t,uint32_t time_us){
+
+	uint32_t time_ms = time_us/1000;
+	size_t lo = 0;
+	size_t hi = t->count;
+
+	while(hi - lo > 1){
+		size_t mid = (lo + hi)/2;
+		if(t->samples[mid].time_ms <= time_ms){
+			lo = mid;
+		}
+		else{
+			hi = mid;
+		}
+	}
+	return &t->samples[lo];
+}
+
+static void queue_record(streamTest_t * t,streamRecord_t * r){
+
+	pthread_mutex_lock(&t->lock);
+	stream_queue_put(&t->queue,r);
+	pthread_mutex_unlock(&t->lock);
+}
+
+//The sensor tasks and the logging task: a reading whenever a sensor is due, with the accelerometer and the gyroscope in
+//one reading when they are due together as the IMU task reads them, and a stats record every STATS_PERIOD ms.
+static void * sender_thread(void * arg){
+
+	streamTest_t * t = (streamTest_t *)arg;
+	uint32_t period[3];
+	uint64_t next[3] = {0,0,0};
+	uint64_t end_us = (uint64_t)t->samples[t->count-1].time_ms*1000;
+	uint32_t stats_time = 0;
+	streamRecord_t r;
+	int k;
+
+	for(k=0;k<3;k++){
+		period[k] = 1000000/t->rates[k];
+	}
+	memset(&r,0,sizeof(r));
+
+	while(!stop){
+
+		uint64_t time = next[0];
+		const streamSample_t * s;
+
+		for(k=1;k<3;k++){
+			if(next[k] < time){
+				time = next[k];
+			}
+		}
+		//The BMP388 task sends its own readings.
+		k = (next[0] == time || next[1] == time) ? 0 : 2;
+		if(time > end_us){
+			break;
+		}
+
+		s = sample_at(t,(uint32_t)time);
+		r.kind = STREAM_KIND_READING;
+		r.time_us = (uint32_t)time;
+		r.contents = 0;
+
+		if(k == 0 && next[0] == time){
+			r.contents |= STREAM_HAS_ACC;
+			memcpy(r.acc,s->acc,sizeof(r.acc));
+			next[0] += period[0];
+		}
+		if(k == 0 && next[1] == time){
+			r.contents |= STREAM_HAS_GYRO;
+			memcpy(r.gyro,s->gyro,sizeof(r.gyro));
+			next[1] += period[1];
+		}
+		if(k == 2){
+			r.contents |= STREAM_HAS_PRES;
+			r.pressure = s->pressure;
+			r.temperature = s->temperature;
+			next[2] += period[2];
+		}
+
+		sleep_until(t->start + time/1e6/t->speed);
+		queue_record(t,&r);
+		count_record(&t->sent,&r);
+
+		if(time - stats_time >= STATS_PERIOD*1000){
+			r.kind = STREAM_KIND_STATS;
+			queue_record(t,&r);
+			stats_time = (uint32_t)time;
+		}
+		t->end_us = (uint32_t)time;
+	}
+
+	//A last stats record, so the reader knows every record dropped.
+	r.kind = STREAM_KIND_STATS;
+	queue_record(t,&r);
+
+	pthread_mutex_lock(&t->lock);
+	t->sender_done = 1;
+	pthread_mutex_unlock(&t->lock);
+	return NULL;
+}
+
+static int load_csv(streamTest_t * t,const char * path){
+
+	FILE * f = fopen(path,"r");
+	char line[256];
+	size_t capacity = 0;
+
+	if(f == NULL){
+		perror(path);
+		return -1;
+	}
+
+	while(fgets(line,sizeof(line),f) != NULL){
+
+		streamSample_t s;
+		int a[3],g[3];
+		unsigned long time,p;
+		long temp;
+
+		if(sscanf(line,"%lu,%d,%d,%d,%d,%d,%d,%lu,%ld",&time,&a[0],&a[1],&a[2],&g[0],&g[1],&g[2],&p,&temp) != 9){
+			continue;
+		}
+		s.time_ms = time;
+		s.acc[0] = a[0];	s.acc[1] = a[1];	s.acc[2] = a[2];
+		s.gyro[0] = g[0];	s.gyro[1] = g[1];	s.gyro[2] = g[2];
+		s.pressure = p;
+		s.temperature = temp;
+
+		if(t->count == capacity){
+			capacity = (capacity == 0) ? 4096 : capacity*2;
+			t->samples = realloc(t->samples,capacity*sizeof(streamSample_t));
+			if(t->samples == NULL){
+				fclose(f);
+				return -1;
+			}
+		}
+		t->samples[t->count++] = s;
+	}
+
+	fclose(f);
+	return (t->count > 0) ? 0 : -1;
+}
+
+//Checks a received reading against the sample it was taken from.
+static int reading_matches(const streamTest_t * t,const streamRecord_t * r){
+
+	const streamSample_t * s = sample_at(t,r->time_us);
+
+	if((r->contents & STREAM_HAS_ACC) && memcmp(r->acc,s->acc,sizeof(r->acc)) != 0){
+		return 0;
+	}
+	if((r->contents & STREAM_HAS_GYRO) && memcmp(r->gyro,s->gyro,sizeof(r->gyro)) != 0){
+		return 0;
+	}
+	if((r->contents & STREAM_HAS_PRES) && (r->pressure != s->pressure || r->temperature != s->temperature)){
+		return 0;
+	}
+	return 1;
+}
+
+static int run_test(streamTest_t * t,const char * out_path,int verbose){
+
+	streamDecoder_t dec;
+	streamCounts_t got;
+	streamRecord_t stats;
+	pthread_t sender,uart;
+	uint8_t buffer[4096];
+	FILE * out = open_output(out_path);
+	double idle_since;
+	double seconds;
+	double wall;
+	uint32_t matched = 0;
+	uint32_t readings = 0;
+	uint32_t link_lost;
+	int slave;
+
+	t->master = posix_openpt(O_RDWR | O_NOCTTY);
+	if(t->master < 0 || grantpt(t->master) != 0 || unlockpt(t->master) != 0){
+		perror("posix_openpt");
+		return 1;
+	}
+	set_raw(t->master,0);
+
+	//The reader opens the other end like it would a serial port.
+	slave = open(ptsname(t->master),O_RDONLY | O_NOCTTY);
+	if(slave < 0){
+		perror(ptsname(t->master));
+		return 1;
+	}
+	set_raw(slave,t->baud);
+	printf("Sending on %s at %u baud, %.0f times real time. Sensors at %u, %u and %u Hz.\n",ptsname(t->master),t->baud,t->speed,
+			t->rates[0],t->rates[1],t->rates[2]);
+
+	stream_decoder_init(&dec);
+	stream_queue_init(&t->queue);
+	memset(&got,0,sizeof(got));
+	memset(&stats,0,sizeof(stats));
+	pthread_mutex_init(&t->lock,NULL);
+	signal(SIGINT,on_signal);
+
+	t->start = now_s();
+	pthread_create(&sender,NULL,sender_thread,t);
+	pthread_create(&uart,NULL,uart_thread,t);
+	idle_since = now_s();
+
+	while(1){
+
+		struct pollfd p = { slave, POLLIN, 0 };
+		ssize_t n;
+		ssize_t k;
+		int done;
+
+		pthread_mutex_lock(&t->lock);
+		done = t->uart_done;
+		pthread_mutex_unlock(&t->lock);
+
+		if(poll(&p,1,10) <= 0 || (n = read(slave,buffer,sizeof(buffer))) <= 0){
+
+			if(done && now_s() - idle_since > IDLE_TIMEOUT/1000.0){
+				break;
+			}
+			continue;
+		}
+		idle_since = now_s();
+		got.bytes += n;
+
+		for(k=0;k<n;k++){
+
+			if(!stream_decode(&dec,buffer[k])){
+				continue;
+			}
+			count_record(&got,&dec.record);
+
+			if(dec.record.kind == STREAM_KIND_STATS){
+				stats = dec.record;
+				continue;
+			}
+
+			readings++;
+			matched += reading_matches(t,&dec.record);
+			if(out != NULL){
+				write_reading(out,&dec.record);
+			}
+			if(verbose){
+				printf("%10.6f s seq %5u contents 0x%02X\n",dec.record.time_us/1e6,dec.record.sequence,dec.record.contents);
+			}
+		}
+	}
+
+	pthread_join(sender,NULL);
+	pthread_join(uart,NULL);
+	wall = now_s() - t->start;
+	seconds = t->end_us/1e6;
+	if(seconds <= 0){
+		seconds = wall*t->speed;
+	}
+
+	//Every record takes a sequence number, so the gaps are the records dropped on board and the ones lost on the link.
+	link_lost = (dec.lost > stats.dropped) ? dec.lost - stats.dropped : 0;
+
+	printf("%.1f s of readings in %.1f s, %u records queued, %u dropped on board (queue full), %u bytes, %u damaged.\n",seconds,wall,
+			t->queue.queued,t->queue.dropped,t->queue.bytes,t->damaged);
+	wall = (wall - IDLE_TIMEOUT/1000.0)*t->speed;
+	printf("Received %u bytes, %.0f bytes/s, %.0f%% of the link.\n",got.bytes,got.bytes/wall,got.bytes/wall*1000/t->baud);
+	printf("Decoded %u records, %u missing (%u dropped on board, %u lost on the link), %u bad, %u bytes skipped.\n",dec.records,dec.lost,
+			stats.dropped,link_lost,dec.bad,dec.skipped);
+	printf("%u of %u readings match the samples sent.\n",matched,readings);
+	printf("  %-6s %8s %8s %10s %10s\n","sensor","sent","received","rate","configured");
+	printf("  %-6s %8u %8u %8.1f/s %8u/s\n","acc",t->sent.acc,got.acc,got.acc/seconds,t->rates[0]);
+	printf("  %-6s %8u %8u %8.1f/s %8u/s\n","gyro",t->sent.gyro,got.gyro,got.gyro/seconds,t->rates[1]);
+	printf("  %-6s %8u %8u %8.1f/s %8u/s\n","pres",t->sent.pres,got.pres,got.pres/seconds,t->rates[2]);
+
+	if(out != NULL){
+		fclose(out);
+	}
+	close(slave);
+	close(t->master);
+	return 0;
+}
+
+static void usage(const char * name){
+
+	fprintf(stderr,
+		"Usage: %s -p port [-b baud] [-o readings.csv] [-v]\n"
+		"       %s -c samples.csv [-a hz] [-g hz] [-r hz] [-b baud] [-x speed] [-e rate] [-o readings.csv] [-v]\n"
+		"  -p port    read the stream from a serial port or pseudo terminal until Ctrl-C\n"
+		"  -c file    send the samples of a sensor CSV (see flightReplay) through a pseudo terminal and read them back\n"
+		"  -a, -g, -r accelerometer, gyroscope and BMP388 rates of the test (default %u, %u and %u Hz)\n"
+		"  -b baud    baud rate of the link (default %u)\n"
+		"  -x speed   run the test this many times faster than real time (default 1)\n"
+		"  -e rate    chance of each byte being damaged in the test\n"
+		"  -o file    write every reading received to a CSV\n"
+		"  -v         print every record\n",
+		name,name,ACC_RATE,GYRO_RATE,BMP_RATE,STREAM_BAUD_RATE);
+}
+
+int main(int argc,char ** argv){
+
+	streamTest_t * t;
+	const char * port = NULL;
+	const char * csv_path = NULL;
+	const char * out_path = NULL;
+	uint32_t rates[3] = {ACC_RATE,GYRO_RATE,BMP_RATE};
+	uint32_t baud = STREAM_BAUD_RATE;
+	double speed = 1;
+	double error_rate = 0;
+	int verbose = 0;
+	int opt;
+	int result;
+
+	while((opt = getopt(argc,argv,"p:c:a:g:r:b:x:e:o:v")) != -1){
+		switch(opt){
+			case 'p': port = optarg; break;
+			case 'c': csv_path = optarg; break;
+			case 'a': rates[0] = strtoul(optarg,NULL,0); break;
+			case 'g': rates[1] = strtoul(optarg,NULL,0); break;
+			case 'r': rates[2] = strtoul(optarg,NULL,0); break;
+			case 'b': baud = strtoul(optarg,NULL,0); break;
+			case 'x': speed = strtod(optarg,NULL); break;
+			case 'e': error_rate = strtod(optarg,NULL); break;
+			case 'o': out_path = optarg; break;
+			case 'v': verbose = 1; break;
+			default: usage(argv[0]); return 2;
+		}
+	}
+
+	if((port == NULL) == (csv_path == NULL) || baud == 0 || speed <= 0 || rates[0] == 0 || rates[1] == 0 || rates[2] == 0){
+		usage(argv[0]);
+		return 2;
+	}
+
+	if(port != NULL){
+		return run_viewer(port,baud,out_path,verbose);
+	}
+
+	t = calloc(1,sizeof(streamTest_t));
+	if(t == NULL || load_csv(t,csv_path) != 0){
+		fprintf(stderr,"Could not load %s.\n",csv_path);
+		return 1;
+	}
+	memcpy(t->rates,rates,sizeof(rates));
+	t->baud = baud;
+	t->speed = speed;
+	t->error_rate = error_rate;
+	srand(1);
+
+	result = run_test(t,out_path,verbose);
+	free(t->samples);
+	free(t);
+	return result;
+}
@@ -0,0 +1,689 @@
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// UMSATS 2018-2020
+//
+// Repository:
+//  UMSATS/Avionics-2019
+//
+// File Description:
+//  Ground decoder for the radio telemetry, and a test of the link over a pseudo terminal.
+//
+//  With -p it reads the frames from a serial port (the radio modem) or any terminal and prints the values. With -c it
+//  replays a sensor CSV through flightState.c and the telemetry scheduler of the firmware, sends the frames into a
+//  pseudo terminal at the baud rate and decodes them from the other end, then prints the throughput, the time from
+//  building a frame to decoding it, the time from each flight event to the ground, and how often each field arrived.
+//
+//  Build (from the repository root):
+//   gcc -O2 -pthread -IAvionicsSoftware-AtollicProject/Inc Tools/telemetryLink.c AvionicsSoftware-AtollicProject/Src/telemetryFrame.c
+//       AvionicsSoftware-AtollicProject/Src/crc.c AvionicsSoftware-AtollicProject/Src/flightState.c
+//       AvionicsSoftware-AtollicProject/Src/logPacket.c -lm -o telemetryLink
+//
+// History
+// 2026-10-19
+// - Created.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+#define _XOPEN_SOURCE 600
+#define _DEFAULT_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "telemetryFrame.h"
+#include "flightState.h"
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// DEFINITIONS AND MACROS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+//Must match telemetry.h and configuration.h.
+#define FRAME_PERIOD			100			//ms
+#define BUDGET_PERCENT			80
+#define VELOCITY_GAIN			0.2
+#define FLASH_START_ADDRESS		0x6000
+#define GND_PRES				101325
+#define GND_ALT					0
+
+#define LOG_BYTES_PER_SAMPLE	20			//Rough flash use of a sample, for the log address field.
+#define FIFO_SIZE				4096
+#define EVENT_BITS				8
+#define IDLE_TIMEOUT			500			//ms without bytes after the sender is done before the test ends.
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// STRUCTS AND STRUCT TYPEDEFS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+typedef struct{
+
+	uint32_t time_ms;
+	int16_t acc[3];
+	int16_t gyro[3];
+	uint32_t pressure;		//0.01 Pa
+	int32_t temperature;	//0.01 deg C
+
+}linkSample_t;
+
+//Link test shared between the sender, the UART model and the decoder.
+typedef struct{
+
+	linkSample_t * samples;
+	size_t count;
+	uint32_t baud;
+	double speed;			//Times faster than real time.
+	double error_rate;		//Chance of each byte being damaged.
+	int master;				//Pseudo terminal the frames are written to.
+
+	pthread_mutex_t lock;
+	uint8_t fifo[FIFO_SIZE];	//Bytes waiting to go out of the UART.
+	size_t fifo_head;
+	size_t fifo_used;
+	int sender_done;
+	int uart_done;
+
+	double start;				//Wall time of flight time 0, in s.
+	double build_time[256];		//Wall time each sequence number was built.
+	double event_time[EVENT_BITS];	//Wall time each event bit was first detected, or 0.
+	tlmScheduler_t sched;
+	uint32_t damaged;
+
+}linkTest_t;
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// CONSTANTS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+static const char * event_names[EVENT_BITS] = {
+	"OVERCURRENT","POWER_FAIL","LAND_DETECT","LAUNCH_DETECT","MAIN_DEPLOY","MAIN_DETECT","DROGUE_DEPLOY","DROGUE_DETECT"
+};
+
+static volatile sig_atomic_t stop = 0;
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+// FUNCTIONS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+static double now_s(void){
+
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC,&t);
+	return t.tv_sec + t.tv_nsec/1e9;
+}
+
+static void sleep_until(double t){
+
+	double wait = t - now_s();
+
+	if(wait > 0){
+
+		struct timespec d;
+		d.tv_sec = (time_t)wait;
+		d.tv_nsec = (long)((wait - d.tv_sec)*1e9);
+		nanosleep(&d,NULL);
+	}
+}
+
+static void on_signal(int sig){
+
+	(void)sig;
+	stop = 1;
+}
+
+static speed_t baud_code(uint32_t baud){
+
+	switch(baud){
+		case 1200: return B1200;
+		case 2400: return B2400;
+		case 4800: return B4800;
+		case 9600: return B9600;
+		case 19200: return B19200;
+		case 38400: return B38400;
+		case 57600: return B57600;
+		case 115200: return B115200;
+		default: return B0;
+	}
+}
+
+static int set_raw(int fd,uint32_t baud){
+
+	struct termios tio;
+
+	if(tcgetattr(fd,&tio) != 0){
+		return -1;
+	}
+	cfmakeraw(&tio);
+	tio.c_cc[VMIN] = 0;
+	tio.c_cc[VTIME] = 0;
+	if(baud_code(baud) != B0){
+		cfsetispeed(&tio,baud_code(baud));
+		cfsetospeed(&tio,baud_code(baud));
+	}
+	return tcsetattr(fd,TCSANOW,&tio);
+}
+
+static void print_value(uint8_t field,int32_t value){
+
+	switch(field){
+		case TLM_ALTITUDE:
+		case TLM_ALT_RAW:
+			printf(" %s=%.1fm",tlm_fields[field].name,value/10.0);
+			break;
+		case TLM_VELOCITY:
+			printf(" %s=%.1fm/s",tlm_fields[field].name,value/10.0);
+			break;
+		case TLM_FLIGHT_TIME:
+			printf(" %s=%.1fs",tlm_fields[field].name,(uint32_t)value/1000.0);
+			break;
+		case TLM_CPU_LOAD:
+			printf(" %s=%.1f%%",tlm_fields[field].name,value/10.0);
+			break;
+		case TLM_STATE:
+		case TLM_FLAGS:
+		case TLM_EVENTS:
+		case TLM_CONTINUITY:
+			printf(" %s=0x%02X",tlm_fields[field].name,(unsigned)value);
+			break;
+		case TLM_LOG_ADDRESS:
+			printf(" %s=0x%06X",tlm_fields[field].name,(unsigned)value);
+			break;
+		default:
+			printf(" %s=%d",tlm_fields[field].name,value);
+			break;
+	}
+}
+
+static void print_values(const tlmDecoder_t * dec,uint32_t fields){
+
+	uint8_t i;
+
+	printf("%8.3f s seq %3u:",dec->time/1000.0,dec->sequence);
+	for(i=0;i<TLM_FIELDS;i++){
+		if((fields & ((uint32_t)1 << i)) && dec->valid[i]){
+			print_value(i,dec->values[i]);
+		}
+	}
+	printf("\n");
+}
+
+//Reads frames from a serial port until Ctrl-C. Prints every frame with verbose, otherwise all the values once a second.
+static int run_decoder(const char * path,uint32_t baud,int verbose){
+
+	tlmDecoder_t dec;
+	uint8_t buffer[256];
+	double start = now_s();
+	double last_print = start;
+	uint32_t bytes = 0;
+	int fd = open(path,O_RDONLY | O_NOCTTY);
+
+	if(fd < 0){
+		perror(path);
+		return 1;
+	}
+	if(set_raw(fd,baud) != 0){
+		fprintf(stderr,"%s: could not set the baud rate, reading as is.\n",path);
+	}
+
+	tlm_decoder_init(&dec);
+	signal(SIGINT,on_signal);
+
+	while(!stop){
+
+		struct pollfd p = { fd, POLLIN, 0 };
+		ssize_t n;
+		ssize_t i;
+
+		if(poll(&p,1,200) <= 0){
+			continue;
+		}
+		n = read(fd,buffer,sizeof(buffer));
+		if(n <= 0){
+			if(n < 0 && errno != EAGAIN && errno != EINTR){
+				perror(path);
+				break;
+			}
+			continue;
+		}
+		bytes += n;
+
+		for(i=0;i<n;i++){
+			if(tlm_decode(&dec,buffer[i]) && verbose){
+				print_values(&dec,dec.updated);
+			}
+		}
+
+		if(!verbose && now_s() - last_print >= 1.0 && dec.frames > 0){
+			print_values(&dec,~(uint32_t)0);
+			last_print = now_s();
+		}
+	}
+
+	close(fd);
+	printf("%u bytes in %.1f s, %u frames, %u lost, %u bad, %u bytes skipped.\n",bytes,now_s() - start,dec.frames,dec.lost,dec.bad,dec.skipped);
+	return 0;
+}
+
+static void fifo_put(linkTest_t * t,const uint8_t * data,uint8_t length){
+
+	uint8_t i;
+
+	pthread_mutex_lock(&t->lock);
+	for(i=0;i<length && t->fifo_used < FIFO_SIZE;i++){
+		t->fifo[(t->fifo_head + t->fifo_used) % FIFO_SIZE] = data[i];
+		t->fifo_used++;
+	}
+	pthread_mutex_unlock(&t->lock);
+}
+
+//The UART: sends the bytes of the FIFO into the pseudo terminal at the baud rate, damaging some if asked to.
+static void * uart_thread(void * arg){
+
+	linkTest_t * t = (linkTest_t *)arg;
+	double bytes_per_s = t->baud/10.0*t->speed;
+	double next = now_s();
+
+	while(1){
+
+		uint8_t byte;
+		int have = 0;
+		int done;
+
+		pthread_mutex_lock(&t->lock);
+		if(t->fifo_used > 0){
+			byte = t->fifo[t->fifo_head];
+			t->fifo_head = (t->fifo_head + 1) % FIFO_SIZE;
+			t->fifo_used--;
+			have = 1;
+		}
+		done = t->sender_done && t->fifo_used == 0;
+		pthread_mutex_unlock(&t->lock);
+
+		if(have){
+
+			if(t->error_rate > 0 && rand()/(RAND_MAX + 1.0) < t->error_rate){
+				byte ^= 1 << (rand() % 8);
+				t->damaged++;
+			}
+
+			//A byte takes 10 bit times on the wire.
+			next += 1.0/bytes_per_s;
+			sleep_until(next);
+			if(write(t->master,&byte,1) != 1){
+				break;
+			}
+		}
+		else if(done){
+			break;
+		}
+		else{
+			usleep(200);
+			next = now_s();
+		}
+	}
+
+	pthread_mutex_lock(&t->lock);
+	t->uart_done = 1;
+	pthread_mutex_unlock(&t->lock);
+	return NULL;
+}
+
+//The flight computer: the logging task publishing samples and the telemetry task building a frame every period.
+static void * sender_thread(void * arg){
+
+	linkTest_t * t = (linkTest_t *)arg;
+	uint8_t frame[TLM_MAX_FRAME];
+	uint8_t state = STATE_LAUNCHPAD_ARMED;
+	uint8_t flags = FLAG_RECORDING;
+	uint32_t events = 0;
+	int64_t launch_time = -1;
+	int backup_stage = 0;
+	uint32_t next_frame;
+	float velocity = 0;
+	float prev_alt = 0;
+	uint32_t prev_time = 0;
+	flightState_t fs;
+	flightSample_t sample;
+	size_t i;
+	int k;
+
+	memset(&sample,0,sizeof(sample));
+	flight_state_init(&fs,&state,&flags);
+	tlm_init(&t->sched,tlm_budget(t->baud,BUDGET_PERCENT),0);
+	next_frame = FRAME_PERIOD;
+
+	//Health the firmware would measure, held still here.
+	tlm_set(&t->sched,TLM_CPU_LOAD,350);
+	tlm_set(&t->sched,TLM_STACK_MIN,120);
+	tlm_set(&t->sched,TLM_FLASH_ERRORS,0);
+
+	for(i=0;i<t->count && !stop;i++){
+
+		const linkSample_t * s = &t->samples[i];
+		uint32_t new_events;
+
+		//Backup timers, as in flightReplay.
+		if(launch_time >= 0 && backup_stage == 0 && s->time_ms >= launch_time + BACKUP_DROGUE_TIME){
+			state = STATE_IN_FLIGHT_POST_APOGEE;
+			backup_stage = 1;
+		}
+		if(launch_time >= 0 && backup_stage == 1 && s->time_ms >= launch_time + BACKUP_DROGUE_TIME + 2*BACKUP_BEEP_TIME + BACKUP_MAIN_TIME){
+			state = STATE_IN_FLIGHT_POST_MAIN;
+			backup_stage = 2;
+		}
+
+		while(next_frame <= s->time_ms){
+
+			int busy;
+			uint8_t length;
+
+			sleep_until(t->start + next_frame/1000.0/t->speed);
+
+			tlm_set(&t->sched,TLM_STATE,state);
+			tlm_set(&t->sched,TLM_FLAGS,flags);
+			tlm_set(&t->sched,TLM_CONTINUITY,((events & DROGUE_DEPLOY) ? 0 : 0x01) | ((events & MAIN_DEPLOY) ? 0 : 0x02));
+
+			pthread_mutex_lock(&t->lock);
+			busy = (t->fifo_used > 0);
+			pthread_mutex_unlock(&t->lock);
+
+			//The firmware builds nothing while the last frame is still going out.
+			if(!busy){
+
+				length = tlm_build(&t->sched,next_frame,frame);
+				if(length > 0){
+					t->build_time[frame[2]] = now_s();
+					fifo_put(t,frame,length);
+				}
+			}
+			next_frame += FRAME_PERIOD;
+		}
+
+		for(k=0;k<3;k++){
+			sample.acc[k] = s->acc[k];
+			sample.gyro[k] = s->gyro[k];
+		}
+		sample.altitude = pressure_altitude((float)s->pressure,(float)s->temperature,GND_PRES,GND_ALT);
+
+		new_events = flight_state_update(&fs,&sample);
+		if(new_events & (MAIN_DETECT | DROGUE_DETECT)){
+			new_events |= flight_state_deployed(&fs,new_events);
+		}
+		if(new_events & LAUNCH_DETECT){
+			launch_time = s->time_ms;
+		}
+
+		for(k=0;k<EVENT_BITS;k++){
+			if(((new_events & ~events) >> EXT_KIND_SHIFT) & (1 << k)){
+				t->event_time[k] = now_s();
+			}
+		}
+		events |= new_events;
+
+		//Same as telemetry_publish().
+		if(i > 0 && s->time_ms > prev_time){
+			velocity += VELOCITY_GAIN*((fs.alt_filtered - prev_alt)*1000.0f/(s->time_ms - prev_time) - velocity);
+		}
+		prev_alt = fs.alt_filtered;
+		prev_time = s->time_ms;
+
+		tlm_set(&t->sched,TLM_EVENTS,(events & EVENT_MASK) >> EXT_KIND_SHIFT);
+		tlm_set(&t->sched,TLM_ALTITUDE,(int32_t)(fs.alt_filtered*10));
+		tlm_set(&t->sched,TLM_VELOCITY,(int32_t)(velocity*10));
+		tlm_set(&t->sched,TLM_ACC_X,s->acc[0]);
+		tlm_set(&t->sched,TLM_ACC_Y,s->acc[1]);
+		tlm_set(&t->sched,TLM_ACC_Z,s->acc[2]);
+		tlm_set(&t->sched,TLM_ALT_RAW,(int32_t)(fs.altitude*10));
+		tlm_set(&t->sched,TLM_FLIGHT_TIME,(launch_time < 0) ? 0 : (uint32_t)(s->time_ms - launch_time));
+		tlm_set(&t->sched,TLM_LOG_ADDRESS,FLASH_START_ADDRESS + (uint32_t)i*LOG_BYTES_PER_SAMPLE);
+	}
+
+	pthread_mutex_lock(&t->lock);
+	t->sender_done = 1;
+	pthread_mutex_unlock(&t->lock);
+	return NULL;
+}
+
+static int load_csv(linkTest_t * t,const char * path){
+
+	FILE * f = fopen(path,"r");
+	char line[256];
+	size_t capacity = 0;
+
+	if(f == NULL){
+		perror(path);
+		return -1;
+	}
+
+	while(fgets(line,sizeof(line),f) != NULL){
+
+		linkSample_t s;
+		int a[3],g[3];
+		unsigned long time,p;
+		long temp;
+
+		if(sscanf(line,"%lu,%d,%d,%d,%d,%d,%d,%lu,%ld",&time,&a[0],&a[1],&a[2],&g[0],&g[1],&g[2],&p,&temp) != 9){
+			continue;
+		}
+		s.time_ms = time;
+		s.acc[0] = a[0];	s.acc[1] = a[1];	s.acc[2] = a[2];
+		s.gyro[0] = g[0];	s.gyro[1] = g[1];	s.gyro[2] = g[2];
+		s.pressure = p;
+		s.temperature = temp;
+
+		if(t->count == capacity){
+			capacity = (capacity == 0) ? 4096 : capacity*2;
+			t->samples = realloc(t->samples,capacity*sizeof(linkSample_t));
+			if(t->samples == NULL){
+				fclose(f);
+				return -1;
+			}
+		}
+		t->samples[t->count++] = s;
+	}
+
+	fclose(f);
+	return (t->count > 0) ? 0 : -1;
+}
+
+static int run_test(linkTest_t * t,int verbose){
+
+	tlmDecoder_t dec;
+	pthread_t sender,uart;
+	uint8_t buffer[256];
+	uint32_t updates[TLM_FIELDS];
+	uint32_t prev_events = 0;
+	double latency_sum = 0;
+	double latency_max = 0;
+	double idle_since;
+	double seconds;
+	uint32_t bytes = 0;
+	uint32_t matched = 0;
+	uint32_t valid = 0;
+	int slave;
+	int i;
+
+	t->master = posix_openpt(O_RDWR | O_NOCTTY);
+	if(t->master < 0 || grantpt(t->master) != 0 || unlockpt(t->master) != 0){
+		perror("posix_openpt");
+		return 1;
+	}
+	set_raw(t->master,0);
+
+	//The decoder reads the other end like it would a serial port.
+	slave = open(ptsname(t->master),O_RDONLY | O_NOCTTY);
+	if(slave < 0){
+		perror(ptsname(t->master));
+		return 1;
+	}
+	set_raw(slave,t->baud);
+	printf("Sending on %s at %u baud, %.0f times real time.\n",ptsname(t->master),t->baud,t->speed);
+
+	tlm_decoder_init(&dec);
+	memset(updates,0,sizeof(updates));
+	pthread_mutex_init(&t->lock,NULL);
+	signal(SIGINT,on_signal);
+
+	t->start = now_s();
+	pthread_create(&sender,NULL,sender_thread,t);
+	pthread_create(&uart,NULL,uart_thread,t);
+	idle_since = now_s();
+
+	while(1){
+
+		struct pollfd p = { slave, POLLIN, 0 };
+		ssize_t n;
+		ssize_t k;
+		int done;
+
+		pthread_mutex_lock(&t->lock);
+		done = t->uart_done;
+		pthread_mutex_unlock(&t->lock);
+
+		if(poll(&p,1,10) <= 0 || (n = read(slave,buffer,sizeof(buffer))) <= 0){
+
+			if(done && now_s() - idle_since > IDLE_TIMEOUT/1000.0){
+				break;
+			}
+			continue;
+		}
+		idle_since = now_s();
+		bytes += n;
+
+		for(k=0;k<n;k++){
+
+			double latency;
+			uint32_t new_events;
+
+			if(!tlm_decode(&dec,buffer[k])){
+				continue;
+			}
+
+			//Link time from the frame being built to its last byte arriving.
+			latency = (now_s() - t->build_time[dec.sequence])*t->speed;
+			latency_sum += latency;
+			if(latency > latency_max){
+				latency_max = latency;
+			}
+
+			for(i=0;i<TLM_FIELDS;i++){
+				if(dec.updated & ((uint32_t)1 << i)){
+					updates[i]++;
+				}
+			}
+
+			if(dec.valid[TLM_EVENTS]){
+
+				new_events = dec.values[TLM_EVENTS] & ~prev_events;
+				for(i=0;i<EVENT_BITS;i++){
+					if((new_events & (1 << i)) && t->event_time[i] > 0){
+						printf("  %-14s at %8.3f s, %4.0f ms to the ground\n",event_names[i],(now_s() - t->start)*t->speed,
+								(now_s() - t->event_time[i])*t->speed*1000);
+					}
+				}
+				prev_events |= new_events;
+			}
+
+			if(verbose){
+				print_values(&dec,dec.updated);
+			}
+		}
+	}
+
+	pthread_join(sender,NULL);
+	pthread_join(uart,NULL);
+	seconds = (now_s() - t->start)*t->speed;
+
+	//With no damaged bytes the decoder must end up with what the scheduler last sent.
+	for(i=0;i<TLM_FIELDS;i++){
+		if(dec.valid[i]){
+			valid++;
+			matched += (dec.values[i] == t->sched.fields[i].sent);
+		}
+	}
+
+	printf("%.1f s of flight, %u frames and %u bytes sent, %u damaged.\n",seconds,t->sched.frames,t->sched.bytes,t->damaged);
+	printf("Received %u bytes, %.1f bytes/s, %.0f%% of the link, budget %u bytes/s.\n",bytes,bytes/seconds,
+			bytes/seconds*1000/t->baud,tlm_budget(t->baud,BUDGET_PERCENT));
+	printf("Decoded %u frames, %u lost, %u bad, %u bytes skipped. Frame latency mean %.1f ms, max %.1f ms.\n",dec.frames,dec.lost,dec.bad,
+			dec.skipped,(dec.frames == 0) ? 0 : latency_sum/dec.frames*1000,latency_max*1000);
+	printf("%u of %u values at the end match the sender.\n",matched,valid);
+	printf("  %-14s %9s %9s %8s\n","field","period","interval","updates");
+	for(i=0;i<TLM_FIELDS;i++){
+		printf("  %-14s %6u ms %6.0f ms %8u\n",tlm_fields[i].name,tlm_fields[i].period,(updates[i] == 0) ? 0 : seconds*1000/updates[i],updates[i]);
+	}
+
+	close(slave);
+	close(t->master);
+	return 0;
+}
+
+static void usage(const char * name){
+
+	fprintf(stderr,
+		"Usage: %s -p port [-b baud] [-v]\n"
+		"       %s -c samples.csv [-b baud] [-x speed] [-e rate] [-v]\n"
+		"  -p port    decode frames from a serial port or pseudo terminal until Ctrl-C\n"
+		"  -c file    send the flight in a sensor CSV (see flightReplay) through a pseudo terminal and decode it\n"
+		"  -b baud    baud rate of the link (default 9600)\n"
+		"  -x speed   run the test this many times faster than real time (default 1)\n"
+		"  -e rate    chance of each byte being damaged in the test\n"
+		"  -v         print every frame\n",
+		name,name);
+}
+
+int main(int argc,char ** argv){
+
+	linkTest_t * t;
+	const char * port = NULL;
+	const char * csv_path = NULL;
+	uint32_t baud = 9600;
+	double speed = 1;
+	double error_rate = 0;
+	int verbose = 0;
+	int opt;
+	int result;
+
+	while((opt = getopt(argc,argv,"p:c:b:x:e:v")) != -1){
+		switch(opt){
+			case 'p': port = optarg; break;
+			case 'c': csv_path = optarg; break;
+			case 'b': baud = strtoul(optarg,NULL,0); break;
+			case 'x': speed = strtod(optarg,NULL); break;
+			case 'e': error_rate = strtod(optarg,NULL); break;
+			case 'v': verbose = 1; break;
+			default: usage(argv[0]); return 2;
+		}
+	}
+
+	if((port == NULL) == (csv_path == NULL) || baud == 0 || speed <= 0){
+		usage(argv[0]);
+		return 2;
+	}
+
+	if(port != NULL){
+		return run_decoder(port,baud,verbose);
+	}
+
+	t = calloc(1,sizeof(linkTest_t));
+	if(t == NULL || load_csv(t,csv_path) != 0){
+		fprintf(stderr,"Could not load %s.\n",csv_path);
+		return 1;
+	}
+	t->baud = baud;
+	t->speed = speed;
+	t->error_rate = error_rate;
+	srand(1);
+
+	result = run_test(t,verbose);
+	free(t->samples);
+	free(t);
+	return result;
+}